@@ -0,0 +1,83 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file amux_hal.h
+ * @brief this file contain the functions prototype to create an abstract interface
+ * to read humidity probes through CD74HC4067 analog multiplexers
+ *
+ * Mux channel k of bank b is the analog channel AMUX_FIRST_ch + b * AMUX_BANK_CHANNELS + k
+ * of analog_a: every sweep feeds the Fifo_buf_t of these channels with the spike filter
+ * of analog_hal, read_humidity() then only reads their average.
+ *
+ * The following functions will be implemented:
+ * - amux_hal_init() to configure select lines and analog channels of the muxes
+ * - amux_hal_sweep() to scan all mux channels once
+ * - amux_hal_print() to print the timing of the last sweep
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __AMUX_HAL_H__
+#define __AMUX_HAL_H__
+
+#include "common.h"
+#include "HAL/analog_hal.h"
+#include "HAL/amux_scan.h"
+
+#define AMUX_S0_pin 25 // select lines, shared by all banks
+#define AMUX_S1_pin 26
+#define AMUX_S2_pin 27
+#define AMUX_S3_pin 14
+#define AMUX_SIG_0_pin 34 // ADC1 pin of bank 0
+#define AMUX_SIG_1_pin 35 // ADC1 pin of bank 1
+#define AMUX_SETTLE_US 10 // probe source impedance x (mux + ADC input capacitance), with margin
+#define AMUX_DISCARD 1 // dummy conversions after switching
+
+#if AMUX_HUMIDITY && ULP_HUMIDITY
+#error "AMUX_HUMIDITY and ULP_HUMIDITY both need ADC1"
+#endif
+
+/**
+ * @brief Initialize multiplexer scanning
+ *
+ * Configure the select lines as outputs, set the pin of every mux channel in the analog
+ * array and initialize the scanning engine.
+ *
+ * @param a 8-bit struct pointer to an n-element data array
+ * @param size 8-bit value that indicate number of analog array
+ *
+ * @return void
+ */
+void amux_hal_init(Analog_t* a, uint8_t size);
+
+/**
+ * @brief Scan all mux channels once
+ *
+ * Select every channel, convert all banks and add the samples to the analog channels.
+ * The CPU is kept at max frequency during the sweep.
+ *
+ * @param a 8-bit struct pointer to an n-element data array
+ * @param size 8-bit value that indicate number of analog array
+ *
+ * @return void
+ */
+void amux_hal_sweep(Analog_t* a, uint8_t size);
+
+/**
+ * @brief Print timing of the last sweep
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void amux_hal_print();
+
+#endif /* __AMUX_HAL_H__ */
@@ -0,0 +1,98 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file amux_scan.h
+ * @brief this file contain the functions prototype of the analog multiplexer scanning engine
+ *
+ * One or more CD74HC4067 (16 channels) share the select lines, each mux output goes to
+ * its own ADC pin (bank). A sweep selects every channel once and converts all banks on it.
+ * - channels are visited in Gray code order: one select line toggles per step, so the
+ *   charge injected on the mux output by the switching is the smallest possible
+ * - pipelined: the filter stage (sink) of the previous step runs while the newly selected
+ *   channel settles, only the remainder of the settling time is busy-waited
+ * - optional dummy conversions after switching discard the charge left on the ADC
+ *   sampling capacitor by the previous channel (crosstalk)
+ *
+ * The engine accesses the hardware through AmuxIo_t and has no dependency on Arduino, so
+ * it can be run on the host by the mock mux in tools/amux_mock.
+ *
+ * The following functions will be implemented:
+ * - amux_init() to set geometry, settling time and scan order
+ * - amux_sweep() to scan all channels once
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __AMUX_SCAN_H__
+#define __AMUX_SCAN_H__
+
+#include <stdint.h>
+
+#define AMUX_MAX_CHANNELS 16 // channels of a CD74HC4067
+#define AMUX_MAX_BANKS 2 // muxes sharing the select lines
+
+typedef struct AmuxIo_s
+{
+  void      (*select)(struct AmuxIo_s* io, uint8_t lines); // set S0..S3
+  uint16_t  (*convert)(struct AmuxIo_s* io, uint8_t bank); // one ADC conversion of a bank
+  uint32_t  (*now_us)(struct AmuxIo_s* io);
+  void      (*delay_us)(struct AmuxIo_s* io, uint32_t us); // busy-wait
+  void      (*sink)(struct AmuxIo_s* io, uint8_t channel, uint16_t raw); // filter stage of a virtual channel
+  void*     ctx; // backend data
+}AmuxIo_t;
+
+typedef struct
+{
+  uint32_t  sweeps;
+  uint32_t  conversions; // dummy conversions included
+  uint32_t  sweep_us; // duration of the last sweep
+  uint32_t  wait_us; // settling busy-waited in the last sweep
+  uint32_t  overlap_us; // settling covered by the filter stage in the last sweep
+}AmuxStats_t;
+
+typedef struct
+{
+  uint8_t     banks;
+  uint8_t     channels; // channels per bank
+  uint16_t    settle_us; // settling time after switching
+  uint8_t     discard; // dummy conversions after switching
+  uint8_t     order[AMUX_MAX_CHANNELS]; // scan order
+  AmuxStats_t stats;
+}Amux_t;
+
+/**
+ * @brief Initialize scanning engine
+ *
+ * Virtual channel of bank b, mux channel k is b * channels + k.
+ *
+ * @param m Amux_t struct pointer
+ * @param banks number of muxes sharing the select lines
+ * @param channels channels used on each mux
+ * @param settle_us settling time after switching in microseconds
+ * @param discard dummy conversions after switching
+ *
+ * @return void
+ */
+void amux_init(Amux_t* m, uint8_t banks, uint8_t channels, uint16_t settle_us, uint8_t discard);
+
+/**
+ * @brief Scan all channels once
+ *
+ * Call io->sink once for every virtual channel with its raw conversion.
+ *
+ * @param m Amux_t struct pointer
+ * @param io AmuxIo_t struct pointer
+ *
+ * @return void
+ */
+void amux_sweep(Amux_t* m, AmuxIo_t* io);
+
+#endif /* __AMUX_SCAN_H__ */
@@ -20,7 +20,11 @@
  * - spike_counter() to count number of spikes
  * - analog_get_media() to get media from samples collected in the FIFO buffer
  * - analog_read_data() to read data from analog pins
+ * - analog_add_sample() to filter a new sample and add it to the FIFO buffer
  * - analog_print() to print data for a specific channel
+ * - analog_set_length() to set the FIFO buffer length of a specific channel
+ * - analog_set_spike() to set the spike filter parameters
+ * - analog_get_value() to get the filtered value of a specific channel
  * 
  * @author Marconatale Parise
  * @date 09 June 2025
@@ -31,16 +35,38 @@
 #define __ANALOG_HAL_H__
 
 #include "common.h"
+#include "kalman.h"
 
 #define VUSB 5000
 #define VBATT 4200
 #define VREG 3320
-#define RANGE   (4095*300)/VREG   //300mV in bit
+#define RANGE   (4095*300)/VREG   //300mV in bit, default of analog_set_spike()
 #define NO_ADC_SPIKE  0 // no spike detected
-#define LIMIT_ADC_SPIKE 3 // spike detected and data is valid
+#define LIMIT_ADC_SPIKE 3 // spike detected and data is valid, default of analog_set_spike()
 
+#ifndef AMUX_HUMIDITY
+#define AMUX_HUMIDITY 0 // 1 read humidity probes through CD74HC4067 muxes (HAL/amux_hal.h)
+#endif
+#define AMUX_NUM_BANKS 1 // muxes sharing the select lines, one ADC pin each
+#define AMUX_BANK_CHANNELS 16 // channels used on each mux
+#define AMUX_FIRST_ch 1 // analog channel of bank 0, mux channel 0
+
+#if AMUX_HUMIDITY
+#define NUM_ANALOG_PERIP (AMUX_FIRST_ch + AMUX_NUM_BANKS * AMUX_BANK_CHANNELS) // number of analog peripherals
+#else
 #define NUM_ANALOG_PERIP 1 // number of analog peripherals
-#define BUFFER_SIZE 4 // number of samples to store in the buffer
+#endif
+#ifndef BUFFER_SIZE
+#define BUFFER_SIZE 4 // number of samples to store in the buffer, maximum of analog_set_length()
+#endif
+
+#ifndef KALMAN_FILTER
+#define KALMAN_FILTER 0 // 1 filtered value from the Kalman filter instead of the buffer average
+#endif
+// Kalman tuning in ADC bits, see tools/kalman_bench
+#define KALMAN_ADC_R 225.0 // measurement noise variance (15 bits rms)
+#define KALMAN_ADC_QX 0.05 // level noise per sample
+#define KALMAN_ADC_QV 0.05 // rate noise per sample, lower is smoother but slower on steps
 
 typedef struct 
 {
@@ -56,7 +82,7 @@ typedef struct
 	bool 			  status;
 	Fifo_buf_t		fbuf;
   uint8_t     counter_spike;
-  
+  Kalman_t    kf; // runs after the spike filter, on the accepted samples (KALMAN_FILTER 1 only)
 }Analog_t;
 
 /**
@@ -153,6 +179,21 @@ uint16_t analog_get_media (Analog_t* a, uint8_t channel, uint8_t size);
  */
 void analog_read_data (Analog_t* a, uint8_t channel, uint8_t size);
 
+/**
+ * @brief Filter new sample
+ *
+ * Apply the spike filter to a sample already converted (e.g. by the mux scanning engine)
+ * and add it to the FIFO buffer of the channel.
+ *
+ * @param a 8-bit struct pointer to an n-element data array
+ * @param channel 8-bit value that indicate channel of analog array 
+ * @param data_read 16-bit value new data to be added to the buffer
+ * @param size 8-bit value that indicate number of analog array 
+ *
+ * @return void
+ */
+void analog_add_sample (Analog_t* a, uint8_t channel, uint16_t data_read, uint8_t size);
+
 /**
  * @brief Print data for a specific channel
  *
@@ -165,4 +206,45 @@ void analog_read_data (Analog_t* a, uint8_t channel, uint8_t size);
  */
 void analog_print(Analog_t* a, uint8_t channel);
 
+/**
+ * @brief Set FIFO buffer length for a specific channel
+ *
+ * Set the number of samples averaged by the filter. When the buffer shrinks the newest
+ * samples are kept and the media is updated.
+ *
+ * @param a 8-bit struct pointer to an n-element data array
+ * @param channel 8-bit value that indicate channel of analog array 
+ * @param length 8-bit value that indicate number of samples (1..BUFFER_SIZE)
+ * @param size 8-bit value that indicate number of analog array 
+ *
+ * @return bool true if length is valid, false otherwise
+ */
+bool analog_set_length(Analog_t* a, uint8_t channel, uint8_t length, uint8_t size);
+
+/**
+ * @brief Set spike filter parameters
+ *
+ * Set the parameters of the spike filter shared by all channels.
+ *
+ * @param range 16-bit value that indicate ADC bits between two samples above which a sample is a spike
+ * @param limit 8-bit value that indicate consecutive spikes accepted as a real change
+ *
+ * @return void
+ */
+void analog_set_spike(uint16_t range, uint8_t limit);
+
+/**
+ * @brief Get filtered value for a specific channel
+ *
+ * Value after the spike filter and the smoothing stage: the buffer average, or the
+ * Kalman estimate when KALMAN_FILTER is 1.
+ *
+ * @param a 8-bit struct pointer to an n-element data array
+ * @param channel 8-bit value that indicate channel of analog array 
+ * @param size 8-bit value that indicate number of analog array 
+ *
+ * @return uint16_t filtered value in ADC bits, 0 if the channel is not valid
+ */
+uint16_t analog_get_value(Analog_t* a, uint8_t channel, uint8_t size);
+
 #endif
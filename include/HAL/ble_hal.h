@@ -15,7 +15,18 @@
  * The following functions will be implemented:
  * - ble_init() to initialize the ble
  * - ble_create_service() to create BLE service and characteristics
- * - ble_transmit_temp() to transmit temperature data over BLE
+ * - ble_transmit_temp() to transmit temperature data over BLE (deprecated)
+ * - ble_transmit_humidity() to transmit humidity percentage over BLE (deprecated)
+ * - ble_transmit_slrrad() to transmit solar radiation status over BLE (deprecated)
+ * - ble_transmit_alarm() to transmit alarm status over BLE
+ * - ble_transmit_stats() to transmit rolling statistics over BLE
+ * - ble_transmit_records() to transmit plant records over BLE
+ * - ble_set_config_handler() to set the handlers of the config characteristic
+ * - ble_transmit_history() to transmit the points of a history query over BLE
+ * - ble_set_history_handler() to set the handler of the history characteristic
+ * - ble_set_time_handler() to set the handler of the time characteristic
+ * - ble_get_centrals() to get the number of connected centrals
+ * - ble_get_notify_stats() to get the notification counters
  * 
  * @author Marconatale Parise
  * @date 09 June 2025
@@ -26,6 +37,9 @@
 #define __BLE_HAL_H__
 
 #include "common.h"
+#include "rollstat.h"
+#include "downsample.h"
+#include "record.h"
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
@@ -37,10 +51,34 @@
 #define CHARACTERISTIC_UUID_TEMP  "00002A6E-0000-1000-8000-00805F9B34FB"
 #define CHARACTERISTIC_UUID_HUMIDITY  "00002A6F-0000-1000-8000-00805F9B34FB"
 #define CHARACTERISTIC_UUID_SLRRAD  "00002A77-0000-1000-8000-00805F9B34FB"
+#define CHARACTERISTIC_UUID_ALARM  "00002A3F-0000-1000-8000-00805F9B34FB"
+#define CHARACTERISTIC_UUID_STATS  "8d6b0001-3c2e-4a8b-9f4e-5b1d7c2a9e10" // no standard characteristic
+#define CHARACTERISTIC_UUID_CONFIG  "8d6b0002-3c2e-4a8b-9f4e-5b1d7c2a9e10"
+#define CHARACTERISTIC_UUID_HISTORY  "8d6b0003-3c2e-4a8b-9f4e-5b1d7c2a9e10"
+#define CHARACTERISTIC_UUID_RECORD  "8d6b0004-3c2e-4a8b-9f4e-5b1d7c2a9e10"
+#define CHARACTERISTIC_UUID_TIME  "8d6b0005-3c2e-4a8b-9f4e-5b1d7c2a9e10"
+#define BLE_SERVICE_HANDLES 32 // service, 2 per characteristic, 1 per descriptor (default 15 is too few)
+#define BLE_CONFIG_MAX_LEN 256 // longest config write (alarm rule table)
+#define BLE_HISTORY_CHUNK_POINTS 3 // points per notification, fits the default 20-byte payload
+#define BLE_RECORD_CHUNK_RECORDS 1 // plant records per notification, fits the default 20-byte payload
+#ifndef BLE_LEGACY_CHARACTERISTICS
+#define BLE_LEGACY_CHARACTERISTICS 1 // deprecated 16-bit temperature/humidity/solar of plant 1, 0 record characteristic only
+#endif
+#ifndef BLE_MAX_CENTRALS
+#define BLE_MAX_CENTRALS 3 // connected centrals, advertising goes on until reached
+#endif
 
+#if BLE_LEGACY_CHARACTERISTICS
 extern BLECharacteristic *characteristic_temp;
 extern BLECharacteristic *characteristic_humidity;
 extern BLECharacteristic *characteristic_slrrad;
+#endif
+extern BLECharacteristic *characteristic_alarm;
+extern BLECharacteristic *characteristic_stats;
+extern BLECharacteristic *characteristic_config;
+extern BLECharacteristic *characteristic_history;
+extern BLECharacteristic *characteristic_record;
+extern BLECharacteristic *characteristic_time;
 
 extern bool deviceConnected;
 
@@ -66,10 +104,13 @@ void ble_init();
  */
 void ble_create_service();
 
+#if BLE_LEGACY_CHARACTERISTICS
 /**
  * @brief Transmit temperature data over BLE
  *
  * Transmit temperature data over BLE by setting the value of the characteristic and notifying connected devices.
+ * Deprecated: plant 1 only, truncated to whole units and without time; clients read the
+ * record characteristic (ble_transmit_records()). Built with BLE_LEGACY_CHARACTERISTICS.
  *
  * @param value 16-bit value representing the temperature data
  *
@@ -81,6 +122,7 @@ void ble_transmit_temp(uint16_t value);
  * @brief Transmit humidity percentage over BLE
  *
  * Transmit humidity percentage over BLE by setting the value of the characteristic and notifying connected devices.
+ * Deprecated like ble_transmit_temp().
  *
  * @param value 16-bit value representing the humidity data
  *
@@ -92,12 +134,131 @@ void ble_transmit_humidity(uint16_t value);
  * @brief Transmit solar radition status over BLE
  *
  * Transmit solar radition status over BLE by setting the value of the characteristic and notifying connected devices.
+ * Deprecated like ble_transmit_temp().
  *
  * @param value 16-bit value representing the solar radition data
  *
  * @return void
  */
 void ble_transmit_slrrad(uint16_t value);
+#endif
+
+/**
+ * @brief Transmit alarm status over BLE
+ *
+ * Transmit the alarm bits of a plant as soon as they change. The value is 2 bytes:
+ * plant index and alarm mask (bit n set if alarm id n is raised).
+ *
+ * @param plant 8-bit value that indicate plant channel
+ * @param mask 8-bit value that indicate alarm bits of the plant
+ *
+ * @return void
+ */
+void ble_transmit_alarm(uint8_t plant, uint8_t mask);
+
+/**
+ * @brief Transmit rolling statistics over BLE
+ *
+ * Transmit the statistics of a field of a plant. The value is 16 bytes, little endian:
+ * plant (u8), field (u8), samples (u32), mean, stddev, min, max, EWMA (i16, 0.01 units).
+ *
+ * @param plant 8-bit value that indicate plant channel
+ * @param field 8-bit value that indicate field (AlarmField_t)
+ * @param v RollStatValue_t struct pointer
+ *
+ * @return void
+ */
+void ble_transmit_stats(uint8_t plant, uint8_t field, const RollStatValue_t* v);
+
+/**
+ * @brief Transmit plant records over BLE
+ *
+ * Notify the records in batches of BLE_RECORD_CHUNK_RECORDS, each notification is a
+ * plant record batch (see record.h): versioned, timestamped, 0.1 units.
+ *
+ * @param r pointer to the records, in time order
+ * @param count number of records
+ *
+ * @return void
+ */
+void ble_transmit_records(const PlantRecord_t* r, uint8_t count);
+
+/**
+ * @brief Set the handlers of the config characteristic
+ *
+ * on_write receives every write of the config characteristic (called from the BLE
+ * stack task), on_read fills the value returned to the next read.
+ *
+ * @param on_write function called with the written bytes, returns true if accepted
+ * @param on_read function filling a buffer, returns the number of bytes
+ *
+ * @return void
+ */
+void ble_set_config_handler(bool (*on_write)(const uint8_t* data, size_t len),
+                            size_t (*on_read)(uint8_t* data, size_t max));
+
+/**
+ * @brief Transmit the points of a history query over BLE
+ *
+ * Notify the points in chunks, little endian: chunk sequence (u8), points in the chunk
+ * (u8), then ts (u32) and value (i16, 0.1 units for temperature and humidity) of each
+ * point. The last notification has 0 points, followed by the number of points sent (u16)
+ * and the newest stored timestamp (u32).
+ *
+ * @param p pointer to the points
+ * @param count number of points
+ * @param last_ts newest timestamp of the history
+ *
+ * @return void
+ */
+void ble_transmit_history(const DsPoint_t* p, uint16_t count, uint32_t last_ts);
+
+/**
+ * @brief Set the handler of the history characteristic
+ *
+ * on_write receives every write of the history characteristic (called from the BLE
+ * stack task), a HistoryQuery_t.
+ *
+ * @param on_write function called with the written bytes, returns true if accepted
+ *
+ * @return void
+ */
+void ble_set_history_handler(bool (*on_write)(const uint8_t* data, size_t len));
+
+/**
+ * @brief Set the handler of the time characteristic
+ *
+ * on_write receives every write of the time characteristic (called from the BLE stack
+ * task), the wall clock of the client.
+ *
+ * @param on_write function called with the written bytes, returns true if accepted
+ *
+ * @return void
+ */
+void ble_set_time_handler(bool (*on_write)(const uint8_t* data, size_t len));
+
+/**
+ * @brief Get the number of connected centrals
+ *
+ * @param NO PARAMETERS
+ *
+ * @return uint8_t connected centrals, up to BLE_MAX_CENTRALS
+ */
+uint8_t ble_get_centrals();
+
+/**
+ * @brief Get the notification counters
+ *
+ * Counted since boot from the status reported by the BLE stack for each central: a
+ * notification is sent when queued for the radio, dropped when the stack refuses it
+ * (ERROR_GATT, TX buffers full on a congested link).
+ *
+ * @param sent pointer to the notifications sent
+ * @param dropped pointer to the notifications dropped
+ *
+ * @return void
+ */
+void ble_get_notify_stats(uint32_t* sent, uint32_t* dropped);
 
 
 #endif
@@ -0,0 +1,47 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file flash_hal.h
+ * @brief this file contain the functions prototype to create an abstract interface
+ * to access a raw data partition of the SPI flash
+ *
+ * The partition is described by partitions.csv (type data, subtype TSDB_PARTITION_SUBTYPE).
+ *
+ * The following functions will be implemented:
+ * - flash_init() to find the partition and fill the Flash_t access functions
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __FLASH_HAL_H__
+#define __FLASH_HAL_H__
+
+#include "common.h"
+#include "esp_partition.h"
+#include "tsdb.h"
+
+#define TSDB_PARTITION_LABEL "tsdb" // label in partitions.csv
+#define TSDB_PARTITION_SUBTYPE 0x40 // first custom data subtype
+
+/**
+ * @brief Initialize flash partition access
+ *
+ * Find the data partition with the given label and set sector size, sector count and
+ * the read/write/erase functions of the Flash_t struct.
+ *
+ * @param f Flash_t struct pointer
+ * @param label partition label
+ *
+ * @return bool true if the partition has been found, false otherwise
+ */
+bool flash_init(Flash_t* f, const char* label);
+
+#endif /* __FLASH_HAL_H__ */
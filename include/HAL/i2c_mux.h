@@ -0,0 +1,112 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file i2c_mux.h
+ * @brief this file contain the functions prototype to read sensors behind a TCA9548A
+ * I2C multiplexer
+ *
+ * Up to two BMP280 (0x76, 0x77) can sit on each of the 8 downstream channels. Reads are
+ * grouped by mux channel: the read plan is sorted by channel and starts from the channel
+ * already selected, so a full read costs one channel switch per used channel at most.
+ * Every sensor keeps its read latency (switch excluded). A sensor that fails
+ * I2CMUX_MAX_ERRORS reads in a row has no value (NAN) until it answers again: an old
+ * reading is not passed on as the current one.
+ *
+ * The bus is accessed through I2cBus_t and this file has no dependency on Arduino, so it
+ * can be run on the host by the fake bus in tools/i2cmux_fake.
+ *
+ * The following functions will be implemented:
+ * - i2cmux_init() to initialize the sensor table
+ * - i2cmux_add() to add a sensor and rebuild the read plan
+ * - i2cmux_read_all() to read all sensors grouped by mux channel
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __I2C_MUX_H__
+#define __I2C_MUX_H__
+
+#include <stdint.h>
+
+#define I2CMUX_CHANNELS 8 // downstream channels of a TCA9548A
+#define I2CMUX_MAX_SENSORS 16 // two BMP280 addresses per channel
+#define I2CMUX_NONE 0xFF // sensor directly on the bus / no channel selected
+#ifndef I2CMUX_MAX_ERRORS
+#define I2CMUX_MAX_ERRORS 3 // consecutive failed reads before the value is dropped
+#endif
+
+typedef struct I2cBus_s
+{
+  bool      (*select)(struct I2cBus_s* bus, uint8_t mux_ch); // write the mux control register
+  bool      (*read)(struct I2cBus_s* bus, uint8_t sensor, float* value); // read a sensor of the selected channel
+  uint32_t  (*now_us)(struct I2cBus_s* bus);
+  void*     ctx; // backend data
+}I2cBus_t;
+
+typedef struct
+{
+  uint8_t   mux_ch; // mux channel, I2CMUX_NONE if directly on the bus
+  uint8_t   addr; // I2C address
+  float     value; // last value read, NAN if never read or after I2CMUX_MAX_ERRORS failed reads in a row
+  uint32_t  reads; // successful reads
+  uint32_t  errors; // failed reads
+  uint8_t   fails; // consecutive failed reads
+  uint32_t  last_us; // latency of the last read
+  uint32_t  max_us; // worst latency
+  uint64_t  sum_us; // total latency of successful reads
+}I2cSensor_t;
+
+typedef struct
+{
+  uint8_t       count; // sensors in the table
+  I2cSensor_t   sensor[I2CMUX_MAX_SENSORS];
+  uint8_t       plan[I2CMUX_MAX_SENSORS]; // sensor indexes sorted by mux channel
+  uint8_t       current; // selected mux channel
+  uint32_t      switches; // channel switches
+}I2cMux_t;
+
+/**
+ * @brief Initialize sensor table
+ *
+ * @param m I2cMux_t struct pointer
+ *
+ * @return void
+ */
+void i2cmux_init(I2cMux_t* m);
+
+/**
+ * @brief Add a sensor
+ *
+ * Add a sensor to the table and insert it in the read plan.
+ *
+ * @param m I2cMux_t struct pointer
+ * @param mux_ch mux channel of the sensor, I2CMUX_NONE if directly on the bus
+ * @param addr I2C address of the sensor
+ *
+ * @return int8_t sensor index, -1 if the table is full or the sensor already exists
+ */
+int8_t i2cmux_add(I2cMux_t* m, uint8_t mux_ch, uint8_t addr);
+
+/**
+ * @brief Read all sensors
+ *
+ * Follow the read plan from the group of the selected channel, switch channel only when
+ * the next sensor is on another one. A failed switch skips the sensors of the channel.
+ * The value of a sensor is set to NAN at its I2CMUX_MAX_ERRORS-th failed read in a row.
+ *
+ * @param m I2cMux_t struct pointer
+ * @param bus I2cBus_t struct pointer
+ *
+ * @return uint8_t number of sensors read successfully
+ */
+uint8_t i2cmux_read_all(I2cMux_t* m, I2cBus_t* bus);
+
+#endif /* __I2C_MUX_H__ */
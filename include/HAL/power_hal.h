@@ -0,0 +1,141 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file power_hal.h
+ * @brief this file contain the functions prototype to create an abstract interface
+ * to manage power management (automatic light sleep and dynamic frequency scaling)
+ *
+ * The following functions will be implemented:
+ * - power_init() to configure esp_pm and create the PM locks
+ * - power_lock_acquire() to hold the CPU at max frequency around active work
+ * - power_lock_release() to release the CPU frequency lock
+ * - power_delay_until() to sleep a task until its next period or a notification
+ * - power_print() to print time spent at each CPU frequency and wake-up latency
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __POWER_HAL_H__
+#define __POWER_HAL_H__
+
+#include "common.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+
+#ifndef POWER_SAVE
+#define POWER_SAVE 1 // 1 enable automatic light sleep and DFS, 0 keep CPU at max frequency
+#endif
+
+#define PM_CPU_FREQ_MAX 240 // MHz, used while a PM lock is held
+#define PM_CPU_FREQ_MIN 80  // MHz, used when no PM lock is held (APB stays at 80 MHz)
+
+#define NUM_PM_LOCKS 3 // number of PM locks
+#define PM_LOCK_ADC_ch 0 // lock taken around ADC bursts
+#define PM_LOCK_I2C_ch 1 // lock taken around I2C transactions
+#define PM_LOCK_BLE_ch 2 // lock taken around BLE events
+
+typedef struct
+{
+  const char*           name; // lock name shown by esp_pm_dump_locks()
+  bool                  status; // true if lock has been created
+  esp_pm_lock_handle_t  handle;
+  uint8_t               depth; // nesting level of the lock
+  uint32_t              count; // number of acquisitions
+  int64_t               since_us; // timestamp of the outermost acquisition
+  uint64_t              held_us; // total time the lock has been held
+}Power_t;
+
+typedef struct
+{
+  bool      pm_enabled; // true if esp_pm_configure() succeeded
+  uint8_t   active_locks; // number of locks currently held
+  int64_t   boot_us; // timestamp of power_init()
+  int64_t   max_since_us; // timestamp of the last transition to max frequency
+  uint64_t  max_freq_us; // total time a lock of this firmware has been held
+  uint32_t  wake_count; // number of measured wake-ups
+  uint32_t  wake_latency_max_us; // worst wake-up latency
+  uint64_t  wake_latency_sum_us; // sum of wake-up latencies
+}PowerStats_t;
+
+/**
+ * @brief Initialize power management
+ *
+ * Configure esp_pm for DFS and automatic light sleep (if POWER_SAVE is enabled)
+ * and create one CPU frequency lock for each channel of the power array.
+ *
+ * @param p Power_t struct pointer to an n-element lock array
+ * @param size 8-bit value that indicate number of locks
+ *
+ * @return void
+ */
+void power_init(Power_t* p, uint8_t size);
+
+/**
+ * @brief Acquire a PM lock
+ *
+ * Keep the CPU at PM_CPU_FREQ_MAX and prevent light sleep until the lock is released.
+ * Calls can be nested, the lock is released on the last power_lock_release().
+ *
+ * @param p Power_t struct pointer to an n-element lock array
+ * @param channel 8-bit value that indicate channel of lock array
+ * @param size 8-bit value that indicate number of locks
+ *
+ * @return void
+ */
+void power_lock_acquire(Power_t* p, uint8_t channel, uint8_t size);
+
+/**
+ * @brief Release a PM lock
+ *
+ * Release the lock taken by power_lock_acquire() and account the time it was held.
+ *
+ * @param p Power_t struct pointer to an n-element lock array
+ * @param channel 8-bit value that indicate channel of lock array
+ * @param size 8-bit value that indicate number of locks
+ *
+ * @return void
+ */
+void power_lock_release(Power_t* p, uint8_t channel, uint8_t size);
+
+/**
+ * @brief Delay a task until the next period or a notification
+ *
+ * Same period as vTaskDelayUntil(), but the task also wakes on a notification
+ * (xTaskNotifyGive), and the next period then starts from that wake-up. At the end of
+ * the period the latency between the expected wake-up time and the time the task
+ * actually runs again is added to the power statistics, including the tick phase
+ * error (up to one tick). An early wake-up has no expected time and is not measured.
+ *
+ * @param last_wake pointer to the last wake time in ticks, updated
+ * @param interval period in ticks, upper bound of the wait
+ *
+ * @return bool true if woken by a notification, false at the end of the period
+ */
+bool power_delay_until(TickType_t* last_wake, TickType_t interval);
+
+/**
+ * @brief Print power statistics
+ *
+ * Print time spent at each CPU frequency, average/max wake-up latency and
+ * the time every lock has been held.
+ * The time at PM_CPU_FREQ_MAX is inferred from the locks of this firmware only (the
+ * locks of the BLE stack and of the drivers are not seen), the rest of the uptime is
+ * reported as one bucket: running at PM_CPU_FREQ_MIN and light sleep are not split.
+ * The report header says so.
+ *
+ * @param p Power_t struct pointer to an n-element lock array
+ * @param size 8-bit value that indicate number of locks
+ *
+ * @return void
+ */
+void power_print(Power_t* p, uint8_t size);
+
+#endif /* __POWER_HAL_H__ */
@@ -28,7 +28,7 @@
 
 #include "common.h"
 
-#define NUM_TASKS 2 // number of tasks
+#define NUM_TASKS 3 // number of tasks
 
 typedef struct
 {
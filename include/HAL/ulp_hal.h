@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file ulp_hal.h
+ * @brief this file contain the functions prototype to create an abstract interface
+ * to sample the humidity channel with the ULP coprocessor while main cores sleep
+ *
+ * The ULP program samples HUMIDITY_1_pin every ULP_PERIOD_US, applies the spike rule and
+ * the FIFO average of analog_hal and stores the averages in a batch. Main cores are woken
+ * only when the batch is full or the average crosses ULP_TH_HIGH / ULP_TH_LOW: the wake-up
+ * notifies Task1, waiting in power_delay_until(), so it runs at that wake-up instead of at
+ * the end of its period, and pushes the batch in the statistics and the history (smartplant.h).
+ * The ULP does not wake cores that are already awake: a crossing while Task1 runs or while
+ * another task keeps the cores awake is read at the end of the period.
+ *
+ * The following functions will be implemented:
+ * - ulp_humidity_init() to load and start the ULP program
+ * - ulp_humidity_set_notify() to notify a task when the ULP wakes the main cores
+ * - ulp_humidity_media() to get the last average computed by the ULP
+ * - ulp_humidity_read_batch() to drain the batch of averages
+ * - ulp_humidity_wake_reason() to read and clear the wake reason bits
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __ULP_HAL_H__
+#define __ULP_HAL_H__
+
+#include "common.h"
+#include "HAL/ulp_model.h"
+
+#ifndef ULP_HUMIDITY
+#define ULP_HUMIDITY 0 // 1 sample humidity with the ULP instead of analogRead()
+#endif
+
+#define ULP_ADC_CHANNEL 4 // ADC1 channel of HUMIDITY_1_pin (GPIO32)
+#define ULP_PERIOD_US 100000 // ULP sampling period
+#define ULP_PROG_START 128 // word offset of the program in RTC slow memory
+#define ULP_TH_HIGH ((4095 * 80) / 100) // wake up above 80% humidity
+#define ULP_TH_LOW ((4095 * 20) / 100) // wake up below 20% humidity
+
+/**
+ * @brief Initialize ULP humidity sampling
+ *
+ * Configure ADC1 for the ULP, load the program in RTC slow memory, enable ULP wake-up
+ * and start the ULP timer.
+ *
+ * @param range accepted distance between two consecutive samples in ADC bits
+ * @param limit number of consecutive spikes accepted as a real change
+ *
+ * @return bool true if the program has been loaded and started, false otherwise
+ */
+bool ulp_humidity_init(uint16_t range, uint16_t limit);
+
+/**
+ * @brief Set task to notify on ULP wake-up
+ *
+ * The task receives a notification (xTaskNotifyGive) every time the ULP wakes main cores.
+ *
+ * @param task handle of the task to notify, NULL to disable
+ *
+ * @return void
+ */
+void ulp_humidity_set_notify(TaskHandle_t task);
+
+/**
+ * @brief Get last average
+ *
+ * @param NO PARAMETERS
+ *
+ * @return uint16_t last FIFO average computed by the ULP in ADC bits
+ */
+uint16_t ulp_humidity_media();
+
+/**
+ * @brief Drain batch of averages
+ *
+ * Copy the averages stored by the ULP and reset the batch.
+ *
+ * @param out pointer to the destination buffer
+ * @param max 8-bit value that indicate size of destination buffer
+ *
+ * @return uint8_t number of averages copied
+ */
+uint8_t ulp_humidity_read_batch(uint16_t* out, uint8_t max);
+
+/**
+ * @brief Read and clear wake reason
+ *
+ * @param NO PARAMETERS
+ *
+ * @return uint16_t wake reason bits (ULP_WAKE_BATCH, ULP_WAKE_THRESHOLD)
+ */
+uint16_t ulp_humidity_wake_reason();
+
+#endif /* __ULP_HAL_H__ */
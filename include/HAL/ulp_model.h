@@ -0,0 +1,94 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file ulp_model.h
+ * @brief this file contain the shared memory layout of the ULP humidity program
+ * and the prototype of its reference model
+ *
+ * The ULP program (ulp_hal.cpp) and the reference model (ulp_model.cpp) work on the same
+ * 16-bit word layout in RTC slow memory. The model has no dependency on Arduino, so it
+ * can be built on the host by the simulator in tools/ulp_sim.
+ *
+ * The following functions will be implemented:
+ * - ulp_model_init() to initialize the shared memory words
+ * - ulp_model_step() to run one ULP wake-up on a new raw sample
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __ULP_MODEL_H__
+#define __ULP_MODEL_H__
+
+#include <stdint.h>
+
+#define ULP_FIFO_SIZE 4 // samples averaged by the ULP, must be a power of two
+#define ULP_FIFO_SHIFT 2 // log2(ULP_FIFO_SIZE)
+#define ULP_BATCH_SIZE 32 // averaged samples stored before waking the main cores
+
+#define ULP_WAKE_NONE 0x00
+#define ULP_WAKE_BATCH 0x01 // batch buffer is full
+#define ULP_WAKE_THRESHOLD 0x02 // average crossed the high or low threshold
+
+#define ULP_ZONE_NORMAL 0
+#define ULP_ZONE_HIGH 1
+#define ULP_ZONE_LOW 2
+
+// word offsets in RTC slow memory shared by ULP and main cores
+enum {
+  ULP_VAR_RAW = 0, // last raw sample
+  ULP_VAR_LAST, // last accepted sample
+  ULP_VAR_COUNT, // number of samples in the FIFO (0 or ULP_FIFO_SIZE)
+  ULP_VAR_INDEX, // FIFO write index
+  ULP_VAR_SPIKE, // consecutive out of range samples
+  ULP_VAR_MEDIA, // average of the FIFO
+  ULP_VAR_ZONE, // threshold zone of the last average
+  ULP_VAR_RANGE, // accepted distance from the last sample
+  ULP_VAR_LIMIT, // spikes accepted as a real change
+  ULP_VAR_TH_HIGH, // wake-up threshold above
+  ULP_VAR_TH_LOW, // wake-up threshold below
+  ULP_VAR_BATCH_N, // number of averages in the batch
+  ULP_VAR_WAKE, // wake reason bits
+  ULP_VAR_SAMPLES, // total ADC conversions (wraps at 16 bits)
+  ULP_VAR_FIFO, // ULP_FIFO_SIZE words
+  ULP_VAR_BATCH = ULP_VAR_FIFO + ULP_FIFO_SIZE, // ULP_BATCH_SIZE words
+  ULP_VAR_WORDS = ULP_VAR_BATCH + ULP_BATCH_SIZE
+};
+
+/**
+ * @brief Initialize shared memory
+ *
+ * Clear the shared words and set the spike rule and the wake-up thresholds.
+ *
+ * @param mem pointer to ULP_VAR_WORDS 16-bit words
+ * @param range accepted distance between two consecutive samples in ADC bits
+ * @param limit number of consecutive spikes accepted as a real change
+ * @param th_high wake-up threshold above in ADC bits
+ * @param th_low wake-up threshold below in ADC bits
+ *
+ * @return void
+ */
+void ulp_model_init(uint16_t* mem, uint16_t range, uint16_t limit, uint16_t th_high, uint16_t th_low);
+
+/**
+ * @brief Run one ULP wake-up
+ *
+ * Apply the same rules of the ULP program to a new raw sample: spike rejection,
+ * FIFO average, batch store and threshold crossing.
+ * The FIFO is prefilled with the first sample so the average is always defined.
+ *
+ * @param mem pointer to ULP_VAR_WORDS 16-bit words
+ * @param raw 12-bit raw ADC sample
+ *
+ * @return uint16_t wake reason bits (ULP_WAKE_NONE if main cores keep sleeping)
+ */
+uint16_t ulp_model_step(uint16_t* mem, uint16_t raw);
+
+#endif /* __ULP_MODEL_H__ */
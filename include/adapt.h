@@ -0,0 +1,142 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file adapt.h
+ * @brief this file contain the functions prototype of the adaptive sampling controller
+ *
+ * The controller picks the next sampling interval from the readings of all points
+ * (a point is one field of one plant, values laid out field by field):
+ * - the slope of each point follows a rise at once and decays slowly (fast attack, slow
+ *   release), the interval is the time the point takes to move by one resolution step
+ * - a point inside the guard band of an alarm threshold is sampled at the minimum
+ *   interval, outside the band the interval is bounded by the time to reach the band
+ * - the interval is the minimum over all points, it drops at once and grows by at most
+ *   the growth factor per sample, between min_ms and max_ms
+ * This file has no dependency on Arduino so it can be built on the host.
+ *
+ * The following functions will be implemented:
+ * - adapt_init() to set the interval bounds and reset the controller
+ * - adapt_set_field() to set resolution and guard band of a field
+ * - adapt_add_threshold() to add an alarm threshold of a field
+ * - adapt_update() to feed the readings and get the next interval
+ * - adapt_set_bounds() to change the interval bounds
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __ADAPT_H__
+#define __ADAPT_H__
+
+#include <stdint.h>
+
+#define ADAPT_MAX_FIELDS 4 // fields per plant
+#define ADAPT_MAX_THRESHOLDS 4 // alarm thresholds per field
+#ifndef ADAPT_MAX_POINTS
+#define ADAPT_MAX_POINTS 96 // fields x plants
+#endif
+#define ADAPT_RELEASE 0.3f // slope decay towards a lower reading per sample
+
+typedef struct
+{
+  float     resolution; // change worth a sample, above the sensor noise
+  float     guard; // distance from a threshold sampled at min_ms
+  uint8_t   thr_count;
+  float     thr[ADAPT_MAX_THRESHOLDS];
+}AdaptField_t;
+
+typedef struct
+{
+  uint32_t  cycles; // samples taken
+  uint32_t  skipped; // samples a fixed min_ms rate would have taken in addition
+  uint32_t  elapsed_ms; // time covered by the samples
+}AdaptStats_t;
+
+typedef struct
+{
+  uint32_t      min_ms; // fastest interval
+  uint32_t      max_ms; // slowest interval
+  float         growth; // maximum interval ratio between two samples
+  uint8_t       fields;
+  AdaptField_t  field[ADAPT_MAX_FIELDS];
+  uint32_t      interval_ms; // last interval returned
+  uint32_t      last_ms; // time of the last sample
+  bool          has_last;
+  float         last[ADAPT_MAX_POINTS]; // last reading of each point
+  float         slope[ADAPT_MAX_POINTS]; // units per ms
+  AdaptStats_t  stats;
+}Adapt_t;
+
+/**
+ * @brief Initialize the controller
+ *
+ * All fields start with resolution 1, no guard band and no threshold.
+ *
+ * @param a Adapt_t struct pointer
+ * @param fields 8-bit value that indicate fields per plant (at most ADAPT_MAX_FIELDS)
+ * @param min_ms fastest interval in milliseconds
+ * @param max_ms slowest interval in milliseconds
+ * @param growth maximum interval ratio between two samples (above 1)
+ *
+ * @return bool true if the parameters are valid, false otherwise
+ */
+bool adapt_init(Adapt_t* a, uint8_t fields, uint32_t min_ms, uint32_t max_ms, float growth);
+
+/**
+ * @brief Set resolution and guard band of a field
+ *
+ * The thresholds of the field are removed.
+ *
+ * @param a Adapt_t struct pointer
+ * @param field 8-bit value that indicate field
+ * @param resolution change worth a sample (above 0)
+ * @param guard distance from a threshold sampled at min_ms
+ *
+ * @return bool true if the parameters are valid, false otherwise
+ */
+bool adapt_set_field(Adapt_t* a, uint8_t field, float resolution, float guard);
+
+/**
+ * @brief Add an alarm threshold of a field
+ *
+ * @param a Adapt_t struct pointer
+ * @param field 8-bit value that indicate field
+ * @param thr threshold value
+ *
+ * @return bool true if the threshold is added, false if the field is full or invalid
+ */
+bool adapt_add_threshold(Adapt_t* a, uint8_t field, float thr);
+
+/**
+ * @brief Feed the readings and get the next interval
+ *
+ * @param a Adapt_t struct pointer
+ * @param value readings, value[field * channels + channel]
+ * @param channels 8-bit value that indicate number of plants
+ * @param now_ms time of the readings in milliseconds
+ *
+ * @return uint32_t next sampling interval in milliseconds
+ */
+uint32_t adapt_update(Adapt_t* a, const float* value, uint8_t channels, uint32_t now_ms);
+
+/**
+ * @brief Change the interval bounds
+ *
+ * Slopes and statistics are kept, the next interval is clamped to the new bounds.
+ *
+ * @param a Adapt_t struct pointer
+ * @param min_ms fastest interval in milliseconds
+ * @param max_ms slowest interval in milliseconds
+ *
+ * @return bool true if the bounds are valid, false otherwise
+ */
+bool adapt_set_bounds(Adapt_t* a, uint32_t min_ms, uint32_t max_ms);
+
+#endif /* __ADAPT_H__ */
@@ -0,0 +1,142 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file alarm.h
+ * @brief this file contain the functions prototype of the rule-based alarm engine
+ *
+ * Alarms are described by a flat table of rules evaluated in postfix order:
+ * - ALARM_OP_COND compares a field with a threshold and pushes the result. The condition
+ *   turns on when the comparison holds for min_s seconds and turns off only when the
+ *   value goes back past threshold -/+ hysteresis
+ * - ALARM_OP_AND, ALARM_OP_OR, ALARM_OP_NOT combine the results on the stack
+ * - ALARM_OP_RAISE pops a result and sets alarm bit id
+ *
+ * A table is validated once (alarm_compile), evaluation is one pass over the table per
+ * plant with a fixed size stack: O(rules), no allocation. The table is built from
+ * ALARM_RULES (alarm_rules.h) or loaded from NVS. This file has no dependency on Arduino.
+ *
+ * The following functions will be implemented:
+ * - alarm_compile() to validate a rule table and copy it in the flat array
+ * - alarm_reset() to reset the alarm state of plants
+ * - alarm_eval() to evaluate the rules for a plant
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __ALARM_H__
+#define __ALARM_H__
+
+#include <stdint.h>
+
+#define ALARM_MAX_RULES 16 // rules in a table
+#define ALARM_MAX_STACK 8 // depth of the evaluation stack
+#define ALARM_MAX_IDS 8 // alarm bits
+
+typedef enum {
+  ALARM_FIELD_TEMPERATURE = 0, // Celsius
+  ALARM_FIELD_HUMIDITY, // percent
+  ALARM_FIELD_SOLAR, // solar sensor status (1 low light, 0 high light)
+  ALARM_NUM_FIELDS
+}AlarmField_t;
+
+typedef enum {
+  ALARM_OP_COND = 0,
+  ALARM_OP_AND,
+  ALARM_OP_OR,
+  ALARM_OP_NOT,
+  ALARM_OP_RAISE
+}AlarmOp_t;
+
+typedef enum {
+  ALARM_CMP_GT = 0, // value > threshold, off below threshold - hysteresis
+  ALARM_CMP_LT // value < threshold, off above threshold + hysteresis
+}AlarmCmp_t;
+
+typedef struct
+{
+  uint8_t   op; // AlarmOp_t
+  uint8_t   field; // AlarmField_t (COND)
+  uint8_t   cmp; // AlarmCmp_t (COND)
+  uint8_t   id; // alarm bit (RAISE)
+  float     threshold; // (COND)
+  float     hysteresis; // (COND)
+  uint16_t  min_s; // seconds the comparison must hold before turning on (COND)
+  uint16_t  reserved;
+}AlarmRule_t;
+
+static_assert(sizeof(AlarmRule_t) == 16, "AlarmRule_t is stored in NVS");
+
+#define ALARM_COND(field, cmp, threshold, hysteresis, min_s) \
+  { ALARM_OP_COND, field, cmp, 0, threshold, hysteresis, min_s, 0 }
+#define ALARM_AND() { ALARM_OP_AND, 0, 0, 0, 0.0f, 0.0f, 0, 0 }
+#define ALARM_OR() { ALARM_OP_OR, 0, 0, 0, 0.0f, 0.0f, 0, 0 }
+#define ALARM_NOT() { ALARM_OP_NOT, 0, 0, 0, 0.0f, 0.0f, 0, 0 }
+#define ALARM_RAISE(id) { ALARM_OP_RAISE, 0, 0, id, 0.0f, 0.0f, 0, 0 }
+
+typedef struct
+{
+  uint8_t       count; // rules in the table
+  AlarmRule_t   rule[ALARM_MAX_RULES];
+}AlarmTable_t;
+
+typedef struct
+{
+  uint32_t  since_ms; // time the comparison started to hold
+  uint8_t   raw; // comparison holds (with hysteresis)
+  uint8_t   active; // condition on (raw for min_s)
+}AlarmCond_t;
+
+typedef struct
+{
+  AlarmCond_t   cond[ALARM_MAX_RULES]; // state of the COND rules
+  uint8_t       mask; // alarm bits of the last evaluation
+}AlarmPlant_t;
+
+/**
+ * @brief Compile a rule table
+ *
+ * Check operators, fields, ids and stack balance, then copy the rules in the table.
+ * The table is left unchanged if the rules are not valid.
+ *
+ * @param t AlarmTable_t struct pointer
+ * @param rules pointer to the rules
+ * @param count number of rules
+ *
+ * @return bool true if the rules are valid, false otherwise
+ */
+bool alarm_compile(AlarmTable_t* t, const AlarmRule_t* rules, uint8_t count);
+
+/**
+ * @brief Reset alarm state
+ *
+ * @param p AlarmPlant_t struct pointer
+ * @param size 8-bit value that indicate number of plants
+ *
+ * @return void
+ */
+void alarm_reset(AlarmPlant_t* p, uint8_t size);
+
+/**
+ * @brief Evaluate rules for a specific plant
+ *
+ * @param t AlarmTable_t struct pointer
+ * @param p AlarmPlant_t struct pointer
+ * @param channel 8-bit value that indicate channel of the plant
+ * @param size 8-bit value that indicate number of plants
+ * @param value field values of the plant, indexed by AlarmField_t
+ * @param now_ms timestamp of the values in milliseconds
+ *
+ * @return uint8_t alarm bits of the plant
+ */
+uint8_t alarm_eval(const AlarmTable_t* t, AlarmPlant_t* p, uint8_t channel, uint8_t size,
+                   const float* value, uint32_t now_ms);
+
+#endif /* __ALARM_H__ */
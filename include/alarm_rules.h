@@ -0,0 +1,41 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file alarm_rules.h
+ * @brief this file contain the default alarm rule table
+ *
+ * The table is compiled in the firmware and used when NVS holds no valid table.
+ * Rules are in postfix order, see alarm.h.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __ALARM_RULES_H__
+#define __ALARM_RULES_H__
+
+#include "alarm.h"
+
+#define ALARM_HOT 0 // alarm bit: temperature too high
+#define ALARM_COLD 1 // alarm bit: temperature too low
+#define ALARM_DRY 2 // alarm bit: dry sand in full sun
+
+#define ALARM_RULES { \
+  ALARM_COND(ALARM_FIELD_TEMPERATURE, ALARM_CMP_GT, 30.0f, 0.5f, 5), \
+  ALARM_RAISE(ALARM_HOT), \
+  ALARM_COND(ALARM_FIELD_TEMPERATURE, ALARM_CMP_LT, 5.0f, 0.5f, 5), \
+  ALARM_RAISE(ALARM_COLD), \
+  ALARM_COND(ALARM_FIELD_HUMIDITY, ALARM_CMP_LT, 20.0f, 2.0f, 60), \
+  ALARM_COND(ALARM_FIELD_SOLAR, ALARM_CMP_LT, 0.5f, 0.0f, 60), \
+  ALARM_AND(), \
+  ALARM_RAISE(ALARM_DRY) \
+}
+
+#endif /* __ALARM_RULES_H__ */
@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file bench.h
+ * @brief this file contain the functions prototype of the microbenchmark suite
+ *
+ * Each case calls one HAL function or pipeline stage in a loop and counts the CPU cycles
+ * (CCOUNT register through ESP.getCycleCount()). A result is the cost of a batch of calls
+ * (calls column), sized so that every result is a few hundred cycles at least: rounding
+ * and timer resolution stay small against it. A case is run BENCH_REPEAT times, the
+ * minimum is the cost without interrupts, the average shows their weight.
+ * The first case (BENCH_REFERENCE) is a fixed busy loop with no firmware code: it
+ * measures the machine, the host runner scales the baseline with it.
+ * The suite runs on the board (build with BENCH_MODE=1, see [env:bench] in platformio.ini,
+ * results at boot before the tasks start) and on the host with the fakes of the native
+ * build (tools/pipeline_bench, which also compares a run with a stored baseline).
+ * Buffer size and plant count are build flags (BUFFER_SIZE, NUM_PLANTS): each build
+ * reports the values it was built with.
+ *
+ * Results are printed one per line, CSV prefixed with "bench," so they can be picked
+ * out of the Serial log:
+ *   bench,name,plants,buffer,calls,iterations,cycles_min,cycles_avg,ns_min
+ *
+ * The following functions will be implemented:
+ * - bench_run() to run the suite
+ * - bench_print() to print the results
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include "Arduino.h"
+#include "smartplant.h"
+
+#ifndef BENCH_MODE
+#define BENCH_MODE 0 // 1 run the microbenchmark suite at boot, before the tasks start
+#endif
+
+#define BENCH_REPEAT 5 // runs of each case
+#define BENCH_MAX_RESULTS 32 // cases of the suite
+#define BENCH_PREFIX "bench" // first CSV column of every result line
+#define BENCH_REFERENCE "reference" // name of the busy loop case
+
+typedef struct
+{
+  const char* name; // function or stage under test
+  uint16_t  plants; // NUM_PLANTS of the build
+  uint16_t  buffer; // BUFFER_SIZE of the build
+  uint32_t  calls; // calls per result
+  uint32_t  iterations; // results per run
+  uint32_t  cycles_min; // cycles per result, best run
+  uint32_t  cycles_avg; // cycles per result, average of the runs
+  uint32_t  ns_min; // result of the best run in nanoseconds at the current CPU frequency
+}BenchResult_t;
+
+/**
+ * @brief Run the suite
+ *
+ * Peripherals, plant state, alarm rules and configuration must be initialized (the suite
+ * runs the real pipeline). The plant state is left as after some sampling cycles.
+ *
+ * @param sm SmartPlant_t struct pointer
+ * @param size 8-bit value that indicate number of plants
+ * @param out pointer to the result array
+ * @param max size of the result array
+ *
+ * @return uint8_t number of results
+ */
+uint8_t bench_run(SmartPlant_t* sm, uint8_t size, BenchResult_t* out, uint8_t max);
+
+/**
+ * @brief Print the results
+ *
+ * Print the CSV header and one line per result on Serial.
+ *
+ * @param r pointer to the result array
+ * @param count number of results
+ *
+ * @return void
+ */
+void bench_print(const BenchResult_t* r, uint8_t count);
+
+#endif /* __BENCH_H__ */
@@ -0,0 +1,160 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file boot.h
+ * @brief this file contain the functions prototype of the boot sequence and degraded mode
+ *
+ * The BLE stack bring-up (hundreds of ms, independent of the I2C bus) runs in a task on
+ * core 0 while setup() probes the I2C devices and mounts NVS and flash on core 1; the
+ * firmware tasks start once both are done.
+ * A device that does not answer at boot (BMP280 sensors, OLED) does not stop the node: it
+ * runs in degraded mode (no temperature or no display, the other fields are sampled and
+ * sent) and Task1 probes the missing device again between two cycles, with a backoff
+ * from BOOT_RETRY_MIN_MS to BOOT_RETRY_MAX_MS. Retries run in Task1, the only task using
+ * the I2C bus, so a probe never interleaves with a sensor read.
+ * Time to first sample (reset to end of the first Task1 cycle) and the boot phases are
+ * logged after the first cycle.
+ *
+ * The following functions will be implemented:
+ * - boot_start_async() to run a start function on the other core
+ * - boot_wait_async() to wait for the start function
+ * - boot_device() to start a device that may be missing
+ * - boot_ready() to know if a device is running
+ * - boot_missing() to get the missing devices
+ * - boot_retry() to probe the missing devices again
+ * - boot_first_sample() to report the time to first sample
+ * - boot_get_times() to get the duration of the boot phases
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __BOOT_H__
+#define __BOOT_H__
+
+#include "common.h"
+
+// devices started with boot_device()
+#define BOOT_DEV_TEMPERATURE 0 // BMP280 sensors
+#define BOOT_DEV_OLED 1
+#define NUM_BOOT_DEVICES 2
+
+#ifndef BOOT_RETRY_MIN_MS
+#define BOOT_RETRY_MIN_MS 5000 // first retry of a missing device
+#endif
+#define BOOT_RETRY_MAX_MS 300000 // backoff limit, doubled at every failed retry
+#define BOOT_TASK_CORE 0 // BLE controller core
+#define BOOT_TASK_PRIO 1
+#define BOOT_TASK_STACK 4096
+
+typedef struct
+{
+  const char* name; // printed at boot
+  bool      (*start)(); // probe and start the device, true if it answers
+  bool      ready; // started
+  uint32_t  retry_ms; // backoff of the next retry
+  uint32_t  next_ms; // millis() of the next retry
+  uint32_t  retries; // failed retries since boot
+}BootDevice_t;
+
+typedef struct
+{
+  uint32_t  async_us; // start function on the other core
+  uint32_t  devices_us; // boot_device() calls at boot
+  uint32_t  wait_us; // time boot_wait_async() blocked, 0 if fully overlapped
+  uint32_t  first_sample_us; // reset to end of the first Task1 cycle, 0 before
+}BootTimes_t;
+
+/**
+ * @brief Run a start function on the other core
+ *
+ * Create a task on BOOT_TASK_CORE running fn once. Only one start function at a time.
+ *
+ * @param fn function to run, e.g. ble_init()
+ *
+ * @return void
+ */
+void boot_start_async(void (*fn)());
+
+/**
+ * @brief Wait for the start function
+ *
+ * Block the caller until the function passed to boot_start_async() has returned.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void boot_wait_async();
+
+/**
+ * @brief Start a device that may be missing
+ *
+ * Call start once. If the device does not answer, it is retried by boot_retry().
+ *
+ * @param dev 8-bit value that indicate device (BOOT_DEV_x)
+ * @param name device name for the boot messages
+ * @param start function probing and starting the device, true if it answers
+ *
+ * @return bool true if the device is running
+ */
+bool boot_device(uint8_t dev, const char* name, bool (*start)());
+
+/**
+ * @brief Know if a device is running
+ *
+ * @param dev 8-bit value that indicate device (BOOT_DEV_x)
+ *
+ * @return bool true if started at boot or by a retry
+ */
+bool boot_ready(uint8_t dev);
+
+/**
+ * @brief Get the missing devices
+ *
+ * @param NO PARAMETERS
+ *
+ * @return uint8_t bit n set if device n is missing, 0 if the node is not degraded
+ */
+uint8_t boot_missing();
+
+/**
+ * @brief Probe the missing devices again
+ *
+ * Called by Task1 between two cycles: each missing device whose retry is due is started
+ * again, its backoff doubles if it still does not answer.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void boot_retry();
+
+/**
+ * @brief Report the time to first sample
+ *
+ * Called by Task1 at the end of each cycle, logs the boot phases after the first one.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void boot_first_sample();
+
+/**
+ * @brief Get the duration of the boot phases
+ *
+ * @param out BootTimes_t struct pointer
+ *
+ * @return void
+ */
+void boot_get_times(BootTimes_t* out);
+
+#endif /* __BOOT_H__ */
@@ -24,10 +24,23 @@
 #define SIZEOF(x)   (sizeof(x)/sizeof(x[0]))
 #endif
 
+#ifndef TELEMETRY_MODE
+#define TELEMETRY_MODE 0 // 1 binary framed telemetry on Serial (see telemetry.h), text output disabled
+#endif
+
+#if TELEMETRY_MODE
+#define DEBUG 0
+#else
 #define DEBUG 1
+#endif
 
 #if DEBUG
 #define DEBUG_PRINT(x,...) if (DEBUG) { Serial.printf("[%lu ms]" x , millis(), ##__VA_ARGS__); }
+#else
+#define DEBUG_PRINT(x,...) do { if (0) { Serial.printf("[%lu ms]" x , millis(), ##__VA_ARGS__); } } while (0) // arguments still referenced, compiled out
 #endif
 
+// deferred logger for hot paths, DEBUG_PRINT is kept for diagnostic dumps
+#include "dlog.h"
+
 #endif /* __COMMON_H__ */
\ No newline at end of file
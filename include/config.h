@@ -0,0 +1,164 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file config.h
+ * @brief this file contain the functions prototype of the runtime configuration
+ *
+ * Tunable parameters (sampling periods, spike filter, filter buffer length) live in a
+ * Config_t record cached in RAM and stored in NVS. A new record is written over the BLE
+ * config characteristic, validated, saved and applied by Task1 between two cycles: the
+ * sampling pipeline never waits on NVS and readers only dereference the cache.
+ * A BLE write wakes Task1 (config_set_notify()), so the new parameters and alarm rules
+ * apply within one Task1 cycle of the write, not at the end of the current interval.
+ *
+ * BLE write payload, first byte is the kind:
+ * - CONFIG_KIND_PARAMS followed by a Config_t (little endian)
+ * - CONFIG_KIND_ALARM_RULES followed by the rule count and the AlarmRule_t table
+ * A read returns the Config_t in use.
+ *
+ * The following functions will be implemented:
+ * - config_init() to load the configuration from NVS
+ * - config_get() to get the configuration in use
+ * - config_validate() to check a configuration
+ * - config_store() to save a configuration and schedule it
+ * - config_write() to handle a write of the BLE config characteristic
+ * - config_read() to fill the value of the BLE config characteristic
+ * - config_set_notify() to set the task woken by BLE writes
+ * - config_apply() to apply a scheduled configuration
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include "common.h"
+
+#define CONFIG_NVS_NAMESPACE "config" // Preferences namespace of the configuration
+#define CONFIG_VERSION 1 // layout of Config_t
+#define CONFIG_KIND_PARAMS 1
+#define CONFIG_KIND_ALARM_RULES 2
+
+// validation bounds
+#ifndef CONFIG_TASK1_MIN_MS
+#define CONFIG_TASK1_MIN_MS 100
+#endif
+#define CONFIG_TASK2_MIN_MS 500
+#define CONFIG_MAX_MS 60000 // TASK1 and TASK2 period
+#define CONFIG_SAMPLE_MAX_MS 600000 // slowest adaptive interval
+#define CONFIG_SPIKE_LIMIT_MAX 15
+#define CONFIG_UPLINK_MIN_S 5 // uplink publish interval
+#define CONFIG_UPLINK_MAX_S 3600
+
+typedef struct __attribute__((packed))
+{
+  uint8_t   version; // CONFIG_VERSION
+  uint8_t   buffer_len; // samples averaged by the analog filter, 1..BUFFER_SIZE
+  uint16_t  task1_ms; // sampling period, fastest interval with adaptive sampling
+  uint16_t  task2_ms; // BLE period
+  uint16_t  spike_range; // ADC bits between two samples above which a sample is a spike
+  uint32_t  sample_max_ms; // slowest adaptive interval
+  uint8_t   spike_limit; // consecutive spikes accepted as a real change
+  uint16_t  uplink_s; // Wi-Fi uplink publish interval, 0 for UPLINK_PUBLISH_S
+  uint8_t   reserved[1];
+}Config_t;
+
+static_assert(sizeof(Config_t) == 16, "Config_t is stored in NVS and sent over BLE");
+
+/**
+ * @brief Load the configuration
+ *
+ * Load the record stored in NVS, or the compile-time defaults if NVS holds no valid
+ * record, and apply it. Call after peripheral_init() and smartplant_init().
+ *
+ * @param NO PARAMETERS
+ *
+ * @return bool true if the configuration comes from NVS, false if defaults are used
+ */
+bool config_init();
+
+/**
+ * @brief Get the configuration in use
+ *
+ * @param NO PARAMETERS
+ *
+ * @return const Config_t* pointer to the cached configuration
+ */
+const Config_t* config_get();
+
+/**
+ * @brief Check a configuration
+ *
+ * @param c Config_t struct pointer
+ *
+ * @return bool true if every field is within its bounds, false otherwise
+ */
+bool config_validate(const Config_t* c);
+
+/**
+ * @brief Save a configuration and schedule it
+ *
+ * Validate the configuration and save it in NVS. Task1 applies it at the start of its
+ * next cycle, so this function can be called from any task. Task1 is not woken here,
+ * config_write() wakes it for BLE writes.
+ *
+ * @param c Config_t struct pointer
+ *
+ * @return bool true if the configuration is valid and saved, false otherwise
+ */
+bool config_store(const Config_t* c);
+
+/**
+ * @brief Handle a write of the BLE config characteristic
+ *
+ * A valid payload wakes the task set by config_set_notify() to apply it.
+ *
+ * @param data pointer to the written bytes
+ * @param len number of written bytes
+ *
+ * @return bool true if the payload is valid and stored, false otherwise
+ */
+bool config_write(const uint8_t* data, size_t len);
+
+/**
+ * @brief Fill the value of the BLE config characteristic
+ *
+ * @param data pointer to the buffer
+ * @param max size of the buffer
+ *
+ * @return size_t number of bytes written, 0 if the buffer is too small
+ */
+size_t config_read(uint8_t* data, size_t max);
+
+/**
+ * @brief Set the task woken by BLE writes
+ *
+ * The task receives a notification (xTaskNotifyGive) every time a valid payload is
+ * written, and must call config_apply().
+ *
+ * @param task handle of the task to notify, NULL to disable
+ *
+ * @return void
+ */
+void config_set_notify(TaskHandle_t task);
+
+/**
+ * @brief Apply a scheduled configuration
+ *
+ * Called by Task1 between two cycles. Does nothing if no configuration is pending.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void config_apply();
+
+#endif /* __CONFIG_H__ */
@@ -0,0 +1,157 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file dlog.h
+ * @brief this file contain the functions prototype of the deferred logger
+ *
+ * LOG_E/LOG_W/LOG_I/LOG_D push a format id and raw arguments in a lock-free ring of the
+ * calling core (no formatting, no UART access). A low-priority task drains the rings
+ * and formats the records, or sends them in binary form to tools/log_decode.
+ * Levels above LOG_LEVEL compile to nothing (the arguments stay referenced, no unused warnings).
+ *
+ * The following functions will be implemented:
+ * - dlog_init() to initialize the rings and start the logger task
+ * - dlog_push() to push a record in the ring of the calling core
+ * - dlog_flush() to output all pending records
+ * - dlog_benchmark() to compare the cost of Serial.printf and dlog_push
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __DLOG_H__
+#define __DLOG_H__
+
+#include "Arduino.h"
+#include "dlog_fmt.h"
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG // records above this level are compiled out
+#endif
+
+#ifndef DLOG_BINARY
+#define DLOG_BINARY 0 // 1 send raw records to tools/log_decode, 0 format on device
+#endif
+
+#ifndef DLOG_BENCH
+#define DLOG_BENCH 0 // 1 print hot-path cost of Serial.printf vs deferred push at boot
+#endif
+
+#define DLOG_NUM_RINGS 2 // one ring per core
+#define DLOG_RING_SIZE 64 // records per ring, must be a power of two
+#define DLOG_FLUSH_MS 100 // logger task period
+#define DLOG_TASK_PRIO 0 // logger task priority, lower than any application task
+#define DLOG_TASK_CORE 0 // logger task core, application tasks run on core 1
+
+typedef struct
+{
+  uint32_t      seq; // slot sequence number, owns the slot for producer or consumer
+  LogRecord_t   rec;
+}LogSlot_t;
+
+typedef struct
+{
+  LogSlot_t   slot[DLOG_RING_SIZE];
+  uint32_t    head; // next position to reserve (producers)
+  uint32_t    tail; // next position to read (logger task only)
+  uint32_t    dropped; // records lost because the ring was full
+}LogRing_t;
+
+/**
+ * @brief Initialize deferred logger
+ *
+ * Initialize the rings and start the logger task.
+ *
+ * @param r LogRing_t struct pointer to an n-element ring array
+ * @param size 8-bit value that indicate number of rings
+ *
+ * @return void
+ */
+void dlog_init(LogRing_t* r, uint8_t size);
+
+/**
+ * @brief Push a record
+ *
+ * Reserve a slot in the ring of the calling core and copy the record, never blocks.
+ * If the ring is full the record is dropped and counted.
+ *
+ * @param level 8-bit value that indicate log level
+ * @param fmt 16-bit value that indicate format id (LogFmt_t)
+ * @param nargs 8-bit value that indicate number of arguments
+ * @param args pointer to nargs raw 32-bit arguments
+ *
+ * @return void
+ */
+void dlog_push(uint8_t level, uint16_t fmt, uint8_t nargs, const uint32_t* args);
+
+/**
+ * @brief Output pending records
+ *
+ * Drain all rings in timestamp order and write records to Serial. Must be called
+ * by one task only (the logger task).
+ *
+ * @param r LogRing_t struct pointer to an n-element ring array
+ * @param size 8-bit value that indicate number of rings
+ *
+ * @return void
+ */
+void dlog_flush(LogRing_t* r, uint8_t size);
+
+/**
+ * @brief Measure hot-path cost of logging
+ *
+ * Print the average CPU cycles of a synchronous Serial.printf and of a deferred push
+ * for the temperature message.
+ * Also runs in the native build (-DDLOG_BENCH=1), where the cycles are host time scaled
+ * to 240 MHz and Serial is stdout: the ratio of the two paths holds, the absolute cost
+ * of Serial.printf on the board (UART FIFO waits) has to be measured on the board.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void dlog_benchmark();
+
+static inline uint32_t dlog_arg(float v){ uint32_t u; memcpy(&u, &v, sizeof(u)); return u; }
+static inline uint32_t dlog_arg(double v){ return dlog_arg((float)v); }
+static inline uint32_t dlog_arg(int v){ return (uint32_t)v; }
+static inline uint32_t dlog_arg(unsigned int v){ return (uint32_t)v; }
+static inline uint32_t dlog_arg(long v){ return (uint32_t)v; }
+static inline uint32_t dlog_arg(unsigned long v){ return (uint32_t)v; }
+
+template<typename... Args>
+static inline void dlog_write(uint8_t level, uint16_t fmt, Args... args){
+  static_assert(sizeof...(Args) <= DLOG_MAX_ARGS, "too many log arguments");
+  const uint32_t a[] = { dlog_arg(args)..., 0 };
+  dlog_push(level, fmt, sizeof...(Args), a);
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(id, ...) dlog_write(LOG_LEVEL_ERROR, id, ##__VA_ARGS__)
+#else
+#define LOG_E(id, ...) do { if (0) { dlog_write(LOG_LEVEL_ERROR, id, ##__VA_ARGS__); } } while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(id, ...) dlog_write(LOG_LEVEL_WARN, id, ##__VA_ARGS__)
+#else
+#define LOG_W(id, ...) do { if (0) { dlog_write(LOG_LEVEL_WARN, id, ##__VA_ARGS__); } } while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(id, ...) dlog_write(LOG_LEVEL_INFO, id, ##__VA_ARGS__)
+#else
+#define LOG_I(id, ...) do { if (0) { dlog_write(LOG_LEVEL_INFO, id, ##__VA_ARGS__); } } while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(id, ...) dlog_write(LOG_LEVEL_DEBUG, id, ##__VA_ARGS__)
+#else
+#define LOG_D(id, ...) do { if (0) { dlog_write(LOG_LEVEL_DEBUG, id, ##__VA_ARGS__); } } while (0)
+#endif
+
+#endif /* __DLOG_H__ */
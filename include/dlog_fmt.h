@@ -0,0 +1,103 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file dlog_fmt.h
+ * @brief this file contain the table of log format strings and the deferred log record
+ *
+ * Call sites log a format id and raw 32-bit arguments, the string is formatted later
+ * by the logger task or by the host decoder (tools/log_decode). This file has no
+ * dependency on Arduino so it can be shared with host tools.
+ *
+ * The following functions will be implemented:
+ * - dlog_format() to format a log record in a text buffer
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __DLOG_FMT_H__
+#define __DLOG_FMT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DLOG_MAX_ARGS 4 // maximum number of arguments of a log record
+#define DLOG_SYNC_0 0xA5 // binary output: first sync byte before each record
+#define DLOG_SYNC_1 0x5A // binary output: second sync byte before each record
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// format id, format string: append only, ids are part of the binary log format
+#define DLOG_FORMATS(X) \
+  X(LOG_FMT_TASK_DONE, "Task %d completed on core %d\n") \
+  X(LOG_FMT_TEMPERATURE, "Temperature: %4.4f *C\n") \
+  X(LOG_FMT_SOLAR, "Solar sensor status = %d \n") \
+  X(LOG_FMT_HUMIDITY, "Humidity sensor value = %.2f %%\n") \
+  X(LOG_FMT_ULP_BATCH, "ULP batch %d samples, wake 0x%x\n") \
+  X(LOG_FMT_CHANNEL_INVALID, "Channel not valid %d\n") \
+  X(LOG_FMT_CHANNEL_OOB, "Channel out of bounds %d\n") \
+  X(LOG_FMT_BLE_CONNECTED, "Device Connected\n") \
+  X(LOG_FMT_BLE_DISCONNECTED, "Device Disconnected\n") \
+  X(LOG_FMT_BLE_ADV_RESTART, "Advertising restarted\n") \
+  X(LOG_FMT_DROPPED, "%u log records dropped\n") \
+  X(LOG_FMT_CYCLE_TIME, "Cycle %u plants: avg %u us, max %u us\n") \
+  X(LOG_FMT_AMUX_SWEEP, "Mux sweep %u channels in %u us, settle wait %u us\n") \
+  X(LOG_FMT_ALARM_EVENT, "Alarm plant %u mask 0x%x, notified in %u us\n") \
+  X(LOG_FMT_ADAPT, "Sampling every %u ms, %u mHz effective, %u cycles skipped, CPU saved %u ms\n") \
+  X(LOG_FMT_RADIO_SAVED, "BLE updates skipped %u, radio saved %u ms\n") \
+  X(LOG_FMT_CONFIG, "Config kind %u stored (%u bytes)\n") \
+  X(LOG_FMT_CONFIG_REJECTED, "Config kind %u rejected (%u bytes)\n") \
+  X(LOG_FMT_HISTORY_QUERY, "History query: %u samples to %u points in %u ms\n") \
+  X(LOG_FMT_BOOT, "First sample %u ms after reset, BLE start %u ms (waited %u ms), missing 0x%x\n") \
+  X(LOG_FMT_DEVICE_RETRY, "Device %u still missing, next retry in %u ms\n") \
+  X(LOG_FMT_DEVICE_RECOVERED, "Device %u recovered after %u retries\n") \
+  X(LOG_FMT_UPLINK_UP, "Uplink connected (%u reconnects), backlog %u records + flash %u s\n") \
+  X(LOG_FMT_UPLINK_DOWN, "Uplink lost (Wi-Fi %u), retry in %u ms\n") \
+  X(LOG_FMT_TIME_SYNC, "Wall clock sync %u, correction %d ms after %u s\n") \
+  X(LOG_FMT_STACK_LOW, "Task %u stack: %u bytes never used\n")
+
+#define DLOG_ENUM(id, fmt) id,
+typedef enum {
+  DLOG_FORMATS(DLOG_ENUM)
+  LOG_FMT_COUNT
+}LogFmt_t;
+#undef DLOG_ENUM
+
+typedef struct
+{
+  uint32_t  ts_us; // micros() when the record has been pushed
+  uint16_t  fmt; // LogFmt_t format id
+  uint8_t   level; // LOG_LEVEL_x
+  uint8_t   nargs; // number of arguments
+  uint32_t  args[DLOG_MAX_ARGS]; // raw arguments, float stored as IEEE-754 bits
+}LogRecord_t;
+
+static_assert(sizeof(LogRecord_t) == 24, "LogRecord_t is part of the binary log format");
+
+/**
+ * @brief Format a log record
+ *
+ * Format the record with the string of its format id. Arguments are taken by conversion:
+ * floating point conversions read the IEEE-754 bits, integer conversions the raw value.
+ * The output is prefixed with the timestamp as DEBUG_PRINT does.
+ *
+ * @param out pointer to the text buffer
+ * @param len size of the text buffer
+ * @param r LogRecord_t struct pointer
+ *
+ * @return int number of characters written (without terminator)
+ */
+int dlog_format(char* out, size_t len, const LogRecord_t* r);
+
+#endif /* __DLOG_FMT_H__ */
@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file downsample.h
+ * @brief this file contain the functions prototype of the streaming downsampler
+ *
+ * Reduce a time range of samples to at most N representative points in one pass, with
+ * memory independent of the number of samples (e.g. a day of 1 Hz history for a chart
+ * on the phone). The range is split in buckets of equal duration, empty buckets give no
+ * point.
+ * - DOWNSAMPLE_LTTB: Largest-Triangle-Three-Buckets. The first and the last sample are
+ *   kept, from each of the N-2 buckets the point forming the largest triangle with the
+ *   point kept before and the average of the next bucket. Only the first, last, min and
+ *   max samples of a bucket are candidates (the extremes of the bucket), so two buckets
+ *   are held instead of the whole range.
+ * - DOWNSAMPLE_MINMAX: N/2 buckets, the min and max sample of each bucket in time order,
+ *   every peak is kept.
+ * This file has no dependency on Arduino so it can be built on the host.
+ *
+ * The following functions will be implemented:
+ * - downsample_init() to start a downsampling pass
+ * - downsample_push() to add a sample
+ * - downsample_finish() to emit the last points
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __DOWNSAMPLE_H__
+#define __DOWNSAMPLE_H__
+
+#include <stdint.h>
+
+typedef enum
+{
+  DOWNSAMPLE_LTTB = 0,
+  DOWNSAMPLE_MINMAX,
+  DOWNSAMPLE_NUM_MODES
+}DownsampleMode_t;
+
+typedef struct
+{
+  uint32_t  ts; // seconds
+  int32_t   value;
+}DsPoint_t;
+
+typedef struct
+{
+  DsPoint_t first, last, min, max; // candidates
+  uint32_t  count; // samples in the bucket
+  int64_t   sum_ts; // relative to the start of the range
+  int64_t   sum_value;
+  uint16_t  index;
+}DsBucket_t;
+
+typedef struct
+{
+  uint8_t     mode; // DownsampleMode_t
+  uint32_t    from, to; // time range
+  uint16_t    buckets;
+  DsPoint_t   a; // last point emitted (LTTB)
+  DsBucket_t  prev; // bucket waiting for the average of the next one (LTTB)
+  DsBucket_t  cur; // bucket being filled
+  bool        has_a, has_prev, has_cur;
+  void (*emit)(const DsPoint_t* p, void* arg);
+  void*       arg;
+  uint32_t    in; // samples pushed
+  uint16_t    out; // points emitted
+}Downsample_t;
+
+/**
+ * @brief Start a downsampling pass
+ *
+ * @param d Downsample_t struct pointer
+ * @param mode DownsampleMode_t
+ * @param from first timestamp of the range
+ * @param to last timestamp of the range
+ * @param points maximum number of points emitted (at least 3 for LTTB, 2 for min/max)
+ * @param emit function called for every point, in time order
+ * @param arg argument for emit
+ *
+ * @return bool true if the parameters are valid, false otherwise
+ */
+bool downsample_init(Downsample_t* d, uint8_t mode, uint32_t from, uint32_t to, uint16_t points,
+                     void (*emit)(const DsPoint_t* p, void* arg), void* arg);
+
+/**
+ * @brief Add a sample
+ *
+ * Samples must come in increasing time order, samples out of the range are ignored.
+ *
+ * @param d Downsample_t struct pointer
+ * @param ts timestamp of the sample
+ * @param value value of the sample
+ *
+ * @return void
+ */
+void downsample_push(Downsample_t* d, uint32_t ts, int32_t value);
+
+/**
+ * @brief Emit the last points
+ *
+ * @param d Downsample_t struct pointer
+ *
+ * @return uint16_t number of points emitted by the pass
+ */
+uint16_t downsample_finish(Downsample_t* d);
+
+#endif /* __DOWNSAMPLE_H__ */
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file frame.h
+ * @brief this file contain the functions prototype of the COBS + CRC16 framing
+ *
+ * A frame is the COBS encoding of payload + CRC16 (little endian) followed by a 0x00
+ * delimiter, so a receiver can resynchronize on any zero byte. This file has no
+ * dependency on Arduino so it can be shared with host tools.
+ *
+ * The following functions will be implemented:
+ * - frame_crc16() to compute CRC-16/CCITT-FALSE
+ * - frame_encode() to build a frame from a payload
+ * - frame_decode() to check a frame and extract its payload
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __FRAME_H__
+#define __FRAME_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FRAME_DELIMITER 0x00
+#define FRAME_CRC_SIZE 2
+// worst case encoded size of a payload: COBS overhead, CRC and delimiter
+#define FRAME_MAX_ENCODED(len) ((len) + FRAME_CRC_SIZE + ((len) + FRAME_CRC_SIZE) / 254 + 2)
+
+/**
+ * @brief Compute CRC-16/CCITT-FALSE
+ *
+ * @param data pointer to the data
+ * @param len number of bytes
+ *
+ * @return uint16_t CRC (poly 0x1021, init 0xFFFF)
+ */
+uint16_t frame_crc16(const uint8_t* data, size_t len);
+
+/**
+ * @brief Encode a frame
+ *
+ * Append the CRC to the payload, COBS-encode the result and add the delimiter.
+ *
+ * @param payload pointer to the payload
+ * @param len number of payload bytes
+ * @param out pointer to the output buffer, at least FRAME_MAX_ENCODED(len) bytes
+ * @param out_size size of the output buffer
+ *
+ * @return size_t number of bytes written, 0 if the output buffer is too small
+ */
+size_t frame_encode(const uint8_t* payload, size_t len, uint8_t* out, size_t out_size);
+
+/**
+ * @brief Decode a frame
+ *
+ * COBS-decode the bytes received between two delimiters (delimiter excluded) and check CRC.
+ *
+ * @param in pointer to the encoded bytes
+ * @param len number of encoded bytes
+ * @param out pointer to the payload buffer
+ * @param out_size size of the payload buffer
+ *
+ * @return int payload length, -1 on malformed frame or CRC mismatch
+ */
+int frame_decode(const uint8_t* in, size_t len, uint8_t* out, size_t out_size);
+
+#endif /* __FRAME_H__ */
@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file kalman.h
+ * @brief this file contain the functions prototype of the fixed-point Kalman filter
+ *
+ * Kalman filter of one measured value with a constant-rate model: the state is the
+ * level and its rate per sample, so a slow drift (sand drying, daily temperature swing)
+ * is followed without the lag of an average. Level, rate and covariance are 32-bit
+ * fixed point with KALMAN_FRAC fractional bits, products and gains use 64-bit
+ * intermediates: no float on the sampling path.
+ * The variance of the level estimate (P00) tells how much the value can be trusted.
+ * This file has no dependency on Arduino so it can be built on the host.
+ *
+ * The following functions will be implemented:
+ * - kalman_init() to set the noise parameters
+ * - kalman_restart() to restart from the next measurement
+ * - kalman_predict() to advance the state by one sample without measurement
+ * - kalman_update() to advance the state by one sample with a measurement
+ * - kalman_value() to get the level estimate
+ * - kalman_variance() to get the variance of the level estimate
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __KALMAN_H__
+#define __KALMAN_H__
+
+#include <stdint.h>
+
+#define KALMAN_FRAC 8 // fractional bits of level, rate and covariance
+#define KALMAN_Q(v) ((int32_t)((v) * (1 << KALMAN_FRAC))) // constant to fixed point
+
+typedef struct
+{
+  int32_t   x; // level
+  int32_t   v; // rate per sample
+  int32_t   p00, p01, p11; // covariance of (x, v)
+  int32_t   q_x; // level noise added per sample
+  int32_t   q_v; // rate noise added per sample
+  int32_t   r; // measurement noise variance
+  bool      started; // false until the first measurement
+}Kalman_t;
+
+/**
+ * @brief Initialize the filter
+ *
+ * The first measurement sets the level, the rate starts at 0.
+ *
+ * @param k Kalman_t struct pointer
+ * @param r measurement noise variance, KALMAN_Q(units^2)
+ * @param q_x level noise per sample, KALMAN_Q(units^2)
+ * @param q_v rate noise per sample, KALMAN_Q(units^2)
+ *
+ * @return void
+ */
+void kalman_init(Kalman_t* k, int32_t r, int32_t q_x, int32_t q_v);
+
+/**
+ * @brief Restart from the next measurement
+ *
+ * Used when a step is known to be real (e.g. confirmed by the spike filter): the next
+ * measurement sets the level instead of being followed with the filter lag.
+ *
+ * @param k Kalman_t struct pointer
+ *
+ * @return void
+ */
+void kalman_restart(Kalman_t* k);
+
+/**
+ * @brief Advance by one sample without measurement
+ *
+ * Used when a sample is rejected (spike): the level moves with the rate and the
+ * variance grows.
+ *
+ * @param k Kalman_t struct pointer
+ *
+ * @return void
+ */
+void kalman_predict(Kalman_t* k);
+
+/**
+ * @brief Advance by one sample with a measurement
+ *
+ * @param k Kalman_t struct pointer
+ * @param z measurement in units (e.g. ADC bits)
+ *
+ * @return void
+ */
+void kalman_update(Kalman_t* k, int32_t z);
+
+/**
+ * @brief Get the level estimate
+ *
+ * @param k Kalman_t struct pointer
+ *
+ * @return int32_t level rounded to units
+ */
+int32_t kalman_value(const Kalman_t* k);
+
+/**
+ * @brief Get the variance of the level estimate
+ *
+ * @param k Kalman_t struct pointer
+ *
+ * @return int32_t variance, KALMAN_Q(units^2)
+ */
+int32_t kalman_variance(const Kalman_t* k);
+
+#endif /* __KALMAN_H__ */
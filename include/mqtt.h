@@ -0,0 +1,207 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file mqtt.h
+ * @brief this file contain the functions prototype of the MQTT 3.1.1 publisher
+ *
+ * Minimal MQTT client: clean session, QoS 1 publish with one message in flight, keepalive.
+ * The in-flight PUBLISH is kept by the client and sent again with the DUP flag when its
+ * PUBACK does not come within MQTT_ACK_TIMEOUT_MS or after a reconnection. The byte
+ * stream goes through an MqttLink_t and the time is passed by the caller, so this file
+ * has no dependency on Arduino and can be shared with host tools.
+ *
+ * The following functions will be implemented:
+ * - mqtt_packet_len() to get the length of the first packet of a stream
+ * - mqtt_encode_connect() to build a CONNECT packet
+ * - mqtt_encode_publish() to build a QoS 1 PUBLISH packet
+ * - mqtt_init() to initialize a client
+ * - mqtt_connect() to open the link and send CONNECT
+ * - mqtt_poll() to handle the packets of the broker and the timers
+ * - mqtt_publish() to publish a message with QoS 1
+ * - mqtt_disconnect() to close the session
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __MQTT_H__
+#define __MQTT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MQTT_PROTOCOL_LEVEL 4 // MQTT 3.1.1
+#define MQTT_MAX_PACKET 512 // largest packet sent or received
+#define MQTT_CONNECT_TIMEOUT_MS 5000 // CONNACK and PINGRESP
+#define MQTT_ACK_TIMEOUT_MS 10000 // PUBACK, then the PUBLISH is sent again
+
+// control packet types (first byte, flags cleared)
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH 0x30
+#define MQTT_PUBACK 0x40
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+#define MQTT_DISCONNECT 0xE0
+#define MQTT_FLAG_DUP 0x08
+#define MQTT_FLAG_QOS1 0x02
+
+typedef struct MqttLink_s
+{
+  bool (*open)(struct MqttLink_s* l); // connect to the broker
+  int (*write)(struct MqttLink_s* l, const uint8_t* data, size_t len); // bytes written, -1 if the link is lost
+  int (*read)(struct MqttLink_s* l, uint8_t* data, size_t max); // bytes received, without waiting; -1 if lost
+  void (*close)(struct MqttLink_s* l);
+  void*     ctx; // backend data
+}MqttLink_t;
+
+typedef enum
+{
+  MQTT_STATE_DOWN = 0, // no link
+  MQTT_STATE_CONNECTING, // CONNECT sent, waiting for CONNACK
+  MQTT_STATE_UP // session accepted
+}MqttState_t;
+
+typedef struct
+{
+  uint32_t  connects; // sessions accepted by the broker
+  uint32_t  publishes; // PUBLISH sent, retransmissions included
+  uint32_t  retransmits; // PUBLISH sent again with DUP
+  uint32_t  pubacks; // PUBACK of the in-flight message
+  uint32_t  bytes_tx; // bytes written, all packets
+  uint32_t  errors; // lost links, timeouts and refused sessions
+}MqttStats_t;
+
+typedef struct
+{
+  MqttLink_t*   link;
+  const char*   client_id;
+  uint16_t      keepalive_s;
+  MqttState_t   state;
+  uint16_t      next_id; // packet identifier of the next message
+  uint16_t      inflight_id; // message waiting for its PUBACK, 0 if none
+  uint8_t       tx[MQTT_MAX_PACKET]; // in-flight PUBLISH
+  uint16_t      tx_len;
+  uint32_t      sent_ms; // CONNECT or in-flight PUBLISH sent
+  uint32_t      tx_ms; // last packet sent, for the keepalive
+  uint32_t      ping_ms; // PINGREQ sent, 0 if none pending
+  uint8_t       rx[MQTT_MAX_PACKET];
+  uint16_t      rx_len;
+  MqttStats_t   stats;
+}MqttClient_t;
+
+/**
+ * @brief Get length of the first packet of a stream
+ *
+ * @param data pointer to the received bytes
+ * @param len number of received bytes
+ *
+ * @return size_t length of the first packet (header included), 0 if incomplete,
+ *         SIZE_MAX if the remaining length is malformed
+ */
+size_t mqtt_packet_len(const uint8_t* data, size_t len);
+
+/**
+ * @brief Build a CONNECT packet
+ *
+ * Clean session, no will, no credentials.
+ *
+ * @param out pointer to the output buffer
+ * @param size size of the output buffer
+ * @param client_id client identifier
+ * @param keepalive_s keepalive in seconds
+ *
+ * @return size_t number of bytes written, 0 if the output buffer is too small
+ */
+size_t mqtt_encode_connect(uint8_t* out, size_t size, const char* client_id, uint16_t keepalive_s);
+
+/**
+ * @brief Build a QoS 1 PUBLISH packet
+ *
+ * @param out pointer to the output buffer
+ * @param size size of the output buffer
+ * @param topic topic name
+ * @param payload pointer to the payload
+ * @param len number of payload bytes
+ * @param id packet identifier, not 0
+ * @param dup true for a retransmission
+ *
+ * @return size_t number of bytes written, 0 if the output buffer is too small
+ */
+size_t mqtt_encode_publish(uint8_t* out, size_t size, const char* topic, const uint8_t* payload, size_t len,
+                           uint16_t id, bool dup);
+
+/**
+ * @brief Initialize a client
+ *
+ * @param c MqttClient_t struct pointer
+ * @param link MqttLink_t struct pointer, the byte stream to the broker
+ * @param client_id client identifier, kept by pointer
+ * @param keepalive_s keepalive in seconds
+ *
+ * @return void
+ */
+void mqtt_init(MqttClient_t* c, MqttLink_t* link, const char* client_id, uint16_t keepalive_s);
+
+/**
+ * @brief Open the link and send CONNECT
+ *
+ * The session is up when mqtt_poll() receives the CONNACK.
+ *
+ * @param c MqttClient_t struct pointer
+ * @param now_ms time in milliseconds
+ *
+ * @return bool true if CONNECT is sent, false if the link cannot be opened
+ */
+bool mqtt_connect(MqttClient_t* c, uint32_t now_ms);
+
+/**
+ * @brief Handle the packets of the broker and the timers
+ *
+ * Read CONNACK, PUBACK and PINGRESP, send PINGREQ when the link is idle for the keepalive
+ * and the in-flight PUBLISH again (DUP) when its PUBACK is late or the session is new.
+ * A lost link, a timeout or a refused session close the link (MQTT_STATE_DOWN), the
+ * in-flight message is kept for the next session.
+ *
+ * @param c MqttClient_t struct pointer
+ * @param now_ms time in milliseconds
+ *
+ * @return MqttState_t state of the session
+ */
+MqttState_t mqtt_poll(MqttClient_t* c, uint32_t now_ms);
+
+/**
+ * @brief Publish a message with QoS 1
+ *
+ * The message is in flight until its PUBACK (c->inflight_id back to 0).
+ *
+ * @param c MqttClient_t struct pointer
+ * @param topic topic name
+ * @param payload pointer to the payload
+ * @param len number of payload bytes
+ * @param now_ms time in milliseconds
+ *
+ * @return bool true if sent, false if the session is not up, a message is in flight or
+ *         the packet exceeds MQTT_MAX_PACKET
+ */
+bool mqtt_publish(MqttClient_t* c, const char* topic, const uint8_t* payload, size_t len, uint32_t now_ms);
+
+/**
+ * @brief Close the session
+ *
+ * Send DISCONNECT if the session is up and close the link. The in-flight message is kept.
+ *
+ * @param c MqttClient_t struct pointer
+ *
+ * @return void
+ */
+void mqtt_disconnect(MqttClient_t* c);
+
+#endif /* __MQTT_H__ */
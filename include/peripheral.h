@@ -13,10 +13,20 @@
  *
  * The following functions will be implemented:
  * - peripheral_init() to initialize the peripherals
+ * - peripheral_start_temperature() to probe the BMP280 sensors
  * - turn_led() to control the LED state
- * - get_temperature() to read the temperature from the BMP280 sensor
+ * - read_temperatures() to read all BMP280 sensors
+ * - get_temperature() to get the temperature of a BMP280 sensor
+ * - get_temperature_count() to get the number of BMP280 sensors
+ * - print_temperature_sensors() to print read latency of the BMP280 sensors
  * - read_solar_radiation() to read the solar radiation status
+ * - scan_humidity() to scan the humidity probes connected to the analog muxes
  * - read_humidity() to read the humidity pertentage from the analog sensor
+ * - read_humidity_batch() to read the humidity averages collected by the ULP
+ *
+ * Each device type is a driver of the compile-time registry (see sensor_driver.h): a new
+ * sensor type is a new driver added to the list in peripheral.cpp, and the pins and
+ * channels below are checked there for conflicts when the firmware is built.
  * 
  * @author Marconatale Parise
  * @date 09 June 2025
@@ -30,21 +40,33 @@
 #include <Adafruit_BMP280.h>
 #include <Wire.h>
 #include <Adafruit_Sensor.h>
+#include "HAL/i2c_mux.h"
 
 // defined the pins for peripherals
 #define DIODE_LED_1_pin 4
 #define SOLAR_SNS_1_pin 5
 #define HUMIDITY_1_pin 32
+#define I2C_SDA_pin 21 // Wire default pins, BMP280 and OLED
+#define I2C_SCL_pin 22
 
-// defined the channels for peripherals
+// defined the channels for peripherals, the digital and the analog arrays are numbered apart
 #define DIODE_LED_1_ch  0
 #define SOLAR_SNS_1_ch  1
 #define HUMIDITY_1_ch  0
 
+// temperature sensors
+#ifndef TEMP_I2CMUX
+#define TEMP_I2CMUX 0 // 1 discover BMP280 sensors behind a TCA9548A I2C mux
+#endif
+#define TCA9548A_ADDR 0x70 // I2C mux address (A0..A2 low)
+#define BMP280_ADDR_1 0x76 // SDO low
+#define BMP280_ADDR_2 0x77 // SDO high
+
 /**
  * @brief Initialize peripherals
  *
  * Initialize peripherals to asserve the functionalities of the system. 
+ * The BLE stack is started on core 0 (boot_start_async()), join it with boot_wait_async().
  *
  * NO parameters are required for this function.
  *
@@ -52,10 +74,23 @@
  */
 void peripheral_init();
 
+/**
+ * @brief Probe the BMP280 sensors
+ *
+ * Discover the temperature sensors (behind the I2C mux with TEMP_I2CMUX) and build the
+ * read plan. Called at boot and by the retry of the degraded mode (boot_device()).
+ *
+ * NO parameters are required for this function.
+ *
+ * @return bool true if at least one sensor answers
+ */
+bool peripheral_start_temperature();
+
 /**
  * @brief Turn LED on or off
  *
- * Set the state of the LED for a specific digital channel.
+ * Set the state of the LED for a specific digital channel. A channel without a LED
+ * driver is logged and left untouched.
  *
  * @param channel 8-bit value that indicate channel of digital array
  * @param value boolean value to set the LED state (true for ON, false for OFF)
@@ -64,16 +99,49 @@ void peripheral_init();
  */
 void turn_led(uint8_t channel, bool value);
 
+/**
+ * @brief Read all BMP280 sensors
+ *
+ * Read every temperature sensor once, grouped by I2C mux channel, to be called before
+ * get_temperature().
+ *
+ * NO parameters are required for this function.
+ *
+ * @return void
+ */
+void read_temperatures();
+
 /**
  * @brief Get temperature from BMP280 sensor
  *
- * Read the temperature from the BMP280 sensor and return the value.
+ * Return the temperature read by the last read_temperatures() for a specific sensor.
+ *
+ * @param channel 8-bit value that indicate index of temperature sensor
+ *
+ * @return float Temperature in degrees Celsius, NAN if no sensor answered (degraded mode) or
+ * the sensor failed I2CMUX_MAX_ERRORS reads in a row
+ */
+float get_temperature(uint8_t channel);
+
+/**
+ * @brief Get number of BMP280 sensors
+ *
+ * NO parameters are required for this function.
+ *
+ * @return uint8_t number of temperature sensors found at init
+ */
+uint8_t get_temperature_count();
+
+/**
+ * @brief Print BMP280 sensors status
+ *
+ * Print mux channel, address, reads, errors and read latency of every temperature sensor.
  *
  * NO parameters are required for this function.
  *
- * @return float Temperature in degrees Celsius
+ * @return void
  */
-float get_temperature();
+void print_temperature_sensors();
 
 /**
  * @brief Read solar radiation status
@@ -82,19 +150,46 @@ float get_temperature();
  *
  * @param channel 8-bit value that indicate channel of digital array
  *
- * @return int Status of the solar radiation sensor (0 or 1)
+ * @return int Status of the solar radiation sensor (0 or 1), 0 if the channel has no solar driver
  */
 int read_solar_radiation(uint8_t channel);
 
+/**
+ * @brief Scan humidity probes on analog muxes
+ *
+ * Convert all mux channels once, to be called before read_humidity() of mux channels.
+ * With ULP_HUMIDITY drain the averages collected by the ULP since the previous scan.
+ * No operation when AMUX_HUMIDITY and ULP_HUMIDITY are disabled.
+ *
+ * NO parameters are required for this function.
+ *
+ * @return void
+ */
+void scan_humidity();
+
 /**
  * @brief Read humidity percentage
  *
  * Read the humidity percentage from the analog sensor for a specific analog channel.
+ * Mux channels return the average of the last scan_humidity().
  *
  * @param channel 8-bit value that indicate channel of analog array
  *
- * @return float Humidity percentage
+ * @return float Humidity percentage, NAN if the channel has no humidity probe
  */
 float read_humidity(uint8_t channel);
 
+/**
+ * @brief Read humidity averages collected by the ULP
+ *
+ * Averages drained by the last scan_humidity(), one every ULP_PERIOD_US, oldest first.
+ * The ULP samples HUMIDITY_1_ch only.
+ *
+ * @param out pointer to the destination buffer of humidity percentages
+ * @param max 8-bit value that indicate size of destination buffer
+ *
+ * @return uint8_t number of averages copied, 0 when ULP_HUMIDITY is disabled
+ */
+uint8_t read_humidity_batch(float* out, uint8_t max);
+
 #endif /* __PERIPHERAL_H__ */
\ No newline at end of file
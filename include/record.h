@@ -0,0 +1,120 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file record.h
+ * @brief this file contain the binary schema and codec of the plant records
+ *
+ * A plant record is the data of one plant at one time, with the fields and units of the
+ * flash history sample (TsdbSample_t): every output of the samples (BLE record
+ * characteristic, UART telemetry frames, Wi-Fi uplink) sends the same batch, and the
+ * flash history stores the same fields delta-encoded.
+ *
+ * Batch (little endian):
+ * - header: version (RECORD_VERSION), record size, count, timestamp of the first record
+ *   (u32, s)
+ * - count records: plant (u8), seconds after the first record (u16), temperature (i16,
+ *   0.1 Celsius, RECORD_TEMP_NONE if missing), humidity (u16, 0.1 %), solar (u8), alarm (u8),
+ *   milliseconds after the second (u16, from record size 11)
+ * The time of a record is the time of its first reading, the other fields are aligned to
+ * it (see smartplant_get_record()).
+ * New fields are appended to a record and raise the record size only: a decoder reads
+ * the fields it knows and skips the others. The version changes when a field changes.
+ * Version 1 was the uplink payload without the record size.
+ * Encoder and decoder never allocate; this file has no dependency on Arduino so it can
+ * be shared with host tools (tools/record_decode, tools/record_bench).
+ *
+ * The following functions will be implemented:
+ * - record_encode() to build a batch
+ * - record_reader_init() to start reading a batch
+ * - record_read() to read the next record of a batch
+ * - record_decode() to read a whole batch
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __RECORD_H__
+#define __RECORD_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "tsdb.h"
+
+#define RECORD_VERSION 2
+#define RECORD_HEADER_SIZE 7 // version, record size, count, base timestamp
+#define RECORD_MIN_BYTES 9 // first record size of this version
+#define RECORD_BYTES 11 // record size written by this version
+#define RECORD_BATCH_SIZE(count) (RECORD_HEADER_SIZE + (count) * RECORD_BYTES)
+#define RECORD_MAX_SPAN_S UINT16_MAX // newest minus oldest timestamp of a batch
+#define RECORD_TEMP_NONE INT16_MIN // no temperature sensor (degraded mode)
+
+typedef struct
+{
+  TsdbSample_t  s; // timestamp and fields, as in the flash history
+  uint8_t       plant;
+  uint16_t      ms; // milliseconds after s.ts, 0 if unknown
+}PlantRecord_t;
+
+typedef struct
+{
+  const uint8_t*  p; // next record
+  uint32_t        base_ts;
+  uint8_t         stride; // record size of the batch
+  uint8_t         left; // records not read yet
+}RecordReader_t;
+
+/**
+ * @brief Build a batch
+ *
+ * @param r pointer to the records, in time order
+ * @param count number of records
+ * @param out pointer to the output buffer
+ * @param size size of the output buffer, RECORD_BATCH_SIZE(count) at least
+ *
+ * @return size_t batch length, 0 if the buffer is too small or the records span more than RECORD_MAX_SPAN_S
+ */
+size_t record_encode(const PlantRecord_t* r, uint8_t count, uint8_t* out, size_t size);
+
+/**
+ * @brief Start reading a batch
+ *
+ * Check the header and the length; the records are read in place by record_read().
+ *
+ * @param rd RecordReader_t struct pointer
+ * @param data pointer to the batch, kept until the last record_read()
+ * @param len number of bytes
+ *
+ * @return bool true if the batch is valid, false otherwise
+ */
+bool record_reader_init(RecordReader_t* rd, const uint8_t* data, size_t len);
+
+/**
+ * @brief Read the next record of a batch
+ *
+ * @param rd RecordReader_t struct pointer
+ * @param out PlantRecord_t struct pointer
+ *
+ * @return bool true if a record was read, false at the end of the batch
+ */
+bool record_read(RecordReader_t* rd, PlantRecord_t* out);
+
+/**
+ * @brief Read a whole batch
+ *
+ * @param data pointer to the batch
+ * @param len number of bytes
+ * @param out pointer to the records
+ * @param max number of records out can hold
+ *
+ * @return int number of records, -1 if the batch is invalid or holds more than max records
+ */
+int record_decode(const uint8_t* data, size_t len, PlantRecord_t* out, uint8_t max);
+
+#endif /* __RECORD_H__ */
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file rollstat.h
+ * @brief this file contain the functions prototype of the rolling statistics
+ *
+ * Samples are grouped in buckets of bucket_samples samples. The window is made of the
+ * last window closed buckets plus the bucket being filled, so a 24 h window at 1 Hz
+ * costs 24 buckets of 1 h, not 86400 samples.
+ * - mean and variance: Welford inside the open bucket, buckets are merged into and
+ *   removed from the window aggregate with the parallel formula (Chan et al.)
+ * - min and max: monotonic deques of bucket indexes, the front is the extreme of the
+ *   window and expired buckets drop off the front
+ * - EWMA of every sample with smoothing factor alpha
+ * Every push is O(1) amortized with fixed memory. This file has no dependency on
+ * Arduino so it can be built on the host.
+ *
+ * The following functions will be implemented:
+ * - rollstat_init() to set the window and reset the statistics
+ * - rollstat_push() to add a sample
+ * - rollstat_push_n() to add a sample held for several sample periods
+ * - rollstat_get() to read the statistics of the window
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __ROLLSTAT_H__
+#define __ROLLSTAT_H__
+
+#include <stdint.h>
+
+#ifndef ROLLSTAT_MAX_BUCKETS
+#define ROLLSTAT_MAX_BUCKETS 24 // closed buckets kept in the window
+#endif
+
+typedef struct
+{
+  float     mean;
+  float     m2; // sum of squared differences from mean
+  float     min;
+  float     max;
+}RollBucket_t;
+
+typedef struct
+{
+  uint16_t      window; // closed buckets in the window, at most ROLLSTAT_MAX_BUCKETS
+  uint16_t      bucket_samples; // samples per bucket
+  float         alpha; // EWMA smoothing factor
+  RollBucket_t  bucket[ROLLSTAT_MAX_BUCKETS]; // closed buckets, ring indexed by seq
+  uint32_t      seq; // buckets closed
+  uint16_t      count; // closed buckets in the window
+  // window aggregate of the closed buckets, double: removing a bucket cancels digits
+  uint32_t      n;
+  double        mean;
+  double        m2;
+  // monotonic deques of bucket seq: values increasing (min) and decreasing (max)
+  uint32_t      min_q[ROLLSTAT_MAX_BUCKETS];
+  uint32_t      max_q[ROLLSTAT_MAX_BUCKETS];
+  uint8_t       min_head, min_len;
+  uint8_t       max_head, max_len;
+  // bucket being filled
+  uint16_t      open_n;
+  RollBucket_t  open;
+  float         ewma;
+}RollStat_t;
+
+typedef struct
+{
+  uint32_t  n; // samples in the window
+  float     mean;
+  float     stddev; // population standard deviation
+  float     min;
+  float     max;
+  float     ewma;
+}RollStatValue_t;
+
+/**
+ * @brief Initialize rolling statistics
+ *
+ * @param r RollStat_t struct pointer
+ * @param window 16-bit value that indicate closed buckets in the window (1..ROLLSTAT_MAX_BUCKETS)
+ * @param bucket_samples 16-bit value that indicate samples per bucket (at least 1)
+ * @param alpha EWMA smoothing factor (0..1], 1 follows the last sample
+ *
+ * @return bool true if the parameters are valid, false otherwise
+ */
+bool rollstat_init(RollStat_t* r, uint16_t window, uint16_t bucket_samples, float alpha);
+
+/**
+ * @brief Add a sample
+ *
+ * Update the open bucket and the EWMA. When the bucket is full it enters the window and
+ * the oldest bucket leaves it.
+ *
+ * @param r RollStat_t struct pointer
+ * @param x sample value
+ *
+ * @return void
+ */
+void rollstat_push(RollStat_t* r, float x);
+
+/**
+ * @brief Add a sample held for several sample periods
+ *
+ * Same as k calls of rollstat_push() with the same value (sample and hold of a slower
+ * sampling rate), O(1) for k up to bucket_samples.
+ *
+ * @param r RollStat_t struct pointer
+ * @param x sample value
+ * @param k 32-bit value that indicate sample periods
+ *
+ * @return void
+ */
+void rollstat_push_n(RollStat_t* r, float x, uint32_t k);
+
+/**
+ * @brief Read the statistics of the window
+ *
+ * Merge the closed buckets with the open bucket. All values are 0 before the first sample.
+ *
+ * @param r RollStat_t struct pointer
+ * @param out RollStatValue_t struct pointer
+ *
+ * @return void
+ */
+void rollstat_get(const RollStat_t* r, RollStatValue_t* out);
+
+#endif /* __ROLLSTAT_H__ */
@@ -31,6 +31,11 @@
 #define TASK2_ch 1
 #define TASK2_PRIO 2
 #define TASK2_TIME 3000
+#define TASK2_STACK 4096 // BLE records and stats, float and 64-bit printf of the diagnostics
+#define TASK_STACK_MIN_FREE 512 // bytes never used by a task below which a warning is logged
+#define TASK3_ch 2
+#define TASK3_PRIO 3 // alarm events preempt sampling and BLE
+#define TASK3_TIME 0 // event driven, woken by the alarm stage
 
 /**
  * @brief Initialize scheduler
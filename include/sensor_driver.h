@@ -0,0 +1,198 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file sensor_driver.h
+ * @brief this file contain the driver interface and the compile-time driver registry
+ *
+ * A driver is a struct with static members only, one per device type, parametrized by
+ * its pin and channel when the board can have more than one:
+ * - BUS: HAL array of its channels (DRIVER_BUS_DIGITAL, DRIVER_BUS_ANALOG), DRIVER_BUS_NONE
+ *   if it has none (I2C)
+ * - CHANNELS: mask of its channels in that array (DRIVER_CH())
+ * - PINS: mask of the GPIOs it owns (DRIVER_PIN())
+ * - init(): set up pins and bus, before any other call
+ * Sensors add:
+ * - raw_t: type of a raw reading
+ * - start(): start a conversion of all channels (read plan, mux sweep), nothing if the
+ *   conversion is done by collect()
+ * - collect(): raw reading of its channel CH, so the channel read is the one checked by
+ *   the registry; drivers of several channels (mux sweep, I2C sensor table) have
+ *   collect(channel) instead, read through driver_read(channel)
+ * - to_units(): raw reading to engineering units
+ *
+ * The registry is a DriverList of the drivers of the board (see peripheral.cpp): every
+ * call is resolved at compile time and inlined, there is no table of function pointers.
+ * The pin and channel masks are checked by static_assert on the list, so two drivers on
+ * the same GPIO or on the same channel of a HAL array do not build.
+ * This file has no dependency on Arduino.
+ *
+ * The following functions will be implemented:
+ * - DriverList::init() to initialize all drivers
+ * - DriverList::pins_free() to check that no GPIO is owned by two drivers
+ * - DriverList::channels_free() to check that no channel is owned by two drivers
+ * - DriverList::channels_valid() to check the channels against the HAL arrays
+ * - DriverList::has() to check that a driver is in the registry
+ * - driver_owns() to check that a channel belongs to a driver
+ * - driver_read() to read a sensor in engineering units
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __SENSOR_DRIVER_H__
+#define __SENSOR_DRIVER_H__
+
+#include <stdint.h>
+#include <math.h>
+#include <type_traits>
+
+#define DRIVER_BUS_NONE 0 // no channel in the HAL arrays
+#define DRIVER_BUS_DIGITAL 1 // channels of the digital array
+#define DRIVER_BUS_ANALOG 2 // channels of the analog array
+
+#define DRIVER_PIN(pin) (1ULL << (pin)) // GPIO 0..39
+#define DRIVER_CH(ch) (1ULL << (ch))
+#define DRIVER_CH_RANGE(first, count) (((1ULL << (count)) - 1) << (first))
+
+template <typename... D> struct DriverList;
+
+template <> struct DriverList<>
+{
+  static void init() {}
+  static constexpr uint64_t pins() { return 0; }
+  static constexpr uint64_t channels(uint8_t bus) { return 0; }
+  static constexpr bool pins_free() { return true; }
+  static constexpr bool channels_free() { return true; }
+  static constexpr bool channels_valid(uint8_t num_digital, uint8_t num_analog) { return true; }
+  template <typename T> static constexpr bool has() { return false; }
+};
+
+template <typename D, typename... R> struct DriverList<D, R...>
+{
+  typedef DriverList<R...> Rest;
+
+  /**
+   * @brief Initialize all drivers
+   *
+   * In list order.
+   *
+   * @param NO PARAMETERS
+   *
+   * @return void
+   */
+  static void init() {
+    D::init();
+    Rest::init();
+  }
+
+  // GPIOs owned by the drivers
+  static constexpr uint64_t pins() { return D::PINS | Rest::pins(); }
+
+  // channels owned by the drivers in a HAL array
+  static constexpr uint64_t channels(uint8_t bus) {
+    return (D::BUS == bus ? D::CHANNELS : 0) | Rest::channels(bus);
+  }
+
+  /**
+   * @brief Check that no GPIO is owned by two drivers
+   *
+   * @param NO PARAMETERS
+   *
+   * @return bool true if the pin masks are disjoint, false otherwise
+   */
+  static constexpr bool pins_free() { return (D::PINS & Rest::pins()) == 0 && Rest::pins_free(); }
+
+  /**
+   * @brief Check that no channel is owned by two drivers
+   *
+   * Channels of different HAL arrays do not conflict (digital 0 and analog 0).
+   *
+   * @param NO PARAMETERS
+   *
+   * @return bool true if the channel masks of each array are disjoint, false otherwise
+   */
+  static constexpr bool channels_free() {
+    return (D::BUS == DRIVER_BUS_NONE || (D::CHANNELS & Rest::channels(D::BUS)) == 0) && Rest::channels_free();
+  }
+
+  /**
+   * @brief Check the channels against the HAL arrays
+   *
+   * @param num_digital number of channels of the digital array
+   * @param num_analog number of channels of the analog array
+   *
+   * @return bool true if every channel is in its array, false otherwise
+   */
+  static constexpr bool channels_valid(uint8_t num_digital, uint8_t num_analog) {
+    return (D::BUS == DRIVER_BUS_NONE ? D::CHANNELS == 0 :
+            (D::CHANNELS >> (D::BUS == DRIVER_BUS_DIGITAL ? num_digital : num_analog)) == 0) &&
+           Rest::channels_valid(num_digital, num_analog);
+  }
+
+  /**
+   * @brief Check that a driver is in the registry
+   *
+   * @param NO PARAMETERS
+   *
+   * @return bool true if T is one of the drivers, false otherwise
+   */
+  template <typename T> static constexpr bool has() {
+    return std::is_same<T, D>::value || Rest::template has<T>();
+  }
+};
+
+/**
+ * @brief Check that a channel belongs to a driver
+ *
+ * Drivers without HAL channels (I2C) index their own table, every channel is theirs.
+ *
+ * @param channel 8-bit value that indicate channel in the HAL array of the driver
+ *
+ * @return bool true if the channel is in the CHANNELS mask of T, false otherwise
+ */
+template <typename T> inline constexpr bool driver_owns(uint8_t channel) {
+  return T::BUS == DRIVER_BUS_NONE || (channel < 64 && ((T::CHANNELS >> channel) & 1) != 0);
+}
+
+/**
+ * @brief Read a single-channel sensor in engineering units
+ *
+ * Collect the raw reading of the channel of the driver type and convert it, both inlined.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return float reading in engineering units
+ */
+template <typename L, typename T> inline float driver_read() {
+  static_assert(L::template has<T>(), "sensor driver not in the registry");
+  static_assert(T::BUS != DRIVER_BUS_NONE && T::CHANNELS != 0 && (T::CHANNELS & (T::CHANNELS - 1)) == 0,
+                "sensor driver has several channels, read it by channel");
+  return T::to_units(T::collect());
+}
+
+/**
+ * @brief Read a channel of a multi-channel sensor in engineering units
+ *
+ * Collect the raw reading of the channel and convert it, both inlined. The channel is
+ * checked against the mask of the driver, so only channels checked by the registry are read.
+ *
+ * @param channel 8-bit value that indicate channel of the sensor
+ *
+ * @return float reading in engineering units, NAN if the channel is not of the driver
+ */
+template <typename L, typename T> inline float driver_read(uint8_t channel) {
+  static_assert(L::template has<T>(), "sensor driver not in the registry");
+  if (!driver_owns<T>(channel)) {
+    return NAN;
+  }
+  return T::to_units(T::collect(channel));
+}
+
+#endif /* __SENSOR_DRIVER_H__ */
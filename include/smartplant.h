@@ -11,13 +11,44 @@
  * @file smart plant.h
  * @brief this file contain the functions prototype to manage the smart plant functionalities
  * 
+ * Plant data is kept as a struct of arrays (one array per field, indexed by plant) so
+ * that each stage of the sampling pipeline walks one contiguous array for all plants.
+ * Each plant has its own map of peripheral channels.
+ * Every reading keeps the time of the stage that read it (start and duration on the
+ * esp_timer clock, one timer read per stage) and the reading before: the fields of a
+ * plant, read one stage after the other, are interpolated to a common time for the
+ * records, and the statistics weigh each reading by its own period.
+ * History timestamps follow the wall clock once a BLE client has set it (timesync.h).
+ * The flash history is single-plant: TsdbSample_t has no plant id and timestamps must
+ * increase, so Task1 stores PLANT_1 only; the other plants are in the live records.
+ *
  * The following functions will be implemented:
  * - smartplant_init() to initialize the smart plant data structure
+ * - smartplant_display_init() to start the OLED screen
+ * - smartplant_set_channels() to set the peripheral channels of a specific plant
+ * - smartplant_update() to run the sampling pipeline for all plants
  * - smartplant_set_temperature() to set the temperature for a specific plant
  * - smartplant_set_solar_intensity() to set the solar intensity for a specific plant
  * - smartplant_set_sand_humidity() to set the sand humidity for a specific plant
  * - smartplant_set_alarm() to set the alarm status for a specific plant
+ * - smartplant_alarm_init() to load the alarm rules
+ * - smartplant_alarm_store() to replace the alarm rules and save them in NVS
+ * - smartplant_alarm_set_notify() to set the task woken by alarm changes
+ * - smartplant_alarm_dispatch() to drive LEDs and notify alarm changes
+ * - smartplant_alarm_print() to print the alarm notify latency
+ * - smartplant_set_stats() to update the rolling statistics of a specific plant
+ * - smartplant_get_stats() to read the rolling statistics of a field of a specific plant
+ * - smartplant_next_interval() to get the next sampling interval
  * - smartplant_display_data() to display the data of a specific plant on the OLED screen
+ * - smartplant_history_init() to mount the flash history store
+ * - smartplant_history_append() to store the data of a specific plant in the history
+ * - smartplant_history_ts() to get the history timestamp of now
+ * - smartplant_get_aligned() to get the data of a specific plant at a common time
+ * - smartplant_get_record() to get the plant record of a specific plant
+ * - smartplant_history_request() to handle a history query written over BLE
+ * - smartplant_history_set_notify() to set the task woken by history queries
+ * - smartplant_history_run() to run the pending history query
+ * - smartplant_history_send() to transmit the result of the history query
  * 
  * 
  * @author Marconatale Parise
@@ -31,8 +62,16 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include "peripheral.h"
+#include "tsdb.h"
+#include "record.h"
+#include "alarm.h"
+#include "rollstat.h"
+#include "adapt.h"
+#include "downsample.h"
 
+#ifndef NUM_PLANTS
 #define NUM_PLANTS 1 // Number of smart plants
+#endif
 
 //OLED display settings
 #define SCREEN_WIDTH 128
@@ -40,24 +79,92 @@
 #define OLED_RESET    -1
 
 #define PLANT_1 0 // Plant channel
-#define PLANT_2 1 // Plant channel Unused
-#define PLANT_3 2 // Plant channel Unused
-#define PLANT_4 3 // Plant channel Unused
-#define PLANT_5 4 // Plant channel Unused
+#define PLANT_2 1 // Plant channel
+#define PLANT_3 2 // Plant channel
+#define PLANT_4 3 // Plant channel
+#define PLANT_5 4 // Plant channel
+
+#define CYCLE_REPORT_PERIOD 10 // Task1 periods between two cycle time reports
+
+#define ALARM_NVS_NAMESPACE "alarm" // Preferences namespace of the alarm rules
+#define ALARM_NVS_VERSION 1 // layout of the stored rule table
+
+#ifndef STATS_WINDOW
+#define STATS_WINDOW 24 // buckets in the statistics window
+#endif
+#ifndef STATS_BUCKET_SAMPLES
+#define STATS_BUCKET_SAMPLES 3600 // samples per bucket, 24 x 1 h at TASK1_TIME 1 s
+#endif
+#define STATS_EWMA_ALPHA 0.01f // EWMA smoothing, time constant about 100 samples
+#define STATS_SAMPLE_MS 1000 // sample period of the statistics, a slower sample counts several times
+
+#ifndef ADAPTIVE_SAMPLING
+#define ADAPTIVE_SAMPLING 1 // Task1 interval follows the signal dynamics, 0 for a fixed TASK1_TIME
+#endif
+#define ADAPT_MIN_MS 1000 // fastest interval, TASK1_TIME (runtime: Config_t task1_ms)
+#define ADAPT_MAX_MS 60000 // slowest interval (runtime: Config_t sample_max_ms)
+#define ADAPT_GROWTH 1.5f // maximum interval ratio between two samples
+#define ADAPT_TEMP_RESOLUTION 0.2f // Celsius worth a sample
+#define ADAPT_TEMP_GUARD 1.0f // Celsius from an alarm threshold sampled at ADAPT_MIN_MS
+#define ADAPT_HUMIDITY_RESOLUTION 1.0f // percent worth a sample, above the ADC noise
+#define ADAPT_HUMIDITY_GUARD 3.0f
+#define ADAPT_SOLAR_RESOLUTION 0.5f // any change of the light status
+#define ADAPT_SOLAR_GUARD 0.0f
+
+#define HISTORY_MAX_POINTS 240 // points of a downsampled history query
 
 
 typedef struct
 {
-	float			temperature; // Temperature in Celsius
-	float 		sand_humidity; // Sand humidity in percentage
-  uint8_t   solar_intensity; // Solar intensity
-  bool 			alarm; // Alarm status
+  int64_t   at_us; // esp_timer time at the start of the stage
+  uint32_t  latency_us; // duration of the stage, the value stands for at_us + latency_us / 2
+}SampleTime_t;
+
+typedef struct
+{
+  // channel map
+  uint8_t   temp_ch[NUM_PLANTS]; // Index of temperature sensor
+  uint8_t   solar_ch[NUM_PLANTS]; // Digital channel of solar sensor
+  uint8_t   humidity_ch[NUM_PLANTS]; // Analog channel of humidity sensor
+  uint8_t   led_ch[NUM_PLANTS]; // Digital channel of alarm LED
+  // plant data
+	float			temperature[NUM_PLANTS]; // Temperature in Celsius
+	float 		sand_humidity[NUM_PLANTS]; // Sand humidity in percentage
+  uint8_t   solar_intensity[NUM_PLANTS]; // Solar intensity
+  bool 			alarm[NUM_PLANTS]; // Alarm status
+  uint8_t   alarm_mask[NUM_PLANTS]; // Alarm bits raised by the rules
+  uint32_t  cycles; // runs of the sampling pipeline
+  // acquisition times on the esp_timer clock, indexed by AlarmField_t (then plant)
+  int64_t       cycle_us; // start of the last run of the sampling pipeline
+  SampleTime_t  sample_time[ALARM_NUM_FIELDS]; // stage of the last reading of each field, all plants
+  int64_t       prev_us[ALARM_NUM_FIELDS]; // reading before (middle), 0 if none
+  float         prev_value[ALARM_NUM_FIELDS][NUM_PLANTS]; // value of the reading before
 }SmartPlant_t;
 
+typedef struct
+{
+  uint32_t  events; // alarm changes dispatched
+  uint32_t  last_us; // latency of the last change, alarm stage to BLE notify
+  uint32_t  max_us; // worst latency
+  uint64_t  sum_us; // sum of latencies
+}AlarmLatency_t;
+
+typedef struct __attribute__((packed))
+{
+  uint8_t   field; // AlarmField_t
+  uint8_t   mode; // DownsampleMode_t
+  uint16_t  points; // maximum points, up to HISTORY_MAX_POINTS
+  uint32_t  from; // history timestamp
+  uint32_t  to; // history timestamp, 0 for the newest sample
+}HistoryQuery_t;
+
+static_assert(sizeof(HistoryQuery_t) == 12, "HistoryQuery_t is written over BLE");
+
 /**
  * @brief Initialize SmartPlant_t structure
  *
  * Initialize the smart plant data structure with default values.
+ * All plants are mapped on the channels of plant 1 until smartplant_set_channels().
  *
  * @param sm SmartPlant_t struct pointer
  * @param size 8-bit value that indicate number of plants
@@ -66,6 +173,49 @@ typedef struct
  */
 void smartplant_init(SmartPlant_t* sm, uint8_t size);
 
+/**
+ * @brief Start the OLED screen
+ *
+ * Start the display and draw the title. Called at boot and by the retry of the degraded
+ * mode (boot_device()): smartplant_display_data() draws nothing until it succeeds.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return bool true if the display answers
+ */
+bool smartplant_display_init();
+
+/**
+ * @brief Set peripheral channels for a specific plant
+ *
+ * Set the channels of the peripherals used to monitor a specific plant.
+ *
+ * @param sm SmartPlant_t struct pointer
+ * @param channel 8-bit value that indicate channel of smart plant structure
+ * @param size 8-bit value that indicate number of plants
+ * @param temp_ch 8-bit value that indicate channel of temperature sensor
+ * @param solar_ch 8-bit value that indicate channel of solar sensor peripheral
+ * @param humidity_ch 8-bit value that indicate channel of humidity sensor peripheral
+ * @param led_ch 8-bit value that indicate channel of LED peripheral
+ *
+ * @return void
+ */
+void smartplant_set_channels(SmartPlant_t* sm, uint8_t channel, uint8_t size,
+                             uint8_t temp_ch, uint8_t solar_ch, uint8_t humidity_ch, uint8_t led_ch);
+
+/**
+ * @brief Run sampling pipeline for all plants
+ *
+ * Run each stage (temperature, solar intensity, sand humidity, alarm, statistics) for
+ * all plants before moving to the next stage.
+ *
+ * @param sm SmartPlant_t struct pointer
+ * @param size 8-bit value that indicate number of plants
+ *
+ * @return void
+ */
+void smartplant_update(SmartPlant_t* sm, uint8_t size);
+
 /**
  * @brief Set temperature for a specific plant
  *
@@ -87,11 +237,10 @@ void smartplant_set_temperature(SmartPlant_t* sm, uint8_t channel, uint8_t size)
  * @param sm SmartPlant_t struct pointer
  * @param channel 8-bit value that indicate channel of smart plant structure
  * @param size 8-bit value that indicate number of plants
- * @param perip_ch 8-bit value that indicate channel of solar sensor peripheral
  *
  * @return void
  */
-void smartplant_set_solar_intensity(SmartPlant_t* sm, uint8_t channel, uint8_t size, uint8_t perip_ch);
+void smartplant_set_solar_intensity(SmartPlant_t* sm, uint8_t channel, uint8_t size);
 
 /**
  * @brief Set sand humidity for a specific plant
@@ -101,32 +250,137 @@ void smartplant_set_solar_intensity(SmartPlant_t* sm, uint8_t channel, uint8_t s
  * @param sm SmartPlant_t struct pointer
  * @param channel 8-bit value that indicate channel of smart plant structure
  * @param size 8-bit value that indicate number of plants
- * @param perip_ch 8-bit value that indicate channel of humidity sensor peripheral
  *
  * @return void
  */
-void smartplant_set_sand_humidity(SmartPlant_t* sm, uint8_t channel, uint8_t size, uint8_t perip_ch);
+void smartplant_set_sand_humidity(SmartPlant_t* sm, uint8_t channel, uint8_t size);
+
+/**
+ * @brief Update rolling statistics for a specific plant
+ *
+ * Push temperature, sand humidity and solar intensity of a specific plant in their
+ * rolling statistics (STATS_WINDOW buckets of STATS_BUCKET_SAMPLES samples). With
+ * adaptive sampling a value counts once per STATS_SAMPLE_MS since the previous run.
+ * With ULP_HUMIDITY the humidity of HUMIDITY_1_ch is the ULP batch drained by this run,
+ * averaged over STATS_SAMPLE_MS, instead of the last average held for the period.
+ *
+ * @param sm SmartPlant_t struct pointer
+ * @param channel 8-bit value that indicate channel of smart plant structure
+ * @param size 8-bit value that indicate number of plants
+ *
+ * @return void
+ */
+void smartplant_set_stats(SmartPlant_t* sm, uint8_t channel, uint8_t size);
+
+/**
+ * @brief Get rolling statistics of a field for a specific plant
+ *
+ * @param channel 8-bit value that indicate channel of smart plant structure
+ * @param field 8-bit value that indicate field (AlarmField_t)
+ * @param size 8-bit value that indicate number of plants
+ * @param out RollStatValue_t struct pointer
+ *
+ * @return bool true if channel and field are valid, false otherwise
+ */
+bool smartplant_get_stats(uint8_t channel, uint8_t field, uint8_t size, RollStatValue_t* out);
 
 /**
  * @brief Set alarm status for a specific plant
  *
- * Set the alarm status for a specific plant in the smart plant data structure.
- * If the temperature exceeds a threshold, the alarm is activated.
+ * Evaluate the alarm rules on the data of a specific plant. The alarm is active if any
+ * rule raises its alarm bit. When the alarm bits change the time is recorded and the
+ * task set by smartplant_alarm_set_notify() is woken, it drives the LEDs.
  *
  * @param sm SmartPlant_t struct pointer
  * @param channel 8-bit value that indicate channel of smart plant structure
  * @param size 8-bit value that indicate number of plants
- * @param perip_ch 8-bit value that indicate channel of LED peripheral
  *
  * @return void
  */
-void smartplant_set_alarm(SmartPlant_t* sm, uint8_t channel, uint8_t size, uint8_t perip_ch);
+void smartplant_set_alarm(SmartPlant_t* sm, uint8_t channel, uint8_t size);
+
+/**
+ * @brief Load alarm rules
+ *
+ * Load the rule table stored in NVS, or the table compiled from ALARM_RULES if NVS holds
+ * no valid table, and reset the alarm state of all plants.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return bool true if the rules come from NVS, false if the default table is used
+ */
+bool smartplant_alarm_init();
+
+/**
+ * @brief Replace alarm rules
+ *
+ * Validate the rules and save them in NVS. Task1 switches to the new rules at its next
+ * alarm stage, so this function can be called from any task.
+ *
+ * @param rules pointer to the rules
+ * @param count number of rules
+ *
+ * @return bool true if the rules are valid and saved, false otherwise
+ */
+bool smartplant_alarm_store(const AlarmRule_t* rules, uint8_t count);
+
+/**
+ * @brief Set the task woken by alarm changes
+ *
+ * The task receives a notification (xTaskNotifyGive) every time the alarm bits of a
+ * plant change, and must call smartplant_alarm_dispatch().
+ *
+ * @param task handle of the task to notify
+ *
+ * @return void
+ */
+void smartplant_alarm_set_notify(TaskHandle_t task);
+
+/**
+ * @brief Dispatch alarm changes
+ *
+ * Drive the LEDs of all plants (a LED shared by several plants is on if any of them is in
+ * alarm) and, for every plant whose alarm bits changed, notify them over BLE and update
+ * the latency from the alarm stage to the notification.
+ *
+ * @param sm SmartPlant_t struct pointer
+ * @param size 8-bit value that indicate number of plants
+ *
+ * @return void
+ */
+void smartplant_alarm_dispatch(SmartPlant_t* sm, uint8_t size);
+
+/**
+ * @brief Print alarm notify latency
+ *
+ * Print events, last, average and worst latency from the alarm stage to the BLE
+ * notification.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void smartplant_alarm_print();
+
+/**
+ * @brief Get the next sampling interval
+ *
+ * Feed the data of all plants to the adaptive sampling controller: the interval grows
+ * while readings are stable and drops on fast changes or near an alarm threshold,
+ * between ADAPT_MIN_MS and ADAPT_MAX_MS. Thresholds come from the alarm rules.
+ *
+ * @param sm SmartPlant_t struct pointer
+ * @param size 8-bit value that indicate number of plants
+ *
+ * @return uint32_t next interval in milliseconds, the fastest interval if ADAPTIVE_SAMPLING is 0
+ */
+uint32_t smartplant_next_interval(SmartPlant_t* sm, uint8_t size);
 
 /**
  * @brief Display data of a specific plant on the OLED screen
  *
  * Display the temperature, solar intensity, and sand humidity of a specific plant
- * on the OLED screen.
+ * on the OLED screen, with temperature min/max and mean sand humidity of the window.
  *
  * @param sm SmartPlant_t struct pointer
  * @param channel 8-bit value that indicate channel of smart plant structure
@@ -136,5 +390,131 @@ void smartplant_set_alarm(SmartPlant_t* sm, uint8_t channel, uint8_t size, uint8
  */
 void smartplant_display_data(SmartPlant_t* sm, uint8_t channel, uint8_t size);
 
+/**
+ * @brief Mount the flash history store
+ *
+ * Mount the time-series store on the tsdb partition. Timestamps continue from the
+ * newest stored sample (seconds of uptime, no wall clock).
+ *
+ * @param NO PARAMETERS
+ *
+ * @return bool true if the store is ready, false otherwise
+ */
+bool smartplant_history_init();
+
+/**
+ * @brief Store data of a specific plant in the history
+ *
+ * Quantize temperature and humidity to 0.1 and append the sample to the flash store.
+ * Nothing is stored while the temperature sensors are missing (degraded mode), the
+ * samples already in RAM are still flushed after TSDB_FLUSH_S.
+ * One plant only: the store has no plant id (Task1 stores PLANT_1).
+ * With ULP_HUMIDITY a sample per STATS_SAMPLE_MS of the ULP batch is stored before the
+ * sample of the run, with the temperature, solar intensity and alarm of the run.
+ *
+ * @param sm SmartPlant_t struct pointer
+ * @param channel 8-bit value that indicate channel of smart plant structure
+ * @param size 8-bit value that indicate number of plants
+ *
+ * @return void
+ */
+void smartplant_history_append(SmartPlant_t* sm, uint8_t channel, uint8_t size);
+
+/**
+ * @brief Get the history timestamp of now
+ *
+ * Seconds since boot, continued from the newest stored sample, or Unix time once the
+ * wall clock is set (a jump forward only, stored timestamps keep increasing): the
+ * timestamp given to the samples by smartplant_history_append().
+ *
+ * @param NO PARAMETERS
+ *
+ * @return uint32_t timestamp in seconds
+ */
+uint32_t smartplant_history_ts();
+
+/**
+ * @brief Get the data of a specific plant at a common time
+ *
+ * Temperature and humidity are interpolated between the last two readings, the solar
+ * status is the one read last before at_us. Outside the two readings the nearest one is
+ * returned.
+ *
+ * @param sm SmartPlant_t struct pointer
+ * @param channel 8-bit value that indicate channel of smart plant structure
+ * @param size 8-bit value that indicate number of plants
+ * @param at_us esp_timer time
+ * @param value pointer to the output values, indexed by AlarmField_t
+ *
+ * @return bool true if the channel exists, false otherwise
+ */
+bool smartplant_get_aligned(const SmartPlant_t* sm, uint8_t channel, uint8_t size, int64_t at_us,
+                            float value[ALARM_NUM_FIELDS]);
+
+/**
+ * @brief Get the plant record of a specific plant
+ *
+ * Quantize the data of the plant to the record schema (see record.h), the one sent on
+ * every output and stored in the flash history. The record time is the first reading of
+ * the last pipeline run, the other fields are aligned to it (smartplant_get_aligned()).
+ *
+ * @param sm SmartPlant_t struct pointer
+ * @param channel 8-bit value that indicate channel of smart plant structure
+ * @param size 8-bit value that indicate number of plants
+ * @param out PlantRecord_t struct pointer
+ *
+ * @return bool true if the channel exists, false otherwise
+ */
+bool smartplant_get_record(const SmartPlant_t* sm, uint8_t channel, uint8_t size, PlantRecord_t* out);
+
+/**
+ * @brief Handle a history query written over BLE
+ *
+ * Validate a HistoryQuery_t and keep it for Task1 (owner of the history store), woken
+ * at once through smartplant_history_set_notify() instead of at its next sample.
+ * A query arriving while the previous one is in progress replaces it.
+ *
+ * @param data pointer to the written bytes
+ * @param len number of written bytes
+ *
+ * @return bool true if the query is valid, false otherwise
+ */
+bool smartplant_history_request(const uint8_t* data, size_t len);
+
+/**
+ * @brief Set the task woken by history queries
+ *
+ * The task receives a notification (xTaskNotifyGive) every time a valid query is
+ * written, and must call smartplant_history_run().
+ *
+ * @param task handle of the task to notify, NULL to disable
+ *
+ * @return void
+ */
+void smartplant_history_set_notify(TaskHandle_t task);
+
+/**
+ * @brief Run the pending history query
+ *
+ * Called by Task1 after the sampling pipeline. The stored range is read and downsampled
+ * in one pass into a buffer of HISTORY_MAX_POINTS points, sent by the next Task2 period.
+ * Does nothing if no query is pending or the previous result is not sent yet.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void smartplant_history_run();
+
+/**
+ * @brief Transmit the result of the history query
+ *
+ * Called by Task2 while a device is connected. Does nothing if no result is ready.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void smartplant_history_send();
 
 #endif  /* __SMART_PLANT_H__ */
@@ -0,0 +1,141 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file stress.h
+ * @brief this file contain the functions prototype of the load stress harness
+ *
+ * With STRESS_MODE=1 the temperature sensors are synthetic (one per plant, the I2C time of
+ * a read is spent with delayMicroseconds()) and a task sweeps the Task1 period through
+ * STRESS_RATES_MS, fastest last. After each period has settled it measures a window of
+ * STRESS_STEP_MS:
+ * - samples run by Task1 and dropped samples (periods of the window without a sample)
+ * - longest Task1 job, start to end, preemptions included
+ * - CPU use of core 0: 100% minus the run time of its idle task, read by the stress task
+ *   pinned on core 0, so the BLE stack, dlog, telemetry and uplink are all counted. It needs
+ *   the FreeRTOS run time stats (configGENERATE_RUN_TIME_STATS, esp_timer clock), "nan"
+ *   without them. On the host only the CPU time of the fakes is counted (native_spend_us())
+ * - CPU use of core 1: time inside the Task1, Task2 and Task3 stages, exclusive of
+ *   preemption (TELEMETRY_STAGE_HOOK=1)
+ * - BLE notifications sent and dropped (ble_get_notify_stats())
+ * The saturation point is the slowest period from which every faster period drops samples
+ * or notifications. Failing windows at slower periods, between passing ones, are counted
+ * apart with the slowest of them: the synthetic sensors raise the alarms of all plants
+ * together, and when that happens in the connection event of a Task2 update the alarm
+ * notifications find the TX buffers full, even at the default period.
+ * Plants are a build flag (NUM_PLANTS), centrals are the ones connected during the window.
+ * The harness runs on the board (see [env:stress] in platformio.ini, connect the centrals
+ * before the sweep) and on the host with the fakes of the native build
+ * (tools/stress_sweep, which also sweeps the number of centrals).
+ * The configuration in use before the sweep is stored again at the end.
+ *
+ * Results are printed one per line, CSV prefixed with "stress," and the saturation point
+ * prefixed with "stress_sat,":
+ *   stress,plants,centrals,task1_ms,elapsed_ms,samples,dropped_samples,task1_max_us,cpu0_pct,cpu1_pct,notify_sent,notify_dropped
+ *   stress_sat,plants,centrals,task1_ms,reason,failed_windows,failed_ms (task1_ms 0 and
+ *   reason "none" if not reached; failed_ms slowest failing window outside the saturation,
+ *   0 if none)
+ *
+ * The following functions will be implemented:
+ * - stress_init() to start the sweep task
+ * - stress_temperature() to read a synthetic temperature sensor
+ * - stress_print() to print the result of a step
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __STRESS_H__
+#define __STRESS_H__
+
+#include "Arduino.h"
+#include "smartplant.h"
+#include "telemetry.h"
+#include "HAL/i2c_mux.h"
+
+#ifndef STRESS_MODE
+#define STRESS_MODE 0 // 1 synthetic temperature sensors and load sweep (see [env:stress])
+#endif
+
+#if STRESS_MODE && (ADAPTIVE_SAMPLING || !TELEMETRY_STAGE_HOOK || TELEMETRY_MODE)
+#error "build with -DADAPTIVE_SAMPLING=0 -DTELEMETRY_STAGE_HOOK=1 and without TELEMETRY_MODE"
+#endif
+
+#ifndef STRESS_RATES_MS
+#define STRESS_RATES_MS 1000, 500, 200, 100, 50, 20, 10 // Task1 periods of the sweep
+#endif
+#ifndef STRESS_STEP_MS
+#define STRESS_STEP_MS 20000 // measure window of each period
+#endif
+#define STRESS_WARMUP_MS 5000 // boot to first step
+#define STRESS_SETTLE_MS 2000 // period change to measure window
+#ifndef STRESS_SENSOR_US
+#define STRESS_SENSOR_US 600 // I2C time of a synthetic BMP280 read, 100 kHz
+#endif
+#define STRESS_SENSORS (NUM_PLANTS < I2CMUX_MAX_SENSORS ? NUM_PLANTS : I2CMUX_MAX_SENSORS)
+#define STRESS_TEMP_PERIOD_S 60 // synthetic temperature swing crossing the hot threshold, all plants in phase
+#define STRESS_TASK_PRIO 4 // above the firmware tasks: the report must not starve
+#define STRESS_TASK_CORE 0
+#define STRESS_NUM_CORES 2
+#define STRESS_FW_CORE 1 // core of Task1, Task2 and Task3 (scheduler_init())
+#define STRESS_MAX_DEPTH 8 // nested task stages per core (preemptions)
+#define STRESS_PREFIX "stress" // first CSV column of every step line
+#define STRESS_SAT_PREFIX "stress_sat" // first CSV column of the saturation line
+
+typedef struct
+{
+  uint16_t  plants; // NUM_PLANTS of the build
+  uint8_t   centrals; // BLE centrals connected at the end of the window
+  uint16_t  task1_ms; // Task1 period
+  uint32_t  elapsed_ms; // measure window
+  uint32_t  samples; // Task1 cycles in the window
+  uint32_t  dropped_samples; // periods of the window without a cycle
+  uint32_t  task1_max_us; // longest Task1 job
+  float     cpu0_pct; // core 0 not idle, NAN without run time stats
+  float     cpu1_pct; // time in the task stages on STRESS_FW_CORE
+  uint32_t  notify_sent; // BLE notifications sent, one per central
+  uint32_t  notify_dropped; // BLE notifications refused by the stack
+}StressStep_t;
+
+/**
+ * @brief Start the sweep task
+ *
+ * Called by scheduler_init() once the configuration is loaded, before the firmware tasks.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void stress_init();
+
+/**
+ * @brief Read a synthetic temperature sensor
+ *
+ * Spend STRESS_SENSOR_US like the I2C read of a BMP280 and return a swing of
+ * STRESS_TEMP_PERIOD_S, the same for every sensor so the alarms of all the plants are
+ * raised together.
+ *
+ * @param sensor 8-bit value that indicate sensor index
+ *
+ * @return float temperature in °C
+ */
+float stress_temperature(uint8_t sensor);
+
+/**
+ * @brief Print the result of a step
+ *
+ * Print one CSV line on Serial.
+ *
+ * @param r StressStep_t struct pointer
+ *
+ * @return void
+ */
+void stress_print(const StressStep_t* r);
+
+#endif /* __STRESS_H__ */
@@ -0,0 +1,148 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file telemetry.h
+ * @brief this file contain the functions prototype of the binary telemetry stream
+ *
+ * With TELEMETRY_MODE=1 every raw ADC sample, processed value and stage timing is queued
+ * and sent on Serial at TELEMETRY_BAUD in COBS + CRC16 frames (decoded on the host by
+ * tools/telemetry_decode). Text output is disabled and deferred log records are sent as
+ * frames too. With TELEMETRY_MODE=0 every call compiles to nothing.
+ * The raw records (ADC, BMP280, digital inputs) are a complete trace of the sensor inputs:
+ * tools/trace_replay runs the firmware on the fakes of the native build against a decoded
+ * trace (record with [env:trace] in platformio.ini).
+ * The stages timed by TELEMETRY_TIME() are also the stages of the host scheduler model
+ * (tools/sched_model, TELEMETRY_STAGE_HOOK=1), which charges them a simulated cost.
+ *
+ * The following functions will be implemented:
+ * - telemetry_init() to start the transmit task and the high-rate capture
+ * - telemetry_emit() to queue a record
+ * - telemetry_emit_float() to queue a processed value
+ * - telemetry_send_log() to send a deferred log record as a frame
+ * - telemetry_send_records() to send plant records as frames
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "common.h"
+#include "frame.h"
+#include "telemetry_fmt.h"
+#include "record.h"
+
+#define TELEMETRY_BAUD 921600 // UART baud rate in telemetry mode
+#define TELEMETRY_QUEUE_SIZE 512 // records waiting for the transmit task
+#define TELEMETRY_BATCH 20 // records per frame
+#define TELEMETRY_PLANT_RECORDS (uint8_t)((TELEMETRY_BATCH * sizeof(TlmRecord_t) - RECORD_HEADER_SIZE) / RECORD_BYTES) // plant records per frame
+#ifndef TELEMETRY_RAW_RATE_HZ
+#define TELEMETRY_RAW_RATE_HZ 2000 // high-rate capture of the humidity pin, 0 to disable
+#endif
+#define TELEMETRY_TASK_PRIO 1
+#define TELEMETRY_TASK_CORE 0
+
+#ifndef TELEMETRY_STAGE_HOOK
+#define TELEMETRY_STAGE_HOOK 0 // 1 without TELEMETRY_MODE: timed stages call the host hooks below (tools/sched_model)
+#endif
+
+#if TELEMETRY_MODE
+/**
+ * @brief Initialize telemetry
+ *
+ * Create the record queue, the transmit task and, if TELEMETRY_RAW_RATE_HZ is not zero,
+ * the periodic capture of the given analog pin.
+ *
+ * @param capture_pin 8-bit value that indicate pin captured at TELEMETRY_RAW_RATE_HZ
+ *
+ * @return void
+ */
+void telemetry_init(uint8_t capture_pin);
+
+/**
+ * @brief Queue a telemetry record
+ *
+ * Never blocks: if the queue is full the record is dropped (visible as a seq gap).
+ *
+ * @param type 8-bit value that indicate record type (TlmType_t)
+ * @param channel 8-bit value that indicate channel, field or stage
+ * @param value 32-bit raw value
+ *
+ * @return void
+ */
+void telemetry_emit(uint8_t type, uint8_t channel, uint32_t value);
+
+/**
+ * @brief Queue a processed value
+ *
+ * @param field 8-bit value that indicate field (TlmField_t)
+ * @param value processed value
+ *
+ * @return void
+ */
+void telemetry_emit_float(uint8_t field, float value);
+
+/**
+ * @brief Send a deferred log record
+ *
+ * @param rec LogRecord_t struct pointer
+ *
+ * @return void
+ */
+void telemetry_send_log(const LogRecord_t* rec);
+
+/**
+ * @brief Send plant records
+ *
+ * Sent at once as TLM_FRAME_PLANT frames of TELEMETRY_PLANT_RECORDS records at most,
+ * not through the record queue.
+ *
+ * @param r pointer to the records, in time order
+ * @param count number of records
+ *
+ * @return void
+ */
+void telemetry_send_records(const PlantRecord_t* r, uint8_t count);
+
+#define TELEMETRY_TIME(stage, stmt) do { uint32_t _tlm_t0 = micros(); stmt; \
+  telemetry_emit(TLM_TIMING, stage, micros() - _tlm_t0); } while (0)
+#else
+static inline void telemetry_init(uint8_t capture_pin) {}
+static inline void telemetry_emit(uint8_t type, uint8_t channel, uint32_t value) {}
+static inline void telemetry_emit_float(uint8_t field, float value) {}
+static inline void telemetry_send_log(const LogRecord_t* rec) {}
+static inline void telemetry_send_records(const PlantRecord_t* r, uint8_t count) {}
+#if TELEMETRY_STAGE_HOOK
+/**
+ * @brief Stage start, implemented by the host tool
+ *
+ * @param stage 8-bit value that indicate stage (TlmStage_t)
+ *
+ * @return void
+ */
+void telemetry_stage_begin(uint8_t stage);
+
+/**
+ * @brief Stage end, implemented by the host tool
+ *
+ * @param stage 8-bit value that indicate stage (TlmStage_t)
+ *
+ * @return void
+ */
+void telemetry_stage_end(uint8_t stage);
+
+#define TELEMETRY_TIME(stage, stmt) do { telemetry_stage_begin(stage); stmt; telemetry_stage_end(stage); } while (0)
+#else
+#define TELEMETRY_TIME(stage, stmt) do { stmt; } while (0)
+#endif
+#endif
+
+#endif /* __TELEMETRY_H__ */
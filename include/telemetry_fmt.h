@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file telemetry_fmt.h
+ * @brief this file contain the payload format of the binary telemetry frames
+ *
+ * Each frame (see frame.h) carries one payload:
+ * - TLM_FRAME_RECORDS: kind, version, count, count x TlmRecord_t
+ * - TLM_FRAME_LOG: kind, version, one LogRecord_t of the deferred logger
+ * - TLM_FRAME_PLANT: kind, version, count, one plant record batch of count records
+ *   (see record.h)
+ * All fields are little endian. This file has no dependency on Arduino so it can be
+ * shared with host tools.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __TELEMETRY_FMT_H__
+#define __TELEMETRY_FMT_H__
+
+#include <stdint.h>
+
+#define TLM_VERSION 1
+#define TLM_HEADER_SIZE 3 // kind, version, count
+#define TLM_FRAME_RECORDS 1
+#define TLM_FRAME_LOG 2
+#define TLM_FRAME_PLANT 3
+
+typedef enum {
+  TLM_RAW_ADC = 1, // raw analogRead() of the sampling pipeline, channel = analog channel
+  TLM_FILTERED, // processed value as float bits, channel = TlmField_t
+  TLM_TIMING, // stage duration in microseconds, channel = TlmStage_t
+  TLM_RAW_CAPTURE, // raw high-rate capture of the humidity pin
+  TLM_RAW_TEMPERATURE, // BMP280 value after each read as float bits, channel = sensor index
+  TLM_RAW_DIGITAL // digitalRead() of the sampling pipeline, channel = digital channel
+}TlmType_t;
+
+typedef enum {
+  TLM_FIELD_TEMPERATURE = 0,
+  TLM_FIELD_HUMIDITY,
+  TLM_FIELD_SOLAR
+}TlmField_t;
+
+typedef enum {
+  TLM_STAGE_TEMPERATURE = 0,
+  TLM_STAGE_SOLAR,
+  TLM_STAGE_HUMIDITY,
+  TLM_STAGE_ALARM,
+  TLM_STAGE_DISPLAY,
+  TLM_STAGE_TASK1,
+  TLM_STAGE_TASK2,
+  TLM_STAGE_TASK3,
+  TLM_STAGE_ALARM_NOTIFY, // alarm crossing to BLE notify latency
+  TLM_STAGE_STATS
+}TlmStage_t;
+
+typedef struct __attribute__((packed))
+{
+  uint8_t   type; // TlmType_t
+  uint8_t   channel; // meaning depends on type
+  uint16_t  seq; // incremented for every emitted record, gaps mean dropped records
+  uint32_t  ts_us; // micros() at emission
+  uint32_t  value; // raw value, float bits for TLM_FILTERED and TLM_RAW_TEMPERATURE
+}TlmRecord_t;
+
+static_assert(sizeof(TlmRecord_t) == 12, "TlmRecord_t is part of the telemetry format");
+
+#endif /* __TELEMETRY_FMT_H__ */
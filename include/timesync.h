@@ -0,0 +1,81 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file timesync.h
+ * @brief this file contain the functions prototype of the wall clock sync
+ *
+ * Sample times are taken on the esp_timer clock (microseconds since boot). A BLE client
+ * can write its wall clock (Unix time in milliseconds, u64 little endian) to the time
+ * characteristic: the offset between the two clocks converts any sample time to Unix
+ * time. The write is taken at reception, the accuracy is about one BLE connection
+ * interval; every new sync replaces the offset and logs the correction (clock drift).
+ *
+ * The following functions will be implemented:
+ * - timesync_request() to handle a wall clock written over BLE
+ * - timesync_set() to set the wall clock
+ * - timesync_to_unix_us() to convert a sample time to Unix time
+ * - timesync_print() to print the sync status
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __TIMESYNC_H__
+#define __TIMESYNC_H__
+
+#include "common.h"
+
+#define TIMESYNC_MIN_UNIX_MS 1577836800000ULL // 2020-01-01, older clocks are refused
+
+/**
+ * @brief Handle a wall clock written over BLE
+ *
+ * Called from the BLE stack task with the written bytes: Unix time in milliseconds,
+ * u64 little endian.
+ *
+ * @param data pointer to the written bytes
+ * @param len number of bytes
+ *
+ * @return bool true if accepted, false otherwise
+ */
+bool timesync_request(const uint8_t* data, size_t len);
+
+/**
+ * @brief Set the wall clock
+ *
+ * @param unix_ms Unix time in milliseconds at now_us
+ * @param now_us esp_timer time
+ *
+ * @return bool true if accepted, false if older than TIMESYNC_MIN_UNIX_MS
+ */
+bool timesync_set(uint64_t unix_ms, int64_t now_us);
+
+/**
+ * @brief Convert a sample time to Unix time
+ *
+ * @param at_us esp_timer time
+ * @param unix_us pointer to the Unix time in microseconds
+ *
+ * @return bool true if the wall clock has been set, false otherwise
+ */
+bool timesync_to_unix_us(int64_t at_us, int64_t* unix_us);
+
+/**
+ * @brief Print the sync status
+ *
+ * Syncs, age of the last one and its correction.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void timesync_print();
+
+#endif /* __TIMESYNC_H__ */
@@ -0,0 +1,189 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file tsdb.h
+ * @brief this file contain the functions prototype of the append-only time-series store
+ *
+ * Samples are appended in RAM blocks and flushed to a flash partition organised as a
+ * circular list of sectors (wear leveling: sectors are erased round robin, the oldest
+ * data is dropped when the partition is full).
+ *
+ * Sector: header (magic, sequence, first timestamp, CRC) followed by blocks.
+ * Block:  header (payload length, record count, CRC16) + payload. The payload is a key
+ *         sample followed by a bitstream of delta records:
+ *         - time:  '0' same interval | '10' + 7-bit delta-of-delta | '11' + 32-bit interval
+ *         - value: '0' unchanged | '10' + 4-bit delta | '110' + 8-bit delta | '111' + 16-bit value
+ *         - flags: '0' unchanged | '1' + 8-bit solar + 1-bit alarm
+ *
+ * The RAM block is flushed when full or when its first sample is TSDB_FLUSH_S old, so a
+ * power loss drops at most TSDB_FLUSH_S + 1 samples at 1 Hz (RAM block, or the block
+ * torn while written) instead of a full block (255 samples).
+ * A torn block (power loss during write) fails its CRC and is skipped at mount, a torn
+ * sector header makes the sector unused. Lookup by time is a binary search on the
+ * sector index kept in RAM followed by a scan of at most one sector.
+ * A store holds one series: samples have no plant id and timestamps must increase.
+ * This file has no dependency on Arduino so it can be built on the host.
+ *
+ * The following functions will be implemented:
+ * - tsdb_mount() to scan the partition and rebuild the RAM index
+ * - tsdb_append() to add a sample
+ * - tsdb_flush() to write the RAM block to flash
+ * - tsdb_flush_aged() to write the RAM block to flash once it is TSDB_FLUSH_S old
+ * - tsdb_query() to read the samples of a time range
+ * - tsdb_last_ts() to get the timestamp of the newest sample
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __TSDB_H__
+#define __TSDB_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TSDB_MAGIC 0x42445354 // "TSDB"
+#define TSDB_VERSION 1
+#define TSDB_MAX_SECTORS 512 // RAM index size, 2 MB partition with 4 KB sectors
+#define TSDB_BLOCK_BYTES 256 // maximum payload of a block
+#define TSDB_BLOCK_RECORDS 255 // maximum records of a block
+#define TSDB_SECTOR_HEADER 16
+#define TSDB_BLOCK_HEADER 5
+#define TSDB_KEY_BYTES 10 // key sample: ts, temperature, humidity, solar, alarm
+#define TSDB_MAX_RECORD_BITS 82 // worst case delta record
+#ifndef TSDB_FLUSH_S
+#define TSDB_FLUSH_S 60 // age of the RAM block that forces a flush, bound of the data lost at power loss
+#endif
+
+typedef struct
+{
+  uint32_t  ts; // seconds
+  int16_t   temperature; // 0.1 degrees Celsius
+  uint16_t  humidity; // 0.1 percent
+  uint8_t   solar; // solar intensity status
+  uint8_t   alarm; // alarm status
+}TsdbSample_t;
+
+typedef struct Flash_s
+{
+  uint32_t  sector_size; // erase unit in bytes
+  uint16_t  sector_count; // sectors in the partition
+  bool (*read)(struct Flash_s* f, uint32_t addr, void* dst, size_t len);
+  bool (*write)(struct Flash_s* f, uint32_t addr, const void* src, size_t len); // NOR: bits 1 -> 0 only
+  bool (*erase)(struct Flash_s* f, uint16_t sector); // set sector to 0xFF
+  void*     ctx; // backend data
+}Flash_t;
+
+typedef struct
+{
+  uint32_t  samples; // samples appended
+  uint32_t  blocks; // blocks written
+  uint32_t  bytes_written; // bytes programmed (headers included)
+  uint32_t  erases; // sectors erased
+  uint32_t  torn_blocks; // blocks skipped at mount
+}TsdbStats_t;
+
+typedef struct
+{
+  Flash_t*      flash;
+  uint16_t      count; // sectors with data
+  uint16_t      order[TSDB_MAX_SECTORS]; // sector numbers, oldest first
+  uint32_t      first_ts[TSDB_MAX_SECTORS]; // first timestamp of order[i]
+  uint32_t      seq; // sequence of the newest sector
+  uint32_t      write_off; // next free offset in the newest sector
+  // RAM block
+  uint8_t       block[TSDB_BLOCK_BYTES];
+  uint16_t      bit_pos; // bits used in block
+  uint8_t       block_count; // records in block
+  uint32_t      block_ts; // timestamp of the key sample of block
+  TsdbSample_t  last; // newest sample (flash or RAM)
+  uint32_t      last_dt; // interval between the last two samples
+  bool          has_last;
+  TsdbStats_t   stats;
+}Tsdb_t;
+
+/**
+ * @brief Mount the store
+ *
+ * Read all sector headers, rebuild the index, find the write position of the newest
+ * sector and the newest sample. Sectors not holding a valid header are reused.
+ *
+ * @param db Tsdb_t struct pointer
+ * @param flash Flash_t struct pointer of the partition
+ *
+ * @return bool true if the partition geometry is supported, false otherwise
+ */
+bool tsdb_mount(Tsdb_t* db, Flash_t* flash);
+
+/**
+ * @brief Append a sample
+ *
+ * Encode the sample in the RAM block, the block is flushed when full or when the sample
+ * is TSDB_FLUSH_S newer than the first one of the block.
+ * Samples must have increasing timestamps, older samples are rejected.
+ *
+ * @param db Tsdb_t struct pointer
+ * @param s TsdbSample_t struct pointer
+ *
+ * @return bool true if the sample has been stored, false otherwise
+ */
+bool tsdb_append(Tsdb_t* db, const TsdbSample_t* s);
+
+/**
+ * @brief Flush the RAM block
+ *
+ * Write the RAM block to flash (samples in RAM are lost on power loss).
+ *
+ * @param db Tsdb_t struct pointer
+ *
+ * @return bool true on success or empty block, false on flash error
+ */
+bool tsdb_flush(Tsdb_t* db);
+
+/**
+ * @brief Flush the RAM block once it is old
+ *
+ * Flush the RAM block if its first sample is TSDB_FLUSH_S older than now, to keep the
+ * bound of tsdb_append() while no sample is appended.
+ *
+ * @param db Tsdb_t struct pointer
+ * @param now timestamp of now
+ *
+ * @return bool true on success, empty or recent block, false on flash error
+ */
+bool tsdb_flush_aged(Tsdb_t* db, uint32_t now);
+
+/**
+ * @brief Query a time range
+ *
+ * Call cb for every sample with from <= ts <= to, in time order, RAM block included.
+ * The callback returns false to stop the query.
+ *
+ * @param db Tsdb_t struct pointer
+ * @param from first timestamp
+ * @param to last timestamp
+ * @param cb callback function
+ * @param arg argument for the callback
+ *
+ * @return uint32_t number of samples passed to the callback
+ */
+uint32_t tsdb_query(Tsdb_t* db, uint32_t from, uint32_t to,
+                    bool (*cb)(const TsdbSample_t* s, void* arg), void* arg);
+
+/**
+ * @brief Get timestamp of the newest sample
+ *
+ * @param db Tsdb_t struct pointer
+ *
+ * @return uint32_t newest timestamp, 0 if the store is empty
+ */
+uint32_t tsdb_last_ts(Tsdb_t* db);
+
+#endif /* __TSDB_H__ */
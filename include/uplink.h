@@ -0,0 +1,159 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file uplink.h
+ * @brief this file contain the functions prototype of the Wi-Fi MQTT uplink
+ *
+ * With WIFI_UPLINK=1 the samples of all plants are published to an MQTT broker, without a
+ * phone in range. Task1 pushes one record per plant and cycle in a RAM ring; the Uplink
+ * task (core 0, next to the BLE stack) publishes them in batches with QoS 1, one batch in
+ * flight, every Config_t uplink_s seconds or as soon as a batch is full.
+ * While Wi-Fi or the broker is down the ring keeps the newest UPLINK_RAM_RECORDS records;
+ * the plant 1 records it overwrites are in the flash history, and are read back from
+ * there by Task1 (store and forward). The newest acknowledged plant 1 timestamp is saved
+ * in NVS, so the records of a power cycle spent offline are published after the reset.
+ * On reconnection the backlog is drained at most one batch per UPLINK_DRAIN_MS.
+ *
+ * The payload on UPLINK_TOPIC is a plant record batch (see record.h), a record is sent at
+ * least once. Timestamps are the ones of the flash history (continue across resets).
+ * The functions exist only with WIFI_UPLINK=1.
+ *
+ * The following functions will be implemented:
+ * - uplink_init() to start the uplink
+ * - uplink_push() to queue the data of all plants
+ * - uplink_run() to read back the flash backlog
+ * - uplink_get_stats() to get the uplink metrics
+ * - uplink_print() to print the uplink metrics
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __UPLINK_H__
+#define __UPLINK_H__
+
+#include "smartplant.h"
+#include "record.h"
+
+#ifndef WIFI_UPLINK
+#define WIFI_UPLINK 0 // 1 publish the samples over Wi-Fi/MQTT
+#endif
+#ifndef UPLINK_WIFI_SSID
+#define UPLINK_WIFI_SSID "smartplant"
+#endif
+#ifndef UPLINK_WIFI_PASS
+#define UPLINK_WIFI_PASS ""
+#endif
+#ifndef UPLINK_MQTT_HOST
+#define UPLINK_MQTT_HOST "192.168.1.10"
+#endif
+#ifndef UPLINK_MQTT_PORT
+#define UPLINK_MQTT_PORT 1883
+#endif
+#ifndef UPLINK_CLIENT_ID
+#define UPLINK_CLIENT_ID "smartplant-1" // MQTT client identifier, one per node
+#endif
+#define UPLINK_TOPIC "smartplant/" UPLINK_CLIENT_ID "/samples"
+
+#define UPLINK_PUBLISH_S 60 // publish interval (runtime: Config_t uplink_s)
+#ifndef UPLINK_RAM_RECORDS
+#define UPLINK_RAM_RECORDS 256 // records kept in RAM while offline, 16 bytes each
+#endif
+#define UPLINK_BATCH_RECORDS 32 // records per payload
+#define UPLINK_DRAIN_MS 1000 // shortest time between two publishes: drain rate of the backlog
+#define UPLINK_POLL_MS 100 // period of the Uplink task
+#define UPLINK_KEEPALIVE_S 120
+#define UPLINK_RETRY_MIN_MS 5000 // Wi-Fi and broker reconnection backoff
+#define UPLINK_RETRY_MAX_MS 300000
+#define UPLINK_CHECKPOINT_MS 60000 // acknowledged timestamp saved in NVS at most this often
+#define UPLINK_NVS_NAMESPACE "uplink" // Preferences namespace of the acknowledged timestamp
+#define UPLINK_TASK_STACK 4096
+#define UPLINK_TASK_PRIO 1
+#define UPLINK_TASK_CORE 0
+
+#define UPLINK_PAYLOAD_MAX RECORD_BATCH_SIZE(UPLINK_BATCH_RECORDS)
+
+static_assert((UPLINK_RAM_RECORDS & (UPLINK_RAM_RECORDS - 1)) == 0, "ring indexed by a free-running sequence");
+
+typedef struct
+{
+  uint32_t  pushed; // records queued by Task1
+  uint32_t  acked; // records of acknowledged batches
+  uint32_t  lost; // records overwritten in RAM and not in the flash history
+  uint32_t  batches; // batches acknowledged
+  uint32_t  payload_bytes; // payload bytes of acknowledged batches
+  uint16_t  payload_max; // largest payload
+  uint32_t  flash_records; // records read back from the flash history
+  uint32_t  backlog; // records waiting in the RAM ring
+  uint32_t  backlog_max; // largest RAM backlog
+  uint32_t  flash_s; // time span of the flash backlog
+  uint32_t  reconnects; // Wi-Fi and broker sessions after the first
+  uint32_t  retransmits; // batches sent again (DUP)
+  bool      up; // broker session up
+}UplinkStats_t;
+
+/**
+ * @brief Start the uplink
+ *
+ * Load the acknowledged timestamp from NVS, schedule the flash records after it and
+ * start the Uplink task. Call after smartplant_history_init().
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void uplink_init();
+
+/**
+ * @brief Queue the data of all plants
+ *
+ * Called by Task1 after the sampling pipeline. When the ring is full the oldest record
+ * is overwritten; plant 1 records stored in the flash history are read back later.
+ *
+ * @param r pointer to the records of the cycle, one per plant
+ * @param count 8-bit value that indicate number of records
+ *
+ * @return void
+ */
+void uplink_push(const PlantRecord_t* r, uint8_t count);
+
+/**
+ * @brief Read back the flash backlog
+ *
+ * Called by Task1, the only user of the flash history: read the next batch of the flash
+ * backlog when the Uplink task asks for it.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void uplink_run();
+
+/**
+ * @brief Get the uplink metrics
+ *
+ * @param out UplinkStats_t struct pointer
+ *
+ * @return void
+ */
+void uplink_get_stats(UplinkStats_t* out);
+
+/**
+ * @brief Print the uplink metrics
+ *
+ * Batches, records per batch, payload size, backlog and reconnections.
+ *
+ * @param NO PARAMETERS
+ *
+ * @return void
+ */
+void uplink_print();
+
+#endif /* __UPLINK_H__ */
@@ -0,0 +1,34 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file Adafruit_BMP280.h
+ * @brief BMP280 driver fake of the native build, temperatures come from native.h
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_ADAFRUIT_BMP280_H__
+#define __NATIVE_ADAFRUIT_BMP280_H__
+
+#include "Adafruit_Sensor.h"
+#include "Wire.h"
+
+class Adafruit_BMP280
+{
+public:
+  Adafruit_BMP280(TwoWire* wire = &Wire);
+  bool begin(uint8_t addr = 0x77, uint8_t chipid = 0x58);
+  float readTemperature();
+private:
+  int16_t sensor_; // index in the fake sensor table, -1 until begin()
+};
+
+#endif /* __NATIVE_ADAFRUIT_BMP280_H__ */
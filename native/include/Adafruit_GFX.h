@@ -0,0 +1,49 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file Adafruit_GFX.h
+ * @brief Adafruit GFX fake of the native build: text is kept in a character grid
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_ADAFRUIT_GFX_H__
+#define __NATIVE_ADAFRUIT_GFX_H__
+
+#include "Arduino.h"
+
+#define NATIVE_GFX_COLS 21 // 6x8 font on 128x64
+#define NATIVE_GFX_ROWS 8
+
+class Adafruit_GFX
+{
+public:
+  void setCursor(int16_t x, int16_t y);
+  void setTextSize(uint8_t size);
+  void setTextColor(uint16_t color);
+  size_t print(const char* s);
+  size_t print(char c);
+  size_t print(int v);
+  size_t print(unsigned v);
+  size_t print(long v);
+  size_t print(unsigned long v);
+  size_t print(double v, int digits = 2);
+  size_t println(const char* s);
+  size_t println(int v);
+  size_t println(double v, int digits = 2);
+  size_t println();
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+protected:
+  char    grid_[NATIVE_GFX_ROWS][NATIVE_GFX_COLS + 1];
+  uint8_t row_, col_;
+};
+
+#endif /* __NATIVE_ADAFRUIT_GFX_H__ */
@@ -0,0 +1,37 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file Adafruit_SSD1306.h
+ * @brief SSD1306 driver fake of the native build, frames are read with native.h
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_ADAFRUIT_SSD1306_H__
+#define __NATIVE_ADAFRUIT_SSD1306_H__
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_WHITE 1
+#define SSD1306_BLACK 0
+
+class Adafruit_SSD1306 : public Adafruit_GFX
+{
+public:
+  Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* wire, int8_t rst);
+  bool begin(uint8_t vcs, uint8_t addr);
+  void clearDisplay();
+  void display();
+};
+
+#endif /* __NATIVE_ADAFRUIT_SSD1306_H__ */
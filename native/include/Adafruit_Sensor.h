@@ -0,0 +1,23 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file Adafruit_Sensor.h
+ * @brief Adafruit unified sensor fake of the native build
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_ADAFRUIT_SENSOR_H__
+#define __NATIVE_ADAFRUIT_SENSOR_H__
+
+#include <math.h>
+
+#endif /* __NATIVE_ADAFRUIT_SENSOR_H__ */
@@ -0,0 +1,74 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file Arduino.h
+ * @brief Arduino core fake of the native build
+ *
+ * The subset of the ESP32 Arduino core used by the firmware. Pins, ADC and clock are
+ * driven by the fakes in native/src, see native.h to set them from a host program.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_ARDUINO_H__
+#define __NATIVE_ARDUINO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+class HardwareSerial
+{
+public:
+  void begin(unsigned long baud);
+  int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char* s);
+  size_t println(const char* s);
+  size_t write(uint8_t c);
+  size_t write(const uint8_t* data, size_t len);
+  int available();
+  int read();
+  int availableForWrite();
+  void flush();
+};
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz();
+};
+extern EspClass ESP;
+
+#endif /* __NATIVE_ARDUINO_H__ */
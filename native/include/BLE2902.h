@@ -0,0 +1,23 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file BLE2902.h
+ * @brief BLE descriptor fake of the native build
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_BLE2902_H__
+#define __NATIVE_BLE2902_H__
+
+#include "BLEDevice.h"
+
+#endif /* __NATIVE_BLE2902_H__ */
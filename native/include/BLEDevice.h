@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file BLEDevice.h
+ * @brief BLE stack fake of the native build: values and notifications are kept per characteristic, a central is simulated with native.h
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_BLEDEVICE_H__
+#define __NATIVE_BLEDEVICE_H__
+
+#include "Arduino.h"
+#include <vector>
+
+class BLECharacteristic;
+class BLEServer;
+
+class BLEDescriptor
+{
+};
+
+class BLE2902 : public BLEDescriptor
+{
+};
+
+class BLECharacteristicCallbacks
+{
+public:
+  typedef enum
+  {
+    SUCCESS_INDICATE,
+    SUCCESS_NOTIFY,
+    ERROR_INDICATE_DISABLED,
+    ERROR_NOTIFY_DISABLED,
+    ERROR_GATT,
+    ERROR_NO_CLIENT,
+    ERROR_INDICATE_TIMEOUT,
+    ERROR_INDICATE_FAILURE
+  }Status;
+
+  virtual ~BLECharacteristicCallbacks() {}
+  virtual void onRead(BLECharacteristic* c) {}
+  virtual void onWrite(BLECharacteristic* c) {}
+  virtual void onStatus(BLECharacteristic* c, Status s, uint32_t code) {}
+};
+
+class BLECharacteristic
+{
+public:
+  static const uint32_t PROPERTY_READ = 1 << 0;
+  static const uint32_t PROPERTY_WRITE = 1 << 1;
+  static const uint32_t PROPERTY_NOTIFY = 1 << 2;
+  static const uint32_t PROPERTY_INDICATE = 1 << 3;
+  static const uint32_t PROPERTY_WRITE_NR = 1 << 4;
+
+  BLECharacteristic(const char* uuid, uint32_t properties);
+  void setValue(uint8_t* data, size_t len);
+  void setValue(uint16_t& v);
+  void setValue(uint32_t& v);
+  void setValue(int& v);
+  void setValue(float& v);
+  std::string getValue();
+  uint8_t* getData();
+  size_t getLength();
+  void notify(bool is_notification = true);
+  void addDescriptor(BLEDescriptor* d);
+  void setCallbacks(BLECharacteristicCallbacks* cb);
+
+  std::string                 uuid;
+  uint32_t                    properties;
+  std::vector<uint8_t>        value;
+  BLECharacteristicCallbacks* callbacks;
+  uint32_t                    notifications; // sent to at least one central
+};
+
+class BLEUUID
+{
+public:
+  BLEUUID(const char* uuid) : uuid_(uuid) {}
+  const char* c_str() const { return uuid_; }
+private:
+  const char* uuid_;
+};
+
+class BLEService
+{
+public:
+  BLECharacteristic* createCharacteristic(const char* uuid, uint32_t properties);
+  void start();
+};
+
+class BLEAdvertising
+{
+public:
+  void start();
+  void stop();
+};
+
+class BLEServerCallbacks
+{
+public:
+  virtual ~BLEServerCallbacks() {}
+  virtual void onConnect(BLEServer* server) {}
+  virtual void onDisconnect(BLEServer* server) {}
+};
+
+class BLEServer
+{
+public:
+  BLEService* createService(const char* uuid);
+  BLEService* createService(BLEUUID uuid, uint32_t numHandles = 15, uint8_t inst_id = 0);
+  void setCallbacks(BLEServerCallbacks* cb);
+  BLEAdvertising* getAdvertising();
+  uint32_t getConnectedCount();
+};
+
+class BLEDevice
+{
+public:
+  static void init(const char* name);
+  static BLEServer* createServer();
+};
+
+#endif /* __NATIVE_BLEDEVICE_H__ */
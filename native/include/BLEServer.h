@@ -0,0 +1,23 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file BLEServer.h
+ * @brief BLE server fake of the native build
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_BLESERVER_H__
+#define __NATIVE_BLESERVER_H__
+
+#include "BLEDevice.h"
+
+#endif /* __NATIVE_BLESERVER_H__ */
@@ -0,0 +1,42 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file Preferences.h
+ * @brief NVS Preferences fake of the native build, stored in RAM
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_PREFERENCES_H__
+#define __NATIVE_PREFERENCES_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+class Preferences
+{
+public:
+  bool begin(const char* name, bool read_only = false);
+  void end();
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buf, size_t len);
+  size_t putBytes(const char* key, const void* value, size_t len);
+  uint32_t getUInt(const char* key, uint32_t default_value = 0);
+  size_t putUInt(const char* key, uint32_t value);
+  bool remove(const char* key);
+  bool clear();
+private:
+  std::string ns_;
+  bool        read_only_;
+};
+
+#endif /* __NATIVE_PREFERENCES_H__ */
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file WiFi.h
+ * @brief WiFi and WiFiClient fakes of the native build
+ *
+ * The station joins a simulated access point and the client talks to an in-process MQTT
+ * broker, or to a real broker over a host socket (see native_broker_use_socket()).
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_WIFI_H__
+#define __NATIVE_WIFI_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum
+{
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+}wl_status_t;
+
+typedef enum
+{
+  WIFI_OFF = 0,
+  WIFI_STA = 1
+}wifi_mode_t;
+
+class WiFiClient
+{
+public:
+  WiFiClient() : fd_(-1), open_(false), session_(0) {}
+  int connect(const char* host, uint16_t port);
+  size_t write(const uint8_t* buf, size_t size);
+  int available();
+  int read(uint8_t* buf, size_t size);
+  uint8_t connected();
+  void stop();
+private:
+  int       fd_; // host socket, -1 with the in-process broker
+  bool      open_;
+  uint32_t  session_; // link generation at connect(), lost when it changes
+};
+
+class WiFiClass
+{
+public:
+  bool mode(wifi_mode_t m);
+  wl_status_t begin(const char* ssid, const char* pass = NULL);
+  bool reconnect();
+  bool disconnect(bool wifioff = false);
+  wl_status_t status();
+};
+
+extern WiFiClass WiFi;
+
+#endif /* __NATIVE_WIFI_H__ */
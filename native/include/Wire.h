@@ -0,0 +1,40 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file Wire.h
+ * @brief I2C fake of the native build
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_WIRE_H__
+#define __NATIVE_WIRE_H__
+
+#include "Arduino.h"
+
+class TwoWire
+{
+public:
+  bool begin();
+  void setClock(uint32_t hz);
+  void beginTransmission(uint8_t addr);
+  size_t write(uint8_t data);
+  uint8_t endTransmission(bool stop = true); // 0 ACK, 2 no device
+  uint8_t requestFrom(uint8_t addr, uint8_t len);
+  int read();
+private:
+  uint8_t addr_;
+  uint8_t last_;
+  bool    wrote_;
+};
+extern TwoWire Wire;
+
+#endif /* __NATIVE_WIRE_H__ */
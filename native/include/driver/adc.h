@@ -0,0 +1,29 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file adc.h
+ * @brief ADC driver fake of the native build (ULP humidity sampling)
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_DRIVER_ADC_H__
+#define __NATIVE_DRIVER_ADC_H__
+
+typedef enum { ADC1_CHANNEL_4 = 4, ADC1_CHANNEL_5, ADC1_CHANNEL_6, ADC1_CHANNEL_7 } adc1_channel_t;
+enum { ADC_WIDTH_BIT_12 = 3 };
+enum { ADC_ATTEN_DB_11 = 3 };
+
+void adc1_config_width(int width);
+void adc1_config_channel_atten(adc1_channel_t channel, int atten);
+void adc1_ulp_enable();
+
+#endif /* __NATIVE_DRIVER_ADC_H__ */
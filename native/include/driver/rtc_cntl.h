@@ -0,0 +1,26 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file rtc_cntl.h
+ * @brief RTC controller fake of the native build
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_DRIVER_RTC_CNTL_H__
+#define __NATIVE_DRIVER_RTC_CNTL_H__
+
+#include <stdint.h>
+#include "esp_err.h"
+
+esp_err_t rtc_isr_register(void (*handler)(void*), void* arg, uint32_t mask);
+
+#endif /* __NATIVE_DRIVER_RTC_CNTL_H__ */
@@ -0,0 +1,58 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file ulp.h
+ * @brief ULP coprocessor fake of the native build: programs compile, the ULP never runs (see tools/ulp_sim)
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_ESP32_ULP_H__
+#define __NATIVE_ESP32_ULP_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef struct { uint32_t word; } ulp_insn_t;
+enum { R0, R1, R2, R3 };
+
+#define NATIVE_ULP_INSN {0}
+#define I_MOVI(a, b) NATIVE_ULP_INSN
+#define I_MOVR(a, b) NATIVE_ULP_INSN
+#define I_ADC(a, b, c) NATIVE_ULP_INSN
+#define I_ST(a, b, c) NATIVE_ULP_INSN
+#define I_LD(a, b, c) NATIVE_ULP_INSN
+#define I_ADDI(a, b, c) NATIVE_ULP_INSN
+#define I_SUBI(a, b, c) NATIVE_ULP_INSN
+#define I_ANDI(a, b, c) NATIVE_ULP_INSN
+#define I_ORI(a, b, c) NATIVE_ULP_INSN
+#define I_RSHI(a, b, c) NATIVE_ULP_INSN
+#define I_ADDR(a, b, c) NATIVE_ULP_INSN
+#define I_SUBR(a, b, c) NATIVE_ULP_INSN
+#define I_ORR(a, b, c) NATIVE_ULP_INSN
+#define I_RD_REG(a, b, c) NATIVE_ULP_INSN
+#define M_BGE(a, b) NATIVE_ULP_INSN
+#define M_BL(a, b) NATIVE_ULP_INSN
+#define M_BX(a) NATIVE_ULP_INSN
+#define M_BXF(a) NATIVE_ULP_INSN
+#define M_BXZ(a) NATIVE_ULP_INSN
+#define M_LABEL(a) NATIVE_ULP_INSN
+#define I_WAKE() NATIVE_ULP_INSN
+#define I_HALT() NATIVE_ULP_INSN
+
+extern uint32_t RTC_SLOW_MEM[];
+
+esp_err_t ulp_process_macros_and_load(uint32_t addr, const ulp_insn_t* program, size_t* size);
+esp_err_t ulp_run(uint32_t entry);
+esp_err_t ulp_set_wakeup_period(size_t index, uint32_t period_us);
+
+#endif /* __NATIVE_ESP32_ULP_H__ */
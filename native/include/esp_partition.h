@@ -0,0 +1,44 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file esp_partition.h
+ * @brief Partition API fake of the native build, partitions live in RAM
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_ESP_PARTITION_H__
+#define __NATIVE_ESP_PARTITION_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef enum { ESP_PARTITION_TYPE_APP = 0, ESP_PARTITION_TYPE_DATA = 1 } esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+
+typedef struct
+{
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+}esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label);
+esp_err_t esp_partition_read(const esp_partition_t* p, size_t offset, void* dst, size_t len);
+esp_err_t esp_partition_write(const esp_partition_t* p, size_t offset, const void* src, size_t len); // NOR: bits 1 -> 0
+esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t offset, size_t len);
+
+#endif /* __NATIVE_ESP_PARTITION_H__ */
@@ -0,0 +1,25 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file esp_sleep.h
+ * @brief Sleep API fake of the native build
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_ESP_SLEEP_H__
+#define __NATIVE_ESP_SLEEP_H__
+
+#include "esp_err.h"
+
+esp_err_t esp_sleep_enable_ulp_wakeup();
+
+#endif /* __NATIVE_ESP_SLEEP_H__ */
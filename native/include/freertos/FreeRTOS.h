@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file FreeRTOS.h
+ * @brief FreeRTOS shim of the native build
+ *
+ * Tasks are coroutines on the host thread, one runs at a time (single core, as all the
+ * tasks of the firmware are pinned on core 1): the highest priority ready task holds the CPU until
+ * it calls a blocking function. Every FreeRTOS call is a scheduling point, so a higher
+ * priority task woken by a notify or a queue send runs at once; a task woken by its
+ * timeout waits for the next scheduling point (no tick preemption), except during the CPU
+ * time spent with native_spend_us() on the virtual clock, preempted as on the device.
+ * One tick is 1 ms. Critical sections are empty: no two tasks run together.
+ * CPU time is charged to the core a task is pinned to (ulTaskGetIdleRunTimeCounter()),
+ * but the two cores never run in parallel.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_FREERTOS_H__
+#define __NATIVE_FREERTOS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef struct NativeTask_s* TaskHandle_t;
+typedef struct NativeQueue_s* QueueHandle_t;
+
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define configGENERATE_RUN_TIME_STATS 1 // run time in us, like the esp_timer clock of ESP-IDF
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define errQUEUE_FULL 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+
+typedef struct { int owner; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(m) (void)(m)
+#define portEXIT_CRITICAL(m) (void)(m)
+#define portENTER_CRITICAL_ISR(m) (void)(m)
+#define portEXIT_CRITICAL_ISR(m) (void)(m)
+#define portYIELD_FROM_ISR() (void)0
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t core);
+BaseType_t xTaskCreate(void (*fn)(void*), const char* name, uint32_t stack, void* arg,
+                       UBaseType_t prio, TaskHandle_t* handle);
+void vTaskDelete(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task); // bytes, like ESP-IDF
+uint32_t ulTaskGetIdleRunTimeCounter(); // us the core of the caller ran no task
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* prev, TickType_t increment);
+BaseType_t xPortGetCoreID();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+const char* pcTaskGetName(TaskHandle_t task);
+
+uint32_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t timeout);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t timeout);
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t timeout);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+
+#endif /* __NATIVE_FREERTOS_H__ */
@@ -0,0 +1,399 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file native.h
+ * @brief this file contain the functions prototype to drive the fakes of the native build
+ *
+ * The native environment (pio run -e native) builds the unmodified firmware sources with
+ * the fakes of native/include and native/src: Arduino core, Wire/BMP280/SSD1306, BLE,
+ * Preferences, esp_partition, esp_pm, esp_timer and a FreeRTOS shim. A host program
+ * (native/src/native_main.cpp) sets the sensor inputs, plays a BLE central and reads the
+ * outputs (pins, OLED text, BLE values) with the functions below.
+ * Functions touching the firmware state must be called from a task of the shim (e.g.
+ * after native_attach()), like a task on the device.
+ *
+ * The following functions will be implemented:
+ * - native_clock_init() to start the clock of the native build
+ * - native_now_us() to read the clock
+ * - native_now_ns() to read the clock with the host resolution
+ * - native_spend_us() to spend CPU time in the running task
+ * - native_set_device_costs() to charge the bus and radio time of the fakes
+ * - native_device_costs() to know if the fakes charge their device time
+ * - native_attach() to turn the caller into a task of the shim
+ * - native_set_analog_source() to set the function giving the ADC readings
+ * - native_set_digital() to set the level of an input pin
+ * - native_set_digital_source() to set the function giving the input pin levels
+ * - native_get_digital() to read the level of a pin
+ * - native_bmp280_add() to connect a BMP280
+ * - native_set_temperature_source() to set the function giving the BMP280 temperatures
+ * - native_oled_present() to connect or remove the OLED
+ * - native_oled_frame() to get the text of the last OLED frame
+ * - native_oled_frames() to get the number of OLED frames
+ * - native_oled_set_frame_hook() to receive every OLED frame
+ * - native_ble_connect() to connect or disconnect the simulated central
+ * - native_ble_set_centrals() to set the number of simulated centrals
+ * - native_ble_find() to get a characteristic by UUID
+ * - native_ble_write() to write a characteristic from the central
+ * - native_ble_set_notify_hook() to receive the notifications
+ * - native_wifi_set_ap() to bring the simulated access point up or down
+ * - native_broker_set_up() to bring the in-process MQTT broker up or down
+ * - native_broker_drop_pubacks() to lose the next PUBACKs of the broker
+ * - native_broker_set_publish_hook() to receive the messages published to the broker
+ * - native_broker_use_socket() to connect to a real MQTT broker instead
+ * - native_serial_mute() to drop the Serial output
+ * - native_set_sched_hook() to receive the scheduling events
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_H__
+#define __NATIVE_H__
+
+#include "Arduino.h"
+#include "BLEDevice.h"
+
+#define NATIVE_NUM_PINS 40
+#define NATIVE_MAX_BMP280 16
+#define NATIVE_I2CMUX_NONE 0xFF // sensor on the main bus
+#define NATIVE_PIN_UNDRIVEN 0xFF // digital source does not drive the pin
+#define NATIVE_BLE_MAX_CENTRALS 8
+
+// device time charged by the fakes with native_set_device_costs(true)
+#define NATIVE_ADC_READ_US 20 // analogRead()
+#define NATIVE_BMP280_READ_US 600 // readTemperature(), 100 kHz I2C
+#define NATIVE_OLED_FRAME_US 23000 // display(), 1 KB at 400 kHz I2C
+#define NATIVE_BLE_NOTIFY_US 150 // notify(), per central
+#define NATIVE_BLE_CONN_INTERVAL_US 30000 // connection interval of every central
+#define NATIVE_BLE_PACKETS_PER_EVENT 4 // notifications sent per central and connection event
+#define NATIVE_BLE_TX_BUFFERS 10 // notifications queued per central, further ones are dropped
+#define NATIVE_WIFI_ASSOC_US 1500000 // WiFi.begin() or access point back to WL_CONNECTED
+
+typedef enum
+{
+  NATIVE_SCHED_READY = 0, // task released: created, timeout, notify or queue item
+  NATIVE_SCHED_RUN, // task takes the CPU
+  NATIVE_SCHED_PREEMPT, // task loses the CPU to a higher priority task
+  NATIVE_SCHED_BLOCK // task blocks in a FreeRTOS call
+}NativeSched_t;
+
+/**
+ * @brief Start the clock of the native build
+ *
+ * The clock starts at 0 and runs speed times faster than the host clock: millis(),
+ * micros(), esp_timer_get_time(), the tick count and every delay follow it.
+ * With speed 0 the clock is virtual: it stands still while a task runs (except for
+ * native_spend_us()) and jumps to the next timeout when all the tasks are blocked, so
+ * the run is as fast as the host allows and does not depend on the host load.
+ *
+ * @param speed ratio between device time and host time (1 real time, 0 virtual clock)
+ *
+ * @return void
+ */
+void native_clock_init(double speed);
+
+/**
+ * @brief Read the clock
+ *
+ * @param NO PARAMETERS
+ *
+ * @return int64_t device time in microseconds
+ */
+int64_t native_now_us();
+
+/**
+ * @brief Read the clock with the host resolution
+ *
+ * Used for the cycle counter (ESP.getCycleCount() counts 240 cycles per microsecond).
+ *
+ * @param NO PARAMETERS
+ *
+ * @return int64_t device time in nanoseconds
+ */
+int64_t native_now_ns();
+
+/**
+ * @brief Spend CPU time in the running task
+ *
+ * Busy wait like delayMicroseconds(): the task keeps the CPU. With the virtual clock the
+ * time is added to the clock, and a higher priority task released meanwhile preempts the
+ * caller at its timeout (tick preemption); the rest of the time is spent when the caller
+ * runs again.
+ *
+ * @param us microseconds
+ *
+ * @return void
+ */
+void native_spend_us(uint32_t us);
+
+/**
+ * @brief Charge the bus and radio time of the fakes
+ *
+ * Off by default: the fakes answer in no device time and BLE notifications are never
+ * dropped. On, analogRead(), readTemperature(), display() and notify() spend the
+ * NATIVE_*_US times of their transfer with native_spend_us(), and every central drains
+ * NATIVE_BLE_PACKETS_PER_EVENT notifications per connection interval out of
+ * NATIVE_BLE_TX_BUFFERS: a notification finding the buffers full is dropped
+ * (onStatus(ERROR_GATT)) like on a congested link.
+ *
+ * @param on true to charge the device time
+ *
+ * @return void
+ */
+void native_set_device_costs(bool on);
+
+/**
+ * @brief Know if the fakes charge their device time
+ *
+ * @param NO PARAMETERS
+ *
+ * @return bool value set by native_set_device_costs()
+ */
+bool native_device_costs();
+
+/**
+ * @brief Turn the caller into a task of the shim
+ *
+ * The caller (main()) holds the CPU like a task created with xTaskCreatePinnedToCore(), so the
+ * host program can call setup() and the functions of native.h as the Arduino loopTask.
+ *
+ * @param name task name
+ * @param prio task priority
+ *
+ * @return void
+ */
+void native_attach(const char* name, UBaseType_t prio);
+
+/**
+ * @brief Set the function giving the ADC readings
+ *
+ * @param source function called by analogRead() with the pin and the device time, returns 0..4095
+ *
+ * @return void
+ */
+void native_set_analog_source(uint16_t (*source)(uint8_t pin, int64_t now_us));
+
+/**
+ * @brief Set the level of an input pin
+ *
+ * @param pin GPIO number
+ * @param level HIGH or LOW
+ *
+ * @return void
+ */
+void native_set_digital(uint8_t pin, uint8_t level);
+
+/**
+ * @brief Set the function giving the input pin levels
+ *
+ * @param source function called by digitalRead() with the pin and the device time, returns
+ *               HIGH, LOW or NATIVE_PIN_UNDRIVEN to read the level set by the firmware or
+ *               by native_set_digital()
+ *
+ * @return void
+ */
+void native_set_digital_source(uint8_t (*source)(uint8_t pin, int64_t now_us));
+
+/**
+ * @brief Read the level of a pin
+ *
+ * @param pin GPIO number
+ *
+ * @return uint8_t level written by the firmware or set by native_set_digital()
+ */
+uint8_t native_get_digital(uint8_t pin);
+
+/**
+ * @brief Connect a BMP280
+ *
+ * @param mux_ch TCA9548A channel, NATIVE_I2CMUX_NONE for the main bus
+ * @param addr I2C address
+ *
+ * @return int8_t index of the sensor, -1 if the table is full
+ */
+int8_t native_bmp280_add(uint8_t mux_ch, uint8_t addr);
+
+/**
+ * @brief Set the function giving the BMP280 temperatures
+ *
+ * @param source function called by readTemperature() with the sensor index and the device time
+ *
+ * @return void
+ */
+void native_set_temperature_source(float (*source)(uint8_t sensor, int64_t now_us));
+
+/**
+ * @brief Connect or remove the OLED
+ *
+ * @param present false to make display.begin() fail
+ *
+ * @return void
+ */
+void native_oled_present(bool present);
+
+/**
+ * @brief Get the text of the last OLED frame
+ *
+ * @param NO PARAMETERS
+ *
+ * @return const char* rows of the frame separated by new lines
+ */
+const char* native_oled_frame();
+
+/**
+ * @brief Get the number of OLED frames
+ *
+ * @param NO PARAMETERS
+ *
+ * @return uint32_t calls of display()
+ */
+uint32_t native_oled_frames();
+
+/**
+ * @brief Receive every OLED frame
+ *
+ * @param hook function called by display() with the text of the frame
+ *
+ * @return void
+ */
+void native_oled_set_frame_hook(void (*hook)(const char* frame));
+
+/**
+ * @brief Connect or disconnect the simulated central
+ *
+ * Call the server callbacks like the BLE stack does. Notifications are counted and
+ * passed to the hook only while connected. Same as native_ble_set_centrals(1 or 0).
+ *
+ * @param connected true to connect
+ *
+ * @return void
+ */
+void native_ble_connect(bool connected);
+
+/**
+ * @brief Set the number of simulated centrals
+ *
+ * Connect or disconnect centrals one at a time (one server callback each), every central
+ * receives every notification.
+ *
+ * @param count number of connected centrals, up to NATIVE_BLE_MAX_CENTRALS
+ *
+ * @return void
+ */
+void native_ble_set_centrals(uint8_t count);
+
+/**
+ * @brief Get a characteristic by UUID
+ *
+ * @param uuid UUID string as passed to createCharacteristic()
+ *
+ * @return BLECharacteristic* characteristic, NULL if not created
+ */
+BLECharacteristic* native_ble_find(const char* uuid);
+
+/**
+ * @brief Write a characteristic from the central
+ *
+ * @param uuid UUID string
+ * @param data pointer to the bytes
+ * @param len number of bytes
+ *
+ * @return bool true if the characteristic exists
+ */
+bool native_ble_write(const char* uuid, const uint8_t* data, size_t len);
+
+/**
+ * @brief Receive the notifications
+ *
+ * @param hook function called for every notification sent while connected
+ *
+ * @return void
+ */
+void native_ble_set_notify_hook(void (*hook)(const BLECharacteristic* c));
+
+/**
+ * @brief Bring the simulated access point up or down
+ *
+ * Down drops the TCP connections and WiFi.status() leaves WL_CONNECTED; up associates
+ * the station again after NATIVE_WIFI_ASSOC_US. The access point is up at start.
+ *
+ * @param up true for up
+ *
+ * @return void
+ */
+void native_wifi_set_ap(bool up);
+
+/**
+ * @brief Bring the in-process MQTT broker up or down
+ *
+ * Down drops the connection and refuses new ones. The broker is up at start.
+ *
+ * @param up true for up
+ *
+ * @return void
+ */
+void native_broker_set_up(bool up);
+
+/**
+ * @brief Lose the next PUBACKs of the broker
+ *
+ * The messages are received (publish hook called) but not acknowledged, as if the PUBACK
+ * was lost on the way back.
+ *
+ * @param count number of PUBACKs to lose
+ *
+ * @return void
+ */
+void native_broker_drop_pubacks(uint32_t count);
+
+/**
+ * @brief Receive the messages published to the broker
+ *
+ * @param hook function called for every PUBLISH received by the in-process broker, dup is
+ *             the DUP flag of the packet
+ *
+ * @return void
+ */
+void native_broker_set_publish_hook(void (*hook)(const char* topic, const uint8_t* payload, size_t len, bool dup));
+
+/**
+ * @brief Connect to a real MQTT broker instead
+ *
+ * WiFiClient::connect() opens a host socket to this broker (e.g. a local Mosquitto),
+ * whatever host the firmware asks for; the access point still controls the link. Use the
+ * real time clock (native_clock_init(1)): the broker answers in host time.
+ *
+ * @param host broker host name or address, NULL for the in-process broker
+ * @param port broker TCP port
+ *
+ * @return void
+ */
+void native_broker_use_socket(const char* host, uint16_t port);
+
+/**
+ * @brief Drop the Serial output
+ *
+ * @param mute true to drop, false to print on stdout
+ *
+ * @return void
+ */
+void native_serial_mute(bool mute);
+
+/**
+ * @brief Receive the scheduling events
+ *
+ * @param hook function called with the event and the task concerned, the device time is
+ *             native_now_us(); the hook must not call blocking functions
+ *
+ * @return void
+ */
+void native_set_sched_hook(void (*hook)(NativeSched_t ev, TaskHandle_t task));
+
+#endif /* __NATIVE_H__ */
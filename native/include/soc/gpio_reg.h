@@ -0,0 +1,29 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file gpio_reg.h
+ * @brief GPIO registers fake of the native build, writes go to the fake pins
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_SOC_GPIO_REG_H__
+#define __NATIVE_SOC_GPIO_REG_H__
+
+#include <stdint.h>
+
+#define GPIO_OUT_W1TS_REG 0x3FF44008
+#define GPIO_OUT_W1TC_REG 0x3FF4400C
+
+void native_reg_write(uint32_t reg, uint32_t value);
+#define REG_WRITE(r, v) native_reg_write((uint32_t)(r), (uint32_t)(v))
+
+#endif /* __NATIVE_SOC_GPIO_REG_H__ */
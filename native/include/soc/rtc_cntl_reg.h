@@ -0,0 +1,28 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file rtc_cntl_reg.h
+ * @brief RTC controller registers fake of the native build
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#ifndef __NATIVE_SOC_RTC_CNTL_REG_H__
+#define __NATIVE_SOC_RTC_CNTL_REG_H__
+
+#define RTC_CNTL_LOW_POWER_ST_REG 0
+#define RTC_CNTL_RDY_FOR_WAKEUP_S 19
+#define RTC_CNTL_ULP_CP_INT_ENA_M 1
+#define RTC_CNTL_INT_ENA_REG 0
+#define REG_SET_BIT(a, b) (void)0
+#define REG_GET_FIELD(a, b) 0
+
+#endif /* __NATIVE_SOC_RTC_CNTL_REG_H__ */
@@ -0,0 +1,183 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file arduino_fake.c
+ * @brief Arduino core fake of the native build
+ *
+ * This implementation file provides pins, ADC, clock, Serial and ESP of the native build.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "soc/gpio_reg.h"
+#include <stdarg.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static uint8_t pin_level[NATIVE_NUM_PINS];
+static uint16_t (*analog_source)(uint8_t pin, int64_t now_us) = nullptr;
+static uint8_t (*digital_source)(uint8_t pin, int64_t now_us) = nullptr;
+static bool serial_mute = false;
+static bool device_costs = false;
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void native_set_device_costs(bool on) {
+  device_costs = on;
+}
+
+bool native_device_costs() {
+  return device_costs;
+}
+
+void native_set_analog_source(uint16_t (*source)(uint8_t pin, int64_t now_us)) {
+  analog_source = source;
+}
+
+void native_set_digital(uint8_t pin, uint8_t level) {
+  if (pin < NATIVE_NUM_PINS) {
+    pin_level[pin] = level ? HIGH : LOW;
+  }
+}
+
+void native_set_digital_source(uint8_t (*source)(uint8_t pin, int64_t now_us)) {
+  digital_source = source;
+}
+
+uint8_t native_get_digital(uint8_t pin) {
+  return pin < NATIVE_NUM_PINS ? pin_level[pin] : LOW;
+}
+
+void native_serial_mute(bool mute) {
+  serial_mute = mute;
+}
+
+void native_reg_write(uint32_t reg, uint32_t value) {
+  for (uint8_t pin = 0; pin < 32; pin++) {
+    if (value & (1u << pin)) {
+      if (reg == GPIO_OUT_W1TS_REG) {
+        pin_level[pin] = HIGH;
+      } else if (reg == GPIO_OUT_W1TC_REG) {
+        pin_level[pin] = LOW;
+      }
+    }
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  native_set_digital(pin, value);
+}
+
+int digitalRead(uint8_t pin) {
+  if (digital_source != nullptr) {
+    uint8_t level = digital_source(pin, native_now_us());
+    if (level != NATIVE_PIN_UNDRIVEN) {
+      return level;
+    }
+  }
+  return native_get_digital(pin);
+}
+
+uint16_t analogRead(uint8_t pin) {
+  if (device_costs) {
+    native_spend_us(NATIVE_ADC_READ_US);
+  }
+  if (analog_source == nullptr) {
+    return 0;
+  }
+  uint16_t v = analog_source(pin, native_now_us());
+  return v > 4095 ? 4095 : v;
+}
+
+unsigned long millis() {
+  return (unsigned long)(native_now_us() / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)native_now_us();
+}
+
+void delay(uint32_t ms) {
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  native_spend_us(us); // busy wait on the device: the task keeps the CPU
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+}
+
+int HardwareSerial::printf(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n = serial_mute ? vsnprintf(nullptr, 0, fmt, args) : vprintf(fmt, args);
+  va_end(args);
+  return n;
+}
+
+size_t HardwareSerial::print(const char* s) {
+  if (!serial_mute) {
+    fputs(s, stdout);
+  }
+  return strlen(s);
+}
+
+size_t HardwareSerial::println(const char* s) {
+  if (!serial_mute) {
+    puts(s);
+  }
+  return strlen(s) + 1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (!serial_mute) {
+    putchar(c);
+  }
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len) {
+  if (!serial_mute) {
+    fwrite(data, 1, len, stdout);
+  }
+  return len;
+}
+
+int HardwareSerial::available() {
+  return 0;
+}
+
+int HardwareSerial::read() {
+  return -1;
+}
+
+int HardwareSerial::availableForWrite() {
+  return 128; // the UART never backs up on the host
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
+
+uint32_t EspClass::getCycleCount() {
+  return (uint32_t)(native_now_ns() * 240 / 1000);
+}
+
+uint32_t EspClass::getCpuFreqMHz() {
+  return 240;
+}
@@ -0,0 +1,209 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file ble_fake.c
+ * @brief BLE fake of the native build
+ *
+ * This implementation file provides a GATT server with simulated centrals: characteristics
+ * are kept in a table the host program reads and writes by UUID. With the device costs on,
+ * each central has its own TX buffers drained at every connection event.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "BLEDevice.h"
+#include <vector>
+
+static BLEServer server;
+static BLEService service;
+static BLEAdvertising advertising;
+static BLEServerCallbacks* server_callbacks = nullptr;
+static std::vector<BLECharacteristic*> characteristics;
+static uint8_t centrals = 0;
+static uint8_t tx_queued[NATIVE_BLE_MAX_CENTRALS]; // notifications waiting for a connection event
+static int64_t tx_drained_us[NATIVE_BLE_MAX_CENTRALS]; // last connection event accounted
+static void (*notify_hook)(const BLECharacteristic* c) = nullptr;
+
+// queue a notification for a central, false if its TX buffers are full
+static bool tx_queue(uint8_t central, int64_t now_us) {
+  int64_t events = (now_us - tx_drained_us[central]) / NATIVE_BLE_CONN_INTERVAL_US;
+  if (events > 0) {
+    int64_t sent = events * NATIVE_BLE_PACKETS_PER_EVENT;
+    tx_queued[central] = sent >= tx_queued[central] ? 0 : tx_queued[central] - (uint8_t)sent;
+    tx_drained_us[central] += events * NATIVE_BLE_CONN_INTERVAL_US;
+  }
+  if (tx_queued[central] >= NATIVE_BLE_TX_BUFFERS) {
+    return false;
+  }
+  tx_queued[central]++;
+  return true;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void native_ble_connect(bool connect) {
+  native_ble_set_centrals(connect ? 1 : 0);
+}
+
+void native_ble_set_centrals(uint8_t count) {
+  count = count > NATIVE_BLE_MAX_CENTRALS ? NATIVE_BLE_MAX_CENTRALS : count;
+  while (centrals < count) {
+    tx_queued[centrals] = 0;
+    tx_drained_us[centrals] = native_now_us();
+    centrals++;
+    if (server_callbacks != nullptr) {
+      server_callbacks->onConnect(&server);
+    }
+  }
+  while (centrals > count) {
+    centrals--;
+    if (server_callbacks != nullptr) {
+      server_callbacks->onDisconnect(&server);
+    }
+  }
+}
+
+BLECharacteristic* native_ble_find(const char* uuid) {
+  for (BLECharacteristic* c : characteristics) {
+    if (c->uuid == uuid) {
+      return c;
+    }
+  }
+  return nullptr;
+}
+
+bool native_ble_write(const char* uuid, const uint8_t* data, size_t len) {
+  BLECharacteristic* c = native_ble_find(uuid);
+  if (c == nullptr) {
+    return false;
+  }
+  c->value.assign(data, data + len);
+  if (c->callbacks != nullptr) {
+    c->callbacks->onWrite(c);
+  }
+  return true;
+}
+
+void native_ble_set_notify_hook(void (*hook)(const BLECharacteristic* c)) {
+  notify_hook = hook;
+}
+
+BLECharacteristic::BLECharacteristic(const char* uuid, uint32_t properties)
+  : uuid(uuid), properties(properties), callbacks(nullptr), notifications(0) {
+}
+
+void BLECharacteristic::setValue(uint8_t* data, size_t len) {
+  value.assign(data, data + len);
+}
+
+void BLECharacteristic::setValue(uint16_t& v) {
+  setValue((uint8_t*)&v, sizeof(v));
+}
+
+void BLECharacteristic::setValue(uint32_t& v) {
+  setValue((uint8_t*)&v, sizeof(v));
+}
+
+void BLECharacteristic::setValue(int& v) {
+  setValue((uint8_t*)&v, sizeof(v));
+}
+
+void BLECharacteristic::setValue(float& v) {
+  setValue((uint8_t*)&v, sizeof(v));
+}
+
+std::string BLECharacteristic::getValue() {
+  return std::string(value.begin(), value.end());
+}
+
+uint8_t* BLECharacteristic::getData() {
+  return value.data();
+}
+
+size_t BLECharacteristic::getLength() {
+  return value.size();
+}
+
+void BLECharacteristic::notify(bool is_notification) {
+  if (centrals == 0 && callbacks != nullptr) {
+    callbacks->onStatus(this, BLECharacteristicCallbacks::ERROR_NO_CLIENT, 0);
+  }
+  bool sent = false;
+  for (uint8_t i = 0; i < centrals; i++) {
+    bool queued = true;
+    if (native_device_costs()) {
+      native_spend_us(NATIVE_BLE_NOTIFY_US);
+      queued = tx_queue(i, native_now_us());
+    }
+    sent = sent || queued;
+    if (callbacks != nullptr) {
+      callbacks->onStatus(this, queued ? BLECharacteristicCallbacks::SUCCESS_NOTIFY : BLECharacteristicCallbacks::ERROR_GATT, 0);
+    }
+  }
+  if (!sent) {
+    return;
+  }
+  notifications++;
+  if (notify_hook != nullptr) {
+    notify_hook(this);
+  }
+}
+
+void BLECharacteristic::addDescriptor(BLEDescriptor* d) {
+}
+
+void BLECharacteristic::setCallbacks(BLECharacteristicCallbacks* cb) {
+  callbacks = cb;
+}
+
+BLECharacteristic* BLEService::createCharacteristic(const char* uuid, uint32_t properties) {
+  BLECharacteristic* c = new BLECharacteristic(uuid, properties);
+  characteristics.push_back(c);
+  return c;
+}
+
+void BLEService::start() {
+}
+
+void BLEAdvertising::start() {
+}
+
+void BLEAdvertising::stop() {
+}
+
+BLEService* BLEServer::createService(const char* uuid) {
+  return &service;
+}
+
+BLEService* BLEServer::createService(BLEUUID uuid, uint32_t numHandles, uint8_t inst_id) {
+  return &service;
+}
+
+void BLEServer::setCallbacks(BLEServerCallbacks* cb) {
+  server_callbacks = cb;
+}
+
+BLEAdvertising* BLEServer::getAdvertising() {
+  return &advertising;
+}
+
+uint32_t BLEServer::getConnectedCount() {
+  return centrals;
+}
+
+void BLEDevice::init(const char* name) {
+}
+
+BLEServer* BLEDevice::createServer() {
+  return &server;
+}
@@ -0,0 +1,473 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file freertos_fake.c
+ * @brief FreeRTOS shim and clock of the native build
+ *
+ * This implementation file provides the single-CPU scheduler of the native build (one
+ * coroutine per task on the host thread, switched with swapcontext()), task notifications,
+ * queues, esp_timer and the clock. The schedule only depends on the clock: with the
+ * virtual clock a run is repeatable.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "esp_timer.h"
+#include <ucontext.h>
+#include <unistd.h>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#define NATIVE_NO_WAKE INT64_MAX
+#define NATIVE_STACK_SIZE (256 * 1024) // host stack of a task, printf and libstdc++ included
+#define NATIVE_STACK_FILL 0xA5 // pattern of the stack bytes never used
+
+typedef enum
+{
+  TASK_READY = 0,
+  TASK_BLOCKED,
+  TASK_DELETED
+}TaskState_t;
+
+struct NativeTask_s
+{
+  void      (*fn)(void*);
+  void*     arg;
+  std::string name;
+  UBaseType_t prio;
+  BaseType_t core;
+  TaskState_t state;
+  uint64_t  ready_seq; // FIFO among tasks of the same priority
+  int64_t   wake_us; // timeout of the blocking call, NATIVE_NO_WAKE if none
+  uint32_t  notify; // notification value
+  bool      wait_notify;
+  NativeQueue_s* wait_queue;
+  ucontext_t ctx; // saved while the task is not running
+  uint8_t*  stack;
+};
+
+struct NativeQueue_s
+{
+  UBaseType_t length;
+  UBaseType_t item_size;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+struct NativeTimer_s
+{
+  esp_timer_create_args_t args;
+  uint64_t  period_us; // 0 for one shot
+  int64_t   due_us;
+  bool      active;
+  TaskHandle_t task;
+};
+
+static std::vector<TaskHandle_t> tasks;
+static TaskHandle_t current = nullptr; // task holding the CPU
+static uint64_t ready_seq = 0;
+static int64_t core_run_us[2] = {}; // CPU time of the tasks pinned on each core
+static int64_t run_since_us = 0; // current holds the CPU since
+
+static std::chrono::steady_clock::time_point clock_t0 = std::chrono::steady_clock::now();
+static double clock_speed = 1.0;
+static bool clock_virtual = false;
+static int64_t virtual_ns = 0;
+static void (*sched_hook)(NativeSched_t ev, TaskHandle_t task) = nullptr;
+
+static void sched_event(NativeSched_t ev, TaskHandle_t t) {
+  if (sched_hook != nullptr) {
+    sched_hook(ev, t);
+  }
+}
+
+static std::chrono::steady_clock::time_point host_time(int64_t device_us) {
+  return clock_t0 + std::chrono::microseconds((int64_t)(device_us / clock_speed));
+}
+
+static void make_ready(TaskHandle_t t) {
+  t->state = TASK_READY;
+  t->ready_seq = ++ready_seq;
+  t->wake_us = NATIVE_NO_WAKE;
+  t->wait_notify = false;
+  t->wait_queue = nullptr;
+  sched_event(NATIVE_SCHED_READY, t);
+}
+
+// highest priority ready task, the one waiting longest among equals
+static TaskHandle_t pick() {
+  TaskHandle_t best = nullptr;
+  for (TaskHandle_t t : tasks) {
+    if (t->state == TASK_READY && (best == nullptr || t->prio > best->prio ||
+        (t->prio == best->prio && t->ready_seq < best->ready_seq))) {
+      best = t;
+    }
+  }
+  return best;
+}
+
+// release the blocked tasks whose timeout expired, return the earliest timeout left
+static int64_t release_expired() {
+  int64_t now = native_now_us();
+  int64_t next = NATIVE_NO_WAKE;
+  for (TaskHandle_t t : tasks) {
+    if (t->state == TASK_BLOCKED && t->wake_us != NATIVE_NO_WAKE) {
+      if (t->wake_us <= now) {
+        make_ready(t);
+      } else if (t->wake_us < next) {
+        next = t->wake_us;
+      }
+    }
+  }
+  return next;
+}
+
+// CPU time of the task leaving the CPU, to its core
+static void charge(TaskHandle_t t) {
+  int64_t now = native_now_us();
+  if (t != nullptr) {
+    core_run_us[t->core % 2] += now - run_since_us;
+  }
+  run_since_us = now;
+}
+
+// scheduling point: give the CPU to the task picked, idle until a timeout if none is ready
+static void schedule() {
+  TaskHandle_t prev = current;
+  charge(prev);
+  while (true) {
+    int64_t next_wake = release_expired();
+    TaskHandle_t next = pick();
+    if (next != nullptr) {
+      current = next;
+      run_since_us = native_now_us(); // idle time before it is not charged
+      if (next != prev) {
+        sched_event(NATIVE_SCHED_RUN, next);
+        swapcontext(&prev->ctx, &next->ctx); // back here when prev is picked again
+      }
+      return;
+    }
+    if (next_wake == NATIVE_NO_WAKE) {
+      fflush(stdout);
+      fprintf(stderr, "native: all tasks blocked without timeout\n");
+      _exit(3);
+    }
+    if (clock_virtual) {
+      virtual_ns = next_wake * 1000; // idle CPU: jump to the next timeout
+    } else {
+      std::this_thread::sleep_until(host_time(next_wake));
+    }
+  }
+}
+
+static void block(int64_t wake_us) {
+  current->state = TASK_BLOCKED;
+  current->wake_us = wake_us;
+  sched_event(NATIVE_SCHED_BLOCK, current);
+  schedule();
+}
+
+// a higher priority ready task takes the CPU
+static void preempt() {
+  TaskHandle_t next = pick();
+  if (next != nullptr && next != current && next->prio > current->prio) {
+    current->ready_seq = ++ready_seq;
+    sched_event(NATIVE_SCHED_PREEMPT, current);
+    schedule();
+  }
+}
+
+static int64_t timeout_us(TickType_t ticks) {
+  return ticks == portMAX_DELAY ? NATIVE_NO_WAKE : native_now_us() + (int64_t)ticks * 1000;
+}
+
+static void task_entry() {
+  current->fn(current->arg);
+  vTaskDelete(nullptr); // a task function returned
+}
+
+static TaskHandle_t task_new(const char* name, UBaseType_t prio, BaseType_t core) {
+  TaskHandle_t t = new NativeTask_s();
+  t->name = name != nullptr ? name : "";
+  t->prio = prio;
+  t->core = core == tskNO_AFFINITY ? 0 : core;
+  t->notify = 0;
+  t->stack = nullptr;
+  make_ready(t);
+  tasks.push_back(t);
+  return t;
+}
+
+static void timer_task(void* arg) {
+  NativeTimer_s* timer = (NativeTimer_s*)arg;
+  while (true) {
+    if (!timer->active) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+    if (timer->due_us > native_now_us()) {
+      block(timer->due_us);
+    }
+    if (timer->active && timer->due_us <= native_now_us()) {
+      timer->args.callback(timer->args.arg);
+      if (timer->period_us > 0) {
+        timer->due_us += timer->period_us;
+      } else {
+        timer->active = false;
+      }
+    }
+  }
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void native_clock_init(double speed) {
+  clock_t0 = std::chrono::steady_clock::now();
+  clock_speed = speed > 0 ? speed : 1.0;
+  clock_virtual = speed <= 0;
+  virtual_ns = 0;
+}
+
+int64_t native_now_us() {
+  return native_now_ns() / 1000;
+}
+
+int64_t native_now_ns() {
+  if (clock_virtual) {
+    return virtual_ns;
+  }
+  auto host_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - clock_t0).count();
+  return (int64_t)(host_ns * clock_speed);
+}
+
+void native_set_sched_hook(void (*hook)(NativeSched_t ev, TaskHandle_t task)) {
+  sched_hook = hook;
+}
+
+void native_attach(const char* name, UBaseType_t prio) {
+  current = task_new(name, prio, 1); // context saved at its first switch
+}
+
+void native_spend_us(uint32_t us) {
+  if (clock_virtual) { // only the running task moves the clock
+    int64_t left_ns = (int64_t)us * 1000;
+    while (true) {
+      release_expired();
+      preempt(); // tick preemption, the clock moves while the task is away
+      int64_t next_wake = release_expired();
+      if (next_wake == NATIVE_NO_WAKE || next_wake * 1000 >= virtual_ns + left_ns) {
+        break;
+      }
+      left_ns -= next_wake * 1000 - virtual_ns;
+      virtual_ns = next_wake * 1000;
+    }
+    virtual_ns += left_ns;
+    return;
+  }
+  int64_t end = native_now_us() + us;
+  while (native_now_us() < end) {
+  }
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t core) {
+  TaskHandle_t t = task_new(name, prio, core);
+  t->fn = fn;
+  t->arg = arg;
+  t->stack = new uint8_t[NATIVE_STACK_SIZE];
+  memset(t->stack, NATIVE_STACK_FILL, NATIVE_STACK_SIZE); // scanned by uxTaskGetStackHighWaterMark()
+  getcontext(&t->ctx);
+  t->ctx.uc_stack.ss_sp = t->stack;
+  t->ctx.uc_stack.ss_size = NATIVE_STACK_SIZE;
+  t->ctx.uc_link = nullptr;
+  makecontext(&t->ctx, task_entry, 0);
+  if (handle != nullptr) {
+    *handle = t;
+  }
+  preempt();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(void (*fn)(void*), const char* name, uint32_t stack, void* arg,
+                       UBaseType_t prio, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stack, arg, prio, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  TaskHandle_t t = task != nullptr ? task : current;
+  t->state = TASK_DELETED;
+  if (t == current) {
+    schedule(); // never picked again, the stack is not reclaimed
+  }
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  TaskHandle_t t = task != nullptr ? task : current;
+  if (t->stack == nullptr) {
+    return NATIVE_STACK_SIZE; // attached thread, host stack not painted
+  }
+  UBaseType_t n = 0;
+  while (n < NATIVE_STACK_SIZE && t->stack[n] == NATIVE_STACK_FILL) { // grows down
+    n++;
+  }
+  return n;
+}
+
+uint32_t ulTaskGetIdleRunTimeCounter() {
+  int64_t now = native_now_us();
+  uint8_t core = current != nullptr ? current->core % 2 : 1;
+  return (uint32_t)(now - core_run_us[core] - (now - run_since_us)); // the caller is running
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)(native_now_us() / 1000);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (ticks == 0) { // yield to the tasks of the same priority
+    current->ready_seq = ++ready_seq;
+    schedule();
+    return;
+  }
+  block(native_now_us() + (int64_t)ticks * 1000);
+}
+
+void vTaskDelayUntil(TickType_t* prev, TickType_t increment) {
+  TickType_t wake = *prev + increment;
+  *prev = wake;
+  int64_t wake_us = (int64_t)wake * 1000;
+  if (wake_us > native_now_us()) {
+    block(wake_us);
+  } else {
+    preempt(); // deadline already passed: no delay
+  }
+}
+
+BaseType_t xPortGetCoreID() {
+  return current != nullptr ? current->core : 1;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return current;
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+  return (task != nullptr ? task : current)->name.c_str();
+}
+
+uint32_t xTaskNotifyGive(TaskHandle_t task) {
+  task->notify++;
+  if (task->state == TASK_BLOCKED && task->wait_notify) {
+    make_ready(task);
+    preempt();
+  }
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+  task->notify++;
+  if (task->state == TASK_BLOCKED && task->wait_notify) {
+    make_ready(task); // runs at the next scheduling point
+    if (woken != nullptr) {
+      *woken = pdTRUE;
+    }
+  }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t timeout) {
+  TaskHandle_t t = current;
+  if (t->notify == 0 && timeout > 0) {
+    t->wait_notify = true;
+    block(timeout_us(timeout));
+  }
+  uint32_t value = t->notify;
+  if (value > 0) {
+    t->notify = clear ? 0 : value - 1;
+  }
+  return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  QueueHandle_t q = new NativeQueue_s();
+  q->length = length;
+  q->item_size = item_size;
+  return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t timeout) {
+  if (q->items.size() >= q->length) {
+    return errQUEUE_FULL; // senders of the firmware never wait for space
+  }
+  const uint8_t* p = (const uint8_t*)item;
+  q->items.emplace_back(p, p + q->item_size);
+  for (TaskHandle_t t : tasks) {
+    if (t->state == TASK_BLOCKED && t->wait_queue == q) {
+      make_ready(t);
+      preempt();
+      break;
+    }
+  }
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t timeout) {
+  if (q->items.empty() && timeout > 0) {
+    current->wait_queue = q;
+    block(timeout_us(timeout));
+  }
+  if (q->items.empty()) {
+    return pdFALSE;
+  }
+  memcpy(item, q->items.front().data(), q->item_size);
+  q->items.pop_front();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  return (UBaseType_t)q->items.size();
+}
+
+int64_t esp_timer_get_time() {
+  return native_now_us();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  NativeTimer_s* timer = new NativeTimer_s();
+  timer->args = *args;
+  timer->active = false;
+  xTaskCreatePinnedToCore(timer_task, "esp_timer", 4096, timer, configMAX_PRIORITIES - 3, &timer->task, 0);
+  *out = timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+  timer->period_us = period_us;
+  timer->due_us = native_now_us() + period_us;
+  timer->active = true;
+  xTaskNotifyGive(timer->task);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  timer->period_us = 0;
+  timer->due_us = native_now_us() + timeout_us;
+  timer->active = true;
+  xTaskNotifyGive(timer->task);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  timer->active = false;
+  return ESP_OK;
+}
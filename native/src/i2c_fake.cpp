@@ -0,0 +1,274 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file i2c_fake.c
+ * @brief I2C fakes of the native build
+ *
+ * This implementation file provides the I2C bus with a TCA9548A at 0x70, the BMP280
+ * sensors and the SSD1306 OLED, whose frames are kept as text.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "Wire.h"
+#include "Adafruit_BMP280.h"
+#include "Adafruit_SSD1306.h"
+#include <stdarg.h>
+
+#define NATIVE_TCA9548A_ADDR 0x70
+#define NATIVE_OLED_ADDR 0x3C
+
+typedef struct
+{
+  uint8_t mux_ch;
+  uint8_t addr;
+}NativeBmp280_t;
+
+TwoWire Wire;
+
+static NativeBmp280_t bmp280[NATIVE_MAX_BMP280];
+static uint8_t bmp280_count = 0;
+static uint8_t mux_select = 0; // channel bit mask written to the TCA9548A
+static float (*temperature_source)(uint8_t sensor, int64_t now_us) = nullptr;
+
+static bool oled_present = true;
+static char oled_frame[NATIVE_GFX_ROWS * (NATIVE_GFX_COLS + 1) + 1];
+static uint32_t oled_frames = 0;
+static void (*oled_frame_hook)(const char* frame) = nullptr;
+
+static bool mux_present() {
+  for (uint8_t i = 0; i < bmp280_count; i++) {
+    if (bmp280[i].mux_ch != NATIVE_I2CMUX_NONE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool bmp280_visible(uint8_t i) {
+  return bmp280[i].mux_ch == NATIVE_I2CMUX_NONE || (mux_select & (1 << bmp280[i].mux_ch));
+}
+
+// sensor answering at addr with the current mux selection, -1 if none
+static int8_t bmp280_find(uint8_t addr) {
+  for (uint8_t i = 0; i < bmp280_count; i++) {
+    if (bmp280[i].addr == addr && bmp280_visible(i)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int8_t native_bmp280_add(uint8_t mux_ch, uint8_t addr) {
+  if (bmp280_count >= NATIVE_MAX_BMP280) {
+    return -1;
+  }
+  bmp280[bmp280_count].mux_ch = mux_ch;
+  bmp280[bmp280_count].addr = addr;
+  return bmp280_count++;
+}
+
+void native_set_temperature_source(float (*source)(uint8_t sensor, int64_t now_us)) {
+  temperature_source = source;
+}
+
+void native_oled_present(bool present) {
+  oled_present = present;
+}
+
+const char* native_oled_frame() {
+  return oled_frame;
+}
+
+uint32_t native_oled_frames() {
+  return oled_frames;
+}
+
+void native_oled_set_frame_hook(void (*hook)(const char* frame)) {
+  oled_frame_hook = hook;
+}
+
+bool TwoWire::begin() {
+  return true;
+}
+
+void TwoWire::setClock(uint32_t hz) {
+}
+
+void TwoWire::beginTransmission(uint8_t addr) {
+  addr_ = addr;
+  wrote_ = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  last_ = data;
+  wrote_ = true;
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+  if (addr_ == NATIVE_TCA9548A_ADDR) {
+    if (!mux_present()) {
+      return 2;
+    }
+    if (wrote_) {
+      mux_select = last_;
+    }
+    return 0;
+  }
+  if (addr_ == NATIVE_OLED_ADDR) {
+    return oled_present ? 0 : 2;
+  }
+  return bmp280_find(addr_) >= 0 ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t addr, uint8_t len) {
+  addr_ = addr;
+  return addr == NATIVE_TCA9548A_ADDR && mux_present() ? 1 : 0;
+}
+
+int TwoWire::read() {
+  return addr_ == NATIVE_TCA9548A_ADDR ? mux_select : -1;
+}
+
+Adafruit_BMP280::Adafruit_BMP280(TwoWire* wire) : sensor_(-1) {
+}
+
+bool Adafruit_BMP280::begin(uint8_t addr, uint8_t chipid) {
+  sensor_ = bmp280_find(addr);
+  return sensor_ >= 0;
+}
+
+float Adafruit_BMP280::readTemperature() {
+  if (native_device_costs()) {
+    native_spend_us(NATIVE_BMP280_READ_US);
+  }
+  if (sensor_ < 0 || !bmp280_visible(sensor_)) {
+    return NAN; // no answer on the bus
+  }
+  return temperature_source != nullptr ? temperature_source(sensor_, native_now_us()) : 25.0f;
+}
+
+void Adafruit_GFX::setCursor(int16_t x, int16_t y) {
+  row_ = (uint8_t)(y / 8);
+  col_ = (uint8_t)(x / 6);
+}
+
+void Adafruit_GFX::setTextSize(uint8_t size) {
+}
+
+void Adafruit_GFX::setTextColor(uint16_t color) {
+}
+
+size_t Adafruit_GFX::print(const char* s) {
+  size_t n = 0;
+  for (; s[n] != '\0'; n++) {
+    print(s[n]);
+  }
+  return n;
+}
+
+size_t Adafruit_GFX::print(char c) {
+  if (c == '\n') {
+    row_++;
+    col_ = 0;
+  } else if (row_ < NATIVE_GFX_ROWS && col_ < NATIVE_GFX_COLS) {
+    grid_[row_][col_++] = c;
+  }
+  return 1;
+}
+
+size_t Adafruit_GFX::print(int v) {
+  return printf("%d", v);
+}
+
+size_t Adafruit_GFX::print(unsigned v) {
+  return printf("%u", v);
+}
+
+size_t Adafruit_GFX::print(long v) {
+  return printf("%ld", v);
+}
+
+size_t Adafruit_GFX::print(unsigned long v) {
+  return printf("%lu", v);
+}
+
+size_t Adafruit_GFX::print(double v, int digits) {
+  return printf("%.*f", digits, v);
+}
+
+size_t Adafruit_GFX::println(const char* s) {
+  return print(s) + print('\n');
+}
+
+size_t Adafruit_GFX::println(int v) {
+  return print(v) + print('\n');
+}
+
+size_t Adafruit_GFX::println(double v, int digits) {
+  return print(v, digits) + print('\n');
+}
+
+size_t Adafruit_GFX::println() {
+  return print('\n');
+}
+
+size_t Adafruit_GFX::printf(const char* fmt, ...) {
+  char buf[64];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  return print(buf);
+}
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* wire, int8_t rst) {
+  clearDisplay();
+}
+
+bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr) {
+  return oled_present && addr == NATIVE_OLED_ADDR;
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+  for (uint8_t r = 0; r < NATIVE_GFX_ROWS; r++) {
+    memset(grid_[r], ' ', NATIVE_GFX_COLS);
+    grid_[r][NATIVE_GFX_COLS] = '\0';
+  }
+  row_ = 0;
+  col_ = 0;
+}
+
+void Adafruit_SSD1306::display() {
+  if (native_device_costs()) {
+    native_spend_us(NATIVE_OLED_FRAME_US);
+  }
+  char* p = oled_frame;
+  for (uint8_t r = 0; r < NATIVE_GFX_ROWS; r++) {
+    size_t len = NATIVE_GFX_COLS;
+    while (len > 0 && grid_[r][len - 1] == ' ') {
+      len--;
+    }
+    memcpy(p, grid_[r], len);
+    p += len;
+    *p++ = '\n';
+  }
+  *p = '\0';
+  oled_frames++;
+  if (oled_frame_hook != nullptr) {
+    oled_frame_hook(oled_frame);
+  }
+}
@@ -0,0 +1,192 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file native_main.cpp
+ * @brief Host program of the native build
+ *
+ * Boot the firmware (setup()) on the fakes and run a plant scenario, then print what the
+ * firmware produced. The scenario, in device time:
+ * - temperature: 22 C +/- 10 C sine with a 60 s period, above 30 C at every peak
+ * - humidity: the sand dries from 60 % to 10 % in 60 s, watered back to 70 % at 80 s
+ * - solar sensor: light status toggles every 20 s
+ * - a BLE central connects at 2 s and asks the humidity history 10 s before the end
+ * - with --plug-sensor-s N the BMP280 is missing at boot and plugged at N s: the node boots
+ *   in degraded mode and must find it again; with --no-oled the OLED is missing
+ * The run fails if the pipeline did not sample, notify, raise an alarm or draw the OLED,
+ * or if a plugged sensor was not found again.
+ *
+ * Build and run from the repository root:
+ *   pio run -e native && .pio/build/native/program [--seconds N] [--speed K] [--quiet]
+ * or without PlatformIO:
+ *   g++ -std=gnu++17 -O2 -pthread -Inative/include -Iinclude $(find src native/src -name '*.cpp') -o smartplant_native
+ *   ./smartplant_native [--seconds N] [--speed K] [--quiet] [--plug-sensor-s N] [--no-oled]
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "smartplant.h"
+#include "peripheral.h"
+#include "HAL/ble_hal.h"
+#include "alarm.h"
+#include "downsample.h"
+#include "boot.h"
+#include <unistd.h>
+
+#define NATIVE_SECONDS 120 // default scenario length, device time
+#define NATIVE_SPEED 10.0 // default device seconds per host second
+#define NATIVE_CONNECT_MS 2000
+#define NATIVE_QUERY_BEFORE_END_MS 10000
+#define NATIVE_TEMP_PERIOD_S 60.0
+#define NATIVE_DRY_S 60.0
+#define NATIVE_WATER_S 80.0
+#define NATIVE_SOLAR_PERIOD_S 20
+
+extern SmartPlant_t SM_list;
+
+void setup();
+
+static uint32_t history_notifications = 0;
+static uint32_t query_ms = 0, history_reply_ms = 0; // query written, first reply notified
+static uint32_t alarm_raised = 0;
+
+static uint16_t humidity_adc(uint8_t pin, int64_t now_us) {
+  double t = now_us / 1e6;
+  double pct;
+  if (t < NATIVE_DRY_S) {
+    pct = 60.0 - 50.0 * t / NATIVE_DRY_S;
+  } else if (t < NATIVE_WATER_S) {
+    pct = 10.0;
+  } else {
+    pct = 70.0;
+  }
+  double noise = ((rand() % 21) - 10) * 0.1; // +/- 1 %
+  return (uint16_t)lround((pct + noise) * 4095.0 / 100.0);
+}
+
+static float temperature_c(uint8_t sensor, int64_t now_us) {
+  return 22.0f + 10.5f * (float)sin(2.0 * M_PI * (now_us / 1e6) / NATIVE_TEMP_PERIOD_S) + sensor * 0.5f;
+}
+
+static void on_notify(const BLECharacteristic* c) {
+  if (c == characteristic_history) {
+    if (history_notifications++ == 0) {
+      history_reply_ms = millis() - query_ms;
+    }
+  } else if (c == characteristic_alarm && c->value.size() >= 2 && c->value[1] != 0) { // [plant, mask]
+    alarm_raised++;
+  }
+}
+
+static void print_characteristic(const char* name, const BLECharacteristic* c) {
+  printf("%s,%u\n", name, c != nullptr ? c->notifications : 0);
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int main(int argc, char** argv) {
+  uint32_t seconds = NATIVE_SECONDS;
+  double speed = NATIVE_SPEED;
+  bool quiet = false;
+  bool oled = true;
+  int32_t plug_s = -1; // BMP280 present at boot
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+      speed = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--quiet") == 0) {
+      quiet = true;
+    } else if (strcmp(argv[i], "--plug-sensor-s") == 0 && i + 1 < argc) {
+      plug_s = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--no-oled") == 0) {
+      oled = false;
+    } else {
+      fprintf(stderr, "usage: %s [--seconds N] [--speed K] [--quiet] [--plug-sensor-s N] [--no-oled]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  srand(1);
+  native_serial_mute(quiet);
+  native_set_analog_source(humidity_adc);
+  native_set_temperature_source(temperature_c);
+  if (plug_s < 0) {
+    native_bmp280_add(TEMP_I2CMUX ? 0 : NATIVE_I2CMUX_NONE, BMP280_ADDR_1);
+  }
+  native_oled_present(oled);
+  native_ble_set_notify_hook(on_notify);
+
+  native_clock_init(speed);
+  native_attach("loopTask", 1);
+  setup();
+
+  uint32_t end_ms = seconds * 1000;
+  bool connected = false, queried = false;
+  for (uint32_t now = millis(); now < end_ms; now = millis()) {
+    if (plug_s >= 0 && now >= (uint32_t)plug_s * 1000) {
+      native_bmp280_add(TEMP_I2CMUX ? 0 : NATIVE_I2CMUX_NONE, BMP280_ADDR_1);
+      plug_s = -1;
+    }
+    native_set_digital(SOLAR_SNS_1_pin, (now / 1000 / NATIVE_SOLAR_PERIOD_S) % 2 ? HIGH : LOW);
+    if (!connected && now >= NATIVE_CONNECT_MS) {
+      native_ble_connect(true);
+      connected = true;
+    }
+    if (!queried && now + NATIVE_QUERY_BEFORE_END_MS >= end_ms) {
+      HistoryQuery_t q = {ALARM_FIELD_HUMIDITY, DOWNSAMPLE_LTTB, 20, 0, 0};
+      query_ms = millis();
+      native_ble_write(CHARACTERISTIC_UUID_HISTORY, (const uint8_t*)&q, sizeof(q));
+      queried = true;
+    }
+    vTaskDelay(pdMS_TO_TICKS(100));
+  }
+
+  native_serial_mute(true); // firmware output would interleave with the summary
+  printf("\nmetric,value\n");
+  printf("device_s,%u\n", seconds);
+  BootTimes_t boot;
+  boot_get_times(&boot);
+  printf("first_sample_ms,%u\n", boot.first_sample_us / 1000);
+  printf("boot_ble_us,%u\n", boot.async_us);
+  printf("boot_devices_us,%u\n", boot.devices_us);
+  printf("boot_missing,0x%x\n", boot_missing());
+  printf("cycles,%u\n", SM_list.cycles);
+  printf("temperature,%.2f\n", SM_list.temperature[0]);
+  printf("humidity,%.2f\n", SM_list.sand_humidity[0]);
+  printf("alarm,%u\n", SM_list.alarm[0] ? 1 : 0);
+  printf("led,%u\n", native_get_digital(DIODE_LED_1_pin));
+#if BLE_LEGACY_CHARACTERISTICS
+  print_characteristic("notify_temp", characteristic_temp);
+  print_characteristic("notify_humidity", characteristic_humidity);
+  print_characteristic("notify_solar", characteristic_slrrad);
+  BLECharacteristic* live = characteristic_temp; // a legacy client keeps working
+#else
+  BLECharacteristic* live = characteristic_record;
+#endif
+  print_characteristic("notify_record", characteristic_record);
+  print_characteristic("notify_alarm", characteristic_alarm);
+  print_characteristic("notify_stats", characteristic_stats);
+  print_characteristic("notify_history", characteristic_history);
+  printf("history_reply_ms,%u\n", history_reply_ms);
+  printf("alarm_raised,%u\n", alarm_raised);
+  printf("oled_frames,%u\n", native_oled_frames());
+  printf("oled_last_frame:\n%s", native_oled_frame());
+
+  bool ok = SM_list.cycles > 0 && live != nullptr && live->notifications > 0 &&
+            alarm_raised > 0 && (!oled || native_oled_frames() > 0) && (!queried || history_notifications > 0) &&
+            boot_ready(BOOT_DEV_TEMPERATURE);
+  fflush(stdout);
+  fprintf(stderr, "%s\n", ok ? "PASSED" : "FAILED");
+  fflush(stderr);
+  _exit(ok ? 0 : 1); // tasks never return
+}
@@ -0,0 +1,183 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file nvs_fake.c
+ * @brief Storage and system fakes of the native build
+ *
+ * This implementation file provides Preferences (kept in RAM), the "tsdb" flash partition
+ * (RAM with NOR write semantics) and the esp_pm, sleep, ADC and ULP stubs: power
+ * management always succeeds, the ULP is never available.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "Preferences.h"
+#include "esp_partition.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "driver/adc.h"
+#include "driver/rtc_cntl.h"
+#include "esp32/ulp.h"
+#include <map>
+#include <vector>
+
+#define NATIVE_TSDB_SUBTYPE 0x40 // as partitions.csv
+#define NATIVE_TSDB_SIZE 0x1F0000
+
+uint32_t RTC_SLOW_MEM[2048];
+
+static std::map<std::string, std::vector<uint8_t>> nvs;
+static const esp_partition_t tsdb_partition = {ESP_PARTITION_TYPE_DATA, NATIVE_TSDB_SUBTYPE, 0x200000, NATIVE_TSDB_SIZE, "tsdb"};
+static std::vector<uint8_t> tsdb_flash(NATIVE_TSDB_SIZE, 0xFF);
+
+static bool flash_range_valid(const esp_partition_t* p, size_t offset, size_t len) {
+  return p == &tsdb_partition && offset + len <= p->size && offset + len >= offset;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool Preferences::begin(const char* name, bool read_only) {
+  ns_ = std::string(name) + "/";
+  read_only_ = read_only;
+  return true;
+}
+
+void Preferences::end() {
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  auto it = nvs.find(ns_ + key);
+  return it != nvs.end() ? it->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t len) {
+  auto it = nvs.find(ns_ + key);
+  if (it == nvs.end() || it->second.size() > len) {
+    return 0;
+  }
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (read_only_) {
+    return 0;
+  }
+  const uint8_t* p = (const uint8_t*)value;
+  nvs[ns_ + key].assign(p, p + len);
+  return len;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t default_value) {
+  uint32_t v;
+  return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : default_value;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+  return putBytes(key, &value, sizeof(value));
+}
+
+bool Preferences::remove(const char* key) {
+  return !read_only_ && nvs.erase(ns_ + key) > 0;
+}
+
+bool Preferences::clear() {
+  if (read_only_) {
+    return false;
+  }
+  for (auto it = nvs.begin(); it != nvs.end();) {
+    it = it->first.compare(0, ns_.size(), ns_) == 0 ? nvs.erase(it) : std::next(it);
+  }
+  return true;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+  if (type != tsdb_partition.type || subtype != tsdb_partition.subtype ||
+      (label != nullptr && strcmp(label, tsdb_partition.label) != 0)) {
+    return nullptr;
+  }
+  return &tsdb_partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* p, size_t offset, void* dst, size_t len) {
+  if (!flash_range_valid(p, offset, len)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memcpy(dst, &tsdb_flash[offset], len);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* p, size_t offset, const void* src, size_t len) {
+  if (!flash_range_valid(p, offset, len)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint8_t* s = (const uint8_t*)src;
+  for (size_t i = 0; i < len; i++) {
+    tsdb_flash[offset + i] &= s[i];
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t offset, size_t len) {
+  if (!flash_range_valid(p, offset, len) || offset % SPI_FLASH_SEC_SIZE != 0 || len % SPI_FLASH_SEC_SIZE != 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(&tsdb_flash[offset], 0xFF, len);
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_configure(const void* config) {
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t type, int arg, const char* name, esp_pm_lock_handle_t* out) {
+  *out = nullptr;
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t lock) {
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t lock) {
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ulp_wakeup() {
+  return ESP_OK;
+}
+
+void adc1_config_width(int width) {
+}
+
+void adc1_config_channel_atten(adc1_channel_t channel, int atten) {
+}
+
+void adc1_ulp_enable() {
+}
+
+esp_err_t rtc_isr_register(void (*handler)(void*), void* arg, uint32_t mask) {
+  return ESP_OK;
+}
+
+esp_err_t ulp_process_macros_and_load(uint32_t addr, const ulp_insn_t* program, size_t* size) {
+  return ESP_FAIL; // no ULP on the host, the firmware falls back to the CPU sampling
+}
+
+esp_err_t ulp_run(uint32_t entry) {
+  return ESP_FAIL;
+}
+
+esp_err_t ulp_set_wakeup_period(size_t index, uint32_t period_us) {
+  return ESP_OK;
+}
@@ -0,0 +1,285 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file wifi_fake.c
+ * @brief Wi-Fi fake of the native build
+ *
+ * This implementation file provides the station of a simulated access point and a TCP
+ * client connected to an in-process MQTT 3.1.1 broker (CONNACK, PUBACK, PINGRESP), or to
+ * a real broker such as a local Mosquitto over a host socket. Taking the access point or
+ * the broker down drops the connection like a lost link.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "WiFi.h"
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MQTT_FAKE_CONNACK 0x20
+#define MQTT_FAKE_PUBACK 0x40
+#define MQTT_FAKE_PINGRESP 0xD0
+
+WiFiClass WiFi;
+
+static bool ap_up = true;
+static bool sta_started = false;
+static int64_t assoc_at_us = INT64_MAX; // station associated from this time
+static bool broker_up = true;
+static uint32_t link_session = 1; // bumped when every connection is lost
+static std::string socket_host; // empty: in-process broker
+static uint16_t socket_port = 0;
+static std::vector<uint8_t> broker_rx; // bytes written by the client
+static std::vector<uint8_t> broker_tx; // bytes waiting for the client
+static uint32_t pubacks_to_drop = 0;
+static void (*publish_hook)(const char* topic, const uint8_t* payload, size_t len, bool dup) = nullptr;
+
+static void link_lost() {
+  link_session++;
+}
+
+static void broker_send(uint8_t type, uint16_t id) {
+  broker_tx.push_back(type);
+  broker_tx.push_back(type == MQTT_FAKE_PINGRESP ? 0 : 2);
+  if (type != MQTT_FAKE_PINGRESP) {
+    broker_tx.push_back((uint8_t)(id >> 8)); // CONNACK: session present 0, return code 0
+    broker_tx.push_back((uint8_t)id);
+  }
+}
+
+// one complete packet of the client; false to close the connection
+static bool broker_packet(const uint8_t* p, size_t hdr, size_t len) {
+  uint8_t type = p[0] & 0xF0;
+  if (type == 0x10) { // CONNECT
+    broker_send(MQTT_FAKE_CONNACK, 0);
+  } else if (type == 0x30) { // PUBLISH
+    uint8_t qos = (p[0] >> 1) & 0x03;
+    size_t topic_len = (size_t)(p[hdr] << 8 | p[hdr + 1]);
+    size_t pos = hdr + 2 + topic_len;
+    uint16_t id = 0;
+    if (qos > 0) {
+      id = (uint16_t)(p[pos] << 8 | p[pos + 1]);
+      pos += 2;
+    }
+    if (pos > len) {
+      return false;
+    }
+    std::string topic((const char*)&p[hdr + 2], topic_len);
+    if (publish_hook != nullptr) {
+      publish_hook(topic.c_str(), &p[pos], len - pos, (p[0] & 0x08) != 0);
+    }
+    if (qos == 1 && pubacks_to_drop > 0) {
+      pubacks_to_drop--;
+    } else if (qos == 1) {
+      broker_send(MQTT_FAKE_PUBACK, id);
+    }
+  } else if (type == 0xC0) { // PINGREQ
+    broker_send(MQTT_FAKE_PINGRESP, 0);
+  } else if (type == 0xE0) { // DISCONNECT
+    return false;
+  }
+  return true;
+}
+
+static bool broker_receive(const uint8_t* data, size_t size) {
+  broker_rx.insert(broker_rx.end(), data, data + size);
+  while (broker_rx.size() >= 2) {
+    size_t remaining = 0, hdr = 1;
+    do {
+      if (hdr >= broker_rx.size() || hdr > 4) {
+        return hdr <= 4; // incomplete, or malformed
+      }
+      remaining |= (size_t)(broker_rx[hdr] & 0x7F) << (7 * (hdr - 1));
+    } while (broker_rx[hdr++] & 0x80);
+    if (broker_rx.size() < hdr + remaining) {
+      return true;
+    }
+    if (!broker_packet(broker_rx.data(), hdr, hdr + remaining)) {
+      return false;
+    }
+    broker_rx.erase(broker_rx.begin(), broker_rx.begin() + hdr + remaining);
+  }
+  return true;
+}
+
+static int socket_open() {
+  struct addrinfo hints = {}, *res = NULL;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(socket_host.c_str(), std::to_string(socket_port).c_str(), &hints, &res) != 0) {
+    return -1;
+  }
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd >= 0) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); // read() must not wait
+  }
+  return fd;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void native_wifi_set_ap(bool up) {
+  if (ap_up && !up) {
+    link_lost();
+  }
+  if (!ap_up && up && sta_started) {
+    assoc_at_us = native_now_us() + NATIVE_WIFI_ASSOC_US; // auto reconnect of the station
+  }
+  ap_up = up;
+}
+
+void native_broker_set_up(bool up) {
+  if (broker_up && !up) {
+    link_lost();
+  }
+  broker_up = up;
+}
+
+void native_broker_drop_pubacks(uint32_t count) {
+  pubacks_to_drop = count;
+}
+
+void native_broker_set_publish_hook(void (*hook)(const char* topic, const uint8_t* payload, size_t len, bool dup)) {
+  publish_hook = hook;
+}
+
+void native_broker_use_socket(const char* host, uint16_t port) {
+  socket_host = host != NULL ? host : "";
+  socket_port = port;
+}
+
+bool WiFiClass::mode(wifi_mode_t m) {
+  return true;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* pass) {
+  sta_started = true;
+  reconnect();
+  return status();
+}
+
+bool WiFiClass::reconnect() {
+  if (sta_started && ap_up && native_now_us() >= assoc_at_us) {
+    return true; // already associated
+  }
+  assoc_at_us = ap_up ? native_now_us() + NATIVE_WIFI_ASSOC_US : INT64_MAX;
+  return ap_up;
+}
+
+bool WiFiClass::disconnect(bool wifioff) {
+  sta_started = !wifioff;
+  assoc_at_us = INT64_MAX;
+  link_lost();
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  if (!sta_started) {
+    return WL_IDLE_STATUS;
+  }
+  if (!ap_up) {
+    return WL_NO_SSID_AVAIL;
+  }
+  return native_now_us() >= assoc_at_us ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+  stop();
+  if (WiFi.status() != WL_CONNECTED) {
+    return 0;
+  }
+  if (!socket_host.empty()) {
+    fd_ = socket_open();
+    if (fd_ < 0) {
+      return 0;
+    }
+  } else if (!broker_up) {
+    return 0;
+  } else {
+    broker_rx.clear();
+    broker_tx.clear();
+  }
+  open_ = true;
+  session_ = link_session;
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+  if (!connected()) {
+    return 0;
+  }
+  if (fd_ >= 0) {
+    ssize_t n = send(fd_, buf, size, MSG_NOSIGNAL);
+    return n > 0 ? (size_t)n : 0;
+  }
+  if (!broker_receive(buf, size)) {
+    open_ = false; // closed by the broker
+  }
+  return size;
+}
+
+int WiFiClient::available() {
+  if (!connected()) {
+    return 0;
+  }
+  if (fd_ >= 0) {
+    int n = 0;
+    return ioctl(fd_, FIONREAD, &n) == 0 ? n : 0;
+  }
+  return (int)broker_tx.size();
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+  if (!connected()) {
+    return -1;
+  }
+  if (fd_ >= 0) {
+    ssize_t n = recv(fd_, buf, size, 0);
+    return n > 0 ? (int)n : -1;
+  }
+  size = size < broker_tx.size() ? size : broker_tx.size();
+  memcpy(buf, broker_tx.data(), size);
+  broker_tx.erase(broker_tx.begin(), broker_tx.begin() + size);
+  return (int)size;
+}
+
+uint8_t WiFiClient::connected() {
+  if (!open_ || session_ != link_session || WiFi.status() != WL_CONNECTED) {
+    return 0;
+  }
+  if (fd_ >= 0) {
+    uint8_t b;
+    ssize_t n = recv(fd_, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) ? 1 : 0; // 0: closed by the broker
+  }
+  return 1;
+}
+
+void WiFiClient::stop() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  fd_ = -1;
+  open_ = false;
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file amux_hal.c
+ * @brief Abstract interface to read humidity probes through analog multiplexers
+ *
+ * This implementation file binds the scanning engine to GPIO, ADC and analog_hal.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "HAL/amux_hal.h"
+#include "HAL/power_hal.h"
+#include "soc/gpio_reg.h"
+
+extern Power_t power_a[NUM_PM_LOCKS]; // array of PM locks
+
+static const uint8_t amux_sel_pin[4] = { AMUX_S0_pin, AMUX_S1_pin, AMUX_S2_pin, AMUX_S3_pin };
+static const uint8_t amux_sig_pin[AMUX_MAX_BANKS] = { AMUX_SIG_0_pin, AMUX_SIG_1_pin };
+static const uint32_t amux_sel_mask = (1UL << AMUX_S0_pin) | (1UL << AMUX_S1_pin) |
+                                      (1UL << AMUX_S2_pin) | (1UL << AMUX_S3_pin);
+
+static Amux_t amux;
+static Analog_t* amux_a = NULL;
+static uint8_t amux_size = 0;
+
+static void amux_select(AmuxIo_t* io, uint8_t lines) {
+  uint32_t set = 0;
+  for (uint8_t i = 0; i < 4; i++){
+    if (lines & (1 << i)) {
+      set |= 1UL << amux_sel_pin[i];
+    }
+  }
+  // all lines change in the same write: no intermediate channel is selected
+  REG_WRITE(GPIO_OUT_W1TC_REG, amux_sel_mask & ~set);
+  REG_WRITE(GPIO_OUT_W1TS_REG, set);
+}
+
+static uint16_t amux_convert(AmuxIo_t* io, uint8_t bank) {
+  return analogRead(amux_sig_pin[bank]);
+}
+
+static uint32_t amux_now_us(AmuxIo_t* io) {
+  return micros();
+}
+
+static void amux_delay_us(AmuxIo_t* io, uint32_t us) {
+  delayMicroseconds(us);
+}
+
+static void amux_sink(AmuxIo_t* io, uint8_t channel, uint16_t raw) {
+  analog_add_sample(amux_a, AMUX_FIRST_ch + channel, raw, amux_size);
+}
+
+static AmuxIo_t amux_io = { amux_select, amux_convert, amux_now_us, amux_delay_us, amux_sink, NULL };
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void amux_hal_init(Analog_t* a, uint8_t size){
+  amux_a = a;
+  amux_size = size;
+  for (uint8_t i = 0; i < 4; i++){
+    pinMode(amux_sel_pin[i], OUTPUT);
+  }
+  for (uint8_t b = 0; b < AMUX_NUM_BANKS; b++){
+    for (uint8_t k = 0; k < AMUX_BANK_CHANNELS; k++){
+      analog_set_pin(a, AMUX_FIRST_ch + b * AMUX_BANK_CHANNELS + k, amux_sig_pin[b], size);
+    }
+  }
+  amux_init(&amux, AMUX_NUM_BANKS, AMUX_BANK_CHANNELS, AMUX_SETTLE_US, AMUX_DISCARD);
+}
+
+void amux_hal_sweep(Analog_t* a, uint8_t size){
+  amux_a = a;
+  amux_size = size;
+  power_lock_acquire(power_a, PM_LOCK_ADC_ch, NUM_PM_LOCKS); // keep CPU awake during the sweep
+  amux_sweep(&amux, &amux_io);
+  power_lock_release(power_a, PM_LOCK_ADC_ch, NUM_PM_LOCKS);
+  LOG_D(LOG_FMT_AMUX_SWEEP, AMUX_NUM_BANKS * AMUX_BANK_CHANNELS, amux.stats.sweep_us, amux.stats.wait_us);
+}
+
+void amux_hal_print(){
+  DEBUG_PRINT("Mux: %u sweeps, %u conversions, last sweep %u us (wait %u us, overlapped %u us)\n",
+              amux.stats.sweeps, amux.stats.conversions, amux.stats.sweep_us,
+              amux.stats.wait_us, amux.stats.overlap_us);
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file amux_scan.c
+ * @brief Analog multiplexer scanning engine
+ *
+ * This implementation file provides the Gray code scan order and the pipelined sweep.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "HAL/amux_scan.h"
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void amux_init(Amux_t* m, uint8_t banks, uint8_t channels, uint16_t settle_us, uint8_t discard){
+  m->banks = banks > AMUX_MAX_BANKS ? AMUX_MAX_BANKS : banks;
+  m->channels = channels > AMUX_MAX_CHANNELS ? AMUX_MAX_CHANNELS : channels;
+  m->settle_us = settle_us;
+  m->discard = discard;
+  // Gray code over the 16 select codes, unused codes skipped
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < AMUX_MAX_CHANNELS; i++){
+    uint8_t k = i ^ (i >> 1);
+    if (k < m->channels) {
+      m->order[n++] = k;
+    }
+  }
+  m->stats = AmuxStats_t();
+}
+
+void amux_sweep(Amux_t* m, AmuxIo_t* io){
+  uint16_t pending[AMUX_MAX_BANKS];
+  uint8_t prev = 0;
+  uint32_t wait_us = 0, overlap_us = 0;
+  uint32_t start = io->now_us(io);
+
+  for (uint8_t step = 0; step <= m->channels; step++){
+    uint8_t k = 0;
+    uint32_t t_sel = 0;
+    if (step < m->channels) {
+      k = m->order[step];
+      io->select(io, k);
+      t_sel = io->now_us(io);
+    }
+    // filter stage of the previous channel while the new one settles
+    if (step > 0) {
+      for (uint8_t b = 0; b < m->banks; b++){
+        io->sink(io, b * m->channels + prev, pending[b]);
+      }
+    }
+    if (step == m->channels) {
+      break;
+    }
+    uint32_t elapsed = io->now_us(io) - t_sel;
+    if (elapsed < m->settle_us) {
+      io->delay_us(io, m->settle_us - elapsed);
+      wait_us += m->settle_us - elapsed;
+      overlap_us += elapsed;
+    } else {
+      overlap_us += m->settle_us;
+    }
+    for (uint8_t b = 0; b < m->banks; b++){
+      for (uint8_t d = 0; d < m->discard; d++){
+        io->convert(io, b);
+      }
+      pending[b] = io->convert(io, b);
+    }
+    m->stats.conversions += m->banks * (1 + m->discard);
+    prev = k;
+  }
+  m->stats.sweeps++;
+  m->stats.sweep_us = io->now_us(io) - start;
+  m->stats.wait_us = wait_us;
+  m->stats.overlap_us = overlap_us;
+}
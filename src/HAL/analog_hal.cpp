@@ -19,8 +19,22 @@
  */
 
 #include "HAL/analog_hal.h"
+#include "HAL/power_hal.h"
+#include "telemetry.h"
 
 Analog_t analog_a[NUM_ANALOG_PERIP] = {}; // array of analog peripherals
+extern Power_t power_a[NUM_PM_LOCKS]; // array of PM locks
+static uint16_t spike_range = RANGE; // set by analog_set_spike()
+static uint8_t spike_limit = LIMIT_ADC_SPIKE;
+
+static uint16_t filtered_value(Analog_t* a, uint8_t channel, uint8_t size){
+#if KALMAN_FILTER
+  int32_t v = a[channel].kf.started ? kalman_value(&a[channel].kf) : 0;
+  return (uint16_t)(v < 0 ? 0 : (v > 4095 ? 4095 : v));
+#else
+  return analog_get_media(a, channel, size);
+#endif
+}
 
 /***********************************************************
  Function Definitions
@@ -38,6 +52,9 @@ void analog_init(Analog_t* a, uint8_t size){
       .count = 0 // Initialize count to zero
     };
     a[i].counter_spike = NO_ADC_SPIKE;
+#if KALMAN_FILTER
+    kalman_init(&a[i].kf, KALMAN_Q(KALMAN_ADC_R), KALMAN_Q(KALMAN_ADC_QX), KALMAN_Q(KALMAN_ADC_QV));
+#endif
   }
 }
 
@@ -73,19 +90,19 @@ bool data_is_valid(Analog_t* a, uint8_t channel, uint16_t data_read, uint8_t siz
     if(a[channel].status){
       if(a[channel].fbuf.count == a[channel].fbuf.length){
         uint16_t last_value = a[channel].fbuf.data_set[a[channel].fbuf.count - 1]; // Get the last value in the buffer
-        return (data_read <= last_value + RANGE & data_read >= last_value - RANGE);
+        return (data_read <= last_value + spike_range & data_read >= last_value - spike_range);
       }else{
         // If the buffer is not full, consider the data valid
         return true;
       }
     }else{
       // If the channel is not valid, return false
-      DEBUG_PRINT("Channel not valid %d\n", channel);
+      LOG_W(LOG_FMT_CHANNEL_INVALID, channel);
       return false; // If the channel is not valid, return false
     }
     
   }else{
-    DEBUG_PRINT("Channel out of bounds %d\n", channel);
+    LOG_W(LOG_FMT_CHANNEL_OOB, channel);
     // If the channel is out of bounds, return false
     return false; // If the channel is out of bounds, return false
   }
@@ -107,11 +124,32 @@ uint8_t spike_counter(Analog_t* a, uint8_t channel,  uint16_t data_read, uint8_t
 
 void analog_read_data (Analog_t* a, uint8_t channel, uint8_t size){
   if (a[channel].status){
+    power_lock_acquire(power_a, PM_LOCK_ADC_ch, NUM_PM_LOCKS); // keep CPU awake during ADC burst
     uint16_t data_read = analogRead(a[channel].pin);
-    if (spike_counter(a, channel, data_read, size) == NO_ADC_SPIKE || spike_counter(a, channel, data_read, size) >= LIMIT_ADC_SPIKE){
+    power_lock_release(power_a, PM_LOCK_ADC_ch, NUM_PM_LOCKS);
+    analog_add_sample(a, channel, data_read, size);
+  }
+}
+
+void analog_add_sample (Analog_t* a, uint8_t channel, uint16_t data_read, uint8_t size){
+  if (channel < size && a[channel].status){
+    telemetry_emit(TLM_RAW_ADC, channel, data_read);
+    if (spike_counter(a, channel, data_read, size) == NO_ADC_SPIKE || spike_counter(a, channel, data_read, size) >= spike_limit){
+#if KALMAN_FILTER
+      if (a[channel].counter_spike != NO_ADC_SPIKE) {
+        kalman_restart(&a[channel].kf); // step confirmed by the spike filter: no lag
+      }
+#endif
       Ff_buffer_add(a, channel, data_read, size); // Add new data to the FIFO buffer
       a[channel].counter_spike = NO_ADC_SPIKE; // Reset spike counter if data is valid
-      a[channel].fbuf.data_media = analog_get_media(a, channel, size); // Calculate media from the buffer
+#if KALMAN_FILTER
+      kalman_update(&a[channel].kf, data_read);
+#endif
+      a[channel].fbuf.data_media = filtered_value(a, channel, size); // Calculate media from the buffer
+    }else{
+#if KALMAN_FILTER
+      kalman_predict(&a[channel].kf); // spike rejected: advance without measurement
+#endif
     }
   }
 }
@@ -144,4 +182,33 @@ void analog_print(Analog_t* a, uint8_t channel){
     }
   }
   DEBUG_PRINT("]\t%d\n", a[channel].counter_spike);
-}
\ No newline at end of file
+}
+
+bool analog_set_length(Analog_t* a, uint8_t channel, uint8_t length, uint8_t size){
+  if(channel < size && length > 0 && length <= BUFFER_SIZE){
+    Fifo_buf_t* f = &a[channel].fbuf;
+    if(f->count > length){
+      // keep the newest samples
+      for(uint8_t i = 0; i < length; i++){
+        f->data_set[i] = f->data_set[f->count - length + i];
+      }
+      f->count = length;
+    }
+    f->length = length;
+    f->data_media = filtered_value(a, channel, size);
+    return true;
+  }
+  return false;
+}
+
+void analog_set_spike(uint16_t range, uint8_t limit){
+  spike_range = range;
+  spike_limit = limit;
+}
+
+uint16_t analog_get_value(Analog_t* a, uint8_t channel, uint8_t size){
+  if(channel < size && a[channel].status){
+    return a[channel].fbuf.data_media;
+  }
+  return 0;
+}
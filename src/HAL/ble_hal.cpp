@@ -18,27 +18,110 @@
  *
  */
 #include "HAL/ble_hal.h"
+#include "HAL/power_hal.h"
+
+extern Power_t power_a[NUM_PM_LOCKS]; // array of PM locks
 
 BLEServer *pServer;
+#if BLE_LEGACY_CHARACTERISTICS
 BLECharacteristic* characteristic_temp = nullptr;
 BLECharacteristic* characteristic_humidity = nullptr;
 BLECharacteristic* characteristic_slrrad = nullptr;
+#endif
+BLECharacteristic* characteristic_alarm = nullptr;
+BLECharacteristic* characteristic_stats = nullptr;
+BLECharacteristic* characteristic_config = nullptr;
+BLECharacteristic* characteristic_history = nullptr;
+BLECharacteristic* characteristic_record = nullptr;
+BLECharacteristic* characteristic_time = nullptr;
+static bool (*config_on_write)(const uint8_t* data, size_t len) = nullptr;
+static size_t (*config_on_read)(uint8_t* data, size_t max) = nullptr;
+static bool (*history_on_write)(const uint8_t* data, size_t len) = nullptr;
+static bool (*time_on_write)(const uint8_t* data, size_t len) = nullptr;
 bool deviceConnected = false;
+static uint8_t ble_centrals = 0; // connected centrals
+static uint32_t notify_sent = 0; // notifications queued, one per central
+static uint32_t notify_dropped = 0; // notifications refused by the stack (TX buffers full)
+static portMUX_TYPE ble_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void put_centi(uint8_t* p, float v){
+    long c = lroundf(v * 100.0f);
+    int16_t s = (int16_t)(c > INT16_MAX ? INT16_MAX : (c < INT16_MIN ? INT16_MIN : c));
+    p[0] = (uint8_t)s;
+    p[1] = (uint8_t)((uint16_t)s >> 8);
+}
+
+class NotifyCallbacks : public BLECharacteristicCallbacks {
+public:
+  void onStatus(BLECharacteristic* c, Status s, uint32_t code) override{
+    portENTER_CRITICAL(&ble_mux);
+    if (s == SUCCESS_NOTIFY) {
+      notify_sent++;
+    } else if (s == ERROR_GATT) {
+      notify_dropped++;
+    }
+    portEXIT_CRITICAL(&ble_mux);
+  }
+};
+
+class ConfigCallbacks : public BLECharacteristicCallbacks {
+  void onWrite(BLECharacteristic* c) override{
+    if (config_on_write != nullptr) {
+      config_on_write(c->getData(), c->getLength());
+    }
+    onRead(c); // read back the configuration in use
+  }
+  void onRead(BLECharacteristic* c) override{
+    if (config_on_read != nullptr) {
+      uint8_t value[BLE_CONFIG_MAX_LEN];
+      size_t len = config_on_read(value, sizeof(value));
+      c->setValue(value, len);
+    }
+  }
+};
+
+class HistoryCallbacks : public NotifyCallbacks {
+  void onWrite(BLECharacteristic* c) override{
+    if (history_on_write != nullptr) {
+      history_on_write(c->getData(), c->getLength());
+    }
+  }
+};
+
+class TimeCallbacks : public BLECharacteristicCallbacks {
+  void onWrite(BLECharacteristic* c) override{
+    if (time_on_write != nullptr) {
+      time_on_write(c->getData(), c->getLength());
+    }
+  }
+};
 
 class MyServerCallbacks : public BLEServerCallbacks {
   void onConnect(BLEServer* pServer) override{
+      power_lock_acquire(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+      ble_centrals++;
       deviceConnected = true;
-      DEBUG_PRINT("Device Connected\n");
+      LOG_I(LOG_FMT_BLE_CONNECTED);
+      // advertising stops at every connection, keep it on for the next central
+      BLEAdvertising *pAdvertising = pServer->getAdvertising();
+      if (pAdvertising && ble_centrals < BLE_MAX_CENTRALS) {
+          pAdvertising->start();
+          LOG_I(LOG_FMT_BLE_ADV_RESTART);
+      }
+      power_lock_release(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
     };
   void onDisconnect(BLEServer *pServer) override{
-    deviceConnected = false;
-    DEBUG_PRINT("Device Disconnected\n");
+    power_lock_acquire(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+    ble_centrals = ble_centrals > 0 ? ble_centrals - 1 : 0;
+    deviceConnected = ble_centrals > 0;
+    LOG_I(LOG_FMT_BLE_DISCONNECTED);
     // restart advertising so central can discover again
     BLEAdvertising *pAdvertising = pServer->getAdvertising();
     if (pAdvertising) {
         pAdvertising->start();
-        DEBUG_PRINT("Advertising restarted on disconnect\n");
+        LOG_I(LOG_FMT_BLE_ADV_RESTART);
     }
+    power_lock_release(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
   }
 };
 
@@ -53,42 +136,183 @@ void ble_init(){
 }
 
 void ble_create_service() {
-  BLEService *pService = pServer->createService(SERVICE_UUID);
+  BLEService *pService = pServer->createService(BLEUUID(SERVICE_UUID), BLE_SERVICE_HANDLES);
+  NotifyCallbacks* notify_callbacks = new NotifyCallbacks(); // notification counters
+#if BLE_LEGACY_CHARACTERISTICS // deprecated, plant 1 only: clients use the record characteristic
   characteristic_temp = pService->createCharacteristic(
                      CHARACTERISTIC_UUID_TEMP,
                       BLECharacteristic::PROPERTY_READ |
                       BLECharacteristic::PROPERTY_NOTIFY
                    );
   characteristic_temp->addDescriptor(new BLE2902());
+  characteristic_temp->setCallbacks(notify_callbacks);
   characteristic_humidity = pService->createCharacteristic(
                      CHARACTERISTIC_UUID_HUMIDITY,
                       BLECharacteristic::PROPERTY_READ |
                       BLECharacteristic::PROPERTY_NOTIFY
                    );
   characteristic_humidity->addDescriptor(new BLE2902());
+  characteristic_humidity->setCallbacks(notify_callbacks);
   characteristic_slrrad = pService->createCharacteristic(
                      CHARACTERISTIC_UUID_SLRRAD,
                       BLECharacteristic::PROPERTY_READ |
                       BLECharacteristic::PROPERTY_NOTIFY
                    );
   characteristic_slrrad->addDescriptor(new BLE2902());
+  characteristic_slrrad->setCallbacks(notify_callbacks);
+#endif
+  characteristic_alarm = pService->createCharacteristic(
+                     CHARACTERISTIC_UUID_ALARM,
+                      BLECharacteristic::PROPERTY_READ |
+                      BLECharacteristic::PROPERTY_NOTIFY
+                   );
+  characteristic_alarm->addDescriptor(new BLE2902());
+  characteristic_alarm->setCallbacks(notify_callbacks);
+  characteristic_stats = pService->createCharacteristic(
+                     CHARACTERISTIC_UUID_STATS,
+                      BLECharacteristic::PROPERTY_READ |
+                      BLECharacteristic::PROPERTY_NOTIFY
+                   );
+  characteristic_stats->addDescriptor(new BLE2902());
+  characteristic_stats->setCallbacks(notify_callbacks);
+  characteristic_config = pService->createCharacteristic(
+                     CHARACTERISTIC_UUID_CONFIG,
+                      BLECharacteristic::PROPERTY_READ |
+                      BLECharacteristic::PROPERTY_WRITE
+                   );
+  characteristic_config->setCallbacks(new ConfigCallbacks());
+  characteristic_history = pService->createCharacteristic(
+                     CHARACTERISTIC_UUID_HISTORY,
+                      BLECharacteristic::PROPERTY_WRITE |
+                      BLECharacteristic::PROPERTY_NOTIFY
+                   );
+  characteristic_history->addDescriptor(new BLE2902());
+  characteristic_history->setCallbacks(new HistoryCallbacks());
+  characteristic_record = pService->createCharacteristic(
+                     CHARACTERISTIC_UUID_RECORD,
+                      BLECharacteristic::PROPERTY_READ |
+                      BLECharacteristic::PROPERTY_NOTIFY
+                   );
+  characteristic_record->addDescriptor(new BLE2902());
+  characteristic_record->setCallbacks(notify_callbacks);
+  characteristic_time = pService->createCharacteristic(
+                     CHARACTERISTIC_UUID_TIME,
+                      BLECharacteristic::PROPERTY_WRITE
+                   );
+  characteristic_time->setCallbacks(new TimeCallbacks());
   pService->start();
   BLEAdvertising *pAdvertising = pServer->getAdvertising();
   pAdvertising->start();
 }
 
+#if BLE_LEGACY_CHARACTERISTICS
 void ble_transmit_temp(uint16_t value){
+    power_lock_acquire(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
     characteristic_temp->setValue(value);
     characteristic_temp->notify();
+    power_lock_release(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
 }
 
 void ble_transmit_humidity(uint16_t value){
+    power_lock_acquire(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
     characteristic_humidity->setValue(value);
     characteristic_humidity->notify();
+    power_lock_release(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
 }
 
 void ble_transmit_slrrad(uint16_t value){
+    power_lock_acquire(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
     characteristic_slrrad->setValue(value);
     characteristic_slrrad->notify();
+    power_lock_release(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+}
+#endif
+
+void ble_transmit_alarm(uint8_t plant, uint8_t mask){
+    uint8_t value[2] = {plant, mask};
+    power_lock_acquire(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+    characteristic_alarm->setValue(value, sizeof(value));
+    characteristic_alarm->notify();
+    power_lock_release(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
 }
 
+void ble_transmit_stats(uint8_t plant, uint8_t field, const RollStatValue_t* v){
+    uint8_t value[16] = {plant, field,
+                         (uint8_t)v->n, (uint8_t)(v->n >> 8), (uint8_t)(v->n >> 16), (uint8_t)(v->n >> 24)};
+    put_centi(&value[6], v->mean);
+    put_centi(&value[8], v->stddev);
+    put_centi(&value[10], v->min);
+    put_centi(&value[12], v->max);
+    put_centi(&value[14], v->ewma);
+    power_lock_acquire(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+    characteristic_stats->setValue(value, sizeof(value));
+    characteristic_stats->notify();
+    power_lock_release(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+}
+
+void ble_transmit_records(const PlantRecord_t* r, uint8_t count){
+    uint8_t value[RECORD_BATCH_SIZE(BLE_RECORD_CHUNK_RECORDS)];
+    power_lock_acquire(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+    for (uint8_t i = 0; i < count; i += BLE_RECORD_CHUNK_RECORDS){
+        uint8_t n = count - i < BLE_RECORD_CHUNK_RECORDS ? count - i : BLE_RECORD_CHUNK_RECORDS;
+        size_t len = record_encode(&r[i], n, value, sizeof(value));
+        if (len > 0){
+            characteristic_record->setValue(value, len);
+            characteristic_record->notify();
+        }
+    }
+    power_lock_release(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+}
+
+void ble_set_config_handler(bool (*on_write)(const uint8_t* data, size_t len),
+                            size_t (*on_read)(uint8_t* data, size_t max)){
+    config_on_write = on_write;
+    config_on_read = on_read;
+}
+
+void ble_transmit_history(const DsPoint_t* p, uint16_t count, uint32_t last_ts){
+    uint8_t value[2 + BLE_HISTORY_CHUNK_POINTS * 6];
+    uint8_t seq = 0;
+    power_lock_acquire(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+    for (uint16_t i = 0; i < count; i += BLE_HISTORY_CHUNK_POINTS){
+        uint8_t n = count - i < BLE_HISTORY_CHUNK_POINTS ? count - i : BLE_HISTORY_CHUNK_POINTS;
+        value[0] = seq++;
+        value[1] = n;
+        for (uint8_t k = 0; k < n; k++){
+            uint8_t* q = &value[2 + k * 6];
+            int16_t v = (int16_t)(p[i + k].value > INT16_MAX ? INT16_MAX : (p[i + k].value < INT16_MIN ? INT16_MIN : p[i + k].value));
+            q[0] = (uint8_t)p[i + k].ts;
+            q[1] = (uint8_t)(p[i + k].ts >> 8);
+            q[2] = (uint8_t)(p[i + k].ts >> 16);
+            q[3] = (uint8_t)(p[i + k].ts >> 24);
+            q[4] = (uint8_t)v;
+            q[5] = (uint8_t)((uint16_t)v >> 8);
+        }
+        characteristic_history->setValue(value, 2 + n * 6);
+        characteristic_history->notify();
+    }
+    uint8_t end[8] = {seq, 0, (uint8_t)count, (uint8_t)(count >> 8),
+                      (uint8_t)last_ts, (uint8_t)(last_ts >> 8), (uint8_t)(last_ts >> 16), (uint8_t)(last_ts >> 24)};
+    characteristic_history->setValue(end, sizeof(end));
+    characteristic_history->notify();
+    power_lock_release(power_a, PM_LOCK_BLE_ch, NUM_PM_LOCKS);
+}
+
+void ble_set_history_handler(bool (*on_write)(const uint8_t* data, size_t len)){
+    history_on_write = on_write;
+}
+
+void ble_set_time_handler(bool (*on_write)(const uint8_t* data, size_t len)){
+    time_on_write = on_write;
+}
+
+uint8_t ble_get_centrals(){
+    return ble_centrals;
+}
+
+void ble_get_notify_stats(uint32_t* sent, uint32_t* dropped){
+    portENTER_CRITICAL(&ble_mux);
+    *sent = notify_sent;
+    *dropped = notify_dropped;
+    portEXIT_CRITICAL(&ble_mux);
+}
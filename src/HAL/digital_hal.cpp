@@ -18,6 +18,7 @@
  *
  */
 #include "HAL/digital_hal.h"
+#include "telemetry.h"
 
 
 Dig_t digital_a[NUM_DIG_PERIP] = {};
@@ -71,6 +72,7 @@ int digital_read(Dig_t* d, uint8_t channel, uint8_t size){
   if(channel < size){
 		if(d[channel].status){
       value = digitalRead(d[channel].pin);
+      telemetry_emit(TLM_RAW_DIGITAL, channel, value);
 		}
 	}
   return value;
@@ -0,0 +1,50 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file flash_hal.c
+ * @brief Abstract interface to access a raw flash partition
+ *
+ * This implementation file maps the Flash_t access functions on esp_partition.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "HAL/flash_hal.h"
+
+static bool flash_read(Flash_t* f, uint32_t addr, void* dst, size_t len) {
+  return esp_partition_read((const esp_partition_t*)f->ctx, addr, dst, len) == ESP_OK;
+}
+
+static bool flash_write(Flash_t* f, uint32_t addr, const void* src, size_t len) {
+  return esp_partition_write((const esp_partition_t*)f->ctx, addr, src, len) == ESP_OK;
+}
+
+static bool flash_erase(Flash_t* f, uint16_t sector) {
+  return esp_partition_erase_range((const esp_partition_t*)f->ctx, (size_t)sector * f->sector_size, f->sector_size) == ESP_OK;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool flash_init(Flash_t* f, const char* label){
+  const esp_partition_t* p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                      (esp_partition_subtype_t)TSDB_PARTITION_SUBTYPE, label);
+  if (p == NULL) {
+    return false;
+  }
+  f->sector_size = SPI_FLASH_SEC_SIZE;
+  f->sector_count = (uint16_t)(p->size / SPI_FLASH_SEC_SIZE);
+  f->read = flash_read;
+  f->write = flash_write;
+  f->erase = flash_erase;
+  f->ctx = (void*)p;
+  return true;
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file i2c_mux.c
+ * @brief Sensors behind a TCA9548A I2C multiplexer
+ *
+ * This implementation file provides the read plan grouped by mux channel and the
+ * per-sensor latency statistics.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <string.h>
+#include <math.h>
+#include "HAL/i2c_mux.h"
+
+// failed read, the value is dropped after I2CMUX_MAX_ERRORS in a row
+static void sensor_error(I2cSensor_t* s){
+  s->errors++;
+  if (s->fails < I2CMUX_MAX_ERRORS) {
+    s->fails++; // saturated, no wrap
+  }
+  if (s->fails == I2CMUX_MAX_ERRORS) {
+    s->value = NAN;
+  }
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void i2cmux_init(I2cMux_t* m){
+  memset(m, 0, sizeof(I2cMux_t));
+  m->current = I2CMUX_NONE;
+}
+
+int8_t i2cmux_add(I2cMux_t* m, uint8_t mux_ch, uint8_t addr){
+  if (m->count >= I2CMUX_MAX_SENSORS) {
+    return -1;
+  }
+  for (uint8_t i = 0; i < m->count; i++){
+    if (m->sensor[i].mux_ch == mux_ch && m->sensor[i].addr == addr) {
+      return -1;
+    }
+  }
+  uint8_t idx = m->count++;
+  memset(&m->sensor[idx], 0, sizeof(I2cSensor_t));
+  m->sensor[idx].mux_ch = mux_ch;
+  m->sensor[idx].addr = addr;
+  m->sensor[idx].value = NAN; // no reading yet
+  // insertion in the plan, sensors directly on the bus (I2CMUX_NONE) last
+  uint8_t i = idx;
+  while (i > 0 && m->sensor[m->plan[i - 1]].mux_ch > mux_ch) {
+    m->plan[i] = m->plan[i - 1];
+    i--;
+  }
+  m->plan[i] = idx;
+  return (int8_t)idx;
+}
+
+uint8_t i2cmux_read_all(I2cMux_t* m, I2cBus_t* bus){
+  if (m->count == 0) {
+    return 0;
+  }
+  // start from the group of the selected channel: saves one switch per read
+  uint8_t start = 0;
+  for (uint8_t i = 0; i < m->count; i++){
+    if (m->sensor[m->plan[i]].mux_ch == m->current) {
+      start = i;
+      break;
+    }
+  }
+  while (start > 0 && m->sensor[m->plan[start - 1]].mux_ch == m->current) {
+    start--;
+  }
+
+  uint8_t ok = 0;
+  uint8_t failed = I2CMUX_NONE;
+  for (uint8_t n = 0; n < m->count; n++){
+    I2cSensor_t* s = &m->sensor[m->plan[(start + n) % m->count]];
+    if (s->mux_ch != I2CMUX_NONE && s->mux_ch != m->current) {
+      if (s->mux_ch == failed) {
+        sensor_error(s);
+        continue;
+      }
+      m->switches++;
+      if (!bus->select(bus, s->mux_ch)) {
+        failed = s->mux_ch;
+        m->current = I2CMUX_NONE; // unknown state after a failed switch
+        sensor_error(s);
+        continue;
+      }
+      m->current = s->mux_ch;
+    }
+    uint32_t t0 = bus->now_us(bus);
+    float value;
+    bool res = bus->read(bus, (uint8_t)(s - m->sensor), &value);
+    s->last_us = bus->now_us(bus) - t0;
+    if (res) {
+      s->value = value;
+      s->fails = 0;
+      s->reads++;
+      s->sum_us += s->last_us;
+      s->max_us = s->last_us > s->max_us ? s->last_us : s->max_us;
+      ok++;
+    } else {
+      sensor_error(s);
+    }
+  }
+  return ok;
+}
@@ -0,0 +1,149 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file power_hal.c
+ * @brief Abstraction of power management interface
+ *
+ * This implementation file provides an abstraction of esp_pm: DFS, automatic light sleep
+ * and PM locks taken only around active work (ADC bursts, I2C transactions, BLE events).
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "HAL/power_hal.h"
+
+Power_t power_a[NUM_PM_LOCKS] = {}; // array of PM locks
+PowerStats_t power_stats = {};
+
+static portMUX_TYPE power_mux = portMUX_INITIALIZER_UNLOCKED;
+static const char* power_lock_names[NUM_PM_LOCKS] = {"adc", "i2c", "ble"};
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void power_init(Power_t* p, uint8_t size){
+  power_stats = {};
+  power_stats.boot_us = esp_timer_get_time();
+
+#if POWER_SAVE
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t pm_config = {
+#else
+  esp_pm_config_esp32_t pm_config = {
+#endif
+    .max_freq_mhz = PM_CPU_FREQ_MAX,
+    .min_freq_mhz = PM_CPU_FREQ_MIN,
+    .light_sleep_enable = true
+  };
+  esp_err_t err = esp_pm_configure(&pm_config);
+  power_stats.pm_enabled = (err == ESP_OK);
+  if (err != ESP_OK) {
+    // Arduino core built without CONFIG_PM_ENABLE: keep running at fixed frequency
+    DEBUG_PRINT("esp_pm_configure failed (%d), power save disabled\n", err);
+  }
+#endif
+
+  for (int i = 0; i < size; i++){
+    p[i].name = (i < NUM_PM_LOCKS) ? power_lock_names[i] : "pm";
+    p[i].handle = NULL;
+    p[i].depth = 0;
+    p[i].count = 0;
+    p[i].since_us = 0;
+    p[i].held_us = 0;
+    p[i].status = false;
+    if (power_stats.pm_enabled) {
+      p[i].status = (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, p[i].name, &p[i].handle) == ESP_OK);
+    }
+  }
+}
+
+void power_lock_acquire(Power_t* p, uint8_t channel, uint8_t size){
+  if(channel < size){
+    if(p[channel].status){
+      esp_pm_lock_acquire(p[channel].handle);
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&power_mux);
+    if (p[channel].depth++ == 0) {
+      p[channel].count++;
+      p[channel].since_us = now;
+      if (power_stats.active_locks++ == 0) {
+        power_stats.max_since_us = now; // CPU switches to max frequency
+      }
+    }
+    portEXIT_CRITICAL(&power_mux);
+  }
+}
+
+void power_lock_release(Power_t* p, uint8_t channel, uint8_t size){
+  if(channel < size){
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&power_mux);
+    if (p[channel].depth > 0 && --p[channel].depth == 0) {
+      p[channel].held_us += now - p[channel].since_us;
+      if (--power_stats.active_locks == 0) {
+        power_stats.max_freq_us += now - power_stats.max_since_us; // CPU back to min frequency
+      }
+    }
+    portEXIT_CRITICAL(&power_mux);
+    if(p[channel].status){
+      esp_pm_lock_release(p[channel].handle);
+    }
+  }
+}
+
+bool power_delay_until(TickType_t* last_wake, TickType_t interval){
+  TickType_t remaining = (*last_wake + interval) - xTaskGetTickCount();
+  if (remaining > interval) {
+    remaining = 0; // period already elapsed, only a pending notification is taken
+  }
+  int64_t expected_us = esp_timer_get_time() + (int64_t)remaining * portTICK_PERIOD_MS * 1000;
+  if (ulTaskNotifyTake(pdTRUE, remaining) > 0) { // woken early: no expected time, no latency
+    *last_wake = xTaskGetTickCount();
+    return true;
+  }
+  *last_wake += interval;
+  int64_t latency = esp_timer_get_time() - expected_us;
+  if (latency < 0) {
+    latency = 0;
+  }
+  portENTER_CRITICAL(&power_mux);
+  power_stats.wake_count++;
+  power_stats.wake_latency_sum_us += (uint64_t)latency;
+  if ((uint32_t)latency > power_stats.wake_latency_max_us) {
+    power_stats.wake_latency_max_us = (uint32_t)latency;
+  }
+  portEXIT_CRITICAL(&power_mux);
+  return false;
+}
+
+void power_print(Power_t* p, uint8_t size){
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&power_mux);
+  PowerStats_t s = power_stats;
+  portEXIT_CRITICAL(&power_mux);
+
+  uint64_t uptime = (uint64_t)(now - s.boot_us);
+  uint64_t max_us = s.max_freq_us + (s.active_locks ? (uint64_t)(now - s.max_since_us) : 0);
+  uint64_t min_us = (uptime > max_us) ? uptime - max_us : 0;
+  uint32_t avg_latency = s.wake_count ? (uint32_t)(s.wake_latency_sum_us / s.wake_count) : 0;
+
+  DEBUG_PRINT("PM %s (firmware locks only, %d MHz and light sleep not split): %d MHz %llu ms (%.1f%%), "
+              "%d MHz or light sleep %llu ms\n",
+              s.pm_enabled ? "on" : "off", PM_CPU_FREQ_MIN,
+              PM_CPU_FREQ_MAX, (unsigned long long)(max_us / 1000), uptime ? (100.0f * max_us) / uptime : 0.0f,
+              PM_CPU_FREQ_MIN, (unsigned long long)(min_us / 1000));
+  DEBUG_PRINT("Wake-up latency avg %u us max %u us (%u wake-ups)\n",
+              avg_latency, s.wake_latency_max_us, s.wake_count);
+  for (uint8_t i = 0; i < size; i++){
+    DEBUG_PRINT("Lock %s \t %u \t %llu us\n", p[i].name, p[i].count, (unsigned long long)p[i].held_us);
+  }
+}
@@ -0,0 +1,228 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file ulp_hal.c
+ * @brief Abstraction of ULP humidity sampling
+ *
+ * This implementation file builds the ULP FSM program with the ulp.h macros and manages
+ * the memory shared with it. The program logic is mirrored in ulp_model.cpp.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "HAL/ulp_hal.h"
+
+#if ULP_HUMIDITY
+#include "esp32/ulp.h"
+#include "driver/adc.h"
+#include "driver/rtc_cntl.h"
+#include "soc/rtc_cntl_reg.h"
+#include "esp_sleep.h"
+
+static_assert(ULP_FIFO_SIZE == 4, "ULP program averages exactly 4 samples");
+static_assert(ULP_VAR_WORDS <= ULP_PROG_START, "ULP variables overlap the program");
+
+static TaskHandle_t ulp_notify_task = NULL;
+
+enum {
+  L_FILLED = 1, L_VALID, L_OUT, L_ACCEPT, L_STORE_LAST, L_BATCH_FULL,
+  L_ZONE, L_HIGH, L_LOW, L_ZONE_CMP, L_WAKE_CHECK, L_END
+};
+
+static void IRAM_ATTR ulp_isr(void* arg){
+  BaseType_t woken = pdFALSE;
+  if (ulp_notify_task != NULL) {
+    vTaskNotifyGiveFromISR(ulp_notify_task, &woken);
+  }
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+static inline uint16_t ulp_var(uint16_t index){
+  return (uint16_t)(RTC_SLOW_MEM[index] & 0xFFFF); // upper half written by ULP ST instruction
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool ulp_humidity_init(uint16_t range, uint16_t limit){
+  const ulp_insn_t program[] = {
+    I_MOVI(R3, 0), // base address of shared variables
+    I_ADC(R0, 0, ULP_ADC_CHANNEL), // R0 = raw sample
+    I_ST(R0, R3, ULP_VAR_RAW),
+    I_LD(R1, R3, ULP_VAR_SAMPLES),
+    I_ADDI(R1, R1, 1),
+    I_ST(R1, R3, ULP_VAR_SAMPLES),
+
+    // first sample: prefill the FIFO
+    I_LD(R0, R3, ULP_VAR_COUNT),
+    M_BGE(L_FILLED, 1),
+    I_LD(R0, R3, ULP_VAR_RAW),
+    I_ST(R0, R3, ULP_VAR_FIFO + 0),
+    I_ST(R0, R3, ULP_VAR_FIFO + 1),
+    I_ST(R0, R3, ULP_VAR_FIFO + 2),
+    I_ST(R0, R3, ULP_VAR_FIFO + 3),
+    I_MOVI(R1, ULP_FIFO_SIZE),
+    I_ST(R1, R3, ULP_VAR_COUNT),
+    M_BX(L_STORE_LAST),
+
+    // spike rule: raw must be within last +/- range
+    M_LABEL(L_FILLED),
+    I_LD(R0, R3, ULP_VAR_RAW),
+    I_LD(R1, R3, ULP_VAR_LAST),
+    I_LD(R2, R3, ULP_VAR_RANGE),
+    I_ADDR(R2, R1, R2),
+    I_SUBR(R2, R2, R0), // last + range - raw
+    M_BXF(L_OUT),
+    I_LD(R2, R3, ULP_VAR_RANGE),
+    I_SUBR(R2, R1, R2), // last - range
+    M_BXF(L_VALID), // no low bound
+    I_SUBR(R2, R0, R2), // raw - (last - range)
+    M_BXF(L_OUT),
+    M_LABEL(L_VALID),
+    I_MOVI(R1, 0),
+    I_ST(R1, R3, ULP_VAR_SPIKE),
+    M_BX(L_ACCEPT),
+    M_LABEL(L_OUT),
+    I_LD(R1, R3, ULP_VAR_SPIKE),
+    I_ADDI(R1, R1, 1),
+    I_ST(R1, R3, ULP_VAR_SPIKE),
+    I_LD(R2, R3, ULP_VAR_LIMIT),
+    I_SUBR(R2, R1, R2), // spike - limit
+    M_BXF(L_END), // spike rejected
+    I_MOVI(R1, 0),
+    I_ST(R1, R3, ULP_VAR_SPIKE),
+
+    // FIFO insert, R0 = raw
+    M_LABEL(L_ACCEPT),
+    I_LD(R1, R3, ULP_VAR_INDEX),
+    I_ADDI(R2, R1, ULP_VAR_FIFO),
+    I_ST(R0, R2, 0),
+    I_ADDI(R1, R1, 1),
+    I_ANDI(R1, R1, ULP_FIFO_SIZE - 1),
+    I_ST(R1, R3, ULP_VAR_INDEX),
+    M_LABEL(L_STORE_LAST),
+    I_ST(R0, R3, ULP_VAR_LAST),
+
+    // FIFO average
+    I_LD(R0, R3, ULP_VAR_FIFO + 0),
+    I_LD(R1, R3, ULP_VAR_FIFO + 1),
+    I_ADDR(R0, R0, R1),
+    I_LD(R1, R3, ULP_VAR_FIFO + 2),
+    I_ADDR(R0, R0, R1),
+    I_LD(R1, R3, ULP_VAR_FIFO + 3),
+    I_ADDR(R0, R0, R1),
+    I_RSHI(R0, R0, ULP_FIFO_SHIFT),
+    I_ST(R0, R3, ULP_VAR_MEDIA),
+
+    // batch store, R2 = wake bits of this run
+    I_MOVI(R2, ULP_WAKE_NONE),
+    I_LD(R1, R3, ULP_VAR_BATCH_N),
+    I_MOVR(R0, R1),
+    M_BGE(L_BATCH_FULL, ULP_BATCH_SIZE),
+    I_LD(R0, R3, ULP_VAR_MEDIA),
+    I_ADDI(R1, R1, ULP_VAR_BATCH),
+    I_ST(R0, R1, 0),
+    I_SUBI(R1, R1, ULP_VAR_BATCH - 1), // batch_n + 1
+    I_ST(R1, R3, ULP_VAR_BATCH_N),
+    I_MOVR(R0, R1),
+    M_BL(L_ZONE, ULP_BATCH_SIZE),
+    M_LABEL(L_BATCH_FULL),
+    I_MOVI(R2, ULP_WAKE_BATCH),
+
+    // threshold zone, R1 = new zone
+    M_LABEL(L_ZONE),
+    I_LD(R0, R3, ULP_VAR_MEDIA),
+    I_LD(R1, R3, ULP_VAR_TH_HIGH),
+    I_SUBR(R1, R1, R0), // th_high - media
+    M_BXF(L_HIGH),
+    I_LD(R1, R3, ULP_VAR_TH_LOW),
+    I_SUBR(R1, R0, R1), // media - th_low
+    M_BXF(L_LOW),
+    I_MOVI(R1, ULP_ZONE_NORMAL),
+    M_BX(L_ZONE_CMP),
+    M_LABEL(L_HIGH),
+    I_MOVI(R1, ULP_ZONE_HIGH),
+    M_BX(L_ZONE_CMP),
+    M_LABEL(L_LOW),
+    I_MOVI(R1, ULP_ZONE_LOW),
+    M_LABEL(L_ZONE_CMP),
+    I_LD(R0, R3, ULP_VAR_ZONE),
+    I_SUBR(R0, R0, R1),
+    M_BXZ(L_WAKE_CHECK), // zone unchanged
+    I_ST(R1, R3, ULP_VAR_ZONE),
+    I_ORI(R2, R2, ULP_WAKE_THRESHOLD),
+
+    // wake main cores if needed and if they are sleeping
+    M_LABEL(L_WAKE_CHECK),
+    I_MOVR(R0, R2),
+    M_BL(L_END, 1),
+    I_LD(R1, R3, ULP_VAR_WAKE),
+    I_ORR(R1, R1, R2),
+    I_ST(R1, R3, ULP_VAR_WAKE),
+    I_RD_REG(RTC_CNTL_LOW_POWER_ST_REG, RTC_CNTL_RDY_FOR_WAKEUP_S, RTC_CNTL_RDY_FOR_WAKEUP_S),
+    M_BL(L_END, 1),
+    I_WAKE(),
+    M_LABEL(L_END),
+    I_HALT()
+  };
+
+  uint16_t mem[ULP_VAR_WORDS];
+  ulp_model_init(mem, range, limit, ULP_TH_HIGH, ULP_TH_LOW);
+  for (int i = 0; i < ULP_VAR_WORDS; i++){
+    RTC_SLOW_MEM[i] = mem[i];
+  }
+
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  adc1_config_channel_atten((adc1_channel_t)ULP_ADC_CHANNEL, ADC_ATTEN_DB_11);
+  adc1_ulp_enable();
+
+  size_t size = sizeof(program) / sizeof(ulp_insn_t);
+  if (ulp_process_macros_and_load(ULP_PROG_START, program, &size) != ESP_OK) {
+    DEBUG_PRINT("ULP program load failed\n");
+    return false;
+  }
+  rtc_isr_register(ulp_isr, NULL, RTC_CNTL_ULP_CP_INT_ENA_M);
+  REG_SET_BIT(RTC_CNTL_INT_ENA_REG, RTC_CNTL_ULP_CP_INT_ENA_M);
+  esp_sleep_enable_ulp_wakeup();
+  ulp_set_wakeup_period(0, ULP_PERIOD_US);
+  return ulp_run(ULP_PROG_START) == ESP_OK;
+}
+
+void ulp_humidity_set_notify(TaskHandle_t task){
+  ulp_notify_task = task;
+}
+
+uint16_t ulp_humidity_media(){
+  return ulp_var(ULP_VAR_MEDIA);
+}
+
+uint8_t ulp_humidity_read_batch(uint16_t* out, uint8_t max){
+  uint8_t n = (uint8_t)ulp_var(ULP_VAR_BATCH_N);
+  if (n > max) {
+    n = max;
+  }
+  for (uint8_t i = 0; i < n; i++){
+    out[i] = ulp_var(ULP_VAR_BATCH + i);
+  }
+  // an average stored by the ULP between the read and the reset is lost
+  RTC_SLOW_MEM[ULP_VAR_BATCH_N] = 0;
+  return n;
+}
+
+uint16_t ulp_humidity_wake_reason(){
+  uint16_t reason = ulp_var(ULP_VAR_WAKE);
+  RTC_SLOW_MEM[ULP_VAR_WAKE] = 0;
+  return reason;
+}
+
+#endif /* ULP_HUMIDITY */
@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file ulp_model.c
+ * @brief Reference model of the ULP humidity program
+ *
+ * This implementation file mirrors, step by step, the ULP program built in ulp_hal.cpp.
+ * Any change to the ULP program must be reflected here (and vice versa).
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "HAL/ulp_model.h"
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void ulp_model_init(uint16_t* mem, uint16_t range, uint16_t limit, uint16_t th_high, uint16_t th_low){
+  for (int i = 0; i < ULP_VAR_WORDS; i++){
+    mem[i] = 0;
+  }
+  mem[ULP_VAR_RANGE] = range;
+  mem[ULP_VAR_LIMIT] = limit;
+  mem[ULP_VAR_TH_HIGH] = th_high;
+  mem[ULP_VAR_TH_LOW] = th_low;
+}
+
+uint16_t ulp_model_step(uint16_t* mem, uint16_t raw){
+  uint16_t wake = ULP_WAKE_NONE;
+  mem[ULP_VAR_RAW] = raw;
+  mem[ULP_VAR_SAMPLES]++;
+
+  if (mem[ULP_VAR_COUNT] == 0) {
+    // first sample: prefill the FIFO
+    for (int i = 0; i < ULP_FIFO_SIZE; i++){
+      mem[ULP_VAR_FIFO + i] = raw;
+    }
+    mem[ULP_VAR_COUNT] = ULP_FIFO_SIZE;
+  } else {
+    uint16_t last = mem[ULP_VAR_LAST];
+    uint16_t range = mem[ULP_VAR_RANGE];
+    bool valid = (raw <= last + range) && (last < range || raw >= last - range);
+    if (valid) {
+      mem[ULP_VAR_SPIKE] = 0;
+    } else {
+      mem[ULP_VAR_SPIKE]++;
+      if (mem[ULP_VAR_SPIKE] < mem[ULP_VAR_LIMIT]) {
+        return wake; // spike rejected, keep sleeping
+      }
+      mem[ULP_VAR_SPIKE] = 0; // persistent change, accept it
+    }
+    mem[ULP_VAR_FIFO + mem[ULP_VAR_INDEX]] = raw;
+    mem[ULP_VAR_INDEX] = (mem[ULP_VAR_INDEX] + 1) & (ULP_FIFO_SIZE - 1);
+  }
+  mem[ULP_VAR_LAST] = raw;
+
+  uint16_t sum = 0;
+  for (int i = 0; i < ULP_FIFO_SIZE; i++){
+    sum += mem[ULP_VAR_FIFO + i];
+  }
+  uint16_t media = sum >> ULP_FIFO_SHIFT;
+  mem[ULP_VAR_MEDIA] = media;
+
+  if (mem[ULP_VAR_BATCH_N] < ULP_BATCH_SIZE) {
+    mem[ULP_VAR_BATCH + mem[ULP_VAR_BATCH_N]] = media;
+    mem[ULP_VAR_BATCH_N]++;
+  }
+  if (mem[ULP_VAR_BATCH_N] >= ULP_BATCH_SIZE) {
+    wake |= ULP_WAKE_BATCH;
+  }
+
+  uint16_t zone = ULP_ZONE_NORMAL;
+  if (media > mem[ULP_VAR_TH_HIGH]) {
+    zone = ULP_ZONE_HIGH;
+  } else if (media < mem[ULP_VAR_TH_LOW]) {
+    zone = ULP_ZONE_LOW;
+  }
+  if (zone != mem[ULP_VAR_ZONE]) {
+    mem[ULP_VAR_ZONE] = zone;
+    wake |= ULP_WAKE_THRESHOLD;
+  }
+
+  mem[ULP_VAR_WAKE] |= wake;
+  return wake;
+}
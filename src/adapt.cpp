@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file adapt.c
+ * @brief Adaptive sampling controller
+ *
+ * This implementation file provides the slope tracking and the interval selection of
+ * the adaptive sampling controller.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <string.h>
+#include <math.h>
+#include "adapt.h"
+
+// interval wanted by one point, in ms
+static float point_interval(const Adapt_t* a, const AdaptField_t* f, float x, float slope){
+  float t = slope > 0.0f ? f->resolution / slope : (float)a->max_ms;
+  for (uint8_t k = 0; k < f->thr_count; k++){
+    float d = fabsf(x - f->thr[k]) - f->guard;
+    if (d <= 0.0f) {
+      return (float)a->min_ms; // inside the guard band
+    }
+    if (slope > 0.0f && d / slope < t) {
+      t = d / slope; // reach the guard band before the next sample
+    }
+  }
+  return t;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool adapt_init(Adapt_t* a, uint8_t fields, uint32_t min_ms, uint32_t max_ms, float growth){
+  if (fields == 0 || fields > ADAPT_MAX_FIELDS || min_ms == 0 || max_ms < min_ms || !(growth > 1.0f)) {
+    return false;
+  }
+  memset(a, 0, sizeof(Adapt_t));
+  a->fields = fields;
+  a->min_ms = min_ms;
+  a->max_ms = max_ms;
+  a->growth = growth;
+  a->interval_ms = min_ms;
+  for (uint8_t f = 0; f < fields; f++){
+    a->field[f].resolution = 1.0f;
+  }
+  return true;
+}
+
+bool adapt_set_field(Adapt_t* a, uint8_t field, float resolution, float guard){
+  if (field >= a->fields || !(resolution > 0.0f) || !(guard >= 0.0f)) {
+    return false;
+  }
+  a->field[field].resolution = resolution;
+  a->field[field].guard = guard;
+  a->field[field].thr_count = 0;
+  return true;
+}
+
+bool adapt_add_threshold(Adapt_t* a, uint8_t field, float thr){
+  if (field >= a->fields || a->field[field].thr_count >= ADAPT_MAX_THRESHOLDS) {
+    return false;
+  }
+  a->field[field].thr[a->field[field].thr_count++] = thr;
+  return true;
+}
+
+uint32_t adapt_update(Adapt_t* a, const float* value, uint8_t channels, uint32_t now_ms){
+  uint16_t points = (uint16_t)(a->fields * channels);
+  if (points > ADAPT_MAX_POINTS) {
+    return a->min_ms;
+  }
+  uint32_t dt = a->has_last ? now_ms - a->last_ms : 0;
+  float next = (float)a->max_ms;
+  for (uint8_t f = 0; f < a->fields; f++){
+    const AdaptField_t* fd = &a->field[f];
+    for (uint8_t c = 0; c < channels; c++){
+      uint16_t p = (uint16_t)(f * channels + c);
+      float x = value[p];
+      if (isnan(x)) {
+        continue; // no reading (sensor missing), the other points decide
+      }
+      if (dt > 0) {
+        float rate = fabsf(x - a->last[p]) / dt;
+        a->slope[p] = rate > a->slope[p] ? rate : a->slope[p] + ADAPT_RELEASE * (rate - a->slope[p]);
+      }
+      a->last[p] = x;
+      float t = point_interval(a, fd, x, a->slope[p]);
+      next = t < next ? t : next;
+    }
+  }
+  if (!a->has_last) {
+    next = (float)a->min_ms; // no slope yet
+  }
+  float limit = a->interval_ms * a->growth;
+  next = next < limit ? next : limit;
+  uint32_t interval = next < (float)a->min_ms ? a->min_ms : (uint32_t)next;
+  interval = interval > a->max_ms ? a->max_ms : interval;
+  a->interval_ms = interval;
+  a->last_ms = now_ms;
+  a->has_last = true;
+  a->stats.cycles++;
+  a->stats.skipped += interval / a->min_ms - 1;
+  a->stats.elapsed_ms += interval;
+  return interval;
+}
+
+bool adapt_set_bounds(Adapt_t* a, uint32_t min_ms, uint32_t max_ms){
+  if (min_ms == 0 || max_ms < min_ms) {
+    return false;
+  }
+  a->min_ms = min_ms;
+  a->max_ms = max_ms;
+  a->interval_ms = a->interval_ms < min_ms ? min_ms : (a->interval_ms > max_ms ? max_ms : a->interval_ms);
+  return true;
+}
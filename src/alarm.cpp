@@ -0,0 +1,123 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file alarm.c
+ * @brief Rule-based alarm engine
+ *
+ * This implementation file provides the validation and the postfix evaluation of the
+ * alarm rule table.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <string.h>
+#include "alarm.h"
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool alarm_compile(AlarmTable_t* t, const AlarmRule_t* rules, uint8_t count){
+  if (count > ALARM_MAX_RULES) {
+    return false;
+  }
+  int8_t depth = 0;
+  for (uint8_t i = 0; i < count; i++){
+    const AlarmRule_t* r = &rules[i];
+    switch (r->op) {
+      case ALARM_OP_COND:
+        if (r->field >= ALARM_NUM_FIELDS || r->cmp > ALARM_CMP_LT || !(r->hysteresis >= 0.0f)) {
+          return false;
+        }
+        depth++;
+        break;
+      case ALARM_OP_AND:
+      case ALARM_OP_OR:
+        depth--; // two operands, one result
+        break;
+      case ALARM_OP_NOT:
+        break;
+      case ALARM_OP_RAISE:
+        if (r->id >= ALARM_MAX_IDS) {
+          return false;
+        }
+        depth--;
+        break;
+      default:
+        return false;
+    }
+    // NOT needs one operand, AND/OR needed two (one left after the pop)
+    if (depth < (r->op == ALARM_OP_RAISE ? 0 : 1) || depth > ALARM_MAX_STACK) {
+      return false;
+    }
+  }
+  if (depth != 0) {
+    return false; // every result must end in a RAISE
+  }
+  memcpy(t->rule, rules, count * sizeof(AlarmRule_t));
+  t->count = count;
+  return true;
+}
+
+void alarm_reset(AlarmPlant_t* p, uint8_t size){
+  memset(p, 0, size * sizeof(AlarmPlant_t));
+}
+
+uint8_t alarm_eval(const AlarmTable_t* t, AlarmPlant_t* p, uint8_t channel, uint8_t size,
+                   const float* value, uint32_t now_ms){
+  if (channel >= size) {
+    return 0;
+  }
+  AlarmPlant_t* s = &p[channel];
+  uint8_t stack = 0; // bit i is the result at depth i
+  uint8_t depth = 0;
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < t->count; i++){
+    const AlarmRule_t* r = &t->rule[i];
+    switch (r->op) {
+      case ALARM_OP_COND: {
+        AlarmCond_t* c = &s->cond[i];
+        float v = value[r->field];
+        bool hold;
+        if (r->cmp == ALARM_CMP_GT) {
+          hold = c->raw ? (v > r->threshold - r->hysteresis) : (v > r->threshold);
+        } else {
+          hold = c->raw ? (v < r->threshold + r->hysteresis) : (v < r->threshold);
+        }
+        if (hold && !c->raw) {
+          c->since_ms = now_ms;
+        }
+        c->raw = hold;
+        c->active = hold && (now_ms - c->since_ms >= (uint32_t)r->min_s * 1000);
+        stack = (uint8_t)((stack & ~(1 << depth)) | (c->active << depth));
+        depth++;
+        break;
+      }
+      case ALARM_OP_AND:
+      case ALARM_OP_OR: {
+        depth--;
+        bool a = (stack >> (depth - 1)) & 1;
+        bool b = (stack >> depth) & 1;
+        bool res = (r->op == ALARM_OP_AND) ? (a && b) : (a || b);
+        stack = (uint8_t)((stack & ~(1 << (depth - 1))) | (res << (depth - 1)));
+        break;
+      }
+      case ALARM_OP_NOT:
+        stack ^= (uint8_t)(1 << (depth - 1));
+        break;
+      case ALARM_OP_RAISE:
+        depth--;
+        mask |= (uint8_t)(((stack >> depth) & 1) << r->id);
+        break;
+    }
+  }
+  s->mask = mask;
+  return mask;
+}
@@ -0,0 +1,226 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file bench.c
+ * @brief Microbenchmark suite of the HAL functions and pipeline stages
+ *
+ * This implementation file provides the benchmark cases and the cycle counting loop.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "bench.h"
+#include "peripheral.h"
+#include "HAL/analog_hal.h"
+#include "HAL/digital_hal.h"
+#include "HAL/power_hal.h"
+#include "HAL/ble_hal.h"
+#include "dlog.h"
+#include "frame.h"
+#include "rollstat.h"
+#include "adapt.h"
+#include "kalman.h"
+#include "downsample.h"
+
+extern Analog_t analog_a[NUM_ANALOG_PERIP];
+extern Dig_t digital_a[NUM_DIG_PERIP];
+extern Power_t power_a[NUM_PM_LOCKS];
+
+typedef struct
+{
+  const char* name;
+  uint32_t    calls; // calls per result, a few hundred cycles at least
+  uint32_t    iterations; // results per run
+  void        (*fn)(uint32_t i);
+}BenchCase_t;
+
+static SmartPlant_t* bench_sm = NULL;
+static uint8_t bench_size = 0;
+static RollStat_t bench_rollstat;
+static Adapt_t bench_adapt;
+static float bench_points[ALARM_NUM_FIELDS * NUM_PLANTS];
+static Kalman_t bench_kalman;
+static Downsample_t bench_ds;
+static volatile uint32_t bench_sink; // results kept alive
+
+#define BENCH_DS_CALLS 500 // calls of the downsample_push case per result
+#define BENCH_DS_ITERATIONS 100 // results of the downsample_push case per run
+#define BENCH_DS_SAMPLES (BENCH_DS_CALLS * BENCH_DS_ITERATIONS * BENCH_REPEAT) // calls of the downsample_push case, one per second
+#define BENCH_REFERENCE_STEPS 8192 // steps of the reference loop, about 1800 cycles: timer resolution below 1 %
+
+static uint32_t bench_ref_table[256]; // 1 KB each, in the data cache like the plant state
+static uint32_t bench_ref_out[256];
+
+// fixed busy loop, no firmware code: the machine speed of the host runner. Loads, stores and
+// arithmetic of independent steps like the cases, a neighbour sharing the core slows it too
+static void case_reference(uint32_t i) {
+  uint32_t sum = i, mix = 0;
+  for (uint32_t k = 0; k < BENCH_REFERENCE_STEPS; k++) {
+    uint32_t a = bench_ref_table[(k * 7) & 255];
+    sum += bench_ref_table[(a + k) & 255];
+    mix ^= a + sum;
+    bench_ref_out[k & 255] = mix;
+  }
+  bench_sink = sum + mix;
+}
+
+static void case_analog_add_sample(uint32_t i) { analog_add_sample(analog_a, HUMIDITY_1_ch, 2000 + (i & 15), NUM_ANALOG_PERIP); }
+static void case_analog_read_data(uint32_t i) { analog_read_data(analog_a, HUMIDITY_1_ch, NUM_ANALOG_PERIP); }
+static void case_analog_get_media(uint32_t i) { bench_sink = analog_get_media(analog_a, HUMIDITY_1_ch, NUM_ANALOG_PERIP); }
+static void case_analog_get_value(uint32_t i) { bench_sink = analog_get_value(analog_a, HUMIDITY_1_ch, NUM_ANALOG_PERIP); }
+static void case_digital_read(uint32_t i) { bench_sink = digital_read(digital_a, SOLAR_SNS_1_ch, NUM_DIG_PERIP); }
+static void case_digital_set_value(uint32_t i) { digital_set_value(digital_a, DIODE_LED_1_ch, i & 1, NUM_DIG_PERIP); }
+static void case_power_lock(uint32_t i) {
+  power_lock_acquire(power_a, PM_LOCK_I2C_ch, NUM_PM_LOCKS);
+  power_lock_release(power_a, PM_LOCK_I2C_ch, NUM_PM_LOCKS);
+}
+static void case_read_temperatures(uint32_t i) { read_temperatures(); }
+static void case_read_solar(uint32_t i) { bench_sink = read_solar_radiation(SOLAR_SNS_1_ch); }
+static void case_read_humidity(uint32_t i) { bench_sink = (uint32_t)read_humidity(HUMIDITY_1_ch); }
+#if AMUX_HUMIDITY
+static void case_scan_humidity(uint32_t i) { scan_humidity(); }
+#endif
+static void case_stage_temperature(uint32_t i) {
+  for (uint8_t p = 0; p < bench_size; p++) smartplant_set_temperature(bench_sm, p, bench_size);
+}
+static void case_stage_solar(uint32_t i) {
+  for (uint8_t p = 0; p < bench_size; p++) smartplant_set_solar_intensity(bench_sm, p, bench_size);
+}
+static void case_stage_humidity(uint32_t i) {
+  for (uint8_t p = 0; p < bench_size; p++) smartplant_set_sand_humidity(bench_sm, p, bench_size);
+}
+static void case_stage_alarm(uint32_t i) {
+  for (uint8_t p = 0; p < bench_size; p++) smartplant_set_alarm(bench_sm, p, bench_size);
+}
+static void case_stage_stats(uint32_t i) {
+  for (uint8_t p = 0; p < bench_size; p++) smartplant_set_stats(bench_sm, p, bench_size);
+}
+static void case_next_interval(uint32_t i) { bench_sink = smartplant_next_interval(bench_sm, bench_size); }
+static void case_smartplant_update(uint32_t i) { smartplant_update(bench_sm, bench_size); }
+static void case_display_data(uint32_t i) { smartplant_display_data(bench_sm, i % bench_size, bench_size); }
+#if BLE_LEGACY_CHARACTERISTICS
+static void case_ble_transmit_temp(uint32_t i) { ble_transmit_temp((uint16_t)bench_sm->temperature[PLANT_1]); }
+#endif
+static void case_ble_transmit_alarm(uint32_t i) { ble_transmit_alarm(PLANT_1, bench_sm->alarm_mask[PLANT_1]); }
+static void case_ble_transmit_stats(uint32_t i) {
+  RollStatValue_t v;
+  smartplant_get_stats(PLANT_1, ALARM_FIELD_TEMPERATURE, bench_size, &v);
+  ble_transmit_stats(PLANT_1, ALARM_FIELD_TEMPERATURE, &v);
+}
+static void case_dlog_write(uint32_t i) { dlog_write(LOG_LEVEL_DEBUG, LOG_FMT_TEMPERATURE, 23.4567f); }
+static void case_frame_encode(uint32_t i) {
+  uint8_t payload[16], out[2 * sizeof(payload) + 8];
+  memset(payload, (uint8_t)i, sizeof(payload));
+  bench_sink = frame_encode(payload, sizeof(payload), out, sizeof(out));
+}
+static void case_rollstat_push(uint32_t i) { rollstat_push(&bench_rollstat, 20.0f + (i & 7) * 0.1f); }
+static void case_adapt_update(uint32_t i) {
+  bench_points[0] = 20.0f + (i & 7) * 0.1f;
+  bench_sink = adapt_update(&bench_adapt, bench_points, bench_size, i * 1000);
+}
+static void case_kalman_update(uint32_t i) { kalman_update(&bench_kalman, 2000 + (i & 15)); }
+static void case_downsample_push(uint32_t i) { downsample_push(&bench_ds, i, (int16_t)(i & 255)); }
+
+static void ds_discard(const DsPoint_t* p, void* arg) {
+}
+
+static const BenchCase_t bench_cases[] = {
+  {BENCH_REFERENCE, 1, 100, case_reference},
+  // HAL
+  {"analog_add_sample", 150, 100, case_analog_add_sample},
+  {"analog_read_data", 20, 100, case_analog_read_data},
+  {"analog_get_media", 500, 100, case_analog_get_media},
+  {"analog_get_value", 1000, 100, case_analog_get_value},
+  {"digital_read", 1000, 100, case_digital_read},
+  {"digital_set_value", 1000, 100, case_digital_set_value},
+  {"power_lock", 40, 100, case_power_lock},
+#if BLE_LEGACY_CHARACTERISTICS
+  {"ble_transmit_temp", 30, 100, case_ble_transmit_temp},
+#endif
+  {"ble_transmit_alarm", 30, 100, case_ble_transmit_alarm},
+  {"ble_transmit_stats", 30, 100, case_ble_transmit_stats},
+  // sensors
+  {"read_temperatures", 10, 100, case_read_temperatures},
+  {"read_solar_radiation", 200, 100, case_read_solar},
+  {"read_humidity", 20, 100, case_read_humidity},
+#if AMUX_HUMIDITY
+  {"scan_humidity", 1, 20, case_scan_humidity},
+#endif
+  // pipeline stages, all plants
+  {"stage_temperature", 200, 100, case_stage_temperature},
+  {"stage_solar", 200, 100, case_stage_solar},
+  {"stage_humidity", 20, 100, case_stage_humidity},
+  {"stage_alarm", 50, 100, case_stage_alarm},
+  {"stage_stats", 150, 100, case_stage_stats},
+  {"smartplant_next_interval", 50, 100, case_next_interval},
+  {"smartplant_update", 4, 100, case_smartplant_update}, // Task1 cycle time
+  {"smartplant_display_data", 2, 100, case_display_data},
+  // building blocks
+  {"dlog_write", 300, 100, case_dlog_write},
+  {"frame_encode", 15, 100, case_frame_encode},
+  {"rollstat_push", 200, 100, case_rollstat_push},
+  {"adapt_update", 150, 100, case_adapt_update},
+  {"kalman_update", 150, 100, case_kalman_update},
+  {"downsample_push", BENCH_DS_CALLS, BENCH_DS_ITERATIONS, case_downsample_push},
+};
+static_assert(SIZEOF(bench_cases) <= BENCH_MAX_RESULTS, "BENCH_MAX_RESULTS too small");
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+uint8_t bench_run(SmartPlant_t* sm, uint8_t size, BenchResult_t* out, uint8_t max) {
+  bench_sm = sm;
+  bench_size = size;
+  rollstat_init(&bench_rollstat, STATS_WINDOW, 16, STATS_EWMA_ALPHA); // short buckets: closing path included
+  adapt_init(&bench_adapt, ALARM_NUM_FIELDS, ADAPT_MIN_MS, ADAPT_MAX_MS, ADAPT_GROWTH);
+  kalman_init(&bench_kalman, KALMAN_Q(KALMAN_ADC_R), KALMAN_Q(KALMAN_ADC_QX), KALMAN_Q(KALMAN_ADC_QV));
+  downsample_init(&bench_ds, DOWNSAMPLE_LTTB, 0, BENCH_DS_SAMPLES - 1, HISTORY_MAX_POINTS, ds_discard, NULL);
+  for (uint32_t k = 0; k < SIZEOF(bench_ref_table); k++) {
+    bench_ref_table[k] = k * 2654435761u; // scattered indexes
+  }
+
+  power_lock_acquire(power_a, PM_LOCK_ADC_ch, NUM_PM_LOCKS); // CPU at PM_CPU_FREQ_MAX, no light sleep
+  uint8_t n = 0;
+  for (uint8_t c = 0; c < SIZEOF(bench_cases) && n < max; c++) {
+    const BenchCase_t* bc = &bench_cases[c];
+    uint32_t best = UINT32_MAX; // cycles of the best run
+    uint64_t sum = 0;
+    uint32_t i = 0;
+    for (uint8_t r = 0; r < BENCH_REPEAT; r++) {
+      uint32_t start = ESP.getCycleCount();
+      for (uint32_t k = 0; k < bc->iterations * bc->calls; k++) {
+        bc->fn(i++);
+      }
+      uint32_t cycles = ESP.getCycleCount() - start;
+      best = cycles < best ? cycles : best;
+      sum += cycles;
+    }
+    out[n].name = bc->name;
+    out[n].plants = size;
+    out[n].buffer = BUFFER_SIZE;
+    out[n].calls = bc->calls;
+    out[n].iterations = bc->iterations;
+    out[n].cycles_min = (best + bc->iterations / 2) / bc->iterations;
+    out[n].cycles_avg = (uint32_t)((sum / BENCH_REPEAT + bc->iterations / 2) / bc->iterations);
+    out[n].ns_min = (uint32_t)((uint64_t)best * 1000 / ESP.getCpuFreqMHz() / bc->iterations);
+    n++;
+  }
+  power_lock_release(power_a, PM_LOCK_ADC_ch, NUM_PM_LOCKS);
+  return n;
+}
+
+void bench_print(const BenchResult_t* r, uint8_t count) {
+  Serial.printf("%s,name,plants,buffer,calls,iterations,cycles_min,cycles_avg,ns_min\n", BENCH_PREFIX);
+  for (uint8_t i = 0; i < count; i++) {
+    Serial.printf("%s,%s,%u,%u,%u,%u,%u,%u,%u\n", BENCH_PREFIX, r[i].name, r[i].plants, r[i].buffer,
+                  r[i].calls, r[i].iterations, r[i].cycles_min, r[i].cycles_avg, r[i].ns_min);
+  }
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file boot.c
+ * @brief Boot sequence: overlapped start, missing devices and degraded mode
+ *
+ * This implementation file provides the start task of the other core, the retry of the
+ * missing devices and the time to first sample.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "boot.h"
+#include "esp_timer.h"
+
+static BootDevice_t boot_a[NUM_BOOT_DEVICES] = {};
+static BootTimes_t boot_times = {};
+static void (*async_fn)() = NULL;
+static TaskHandle_t async_waiter = NULL;
+static volatile bool async_done = true;
+static bool first_sample_done = false;
+
+static void BootTask(void* pvParameters) {
+  int64_t start_us = esp_timer_get_time();
+  async_fn();
+  boot_times.async_us = (uint32_t)(esp_timer_get_time() - start_us);
+  async_done = true;
+  if (async_waiter != NULL) {
+    xTaskNotifyGive(async_waiter);
+  }
+  vTaskDelete(NULL);
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void boot_start_async(void (*fn)()) {
+  async_fn = fn;
+  async_done = false;
+  xTaskCreatePinnedToCore(BootTask, "Boot", BOOT_TASK_STACK, NULL, BOOT_TASK_PRIO, NULL, BOOT_TASK_CORE);
+}
+
+void boot_wait_async() {
+  int64_t start_us = esp_timer_get_time();
+  async_waiter = xTaskGetCurrentTaskHandle();
+  while (!async_done) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10)); // timeout covers a notification given before async_waiter was set
+  }
+  async_waiter = NULL;
+  boot_times.wait_us = (uint32_t)(esp_timer_get_time() - start_us);
+}
+
+bool boot_device(uint8_t dev, const char* name, bool (*start)()) {
+  if (dev >= NUM_BOOT_DEVICES) {
+    return false;
+  }
+  BootDevice_t* b = &boot_a[dev];
+  int64_t start_us = esp_timer_get_time();
+  b->name = name;
+  b->start = start;
+  b->ready = start();
+  b->retry_ms = BOOT_RETRY_MIN_MS;
+  b->next_ms = millis() + b->retry_ms;
+  b->retries = 0;
+  boot_times.devices_us += (uint32_t)(esp_timer_get_time() - start_us);
+  if (!b->ready) {
+    Serial.printf("%s not found, degraded mode: retry every %u..%u s\n", name, BOOT_RETRY_MIN_MS / 1000,
+                  BOOT_RETRY_MAX_MS / 1000);
+  }
+  return b->ready;
+}
+
+bool boot_ready(uint8_t dev) {
+  return dev < NUM_BOOT_DEVICES && boot_a[dev].ready;
+}
+
+uint8_t boot_missing() {
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < NUM_BOOT_DEVICES; i++) {
+    if (boot_a[i].start != NULL && !boot_a[i].ready) {
+      mask |= (uint8_t)(1 << i);
+    }
+  }
+  return mask;
+}
+
+void boot_retry() {
+  uint32_t now_ms = millis();
+  for (uint8_t i = 0; i < NUM_BOOT_DEVICES; i++) {
+    BootDevice_t* b = &boot_a[i];
+    if (b->start == NULL || b->ready || (int32_t)(now_ms - b->next_ms) < 0) {
+      continue;
+    }
+    b->ready = b->start();
+    if (b->ready) {
+      LOG_I(LOG_FMT_DEVICE_RECOVERED, i, b->retries);
+    } else {
+      b->retries++;
+      b->retry_ms = b->retry_ms * 2 > BOOT_RETRY_MAX_MS ? BOOT_RETRY_MAX_MS : b->retry_ms * 2;
+      b->next_ms = now_ms + b->retry_ms;
+      LOG_I(LOG_FMT_DEVICE_RETRY, i, b->retry_ms);
+    }
+  }
+}
+
+void boot_first_sample() {
+  if (first_sample_done) {
+    return;
+  }
+  first_sample_done = true;
+  boot_times.first_sample_us = (uint32_t)esp_timer_get_time(); // esp_timer starts at reset
+  LOG_I(LOG_FMT_BOOT, boot_times.first_sample_us / 1000, boot_times.async_us / 1000, boot_times.wait_us / 1000,
+        boot_missing());
+}
+
+void boot_get_times(BootTimes_t* out) {
+  *out = boot_times;
+}
@@ -0,0 +1,157 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file config.c
+ * @brief Runtime configuration stored in NVS
+ *
+ * This implementation file provides the validation, the NVS storage and the live
+ * application of the runtime configuration.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "config.h"
+#include "scheduler.h"
+#include "smartplant.h"
+#include "HAL/analog_hal.h"
+#include "uplink.h"
+#include <Preferences.h>
+
+extern Analog_t analog_a[NUM_ANALOG_PERIP];
+extern Adapt_t SM_adapt;
+
+static Config_t config_cache = {}; // configuration in use
+static Config_t config_pending = {}; // stored by another task, applied by Task1
+static bool config_pending_set = false;
+static portMUX_TYPE config_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t config_notify_task = NULL;
+
+static void config_defaults(Config_t* c) {
+  memset(c, 0, sizeof(Config_t));
+  c->version = CONFIG_VERSION;
+  c->buffer_len = BUFFER_SIZE;
+  c->task1_ms = TASK1_TIME;
+  c->task2_ms = TASK2_TIME;
+  c->spike_range = RANGE;
+  c->sample_max_ms = ADAPT_MAX_MS;
+  c->spike_limit = LIMIT_ADC_SPIKE;
+  c->uplink_s = UPLINK_PUBLISH_S;
+}
+
+static void config_set(const Config_t* c) {
+  for (uint8_t i = 0; i < NUM_ANALOG_PERIP; i++) {
+    analog_set_length(analog_a, i, c->buffer_len, NUM_ANALOG_PERIP);
+  }
+  analog_set_spike(c->spike_range, c->spike_limit);
+  adapt_set_bounds(&SM_adapt, c->task1_ms, c->sample_max_ms);
+  portENTER_CRITICAL(&config_mux);
+  config_cache = *c; // Task2 picks task2_ms up at its next period
+  portEXIT_CRITICAL(&config_mux);
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool config_init() {
+  Preferences prefs;
+  Config_t c = {};
+  bool from_nvs = false;
+  if (prefs.begin(CONFIG_NVS_NAMESPACE, true)) {
+    from_nvs = prefs.getBytes("params", &c, sizeof(c)) == sizeof(c) && config_validate(&c);
+    prefs.end();
+  }
+  if (!from_nvs) {
+    config_defaults(&c);
+  }
+  config_set(&c);
+  DEBUG_PRINT("Config from %s: Task1 %u ms (max %u ms), Task2 %u ms, buffer %u, spike %u/%u\n",
+              from_nvs ? "NVS" : "firmware", c.task1_ms, c.sample_max_ms, c.task2_ms, c.buffer_len,
+              c.spike_range, c.spike_limit);
+  return from_nvs;
+}
+
+const Config_t* config_get() {
+  return &config_cache;
+}
+
+bool config_validate(const Config_t* c) {
+  return c->version == CONFIG_VERSION &&
+         c->buffer_len >= 1 && c->buffer_len <= BUFFER_SIZE &&
+         c->task1_ms >= CONFIG_TASK1_MIN_MS && c->task1_ms <= CONFIG_MAX_MS &&
+         c->task2_ms >= CONFIG_TASK2_MIN_MS && c->task2_ms <= CONFIG_MAX_MS &&
+         c->spike_range >= 1 && c->spike_range <= 4095 &&
+         c->sample_max_ms >= c->task1_ms && c->sample_max_ms <= CONFIG_SAMPLE_MAX_MS &&
+         c->spike_limit >= 1 && c->spike_limit <= CONFIG_SPIKE_LIMIT_MAX &&
+         (c->uplink_s == 0 || (c->uplink_s >= CONFIG_UPLINK_MIN_S && c->uplink_s <= CONFIG_UPLINK_MAX_S));
+}
+
+bool config_store(const Config_t* c) {
+  if (!config_validate(c)) {
+    return false;
+  }
+  Preferences prefs;
+  bool saved = prefs.begin(CONFIG_NVS_NAMESPACE, false) &&
+               prefs.putBytes("params", c, sizeof(Config_t)) == sizeof(Config_t);
+  prefs.end();
+  portENTER_CRITICAL(&config_mux);
+  config_pending = *c; // applied by the next Task1 cycle
+  config_pending_set = true;
+  portEXIT_CRITICAL(&config_mux);
+  return saved;
+}
+
+bool config_write(const uint8_t* data, size_t len) {
+  bool ok = false;
+  if (len == 1 + sizeof(Config_t) && data[0] == CONFIG_KIND_PARAMS) {
+    Config_t c;
+    memcpy(&c, &data[1], sizeof(Config_t));
+    ok = config_store(&c);
+  } else if (len >= 2 && data[0] == CONFIG_KIND_ALARM_RULES && data[1] <= ALARM_MAX_RULES &&
+             len == 2 + data[1] * sizeof(AlarmRule_t)) {
+    AlarmRule_t rules[ALARM_MAX_RULES];
+    memcpy(rules, &data[2], data[1] * sizeof(AlarmRule_t));
+    ok = smartplant_alarm_store(rules, data[1]);
+  }
+  if (ok) {
+    LOG_I(LOG_FMT_CONFIG, data[0], (uint32_t)len);
+    if (config_notify_task != NULL) {
+      xTaskNotifyGive(config_notify_task); // apply now, not at the next sample
+    }
+  } else {
+    LOG_W(LOG_FMT_CONFIG_REJECTED, len > 0 ? data[0] : 0, (uint32_t)len);
+  }
+  return ok;
+}
+
+size_t config_read(uint8_t* data, size_t max) {
+  if (max < sizeof(Config_t)) {
+    return 0;
+  }
+  portENTER_CRITICAL(&config_mux); // BLE task on core 0 while Task1 applies
+  memcpy(data, &config_cache, sizeof(Config_t));
+  portEXIT_CRITICAL(&config_mux);
+  return sizeof(Config_t);
+}
+
+void config_set_notify(TaskHandle_t task) {
+  config_notify_task = task;
+}
+
+void config_apply() {
+  if (config_pending_set) { // new configuration: switch between two cycles
+    Config_t c;
+    portENTER_CRITICAL(&config_mux);
+    c = config_pending;
+    config_pending_set = false;
+    portEXIT_CRITICAL(&config_mux);
+    config_set(&c);
+  }
+}
@@ -0,0 +1,148 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file dlog.c
+ * @brief Deferred logger
+ *
+ * This implementation file provides a bounded lock-free ring per core (multi-producer,
+ * single consumer, sequence number per slot) and the low-priority task that drains it.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "common.h"
+#include "telemetry.h"
+
+LogRing_t dlog_a[DLOG_NUM_RINGS] = {}; // one ring per core
+
+static void dlog_task(void *pvParameters) {
+  const TickType_t interval = pdMS_TO_TICKS(DLOG_FLUSH_MS);
+  while (true) {
+    dlog_flush(dlog_a, DLOG_NUM_RINGS);
+    vTaskDelay(interval);
+  }
+}
+
+static void dlog_output(const LogRecord_t* rec) {
+#if TELEMETRY_MODE
+  telemetry_send_log(rec); // keep the binary stream parseable
+#elif DLOG_BINARY
+  Serial.write((uint8_t)DLOG_SYNC_0);
+  Serial.write((uint8_t)DLOG_SYNC_1);
+  Serial.write((const uint8_t*)rec, sizeof(LogRecord_t));
+#else
+  char line[128];
+  dlog_format(line, sizeof(line), rec);
+  Serial.print(line);
+#endif
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void dlog_init(LogRing_t* r, uint8_t size){
+  for (int i = 0; i < size; i++){
+    for (uint32_t j = 0; j < DLOG_RING_SIZE; j++){
+      r[i].slot[j].seq = j;
+    }
+    r[i].head = 0;
+    r[i].tail = 0;
+    r[i].dropped = 0;
+  }
+  xTaskCreatePinnedToCore(dlog_task, "dlog", 3072, NULL, DLOG_TASK_PRIO, NULL, DLOG_TASK_CORE);
+}
+
+void dlog_push(uint8_t level, uint16_t fmt, uint8_t nargs, const uint32_t* args){
+  LogRing_t* r = &dlog_a[xPortGetCoreID() % DLOG_NUM_RINGS];
+  uint32_t pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+  LogSlot_t* s;
+  while (true) {
+    s = &r->slot[pos & (DLOG_RING_SIZE - 1)];
+    int32_t diff = (int32_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - pos);
+    if (diff == 0) {
+      // slot free: reserve it, a task preempting us on the same core takes the next one
+      if (__atomic_compare_exchange_n(&r->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      __atomic_fetch_add(&r->dropped, 1, __ATOMIC_RELAXED); // ring full
+      return;
+    } else {
+      pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    }
+  }
+  s->rec.ts_us = micros();
+  s->rec.fmt = fmt;
+  s->rec.level = level;
+  s->rec.nargs = nargs > DLOG_MAX_ARGS ? DLOG_MAX_ARGS : nargs;
+  for (uint8_t i = 0; i < s->rec.nargs; i++){
+    s->rec.args[i] = args[i];
+  }
+  __atomic_store_n(&s->seq, pos + 1, __ATOMIC_RELEASE); // publish to the logger task
+}
+
+void dlog_flush(LogRing_t* r, uint8_t size){
+  while (true) {
+    // pick the oldest committed record among the rings
+    LogSlot_t* oldest = NULL;
+    uint8_t ring = 0;
+    for (uint8_t i = 0; i < size; i++){
+      LogSlot_t* s = &r[i].slot[r[i].tail & (DLOG_RING_SIZE - 1)];
+      if (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) == r[i].tail + 1) {
+        if (oldest == NULL || (int32_t)(s->rec.ts_us - oldest->rec.ts_us) < 0) {
+          oldest = s;
+          ring = i;
+        }
+      }
+    }
+    if (oldest == NULL) {
+      break;
+    }
+    dlog_output(&oldest->rec);
+    __atomic_store_n(&oldest->seq, r[ring].tail + DLOG_RING_SIZE, __ATOMIC_RELEASE); // give slot back
+    r[ring].tail++;
+  }
+
+  for (uint8_t i = 0; i < size; i++){
+    uint32_t dropped = __atomic_exchange_n(&r[i].dropped, 0, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+      LogRecord_t rec = {};
+      rec.ts_us = micros();
+      rec.fmt = LOG_FMT_DROPPED;
+      rec.level = LOG_LEVEL_WARN;
+      rec.nargs = 1;
+      rec.args[0] = dropped;
+      dlog_output(&rec);
+    }
+  }
+}
+
+void dlog_benchmark(){
+  const int n = 16; // fits both the ring and the UART FIFO budget of one flush
+  float temperature = 23.4567f;
+
+  Serial.flush();
+  uint32_t start = ESP.getCycleCount();
+  for (int i = 0; i < n; i++){
+    Serial.printf("[%lu ms]Temperature: %4.4f *C\n", millis(), temperature);
+  }
+  uint32_t sync_cycles = (ESP.getCycleCount() - start) / n;
+  Serial.flush();
+
+  start = ESP.getCycleCount();
+  for (int i = 0; i < n; i++){
+    dlog_write(LOG_LEVEL_DEBUG, LOG_FMT_TEMPERATURE, temperature);
+  }
+  uint32_t deferred_cycles = (ESP.getCycleCount() - start) / n;
+
+  Serial.printf("Log cost: Serial.printf %u cycles/call, deferred %u cycles/call @ %u MHz\n",
+                sync_cycles, deferred_cycles, ESP.getCpuFreqMHz());
+}
@@ -0,0 +1,90 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file dlog_fmt.c
+ * @brief Formatter of deferred log records
+ *
+ * This implementation file formats deferred log records, it is shared by the logger
+ * task and the host decoder.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "dlog_fmt.h"
+
+#define DLOG_STRING(id, fmt) fmt,
+static const char* dlog_strings[LOG_FMT_COUNT] = {
+  DLOG_FORMATS(DLOG_STRING)
+};
+#undef DLOG_STRING
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int dlog_format(char* out, size_t len, const LogRecord_t* r){
+  if (len == 0) {
+    return 0;
+  }
+  int w = snprintf(out, len, "[%lu ms]", (unsigned long)(r->ts_us / 1000));
+  size_t pos = (w > 0) ? (size_t)w : 0;
+  const char* f = (r->fmt < LOG_FMT_COUNT) ? dlog_strings[r->fmt] : "unknown log id\n";
+  uint8_t arg = 0;
+  while (*f != '\0' && pos < len - 1) {
+    if (*f != '%') {
+      out[pos++] = *f++;
+      continue;
+    }
+    if (f[1] == '%') {
+      out[pos++] = '%';
+      f += 2;
+      continue;
+    }
+    // copy the conversion specification, e.g. "%4.4f" or "%lu"
+    char spec[16];
+    size_t n = 0;
+    spec[n++] = *f++;
+    while (*f != '\0' && strchr("diouxXeEfFgGaAc", *f) == NULL && n < sizeof(spec) - 2) {
+      if (*f != 'l' && *f != 'h') {
+        spec[n++] = *f; // length modifiers are dropped, arguments are 32-bit
+      }
+      f++;
+    }
+    char conv = *f;
+    if (conv == '\0') {
+      break; // truncated conversion specification
+    }
+    f++;
+    spec[n++] = conv;
+    spec[n] = '\0';
+
+    uint32_t raw = (arg < r->nargs) ? r->args[arg] : 0;
+    arg++;
+    if (strchr("eEfFgGaA", conv) != NULL) {
+      float v;
+      memcpy(&v, &raw, sizeof(v));
+      w = snprintf(out + pos, len - pos, spec, (double)v);
+    } else if (strchr("di", conv) != NULL) {
+      w = snprintf(out + pos, len - pos, spec, (int)(int32_t)raw);
+    } else {
+      w = snprintf(out + pos, len - pos, spec, (unsigned int)raw);
+    }
+    if (w > 0) {
+      pos += (size_t)w;
+    }
+  }
+  if (pos > len - 1) {
+    pos = len - 1;
+  }
+  out[pos] = '\0';
+  return (int)pos;
+}
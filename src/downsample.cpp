@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file downsample.c
+ * @brief Streaming downsampler (LTTB and min/max buckets)
+ *
+ * This implementation file provides the bucketing and the point selection of the
+ * streaming downsampler.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "downsample.h"
+
+static uint16_t bucket_of(const Downsample_t* d, uint32_t ts){
+  uint64_t span = (uint64_t)d->to - d->from + 1;
+  return (uint16_t)((uint64_t)(ts - d->from) * d->buckets / span);
+}
+
+static void bucket_start(Downsample_t* d, uint32_t ts, int32_t value, uint16_t index){
+  DsBucket_t* b = &d->cur;
+  DsPoint_t p = {ts, value};
+  b->first = b->last = b->min = b->max = p;
+  b->count = 1;
+  b->sum_ts = ts - d->from;
+  b->sum_value = value;
+  b->index = index;
+  d->has_cur = true;
+}
+
+static void bucket_add(Downsample_t* d, uint32_t ts, int32_t value){
+  DsBucket_t* b = &d->cur;
+  DsPoint_t p = {ts, value};
+  b->last = p;
+  if (value < b->min.value) b->min = p;
+  if (value > b->max.value) b->max = p;
+  b->count++;
+  b->sum_ts += ts - d->from;
+  b->sum_value += value;
+}
+
+static void emit_point(Downsample_t* d, const DsPoint_t* p){
+  d->emit(p, d->arg);
+  d->out++;
+}
+
+// candidate of b with the largest triangle (a, candidate, c), skip is excluded if not null
+static DsPoint_t lttb_select(const Downsample_t* d, const DsBucket_t* b, double cx, double cy, const DsPoint_t* skip){
+  const DsPoint_t* cand[4] = {&b->first, &b->min, &b->max, &b->last};
+  double ax = (double)(d->a.ts - d->from), ay = d->a.value;
+  double best = -1.0;
+  DsPoint_t sel = b->first;
+  for (uint8_t i = 0; i < 4; i++){
+    if (skip != nullptr && cand[i]->ts == skip->ts) {
+      continue;
+    }
+    double bx = (double)(cand[i]->ts - d->from), by = cand[i]->value;
+    double area = (ax - cx) * (by - ay) - (ax - bx) * (cy - ay); // twice the area
+    area = area < 0 ? -area : area;
+    if (area > best || (area == best && cand[i]->ts < sel.ts)) {
+      best = area;
+      sel = *cand[i];
+    }
+  }
+  return sel;
+}
+
+// select the point of the previous bucket with the average of the current one
+static void lttb_close(Downsample_t* d){
+  if (d->has_prev) {
+    double cx = (double)d->cur.sum_ts / d->cur.count;
+    double cy = (double)d->cur.sum_value / d->cur.count;
+    d->a = lttb_select(d, &d->prev, cx, cy, nullptr);
+    emit_point(d, &d->a);
+  }
+  d->prev = d->cur;
+  d->has_prev = true;
+  d->has_cur = false;
+}
+
+static void minmax_close(Downsample_t* d){
+  const DsBucket_t* b = &d->cur;
+  const DsPoint_t* lo = b->min.ts <= b->max.ts ? &b->min : &b->max;
+  const DsPoint_t* hi = b->min.ts <= b->max.ts ? &b->max : &b->min;
+  emit_point(d, lo);
+  if (hi->ts != lo->ts) {
+    emit_point(d, hi);
+  }
+  d->has_cur = false;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool downsample_init(Downsample_t* d, uint8_t mode, uint32_t from, uint32_t to, uint16_t points,
+                     void (*emit)(const DsPoint_t* p, void* arg), void* arg){
+  d->mode = mode;
+  d->from = from;
+  d->to = to;
+  d->buckets = mode == DOWNSAMPLE_LTTB ? points - 2 : points / 2;
+  d->has_a = d->has_prev = d->has_cur = false;
+  d->emit = emit;
+  d->arg = arg;
+  d->in = 0;
+  d->out = 0;
+  return mode < DOWNSAMPLE_NUM_MODES && from <= to && emit != nullptr &&
+         points >= (mode == DOWNSAMPLE_LTTB ? 3 : 2);
+}
+
+void downsample_push(Downsample_t* d, uint32_t ts, int32_t value){
+  if (ts < d->from || ts > d->to || (d->has_cur && ts <= d->cur.last.ts) || (d->has_a && ts <= d->a.ts)) {
+    return;
+  }
+  d->in++;
+  if (d->mode == DOWNSAMPLE_LTTB && !d->has_a) { // first sample is always kept
+    d->a.ts = ts;
+    d->a.value = value;
+    d->has_a = true;
+    emit_point(d, &d->a);
+    return;
+  }
+  uint16_t index = bucket_of(d, ts);
+  if (d->has_cur && index != d->cur.index) {
+    if (d->mode == DOWNSAMPLE_LTTB) {
+      lttb_close(d);
+    } else {
+      minmax_close(d);
+    }
+  }
+  if (d->has_cur) {
+    bucket_add(d, ts, value);
+  } else {
+    bucket_start(d, ts, value, index);
+  }
+}
+
+uint16_t downsample_finish(Downsample_t* d){
+  if (d->has_cur) {
+    if (d->mode == DOWNSAMPLE_LTTB) {
+      DsPoint_t last = d->cur.last; // last sample is always kept
+      if (d->has_prev) {
+        double cx = (double)d->cur.sum_ts / d->cur.count;
+        double cy = (double)d->cur.sum_value / d->cur.count;
+        d->a = lttb_select(d, &d->prev, cx, cy, nullptr);
+        emit_point(d, &d->a);
+      }
+      if (d->cur.count > 1) {
+        d->a = lttb_select(d, &d->cur, (double)(last.ts - d->from), last.value, &last);
+        emit_point(d, &d->a);
+      }
+      emit_point(d, &last);
+    } else {
+      minmax_close(d);
+    }
+  }
+  d->has_cur = d->has_prev = false;
+  return d->out;
+}
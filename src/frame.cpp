@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file frame.c
+ * @brief COBS + CRC16 framing
+ *
+ * This implementation file provides the byte-stuffing and integrity check used by the
+ * binary telemetry stream, shared by firmware and host decoder.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "frame.h"
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+uint16_t frame_crc16(const uint8_t* data, size_t len){
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++){
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t b = 0; b < 8; b++){
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+size_t frame_encode(const uint8_t* payload, size_t len, uint8_t* out, size_t out_size){
+  if (out_size < FRAME_MAX_ENCODED(len)) {
+    return 0;
+  }
+  uint16_t crc = frame_crc16(payload, len);
+  size_t code_pos = 0; // position of the current COBS code byte
+  size_t pos = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < len + FRAME_CRC_SIZE; i++){
+    uint8_t byte = (i < len) ? payload[i] : (uint8_t)(i == len ? crc & 0xFF : crc >> 8);
+    if (byte == 0) {
+      out[code_pos] = code;
+      code_pos = pos++;
+      code = 1;
+    } else {
+      out[pos++] = byte;
+      if (++code == 0xFF) {
+        out[code_pos] = code;
+        code_pos = pos++;
+        code = 1;
+      }
+    }
+  }
+  out[code_pos] = code;
+  out[pos++] = FRAME_DELIMITER;
+  return pos;
+}
+
+int frame_decode(const uint8_t* in, size_t len, uint8_t* out, size_t out_size){
+  size_t n = 0;
+  size_t i = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len) {
+      return -1;
+    }
+    for (uint8_t j = 1; j < code; j++){
+      if (n >= out_size) {
+        return -1;
+      }
+      out[n++] = in[i++];
+    }
+    if (code != 0xFF && i < len) {
+      if (n >= out_size) {
+        return -1;
+      }
+      out[n++] = 0;
+    }
+  }
+  if (n < FRAME_CRC_SIZE) {
+    return -1;
+  }
+  n -= FRAME_CRC_SIZE;
+  uint16_t crc = (uint16_t)(out[n] | (out[n + 1] << 8));
+  if (crc != frame_crc16(out, n)) {
+    return -1;
+  }
+  return (int)n;
+}
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file kalman.c
+ * @brief Fixed-point Kalman filter with a constant-rate model
+ *
+ * This implementation file provides the predict and update steps of the fixed-point
+ * Kalman filter.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "kalman.h"
+
+#define GAIN_FRAC 16 // fractional bits of the Kalman gains
+
+static inline int32_t mul_gain(int32_t gain, int32_t v){
+  return (int32_t)(((int64_t)gain * v) >> GAIN_FRAC);
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void kalman_init(Kalman_t* k, int32_t r, int32_t q_x, int32_t q_v){
+  k->x = 0;
+  k->v = 0;
+  k->p00 = r;
+  k->p01 = 0;
+  k->p11 = 0;
+  k->q_x = q_x;
+  k->q_v = q_v;
+  k->r = r > 0 ? r : 1;
+  k->started = false;
+}
+
+void kalman_restart(Kalman_t* k){
+  k->started = false;
+}
+
+void kalman_predict(Kalman_t* k){
+  if (!k->started) {
+    return;
+  }
+  // F = [1 1; 0 1]: P = F P F' + Q
+  k->x += k->v;
+  k->p00 += 2 * k->p01 + k->p11 + k->q_x;
+  k->p01 += k->p11;
+  k->p11 += k->q_v;
+}
+
+void kalman_update(Kalman_t* k, int32_t z){
+  int32_t zq = z * (1 << KALMAN_FRAC);
+  if (!k->started) {
+    k->x = zq;
+    k->v = 0;
+    k->p00 = k->r;
+    k->p01 = 0;
+    k->p11 = k->q_v;
+    k->started = true;
+    return;
+  }
+  kalman_predict(k);
+  // H = [1 0]: S = P00 + R, K = P H' / S
+  int64_t s = (int64_t)k->p00 + k->r;
+  int32_t k0 = (int32_t)(((int64_t)k->p00 << GAIN_FRAC) / s);
+  int32_t k1 = (int32_t)(((int64_t)k->p01 << GAIN_FRAC) / s);
+  int32_t y = zq - k->x; // innovation
+  k->x += mul_gain(k0, y);
+  k->v += mul_gain(k1, y);
+  int32_t p00 = k->p00, p01 = k->p01;
+  k->p00 = p00 - mul_gain(k0, p00);
+  k->p01 = p01 - mul_gain(k0, p01);
+  k->p11 -= mul_gain(k1, p01);
+  k->p00 = k->p00 > 0 ? k->p00 : 1; // rounding
+  k->p11 = k->p11 > 0 ? k->p11 : 0;
+}
+
+int32_t kalman_value(const Kalman_t* k){
+  return (k->x + (1 << (KALMAN_FRAC - 1))) >> KALMAN_FRAC;
+}
+
+int32_t kalman_variance(const Kalman_t* k){
+  return k->p00;
+}
@@ -10,13 +10,18 @@
 
 
 #include "scheduler.h"
+#include "telemetry.h"
 
 
 
 
 void setup() {
   
+#if TELEMETRY_MODE
+  Serial.begin(TELEMETRY_BAUD);
+#else
   Serial.begin(115200);
+#endif
   scheduler_init();
   
 }
@@ -0,0 +1,238 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file mqtt.c
+ * @brief MQTT 3.1.1 publisher
+ *
+ * This implementation file provides the packet encoding and the session of the QoS 1
+ * publisher used by the Wi-Fi uplink, shared by firmware and host tools.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <string.h>
+#include "mqtt.h"
+
+// fixed header: type and remaining length (1 to 4 bytes, 7 bits each)
+static size_t put_header(uint8_t* out, uint8_t type, size_t remaining) {
+  size_t n = 0;
+  out[n++] = type;
+  do {
+    uint8_t b = remaining % 128;
+    remaining /= 128;
+    out[n++] = remaining > 0 ? (b | 0x80) : b;
+  } while (remaining > 0);
+  return n;
+}
+
+static size_t header_len(size_t remaining) {
+  return 2 + (remaining >= 128) + (remaining >= 16384) + (remaining >= 2097152);
+}
+
+static size_t put_string(uint8_t* out, const char* s) {
+  size_t len = strlen(s);
+  out[0] = (uint8_t)(len >> 8);
+  out[1] = (uint8_t)len;
+  memcpy(&out[2], s, len);
+  return 2 + len;
+}
+
+static bool send(MqttClient_t* c, const uint8_t* data, size_t len, uint32_t now_ms) {
+  if (c->link->write(c->link, data, len) != (int)len) {
+    return false;
+  }
+  c->stats.bytes_tx += len;
+  c->tx_ms = now_ms;
+  return true;
+}
+
+static void fail(MqttClient_t* c) {
+  c->link->close(c->link);
+  c->state = MQTT_STATE_DOWN;
+  c->rx_len = 0;
+  c->stats.errors++;
+}
+
+static void resend(MqttClient_t* c, uint32_t now_ms) {
+  c->tx[0] |= MQTT_FLAG_DUP;
+  c->sent_ms = now_ms;
+  c->stats.publishes++;
+  c->stats.retransmits++;
+  if (!send(c, c->tx, c->tx_len, now_ms)) {
+    fail(c);
+  }
+}
+
+static void handle(MqttClient_t* c, const uint8_t* p, size_t len, uint32_t now_ms) {
+  uint8_t type = p[0] & 0xF0;
+  if (type == MQTT_CONNACK && c->state == MQTT_STATE_CONNECTING) {
+    if (len != 4 || p[3] != 0) {
+      fail(c); // session refused
+      return;
+    }
+    c->state = MQTT_STATE_UP;
+    c->ping_ms = 0;
+    c->stats.connects++;
+    if (c->inflight_id != 0) {
+      resend(c, now_ms); // clean session: the broker has not seen it, or lost it
+    }
+  } else if (type == MQTT_PUBACK && len == 4) {
+    uint16_t id = (uint16_t)(p[2] << 8 | p[3]);
+    if (id != 0 && id == c->inflight_id) {
+      c->inflight_id = 0;
+      c->stats.pubacks++;
+    }
+  } else if (type == MQTT_PINGRESP) {
+    c->ping_ms = 0;
+  }
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+size_t mqtt_packet_len(const uint8_t* data, size_t len) {
+  size_t remaining = 0;
+  for (size_t i = 1; i <= 4; i++) {
+    if (i >= len) {
+      return 0;
+    }
+    remaining |= (size_t)(data[i] & 0x7F) << (7 * (i - 1));
+    if ((data[i] & 0x80) == 0) {
+      return i + 1 + remaining <= len ? i + 1 + remaining : 0;
+    }
+  }
+  return SIZE_MAX;
+}
+
+size_t mqtt_encode_connect(uint8_t* out, size_t size, const char* client_id, uint16_t keepalive_s) {
+  size_t remaining = 10 + 2 + strlen(client_id);
+  if (size < header_len(remaining) + remaining) {
+    return 0;
+  }
+  size_t n = put_header(out, MQTT_CONNECT, remaining);
+  n += put_string(&out[n], "MQTT");
+  out[n++] = MQTT_PROTOCOL_LEVEL;
+  out[n++] = 0x02; // clean session
+  out[n++] = (uint8_t)(keepalive_s >> 8);
+  out[n++] = (uint8_t)keepalive_s;
+  n += put_string(&out[n], client_id);
+  return n;
+}
+
+size_t mqtt_encode_publish(uint8_t* out, size_t size, const char* topic, const uint8_t* payload, size_t len,
+                           uint16_t id, bool dup) {
+  size_t remaining = 2 + strlen(topic) + 2 + len;
+  if (size < header_len(remaining) + remaining) {
+    return 0;
+  }
+  size_t n = put_header(out, MQTT_PUBLISH | MQTT_FLAG_QOS1 | (dup ? MQTT_FLAG_DUP : 0), remaining);
+  n += put_string(&out[n], topic);
+  out[n++] = (uint8_t)(id >> 8);
+  out[n++] = (uint8_t)id;
+  memcpy(&out[n], payload, len);
+  return n + len;
+}
+
+void mqtt_init(MqttClient_t* c, MqttLink_t* link, const char* client_id, uint16_t keepalive_s) {
+  memset(c, 0, sizeof(MqttClient_t));
+  c->link = link;
+  c->client_id = client_id;
+  c->keepalive_s = keepalive_s;
+  c->next_id = 1;
+}
+
+bool mqtt_connect(MqttClient_t* c, uint32_t now_ms) {
+  uint8_t p[64];
+  size_t len = mqtt_encode_connect(p, sizeof(p), c->client_id, c->keepalive_s);
+  if (c->state != MQTT_STATE_DOWN || len == 0 || !c->link->open(c->link)) {
+    return false;
+  }
+  c->rx_len = 0;
+  c->sent_ms = now_ms;
+  if (!send(c, p, len, now_ms)) {
+    fail(c);
+    return false;
+  }
+  c->state = MQTT_STATE_CONNECTING;
+  return true;
+}
+
+MqttState_t mqtt_poll(MqttClient_t* c, uint32_t now_ms) {
+  if (c->state == MQTT_STATE_DOWN) {
+    return c->state;
+  }
+  int n = c->link->read(c->link, &c->rx[c->rx_len], sizeof(c->rx) - c->rx_len);
+  if (n < 0) {
+    fail(c);
+    return c->state;
+  }
+  c->rx_len += n;
+  size_t len;
+  while (c->state != MQTT_STATE_DOWN && (len = mqtt_packet_len(c->rx, c->rx_len)) > 0) {
+    if (len == SIZE_MAX) {
+      fail(c); // malformed remaining length
+      return c->state;
+    }
+    handle(c, c->rx, len, now_ms);
+    c->rx_len -= len;
+    memmove(c->rx, &c->rx[len], c->rx_len);
+  }
+  if (c->state == MQTT_STATE_DOWN) {
+    return c->state;
+  }
+  if (c->rx_len == sizeof(c->rx) ||
+      (c->state == MQTT_STATE_CONNECTING && now_ms - c->sent_ms >= MQTT_CONNECT_TIMEOUT_MS) ||
+      (c->ping_ms != 0 && now_ms - c->ping_ms >= MQTT_CONNECT_TIMEOUT_MS)) {
+    fail(c);
+    return c->state;
+  }
+  if (c->state == MQTT_STATE_UP && c->inflight_id != 0 && now_ms - c->sent_ms >= MQTT_ACK_TIMEOUT_MS) {
+    resend(c, now_ms);
+  } else if (c->state == MQTT_STATE_UP && c->ping_ms == 0 && now_ms - c->tx_ms >= c->keepalive_s * 1000u) {
+    const uint8_t ping[2] = {MQTT_PINGREQ, 0};
+    c->ping_ms = now_ms != 0 ? now_ms : 1;
+    if (!send(c, ping, sizeof(ping), now_ms)) {
+      fail(c);
+    }
+  }
+  return c->state;
+}
+
+bool mqtt_publish(MqttClient_t* c, const char* topic, const uint8_t* payload, size_t len, uint32_t now_ms) {
+  if (c->state != MQTT_STATE_UP || c->inflight_id != 0) {
+    return false;
+  }
+  size_t n = mqtt_encode_publish(c->tx, sizeof(c->tx), topic, payload, len, c->next_id, false);
+  if (n == 0) {
+    return false;
+  }
+  c->tx_len = (uint16_t)n;
+  c->inflight_id = c->next_id;
+  c->next_id = c->next_id == 0xFFFF ? 1 : c->next_id + 1; // 0 is not a valid identifier
+  c->sent_ms = now_ms;
+  c->stats.publishes++;
+  if (!send(c, c->tx, c->tx_len, now_ms)) {
+    fail(c); // sent again by the next session
+  }
+  return true;
+}
+
+void mqtt_disconnect(MqttClient_t* c) {
+  if (c->state == MQTT_STATE_UP) {
+    const uint8_t p[2] = {MQTT_DISCONNECT, 0};
+    c->link->write(c->link, p, sizeof(p));
+  }
+  if (c->state != MQTT_STATE_DOWN) {
+    c->link->close(c->link);
+  }
+  c->state = MQTT_STATE_DOWN;
+  c->rx_len = 0;
+}
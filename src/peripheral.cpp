@@ -22,65 +22,284 @@
 #include "HAL/analog_hal.h"
 #include "HAL/task_hal.h"
 #include "HAL/ble_hal.h"
+#include "HAL/power_hal.h"
+#include "HAL/ulp_hal.h"
+#include "HAL/amux_hal.h"
+#include "telemetry.h"
+#include "stress.h"
+#include "boot.h"
+#include "sensor_driver.h"
 
 extern Dig_t digital_a[NUM_DIG_PERIP]; // array of digital peripherals
 extern Analog_t analog_a[NUM_ANALOG_PERIP]; // array of digital peripherals
+extern Power_t power_a[NUM_PM_LOCKS]; // array of PM locks
 
-Adafruit_BMP280 bmp; // I2C interface
+Adafruit_BMP280 bmp_a[I2CMUX_MAX_SENSORS]; // I2C interface, one driver per sensor
+I2cMux_t temp_mux; // temperature sensors and read plan
+
+static bool temp_select(I2cBus_t* bus, uint8_t mux_ch) {
+#if STRESS_MODE
+  return true; // synthetic sensors, no mux on the bus
+#else
+  Wire.beginTransmission(TCA9548A_ADDR);
+  Wire.write((uint8_t)(1 << mux_ch));
+  return Wire.endTransmission() == 0;
+#endif
+}
+
+static bool temp_read(I2cBus_t* bus, uint8_t sensor, float* value) {
+#if STRESS_MODE
+  float temperature = stress_temperature(sensor);
+#else
+  float temperature = bmp_a[sensor].readTemperature(); // Read temperature from BMP280
+#endif
+  if (isnan(temperature)) {
+    return false;
+  }
+  *value = temperature;
+  return true;
+}
+
+static uint32_t temp_now_us(I2cBus_t* bus) {
+  return micros();
+}
+
+static I2cBus_t temp_bus = { temp_select, temp_read, temp_now_us, NULL };
+
+// LED and other outputs of the digital array
+template <uint8_t CH, uint8_t PIN> struct DigitalOutputDriver
+{
+  static_assert(PIN < 34, "GPIO 34-39 are input only");
+  static constexpr uint8_t BUS = DRIVER_BUS_DIGITAL;
+  static constexpr uint64_t CHANNELS = DRIVER_CH(CH);
+  static constexpr uint64_t PINS = DRIVER_PIN(PIN);
+
+  static void init() {
+    digital_set_pin(digital_a, CH, PIN, NUM_DIG_PERIP);
+    digital_set_direction(digital_a, CH, true, NUM_DIG_PERIP); // Set as output
+  }
+  static void set(bool value) {
+    digital_set_value(digital_a, CH, value, NUM_DIG_PERIP);
+  }
+};
+
+// solar radiation status and other inputs of the digital array
+template <uint8_t CH, uint8_t PIN> struct DigitalInputDriver
+{
+  static constexpr uint8_t BUS = DRIVER_BUS_DIGITAL;
+  static constexpr uint64_t CHANNELS = DRIVER_CH(CH);
+  static constexpr uint64_t PINS = DRIVER_PIN(PIN);
+  typedef int raw_t;
+
+  static void init() {
+    digital_set_pin(digital_a, CH, PIN, NUM_DIG_PERIP);
+    digital_set_direction(digital_a, CH, false, NUM_DIG_PERIP); // Set as input
+  }
+  static void start() {}
+  static int collect() { return digital_read(digital_a, CH, NUM_DIG_PERIP); }
+  static float to_units(int raw) { return (float)raw; } // 1 low light
+};
+
+#define AMUX_PINS (DRIVER_PIN(AMUX_S0_pin) | DRIVER_PIN(AMUX_S1_pin) | DRIVER_PIN(AMUX_S2_pin) | \
+                   DRIVER_PIN(AMUX_S3_pin) | DRIVER_PIN(AMUX_SIG_0_pin) | (AMUX_NUM_BANKS > 1 ? DRIVER_PIN(AMUX_SIG_1_pin) : 0))
+
+// capacitive humidity probes: one on an ADC pin, the others behind the analog muxes
+#if ULP_HUMIDITY
+static uint16_t ulp_batch[ULP_BATCH_SIZE]; // averages drained by the last scan_humidity(), oldest first
+static uint8_t ulp_batch_n = 0;
+#endif
+
+template <uint8_t CH, uint8_t PIN> struct HumidityProbeDriver
+{
+  static_assert(PIN >= 32 && PIN <= 39, "humidity needs an ADC1 pin, ADC2 is taken by Wi-Fi");
+  static_assert(!ULP_HUMIDITY || PIN == 32, "ULP_ADC_CHANNEL is the ADC1 channel of GPIO32");
+  static constexpr uint8_t BUS = DRIVER_BUS_ANALOG;
+  static constexpr uint64_t CHANNELS = DRIVER_CH(CH) |
+                                       (AMUX_HUMIDITY ? DRIVER_CH_RANGE(AMUX_FIRST_ch, NUM_ANALOG_PERIP - AMUX_FIRST_ch) : 0);
+  static constexpr uint64_t PINS = DRIVER_PIN(PIN) | (AMUX_HUMIDITY ? AMUX_PINS : 0);
+  typedef uint16_t raw_t;
+
+  static void init() {
+    analog_set_pin(analog_a, CH, PIN, NUM_ANALOG_PERIP); // Set pin for humidity sensor
+#if ULP_HUMIDITY
+    if (!ulp_humidity_init(RANGE, LIMIT_ADC_SPIKE)) { // ULP owns ADC1 from now on
+      Serial.println("Could not start ULP humidity sampling!");
+    }
+#endif
+#if AMUX_HUMIDITY
+    amux_hal_init(analog_a, NUM_ANALOG_PERIP); // Mux channels follow HUMIDITY_1_ch
+#endif
+  }
+  static void start() {
+#if ULP_HUMIDITY
+    ulp_batch_n = ulp_humidity_read_batch(ulp_batch, ULP_BATCH_SIZE); // averages collected while sleeping
+    LOG_D(LOG_FMT_ULP_BATCH, ulp_batch_n, ulp_humidity_wake_reason());
+#endif
+#if AMUX_HUMIDITY
+    amux_hal_sweep(analog_a, NUM_ANALOG_PERIP);
+#endif
+  }
+  static uint16_t collect(uint8_t channel) {
+#if ULP_HUMIDITY
+    return ulp_humidity_media(); // Get the last average computed by the ULP
+#else
+    if (channel < AMUX_FIRST_ch) {
+      analog_read_data(analog_a, channel, NUM_ANALOG_PERIP); // mux channels are read by start()
+    }
+    return analog_get_value(analog_a, channel, NUM_ANALOG_PERIP); // Get the filtered value from the humidity sensor
+#endif
+  }
+  static float to_units(uint16_t raw) { return (float)raw * (100.0f / 4095.0f); } // Convert the average value to percentage
+};
+
+// BMP280 sensors, directly on the bus or behind the TCA9548A, probed by peripheral_start_temperature()
+struct Bmp280Driver
+{
+  static constexpr uint8_t BUS = DRIVER_BUS_NONE;
+  static constexpr uint64_t CHANNELS = 0;
+  static constexpr uint64_t PINS = DRIVER_PIN(I2C_SDA_pin) | DRIVER_PIN(I2C_SCL_pin);
+  typedef float raw_t;
+
+  static void init() { i2cmux_init(&temp_mux); }
+  static void start() {
+    power_lock_acquire(power_a, PM_LOCK_I2C_ch, NUM_PM_LOCKS); // keep CPU awake during I2C transactions
+    i2cmux_read_all(&temp_mux, &temp_bus); // one mux switch per used channel
+    power_lock_release(power_a, PM_LOCK_I2C_ch, NUM_PM_LOCKS);
+  }
+  static float collect(uint8_t channel) { return temp_mux.sensor[channel].value; }
+  static float to_units(float raw) { return raw; } // compensated to Celsius by the BMP280 library
+};
+
+typedef DigitalOutputDriver<DIODE_LED_1_ch, DIODE_LED_1_pin> LedDriver;
+typedef DigitalInputDriver<SOLAR_SNS_1_ch, SOLAR_SNS_1_pin> SolarDriver;
+typedef HumidityProbeDriver<HUMIDITY_1_ch, HUMIDITY_1_pin> HumidityDriver;
+typedef Bmp280Driver TemperatureDriver;
+
+// drivers of the board, initialized in this order
+typedef DriverList<LedDriver, SolarDriver, HumidityDriver, TemperatureDriver> Drivers;
+
+static_assert(Drivers::pins_free(), "two drivers on the same GPIO");
+static_assert(Drivers::channels_free(), "two drivers on the same channel of the digital or analog array");
+static_assert(Drivers::channels_valid(NUM_DIG_PERIP, NUM_ANALOG_PERIP), "driver channel out of its HAL array");
 
 /***********************************************************
  Function Definitions
 ***********************************************************/
 void peripheral_init() {
+    // Enable DFS and light sleep before any peripheral start to use PM locks
+    power_init(power_a, NUM_PM_LOCKS);
+    boot_start_async(ble_init); // BLE stack on core 0 while the I2C devices are probed
+
     // Initialize the digital array
     digital_init(digital_a, NUM_DIG_PERIP);
     analog_init(analog_a, NUM_ANALOG_PERIP);
-   
-    // Set up DIODE_LED pin
-    digital_set_pin(digital_a, DIODE_LED_1_ch, DIODE_LED_1_pin, NUM_DIG_PERIP);
-    digital_set_direction(digital_a, DIODE_LED_1_ch, true, NUM_DIG_PERIP); // Set as output
-    
-
-    // Set up SOLAR_SNS pin
-    digital_set_pin(digital_a, SOLAR_SNS_1_ch, SOLAR_SNS_1_pin, NUM_DIG_PERIP);
-    digital_set_direction(digital_a, SOLAR_SNS_1_ch, false, NUM_DIG_PERIP); // Set as input
 
-    // Set up HUMIDITY pin
-    analog_set_pin(analog_a, HUMIDITY_1_ch, HUMIDITY_1_pin, NUM_ANALOG_PERIP); // Set pin for humidity sensor
-
-
-    if (!bmp.begin(0x76)) { // 0x76 or 0x77 depending on sensor
-      Serial.println("Could not find BMP280 sensor!");
-      while (true);
-   }
-   ble_init();
+    Drivers::init(); // LED, solar, humidity pins, I2C sensor table
  }
 
+bool peripheral_start_temperature() {
+    i2cmux_init(&temp_mux); // probe again from scratch on a retry
+#if STRESS_MODE
+    for (uint8_t i = 0; i < STRESS_SENSORS; i++) { // two addresses per mux channel, like the real bus
+      i2cmux_add(&temp_mux, i / 2, i % 2 ? BMP280_ADDR_2 : BMP280_ADDR_1);
+    }
+#elif TEMP_I2CMUX
+    Wire.begin();
+    for (uint8_t ch = 0; ch < I2CMUX_CHANNELS && temp_select(&temp_bus, ch); ch++) {
+      const uint8_t addr[2] = { BMP280_ADDR_1, BMP280_ADDR_2 };
+      for (uint8_t i = 0; i < 2 && temp_mux.count < I2CMUX_MAX_SENSORS; i++) {
+        if (bmp_a[temp_mux.count].begin(addr[i])) { // driver index follows sensor index
+          i2cmux_add(&temp_mux, ch, addr[i]);
+        }
+      }
+    }
+#else
+    if (bmp_a[0].begin(BMP280_ADDR_1)) { // 0x76 or 0x77 depending on sensor
+      i2cmux_add(&temp_mux, I2CMUX_NONE, BMP280_ADDR_1);
+    }
+#endif
+    return temp_mux.count > 0;
+}
+
  void turn_led(uint8_t channel, bool value) {
-    digital_set_value(digital_a, channel, value, NUM_DIG_PERIP); // Set initial value to HIGH
+    if (!driver_owns<LedDriver>(channel)) {
+      LOG_W(LOG_FMT_CHANNEL_OOB, channel);
+      return;
+    }
+    LedDriver::set(value);
     //digital_print(&digital_a[DIODE_LED_1_ch], DIODE_LED_1_ch); // Print status of the LED
  } 
 
-float get_temperature(){
-   float temperature = bmp.readTemperature(); // Read temperature from BMP280
-   DEBUG_PRINT("Temperature: %4.4f *C\n",temperature);
+void read_temperatures(){
+   TemperatureDriver::start(); // one mux switch per used channel
+#if TELEMETRY_MODE
+   for (uint8_t i = 0; i < temp_mux.count; i++){
+     uint32_t bits;
+     memcpy(&bits, &temp_mux.sensor[i].value, sizeof(bits));
+     telemetry_emit(TLM_RAW_TEMPERATURE, i, bits);
+   }
+#endif
+}
+
+float get_temperature(uint8_t channel){
+   if (temp_mux.count == 0) {
+     return NAN; // degraded mode: no sensor answered, no reading
+   }
+   if (channel >= temp_mux.count) {
+     LOG_W(LOG_FMT_CHANNEL_OOB, channel);
+     return 0.0f;
+   }
+   float temperature = driver_read<Drivers, TemperatureDriver>(channel);
+   LOG_D(LOG_FMT_TEMPERATURE, temperature);
+   telemetry_emit_float(TLM_FIELD_TEMPERATURE, temperature);
    return temperature; // Return the temperature value
 }
 
+uint8_t get_temperature_count(){
+   return temp_mux.count;
+}
+
+void print_temperature_sensors(){
+   for (uint8_t i = 0; i < temp_mux.count; i++){
+     I2cSensor_t* s = &temp_mux.sensor[i];
+     DEBUG_PRINT("Temp sensor %u (ch %d, 0x%02x): %u reads, %u errors, latency last %u us avg %u us max %u us\n",
+                 i, s->mux_ch == I2CMUX_NONE ? -1 : s->mux_ch, s->addr, s->reads, s->errors, s->last_us,
+                 s->reads ? (uint32_t)(s->sum_us / s->reads) : 0, s->max_us);
+   }
+   DEBUG_PRINT("I2C mux: %u channel switches\n", temp_mux.switches);
+}
+
 int read_solar_radiation(uint8_t channel) {
-    int solarSts = digital_read(digital_a, channel, NUM_DIG_PERIP);
-    DEBUG_PRINT("Solar sensor status = %d \n", solarSts);
+    if (!driver_owns<SolarDriver>(channel)) {
+      LOG_W(LOG_FMT_CHANNEL_OOB, channel);
+      return 0;
+    }
+    int solarSts = (int)driver_read<Drivers, SolarDriver>();
+    LOG_D(LOG_FMT_SOLAR, solarSts);
+    telemetry_emit_float(TLM_FIELD_SOLAR, (float)solarSts);
    return solarSts; // Return the status of the solar sensor
 }
 
+void scan_humidity(){
+#if AMUX_HUMIDITY || ULP_HUMIDITY
+   HumidityDriver::start();
+#endif
+}
+
+uint8_t read_humidity_batch(float* out, uint8_t max){
+   uint8_t n = 0;
+#if ULP_HUMIDITY
+   for (; n < ulp_batch_n && n < max; n++) {
+      out[n] = HumidityDriver::to_units(ulp_batch[n]);
+   }
+#endif
+   return n;
+}
+
 float read_humidity(uint8_t channel){
-   float humidity_value = 0.0F;
-   analog_read_data(analog_a,channel, NUM_ANALOG_PERIP); 
-   uint16_t media = analog_get_media(analog_a, channel, NUM_ANALOG_PERIP); // Get the average value from the humidity sensor
-   humidity_value = (float)media * (100.0f / 4095.0f); // Convert the average value to percentage
-   DEBUG_PRINT("Humidity sensor value = %.2f %%\n", humidity_value); 
+   float humidity_value = driver_read<Drivers, HumidityDriver>(channel);
+   LOG_D(LOG_FMT_HUMIDITY, humidity_value);
+   telemetry_emit_float(TLM_FIELD_HUMIDITY, humidity_value);
    //analog_print(analog_a, channel); // Print status of the humidity sensor
    return humidity_value; 
 }
-
-
@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file record.c
+ * @brief Plant record codec
+ *
+ * This implementation file provides the encoder and the decoder of the plant record
+ * batches, shared by the firmware and the host tools.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "record.h"
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get16(const uint8_t* p) {
+  return (uint16_t)(p[0] | p[1] << 8);
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+size_t record_encode(const PlantRecord_t* r, uint8_t count, uint8_t* out, size_t size) {
+  if (count == 0 || size < (size_t)RECORD_BATCH_SIZE(count)) {
+    return 0;
+  }
+  uint32_t base = r[0].s.ts;
+  out[0] = RECORD_VERSION;
+  out[1] = RECORD_BYTES;
+  out[2] = count;
+  put16(&out[3], (uint16_t)base);
+  put16(&out[5], (uint16_t)(base >> 16));
+  uint8_t* p = &out[RECORD_HEADER_SIZE];
+  for (uint8_t i = 0; i < count; i++, p += RECORD_BYTES) {
+    if (r[i].s.ts < base || r[i].s.ts - base > RECORD_MAX_SPAN_S) {
+      return 0;
+    }
+    p[0] = r[i].plant;
+    put16(&p[1], (uint16_t)(r[i].s.ts - base));
+    put16(&p[3], (uint16_t)r[i].s.temperature);
+    put16(&p[5], r[i].s.humidity);
+    p[7] = r[i].s.solar;
+    p[8] = r[i].s.alarm;
+    put16(&p[9], r[i].ms);
+  }
+  return RECORD_BATCH_SIZE(count);
+}
+
+bool record_reader_init(RecordReader_t* rd, const uint8_t* data, size_t len) {
+  if (len < RECORD_HEADER_SIZE || data[0] != RECORD_VERSION || data[1] < RECORD_MIN_BYTES ||
+      len != RECORD_HEADER_SIZE + (size_t)data[1] * data[2]) {
+    return false;
+  }
+  rd->p = &data[RECORD_HEADER_SIZE];
+  rd->base_ts = get16(&data[3]) | (uint32_t)get16(&data[5]) << 16;
+  rd->stride = data[1];
+  rd->left = data[2];
+  return true;
+}
+
+bool record_read(RecordReader_t* rd, PlantRecord_t* out) {
+  if (rd->left == 0) {
+    return false;
+  }
+  const uint8_t* p = rd->p;
+  out->plant = p[0];
+  out->s.ts = rd->base_ts + get16(&p[1]);
+  out->s.temperature = (int16_t)get16(&p[3]);
+  out->s.humidity = get16(&p[5]);
+  out->s.solar = p[7];
+  out->s.alarm = p[8];
+  out->ms = rd->stride >= 11 ? get16(&p[9]) : 0;
+  rd->p += rd->stride; // fields appended by a newer version are skipped
+  rd->left--;
+  return true;
+}
+
+int record_decode(const uint8_t* data, size_t len, PlantRecord_t* out, uint8_t max) {
+  RecordReader_t rd;
+  if (!record_reader_init(&rd, data, len) || rd.left > max) {
+    return -1;
+  }
+  int n = 0;
+  while (record_read(&rd, &out[n])) {
+    n++;
+  }
+  return n;
+}
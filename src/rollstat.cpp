@@ -0,0 +1,169 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file rollstat.c
+ * @brief Rolling statistics over a window of buckets
+ *
+ * This implementation file provides the bucketed Welford mean/variance, the monotonic
+ * deque min/max and the EWMA.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <string.h>
+#include <math.h>
+#include "rollstat.h"
+
+static inline uint8_t ring(uint8_t head, uint8_t i){
+  return (uint8_t)((head + i) % ROLLSTAT_MAX_BUCKETS);
+}
+
+static inline const RollBucket_t* bucket_of(const RollStat_t* r, uint32_t seq){
+  return &r->bucket[seq % ROLLSTAT_MAX_BUCKETS];
+}
+
+// merge a bucket of nb samples into an aggregate
+static void merge_add(uint32_t* n, double* mean, double* m2, const RollBucket_t* b, uint32_t nb){
+  uint32_t total = *n + nb;
+  double delta = b->mean - *mean;
+  *mean += delta * nb / total;
+  *m2 += b->m2 + delta * delta * ((double)*n * nb / total);
+  *n = total;
+}
+
+// inverse of merge_add
+static void merge_remove(uint32_t* n, double* mean, double* m2, const RollBucket_t* b, uint32_t nb){
+  uint32_t rest = *n - nb;
+  if (rest == 0) {
+    *n = 0;
+    *mean = 0.0;
+    *m2 = 0.0;
+    return;
+  }
+  double rest_mean = (*mean * *n - (double)b->mean * nb) / rest;
+  double delta = b->mean - rest_mean;
+  *m2 -= b->m2 + delta * delta * ((double)rest * nb / *n);
+  *m2 = *m2 > 0.0 ? *m2 : 0.0; // rounding
+  *mean = rest_mean;
+  *n = rest;
+}
+
+static void deque_expire(const uint32_t* q, uint8_t* head, uint8_t* len, uint32_t oldest){
+  while (*len > 0 && q[*head] < oldest) {
+    *head = (uint8_t)((*head + 1) % ROLLSTAT_MAX_BUCKETS);
+    (*len)--;
+  }
+}
+
+static void close_bucket(RollStat_t* r){
+  uint32_t seq = r->seq;
+  if (r->count == r->window) { // oldest bucket leaves the window
+    uint32_t oldest = seq - r->window;
+    merge_remove(&r->n, &r->mean, &r->m2, bucket_of(r, oldest), r->bucket_samples);
+    r->count--;
+    deque_expire(r->min_q, &r->min_head, &r->min_len, oldest + 1);
+    deque_expire(r->max_q, &r->max_head, &r->max_len, oldest + 1);
+  }
+  r->bucket[seq % ROLLSTAT_MAX_BUCKETS] = r->open;
+  merge_add(&r->n, &r->mean, &r->m2, &r->open, r->open_n);
+  r->count++;
+  // drop the buckets that can no longer be the extreme, then append
+  while (r->min_len > 0 && bucket_of(r, r->min_q[ring(r->min_head, r->min_len - 1)])->min >= r->open.min) {
+    r->min_len--;
+  }
+  r->min_q[ring(r->min_head, r->min_len++)] = seq;
+  while (r->max_len > 0 && bucket_of(r, r->max_q[ring(r->max_head, r->max_len - 1)])->max <= r->open.max) {
+    r->max_len--;
+  }
+  r->max_q[ring(r->max_head, r->max_len++)] = seq;
+  r->seq = seq + 1;
+  r->open_n = 0;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool rollstat_init(RollStat_t* r, uint16_t window, uint16_t bucket_samples, float alpha){
+  if (window == 0 || window > ROLLSTAT_MAX_BUCKETS || bucket_samples == 0 || !(alpha > 0.0f && alpha <= 1.0f)) {
+    return false;
+  }
+  memset(r, 0, sizeof(RollStat_t));
+  r->window = window;
+  r->bucket_samples = bucket_samples;
+  r->alpha = alpha;
+  return true;
+}
+
+void rollstat_push(RollStat_t* r, float x){
+  rollstat_push_n(r, x, 1);
+}
+
+void rollstat_push_n(RollStat_t* r, float x, uint32_t k){
+  if (k == 0) {
+    return;
+  }
+  if (r->n == 0 && r->open_n == 0) {
+    r->ewma = x;
+  } else {
+    float gain = (k == 1) ? r->alpha : 1.0f - powf(1.0f - r->alpha, (float)k);
+    r->ewma += gain * (x - r->ewma);
+  }
+  RollBucket_t* b = &r->open;
+  while (k > 0) {
+    uint32_t room = r->bucket_samples - r->open_n;
+    uint32_t m = k < room ? k : room; // copies of x in the open bucket
+    if (r->open_n == 0) {
+      b->mean = x;
+      b->m2 = 0.0f;
+      b->min = x;
+      b->max = x;
+    } else {
+      uint32_t n = r->open_n + m;
+      float delta = x - b->mean;
+      b->mean += delta * m / n;
+      b->m2 += delta * delta * ((float)r->open_n * m / n);
+      b->min = x < b->min ? x : b->min;
+      b->max = x > b->max ? x : b->max;
+    }
+    r->open_n = (uint16_t)(r->open_n + m);
+    k -= m;
+    if (r->open_n == r->bucket_samples) {
+      close_bucket(r);
+    }
+  }
+}
+
+void rollstat_get(const RollStat_t* r, RollStatValue_t* out){
+  memset(out, 0, sizeof(RollStatValue_t));
+  if (r->n == 0 && r->open_n == 0) {
+    return;
+  }
+  uint32_t n = r->n; // closed buckets merged with the open bucket
+  double mean = r->mean, m2 = r->m2;
+  float min = r->open.min, max = r->open.max;
+  if (r->open_n > 0) {
+    merge_add(&n, &mean, &m2, &r->open, r->open_n);
+  }
+  if (r->min_len > 0) {
+    float m = bucket_of(r, r->min_q[r->min_head])->min;
+    min = (r->open_n == 0 || m < min) ? m : min;
+  }
+  if (r->max_len > 0) {
+    float m = bucket_of(r, r->max_q[r->max_head])->max;
+    max = (r->open_n == 0 || m > max) ? m : max;
+  }
+  out->n = n;
+  out->mean = (float)mean;
+  out->stddev = (float)sqrt(m2 / n);
+  out->min = min;
+  out->max = max;
+  out->ewma = r->ewma;
+}
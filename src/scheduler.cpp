@@ -19,39 +19,173 @@
  */
 
 #include "scheduler.h"
+#include "HAL/analog_hal.h"
+#include "HAL/amux_hal.h"
 #include "HAL/ble_hal.h"
+#include "HAL/power_hal.h"
+#include "HAL/ulp_hal.h"
 #include "peripheral.h"
 #include "smartplant.h"
+#include "telemetry.h"
+#include "config.h"
+#include "bench.h"
+#include "stress.h"
+#include "boot.h"
+#include "uplink.h"
+#include "timesync.h"
 
 extern Task_t task_a[NUM_TASKS];
-extern SmartPlant_t SM_list[NUM_PLANTS];
+extern SmartPlant_t SM_list;
+extern Power_t power_a[NUM_PM_LOCKS];
+extern LogRing_t dlog_a[DLOG_NUM_RINGS];
+extern Adapt_t SM_adapt;
+
+static_assert(ADAPT_MIN_MS == TASK1_TIME, "adaptive sampling starts from the Task1 period");
+
+// BMP280 probe, then one sensor per plant (shared if fewer) behind the mux
+static bool temperature_start() {
+  if (!peripheral_start_temperature()) {
+    return false;
+  }
+#if TEMP_I2CMUX || STRESS_MODE
+  for (uint8_t i = 0; i < NUM_PLANTS; i++) {
+    smartplant_set_channels(&SM_list, i, NUM_PLANTS, i % get_temperature_count(),
+                            SM_list.solar_ch[i], SM_list.humidity_ch[i], SM_list.led_ch[i]);
+  }
+#endif
+  return true;
+}
 
 
 void Task1(void *pvParameters) {
-  const TickType_t interval = pdMS_TO_TICKS(TASK1_TIME); // 1s
   TickType_t xLastWakeTime = xTaskGetTickCount();
+  uint8_t display_plant = PLANT_1;
+  uint32_t cycle_sum_us = 0, cycle_max_us = 0, cycles = 0;
+  uint64_t cpu_saved_us = 0; // cycles a fixed TASK1_TIME would have run, at their measured cost
+  smartplant_history_set_notify(xTaskGetCurrentTaskHandle()); // history query written over BLE: run now
+  config_set_notify(xTaskGetCurrentTaskHandle()); // configuration written over BLE: apply now
+#if ULP_HUMIDITY
+  ulp_humidity_set_notify(xTaskGetCurrentTaskHandle()); // batch full or threshold crossed: run now
+#endif
   while (true) {
-    Serial.printf("%lu - Task 1 completed on core %d\n", millis(), xPortGetCoreID());
-    smartplant_set_temperature(SM_list, PLANT_1, NUM_PLANTS);
-    smartplant_set_solar_intensity(SM_list, PLANT_1, NUM_PLANTS, SOLAR_SNS_1_ch);
-    smartplant_set_sand_humidity(SM_list, PLANT_1, NUM_PLANTS, HUMIDITY_1_ch);
-    smartplant_set_alarm(SM_list, PLANT_1, NUM_PLANTS, DIODE_LED_1_ch);
-    smartplant_display_data(SM_list,PLANT_1, NUM_PLANTS); // Display data on OLED
-    vTaskDelayUntil(&xLastWakeTime, interval);
+    config_apply(); // configuration written over BLE, between two cycles
+    boot_retry(); // missing I2C devices, between two cycles like every bus user
+    LOG_I(LOG_FMT_TASK_DONE, 1, xPortGetCoreID());
+    int64_t start_us = esp_timer_get_time();
+    TELEMETRY_TIME(TLM_STAGE_TASK1,
+      smartplant_update(&SM_list, NUM_PLANTS); // Read sensors and set alarms of all plants
+      TELEMETRY_TIME(TLM_STAGE_DISPLAY, smartplant_display_data(&SM_list, display_plant, NUM_PLANTS)); // Display data on OLED
+      smartplant_history_append(&SM_list, PLANT_1, NUM_PLANTS); // Store data in flash history
+    );
+#if TELEMETRY_MODE || WIFI_UPLINK
+    PlantRecord_t records[NUM_PLANTS]; // one record per plant, the schema of every output
+    for (uint8_t i = 0; i < NUM_PLANTS; i++) {
+      smartplant_get_record(&SM_list, i, NUM_PLANTS, &records[i]);
+    }
+    telemetry_send_records(records, NUM_PLANTS); // no-op unless TELEMETRY_MODE
+#endif
+#if WIFI_UPLINK
+    uplink_push(records, NUM_PLANTS); // published in batches by the Uplink task
+#endif
+    display_plant = (display_plant + 1) % NUM_PLANTS; // one plant per period on the OLED
+    boot_first_sample(); // time to first sample, once
+
+    // cycle time of the whole pipeline, to size NUM_PLANTS against TASK1_TIME
+    uint32_t cycle_us = (uint32_t)(esp_timer_get_time() - start_us);
+    cycle_sum_us += cycle_us;
+    cycle_max_us = cycle_us > cycle_max_us ? cycle_us : cycle_max_us;
+
+    smartplant_history_run(); // history query written over BLE, outside the cycle time
+#if WIFI_UPLINK
+    uplink_run(); // uplink backlog stored in flash while offline
+#endif
+
+    uint32_t interval_ms = smartplant_next_interval(&SM_list, NUM_PLANTS); // 1s, longer while readings are stable
+    cpu_saved_us += (uint64_t)(interval_ms / config_get()->task1_ms - 1) * cycle_us;
+    if (++cycles == CYCLE_REPORT_PERIOD) {
+      LOG_I(LOG_FMT_CYCLE_TIME, NUM_PLANTS, cycle_sum_us / cycles, cycle_max_us);
+#if ADAPTIVE_SAMPLING
+      LOG_I(LOG_FMT_ADAPT, interval_ms, (uint32_t)((uint64_t)SM_adapt.stats.cycles * 1000000 / SM_adapt.stats.elapsed_ms),
+            SM_adapt.stats.skipped, (uint32_t)(cpu_saved_us / 1000));
+#endif
+      cycle_sum_us = 0;
+      cycle_max_us = 0;
+      cycles = 0;
+    }
+    power_delay_until(&xLastWakeTime, pdMS_TO_TICKS(interval_ms)); // light sleep until next sample or notification
   }
 }
 
 void Task2(void *pvParameters) {
-  const TickType_t interval = pdMS_TO_TICKS(TASK2_TIME); // 3s
   TickType_t xLastWakeTime = xTaskGetTickCount();
+  uint8_t stats_plant = PLANT_1;
+  uint32_t sent_cycles = 0, tx_us = 0, tx_skipped = 0;
+#if ADAPTIVE_SAMPLING
+  uint32_t periods = 0; // since the last radio report
+#endif
+  uint64_t radio_saved_us = 0;
   while (true) {
-    Serial.printf("%lu - Task 2 completed on core %d\n", millis(), xPortGetCoreID());
+    LOG_I(LOG_FMT_TASK_DONE, 2, xPortGetCoreID());
+    TELEMETRY_TIME(TLM_STAGE_TASK2,
+      if (deviceConnected && SM_list.cycles == sent_cycles) { // no new sample: radio stays idle
+        tx_skipped++;
+        radio_saved_us += tx_us;
+      } else if (deviceConnected) {
+        int64_t tx_start_us = esp_timer_get_time();
+#if BLE_LEGACY_CHARACTERISTICS // deprecated, plant 1 only
+        if (!isnan(SM_list.temperature[PLANT_1])) { // no sensor in degraded mode
+          ble_transmit_temp((uint16_t)SM_list.temperature[PLANT_1]);
+        }
+        ble_transmit_humidity((uint16_t)SM_list.sand_humidity[PLANT_1]);
+        ble_transmit_slrrad((uint16_t)SM_list.solar_intensity[PLANT_1]);
+#endif
+        PlantRecord_t records[NUM_PLANTS]; // every plant, timestamped, 0.1 units
+        for (uint8_t i = 0; i < NUM_PLANTS; i++) {
+          smartplant_get_record(&SM_list, i, NUM_PLANTS, &records[i]);
+        }
+        ble_transmit_records(records, NUM_PLANTS);
+        for (uint8_t f = 0; f < ALARM_NUM_FIELDS; f++) { // window statistics, one plant per period
+          RollStatValue_t v;
+          smartplant_get_stats(stats_plant, f, NUM_PLANTS, &v);
+          ble_transmit_stats(stats_plant, f, &v);
+        }
+        stats_plant = (stats_plant + 1) % NUM_PLANTS;
+        sent_cycles = SM_list.cycles;
+        tx_us = (uint32_t)(esp_timer_get_time() - tx_start_us); // cost of the last update
+      }
+    );
+#if ADAPTIVE_SAMPLING
+    if (++periods == CYCLE_REPORT_PERIOD) {
+      LOG_I(LOG_FMT_RADIO_SAVED, tx_skipped, (uint32_t)(radio_saved_us / 1000));
+      periods = 0;
+    }
+#endif
     if (deviceConnected) {
-      ble_transmit_temp((uint16_t)SM_list[PLANT_1].temperature);
-      ble_transmit_humidity((uint16_t)SM_list[PLANT_1].sand_humidity);
-      ble_transmit_slrrad((uint16_t)SM_list[PLANT_1].solar_intensity);
+      smartplant_history_send(); // result of the last history query
     }
-    vTaskDelayUntil(&xLastWakeTime, interval);
+    power_print(power_a, NUM_PM_LOCKS); // time at each CPU frequency and wake-up latency
+    print_temperature_sensors(); // read latency of each temperature sensor
+#if AMUX_HUMIDITY
+    amux_hal_print(); // duration of the last sweep of the humidity muxes
+#endif
+    smartplant_alarm_print(); // alarm stage to BLE notify latency
+#if WIFI_UPLINK
+    uplink_print(); // batches, payload size and backlog of the Wi-Fi uplink
+#endif
+    timesync_print(); // wall clock sync and drift correction
+    UBaseType_t stack_free = uxTaskGetStackHighWaterMark(NULL); // bytes, diagnostics above included
+    if (stack_free < TASK_STACK_MIN_FREE) {
+      LOG_W(LOG_FMT_STACK_LOW, 2, (uint32_t)stack_free);
+    }
+    power_delay_until(&xLastWakeTime, pdMS_TO_TICKS(config_get()->task2_ms)); // 3s unless configured
+  }
+}
+
+void Task3(void *pvParameters) {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // woken by the alarm stage of Task1
+    LOG_I(LOG_FMT_TASK_DONE, 3, xPortGetCoreID());
+    TELEMETRY_TIME(TLM_STAGE_TASK3, smartplant_alarm_dispatch(&SM_list, NUM_PLANTS));
   }
 }
 
@@ -59,6 +193,10 @@ void Task2(void *pvParameters) {
  Function Definitions
 ***********************************************************/
 void scheduler_init() {
+    dlog_init(dlog_a, DLOG_NUM_RINGS); // start deferred logger before any LOG_x call
+#if DLOG_BENCH
+    dlog_benchmark();
+#endif
     // Initialize the digital array
     task_init(task_a, NUM_TASKS);
     // Set up tasks
@@ -68,11 +206,43 @@ void scheduler_init() {
     task_set_priority(task_a, TASK2_ch, TASK2_PRIO, NUM_TASKS); // Set priority for Task 2
     task_set_function(task_a, TASK2_ch, Task2, NUM_TASKS); // Set function for Task 2
     task_set_time(task_a, TASK2_ch, TASK2_TIME, NUM_TASKS); // Set time for Task 2
+    task_set_priority(task_a, TASK3_ch, TASK3_PRIO, NUM_TASKS); // Set priority for Task 3
+    task_set_function(task_a, TASK3_ch, Task3, NUM_TASKS); // Set function for Task 3
+    task_set_time(task_a, TASK3_ch, TASK3_TIME, NUM_TASKS); // Set time for Task 3
     peripheral_init();
-    smartplant_init(SM_list, NUM_PLANTS); // Initialize smart plant data
+    smartplant_init(&SM_list, NUM_PLANTS); // Initialize smart plant data
+    smartplant_set_channels(&SM_list, PLANT_1, NUM_PLANTS, 0, SOLAR_SNS_1_ch, HUMIDITY_1_ch, DIODE_LED_1_ch);
+#if AMUX_HUMIDITY
+    for (uint8_t i = 0; i < NUM_PLANTS && i < NUM_ANALOG_PERIP - AMUX_FIRST_ch; i++) {
+      smartplant_set_channels(&SM_list, i, NUM_PLANTS, 0, SOLAR_SNS_1_ch, AMUX_FIRST_ch + i, DIODE_LED_1_ch); // one probe per plant
+    }
+#endif
+    boot_device(BOOT_DEV_TEMPERATURE, "BMP280 sensor", temperature_start); // degraded mode if missing
+    boot_device(BOOT_DEV_OLED, "OLED", smartplant_display_init);
+    smartplant_alarm_init(); // Alarm rules from NVS or firmware
+    smartplant_history_init(); // Mount flash history, sampling runs without it
+    config_init(); // Runtime configuration from NVS or firmware
+    ble_set_config_handler(config_write, config_read);
+    ble_set_history_handler(smartplant_history_request);
+    ble_set_time_handler(timesync_request);
+    telemetry_init(HUMIDITY_1_pin); // no-op unless TELEMETRY_MODE
+    boot_wait_async(); // BLE stack up before a task notifies
+#if BENCH_MODE
+    static BenchResult_t bench_results[BENCH_MAX_RESULTS];
+    bench_print(bench_results, bench_run(&SM_list, NUM_PLANTS, bench_results, BENCH_MAX_RESULTS)); // before the tasks start
+#endif
+#if WIFI_UPLINK
+    uplink_init(); // after the history: publishes what was stored offline
+#endif
+#if STRESS_MODE
+    stress_init(); // sweep of the Task1 period, synthetic temperature sensors
+#endif
 
-    xTaskCreatePinnedToCore(Task1, "Task 1", 2048, NULL, BaseType_t(get_task_priority(task_a, TASK1_ch, NUM_TASKS)) , NULL, 1); //Core 1
-    xTaskCreatePinnedToCore(Task2, "Task 2", 2048, NULL, BaseType_t(get_task_priority(task_a, TASK2_ch, NUM_TASKS)) , NULL, 1); //Core 1
+    TaskHandle_t alarm_task = NULL;
+    xTaskCreatePinnedToCore(Task3, "Task 3", 3072, NULL, BaseType_t(get_task_priority(task_a, TASK3_ch, NUM_TASKS)) , &alarm_task, 1); //Core 1, alarm events
+    smartplant_alarm_set_notify(alarm_task);
+    xTaskCreatePinnedToCore(Task1, "Task 1", 4096, NULL, BaseType_t(get_task_priority(task_a, TASK1_ch, NUM_TASKS)) , NULL, 1); //Core 1, stack for flash history writes
+    xTaskCreatePinnedToCore(Task2, "Task 2", TASK2_STACK, NULL, BaseType_t(get_task_priority(task_a, TASK2_ch, NUM_TASKS)) , NULL, 1); //Core 1
 }
 
 
@@ -18,24 +18,181 @@
  *
  */
 #include "smartplant.h"
+#include "HAL/flash_hal.h"
+#include "HAL/ble_hal.h"
+#include "HAL/ulp_hal.h"
+#include "telemetry.h"
+#include "frame.h"
+#include "alarm_rules.h"
+#include <Preferences.h>
+#include "esp_timer.h"
+#include "boot.h"
+#include "timesync.h"
 
 
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
-SmartPlant_t SM_list[NUM_PLANTS] = {};
+SmartPlant_t SM_list = {};
+Flash_t history_flash = {};
+Tsdb_t SM_history = {};
+static bool history_ready = false;
+static int64_t history_offset_us = 0; // history time minus esp_timer time, continues from the stored history
+static HistoryQuery_t history_query = {}; // written over BLE, run by Task1
+static bool history_query_set = false;
+static TaskHandle_t history_notify_task = NULL;
+static DsPoint_t history_out[HISTORY_MAX_POINTS]; // downsampled by Task1, sent by Task2
+static uint16_t history_out_count = 0;
+static uint32_t history_out_last = 0; // newest stored timestamp when the query ran
+static volatile bool history_out_ready = false;
+static portMUX_TYPE history_mux = portMUX_INITIALIZER_UNLOCKED;
+
+typedef struct
+{
+  Downsample_t  ds;
+  uint8_t       field; // AlarmField_t
+}HistoryPass_t;
+
+static void history_collect(const DsPoint_t* p, void* arg) {
+  if (history_out_count < HISTORY_MAX_POINTS) {
+    history_out[history_out_count++] = *p;
+  }
+}
+
+static bool history_push(const TsdbSample_t* s, void* arg) {
+  HistoryPass_t* pass = (HistoryPass_t*)arg;
+  int32_t value = pass->field == ALARM_FIELD_TEMPERATURE ? s->temperature :
+                  (pass->field == ALARM_FIELD_HUMIDITY ? s->humidity : s->solar);
+  downsample_push(&pass->ds, s->ts, value);
+  return true;
+}
+AlarmTable_t alarm_table = {}; // rules in use
+AlarmPlant_t alarm_a[NUM_PLANTS] = {}; // alarm state of each plant
+static const AlarmRule_t alarm_default[] = ALARM_RULES;
+static AlarmTable_t alarm_pending = {}; // rules stored by another task, applied by Task1
+static bool alarm_pending_set = false;
+static portMUX_TYPE alarm_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t alarm_notify_task = NULL;
+static int64_t alarm_event_us[NUM_PLANTS] = {}; // time of the pending change, 0 if none
+static AlarmLatency_t alarm_latency = {};
+RollStat_t stat_a[ALARM_NUM_FIELDS][NUM_PLANTS]; // rolling statistics, indexed by AlarmField_t
+static portMUX_TYPE stat_mux = portMUX_INITIALIZER_UNLOCKED; // Task2 reads while Task1 pushes
+static uint32_t stat_hold[ALARM_NUM_FIELDS] = { 1, 1, 1 }; // sample periods covered by the reading of each field, 0 if not read by this run
+#if ULP_HUMIDITY
+#define ULP_STATS_AVERAGES (STATS_SAMPLE_MS * 1000 / ULP_PERIOD_US) // ULP averages in a statistics sample
+static_assert(ULP_STATS_AVERAGES > 0, "ULP_PERIOD_US longer than STATS_SAMPLE_MS");
+static float ulp_sample[ULP_BATCH_SIZE]; // humidity samples of the last ULP batch, oldest first
+static int64_t ulp_sample_us[ULP_BATCH_SIZE]; // time each sample stands for
+static uint8_t ulp_sample_n = 0;
+static float ulp_carry_sum = 0.0f; // averages of the sample still open at the end of the batch
+static uint8_t ulp_carry_n = 0;
+#endif
+Adapt_t SM_adapt = {}; // adaptive sampling controller
+
+static_assert(ALARM_NUM_FIELDS * NUM_PLANTS <= ADAPT_MAX_POINTS, "ADAPT_MAX_POINTS too small for NUM_PLANTS");
+
+// thresholds of the alarm rules in use: the controller samples fast around them
+static void adapt_load_thresholds() {
+  adapt_set_field(&SM_adapt, ALARM_FIELD_TEMPERATURE, ADAPT_TEMP_RESOLUTION, ADAPT_TEMP_GUARD);
+  adapt_set_field(&SM_adapt, ALARM_FIELD_HUMIDITY, ADAPT_HUMIDITY_RESOLUTION, ADAPT_HUMIDITY_GUARD);
+  adapt_set_field(&SM_adapt, ALARM_FIELD_SOLAR, ADAPT_SOLAR_RESOLUTION, ADAPT_SOLAR_GUARD);
+  for (uint8_t i = 0; i < alarm_table.count; i++) {
+    const AlarmRule_t* r = &alarm_table.rule[i];
+    if (r->op == ALARM_OP_COND) {
+      adapt_add_threshold(&SM_adapt, r->field, r->threshold);
+    }
+  }
+}
+
+// middle of the acquisition: the time a reading stands for
+static int64_t sample_mid_us(const SampleTime_t* t) {
+  return t->at_us + t->latency_us / 2;
+}
+
+// a stage has read a field of every plant: one stamp per stage, not per reading
+static void stage_stamp(SmartPlant_t* sm, uint8_t field, int64_t start_us, int64_t end_us) {
+  SampleTime_t* cur = &sm->sample_time[field];
+  sm->prev_us[field] = cur->at_us != 0 ? sample_mid_us(cur) : 0; // reading before, kept for interpolation
+  cur->at_us = start_us;
+  cur->latency_us = (uint32_t)(end_us - start_us);
+  if (sm->prev_us[field] == 0) {
+    stat_hold[field] = 1;
+  } else { // sample periods covered by this reading, same for every plant
+    uint32_t period_ms = (uint32_t)((sample_mid_us(cur) - sm->prev_us[field]) / 1000);
+    stat_hold[field] = (period_ms + STATS_SAMPLE_MS / 2) / STATS_SAMPLE_MS;
+    stat_hold[field] = stat_hold[field] == 0 ? 1 : stat_hold[field];
+  }
+}
+
+#if ULP_HUMIDITY
+// averages of the ULP batch, one per ULP_PERIOD_US up to the drain, to samples of STATS_SAMPLE_MS
+static void ulp_batch_samples(int64_t drain_us) {
+  float avg[ULP_BATCH_SIZE];
+  uint8_t n = read_humidity_batch(avg, ULP_BATCH_SIZE);
+  ulp_sample_n = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    ulp_carry_sum += avg[i];
+    if (++ulp_carry_n == ULP_STATS_AVERAGES) {
+      int64_t end_us = drain_us - (int64_t)(n - 1 - i) * ULP_PERIOD_US;
+      ulp_sample_us[ulp_sample_n] = end_us - (int64_t)(ULP_STATS_AVERAGES - 1) * ULP_PERIOD_US / 2;
+      ulp_sample[ulp_sample_n++] = ulp_carry_sum / ULP_STATS_AVERAGES;
+      ulp_carry_sum = 0.0f;
+      ulp_carry_n = 0;
+    }
+  }
+}
+#endif
+
+// history time of an esp_timer time
+static void history_time(int64_t at_us, uint32_t* ts, uint16_t* ms) {
+  portENTER_CRITICAL(&history_mux);
+  int64_t t_us = history_offset_us + at_us;
+  portEXIT_CRITICAL(&history_mux);
+  *ts = (uint32_t)(t_us / 1000000);
+  *ms = (uint16_t)(t_us / 1000 % 1000);
+}
+
+// history time jumps forward to the wall clock, once set over BLE
+static void history_clock_sync(int64_t now_us) {
+  int64_t unix_us;
+  if (timesync_to_unix_us(now_us, &unix_us) && unix_us > history_offset_us + now_us) {
+    portENTER_CRITICAL(&history_mux);
+    history_offset_us = unix_us - now_us;
+    portEXIT_CRITICAL(&history_mux);
+  }
+}
+
+typedef struct
+{
+  uint8_t   version; // ALARM_NVS_VERSION
+  uint8_t   count; // rules
+  uint16_t  crc; // CRC16 of the rules
+  AlarmRule_t rule[ALARM_MAX_RULES];
+}AlarmBlob_t;
 
 /***********************************************************
  Function Definitions
 ***********************************************************/
 void smartplant_init(SmartPlant_t* sm, uint8_t size){
   for (int i = 0; i < size; i++)  {
-    sm[i].temperature = 0.0f; // Initialize temperature to 0.0
-    sm[i].sand_humidity = 0.0f; // Initialize sand humidity to 0.0
-    sm[i].solar_intensity = 0; // Initialize solar intensity to 0 
-    sm[i].alarm = false; // Initialize alarm status to false
+    sm->temp_ch[i] = 0; // First temperature sensor
+    sm->solar_ch[i] = SOLAR_SNS_1_ch; // Peripherals of plant 1
+    sm->humidity_ch[i] = HUMIDITY_1_ch;
+    sm->led_ch[i] = DIODE_LED_1_ch;
+    sm->temperature[i] = 0.0f; // Initialize temperature to 0.0
+    sm->sand_humidity[i] = 0.0f; // Initialize sand humidity to 0.0
+    sm->solar_intensity[i] = 0; // Initialize solar intensity to 0 
+    sm->alarm[i] = false; // Initialize alarm status to false
+    sm->alarm_mask[i] = 0;
+    for (uint8_t f = 0; f < ALARM_NUM_FIELDS; f++) {
+      rollstat_init(&stat_a[f][i], STATS_WINDOW, STATS_BUCKET_SAMPLES, STATS_EWMA_ALPHA);
+    }
   }
+  sm->cycles = 0;
+  adapt_init(&SM_adapt, ALARM_NUM_FIELDS, ADAPT_MIN_MS, ADAPT_MAX_MS, ADAPT_GROWTH);
+}
+
+bool smartplant_display_init() {
   if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) { // Address 0x3C or 0x3D
-    Serial.println("OLED not found");
-    while (true);
+    return false;
   }
   display.clearDisplay();
   display.setTextSize(1);
@@ -43,59 +200,422 @@ void smartplant_init(SmartPlant_t* sm, uint8_t size){
   display.setCursor(0,0);
   display.println("Smart Plant Monitor");
   display.display();
+  return true;
+}
+
+void smartplant_set_channels(SmartPlant_t* sm, uint8_t channel, uint8_t size,
+                             uint8_t temp_ch, uint8_t solar_ch, uint8_t humidity_ch, uint8_t led_ch) {
+  if(channel < size){
+    sm->temp_ch[channel] = temp_ch;
+    sm->solar_ch[channel] = solar_ch;
+    sm->humidity_ch[channel] = humidity_ch;
+    sm->led_ch[channel] = led_ch;
+  }
+}
+
+void smartplant_update(SmartPlant_t* sm, uint8_t size) {
+  sm->cycle_us = esp_timer_get_time();
+  history_clock_sync(sm->cycle_us); // Task1 is the only writer of the history
+  for (uint8_t f = 0; f < ALARM_NUM_FIELDS; f++) {
+    stat_hold[f] = 0; // until the stage of the field has run
+  }
+  int64_t stage_us = sm->cycle_us;
+  TELEMETRY_TIME(TLM_STAGE_TEMPERATURE,
+    read_temperatures(); // all sensors, grouped by I2C mux channel
+    for (uint8_t i = 0; i < size; i++) smartplant_set_temperature(sm, i, size);
+  );
+  int64_t end_us = esp_timer_get_time();
+  stage_stamp(sm, ALARM_FIELD_TEMPERATURE, stage_us, end_us);
+  stage_us = end_us;
+  TELEMETRY_TIME(TLM_STAGE_SOLAR,
+    for (uint8_t i = 0; i < size; i++) smartplant_set_solar_intensity(sm, i, size);
+  );
+  stage_stamp(sm, ALARM_FIELD_SOLAR, stage_us, stage_us); // one digital read per plant: no clock read of its own
+  TELEMETRY_TIME(TLM_STAGE_HUMIDITY,
+    scan_humidity(); // all mux channels in one sweep
+    for (uint8_t i = 0; i < size; i++) smartplant_set_sand_humidity(sm, i, size);
+  );
+  stage_stamp(sm, ALARM_FIELD_HUMIDITY, stage_us, esp_timer_get_time());
+#if ULP_HUMIDITY
+  ulp_batch_samples(stage_us); // batch drained at the start of the stage
+#endif
+  TELEMETRY_TIME(TLM_STAGE_ALARM,
+    if (alarm_pending_set) { // new rules: swap the table between two evaluations
+      portENTER_CRITICAL(&alarm_mux);
+      alarm_table = alarm_pending;
+      alarm_pending_set = false;
+      portEXIT_CRITICAL(&alarm_mux);
+      alarm_reset(alarm_a, NUM_PLANTS);
+      adapt_load_thresholds();
+    }
+    for (uint8_t i = 0; i < size; i++) smartplant_set_alarm(sm, i, size); // changes wake the alarm task
+  );
+  TELEMETRY_TIME(TLM_STAGE_STATS,
+    for (uint8_t i = 0; i < size; i++) smartplant_set_stats(sm, i, size);
+  );
+  sm->cycles++; // Task2 sends only new data
 }
 
 void smartplant_set_temperature(SmartPlant_t* sm, uint8_t channel, uint8_t size) {
   if(channel < size){
-    sm[channel].temperature = get_temperature(); // Read temperature from the sensor
+    sm->prev_value[ALARM_FIELD_TEMPERATURE][channel] = sm->temperature[channel];
+    sm->temperature[channel] = get_temperature(sm->temp_ch[channel]); // Read temperature from the sensor
   }
 }
 
-void smartplant_set_solar_intensity(SmartPlant_t* sm, uint8_t channel, uint8_t size, uint8_t perip_ch) {
+void smartplant_set_solar_intensity(SmartPlant_t* sm, uint8_t channel, uint8_t size) {
   if(channel < size){
-    sm[channel].solar_intensity = read_solar_radiation(perip_ch); // Read solar intensity from the sensor
+    sm->prev_value[ALARM_FIELD_SOLAR][channel] = (float)sm->solar_intensity[channel];
+    sm->solar_intensity[channel] = read_solar_radiation(sm->solar_ch[channel]); // Read solar intensity from the sensor
   }
 }
 
-void smartplant_set_sand_humidity(SmartPlant_t* sm, uint8_t channel, uint8_t size, uint8_t perip_ch) {
+void smartplant_set_sand_humidity(SmartPlant_t* sm, uint8_t channel, uint8_t size) {
   if(channel < size){
-    sm[channel].sand_humidity = read_humidity(perip_ch); // Read sand humidity from the sensor
+    sm->prev_value[ALARM_FIELD_HUMIDITY][channel] = sm->sand_humidity[channel];
+    sm->sand_humidity[channel] = read_humidity(sm->humidity_ch[channel]); // Read sand humidity from the sensor
   }
 }
 
-void smartplant_set_alarm(SmartPlant_t* sm, uint8_t channel, uint8_t size, uint8_t perip_ch) {
+void smartplant_set_alarm(SmartPlant_t* sm, uint8_t channel, uint8_t size) {
   if(channel < size){
-    if (sm[channel].temperature > 30.0f) {
-      turn_led(perip_ch, true); // Turn on the LED if alarm is active
-      sm[channel].alarm = true; // Set the alarm status
-    } else {
-      turn_led(perip_ch, false); // Turn off the LED if alarm is inactive
-      sm[channel].alarm = false; // Set the alarm status
+    float value[ALARM_NUM_FIELDS];
+    value[ALARM_FIELD_TEMPERATURE] = sm->temperature[channel];
+    value[ALARM_FIELD_HUMIDITY] = sm->sand_humidity[channel];
+    value[ALARM_FIELD_SOLAR] = (float)sm->solar_intensity[channel];
+    uint8_t mask = alarm_eval(&alarm_table, alarm_a, channel, size, value, millis());
+    if (mask != sm->alarm_mask[channel]) {
+      sm->alarm_mask[channel] = mask;
+      sm->alarm[channel] = (mask != 0); // Set the alarm status
+      portENTER_CRITICAL(&alarm_mux);
+      if (alarm_event_us[channel] == 0) {
+        alarm_event_us[channel] = esp_timer_get_time(); // first change not yet dispatched
+      }
+      portEXIT_CRITICAL(&alarm_mux);
+      if (alarm_notify_task != NULL) {
+        xTaskNotifyGive(alarm_notify_task); // higher priority: runs before the next plant
+      }
     }
   }
 }
 
-void smartplant_display_data(SmartPlant_t* sm, uint8_t channel, uint8_t size) {
+void smartplant_set_stats(SmartPlant_t* sm, uint8_t channel, uint8_t size) {
   if(channel < size){
+    uint32_t humidity_hold = stat_hold[ALARM_FIELD_HUMIDITY];
+#if ULP_HUMIDITY
+    bool ulp = sm->humidity_ch[channel] == HUMIDITY_1_ch;
+    humidity_hold = ulp ? 0 : humidity_hold; // the ULP samples cover the period, not the last average
+#endif
+    portENTER_CRITICAL(&stat_mux); // a hold of 0 pushes nothing: field not read by this run
+    if (!isnan(sm->temperature[channel])) { // no sensor in degraded mode
+      rollstat_push_n(&stat_a[ALARM_FIELD_TEMPERATURE][channel], sm->temperature[channel], stat_hold[ALARM_FIELD_TEMPERATURE]);
+    }
+    if (!isnan(sm->sand_humidity[channel])) {
+      rollstat_push_n(&stat_a[ALARM_FIELD_HUMIDITY][channel], sm->sand_humidity[channel], humidity_hold);
+    }
+    rollstat_push_n(&stat_a[ALARM_FIELD_SOLAR][channel], (float)sm->solar_intensity[channel],
+                    stat_hold[ALARM_FIELD_SOLAR]); // mean: fraction of low light
+#if ULP_HUMIDITY
+    for (uint8_t k = 0; ulp && k < ulp_sample_n; k++) {
+      rollstat_push(&stat_a[ALARM_FIELD_HUMIDITY][channel], ulp_sample[k]);
+    }
+#endif
+    portEXIT_CRITICAL(&stat_mux);
+  }
+}
+
+bool smartplant_get_stats(uint8_t channel, uint8_t field, uint8_t size, RollStatValue_t* out) {
+  if(channel < size && field < ALARM_NUM_FIELDS){
+    portENTER_CRITICAL(&stat_mux);
+    rollstat_get(&stat_a[field][channel], out);
+    portEXIT_CRITICAL(&stat_mux);
+    return true;
+  }
+  return false;
+}
+
+bool smartplant_alarm_init() {
+  Preferences prefs;
+  AlarmBlob_t blob = {};
+  bool from_nvs = false;
+  if (prefs.begin(ALARM_NVS_NAMESPACE, true)) {
+    size_t len = prefs.getBytes("rules", &blob, sizeof(blob));
+    prefs.end();
+    from_nvs = len >= 4 && blob.version == ALARM_NVS_VERSION && blob.count <= ALARM_MAX_RULES &&
+               len == 4 + blob.count * sizeof(AlarmRule_t) &&
+               blob.crc == frame_crc16((const uint8_t*)blob.rule, blob.count * sizeof(AlarmRule_t)) &&
+               alarm_compile(&alarm_table, blob.rule, blob.count);
+  }
+  if (!from_nvs) {
+    alarm_compile(&alarm_table, alarm_default, sizeof(alarm_default) / sizeof(alarm_default[0]));
+  }
+  alarm_reset(alarm_a, NUM_PLANTS);
+  adapt_load_thresholds();
+  DEBUG_PRINT("Alarm: %u rules from %s\n", alarm_table.count, from_nvs ? "NVS" : "firmware");
+  return from_nvs;
+}
+
+bool smartplant_alarm_store(const AlarmRule_t* rules, uint8_t count) {
+  AlarmTable_t table;
+  if (!alarm_compile(&table, rules, count)) {
+    return false;
+  }
+  AlarmBlob_t blob = {};
+  blob.version = ALARM_NVS_VERSION;
+  blob.count = count;
+  memcpy(blob.rule, rules, count * sizeof(AlarmRule_t));
+  blob.crc = frame_crc16((const uint8_t*)blob.rule, count * sizeof(AlarmRule_t));
+  Preferences prefs;
+  bool saved = prefs.begin(ALARM_NVS_NAMESPACE, false) &&
+               prefs.putBytes("rules", &blob, 4 + count * sizeof(AlarmRule_t)) > 0;
+  prefs.end();
+  portENTER_CRITICAL(&alarm_mux);
+  alarm_pending = table; // applied by the next alarm stage
+  alarm_pending_set = true;
+  portEXIT_CRITICAL(&alarm_mux);
+  return saved;
+}
+
+void smartplant_alarm_set_notify(TaskHandle_t task) {
+  alarm_notify_task = task;
+}
+
+void smartplant_alarm_dispatch(SmartPlant_t* sm, uint8_t size) {
+  uint32_t led_on = 0; // plants sharing a LED: on if any of them is in alarm
+  for (uint8_t i = 0; i < size; i++) {
+    led_on |= (uint32_t)sm->alarm[i] << sm->led_ch[i];
+  }
+  for (uint8_t i = 0; i < size; i++) {
+    turn_led(sm->led_ch[i], (led_on >> sm->led_ch[i]) & 1);
+  }
+  for (uint8_t i = 0; i < size; i++) {
+    portENTER_CRITICAL(&alarm_mux);
+    int64_t t0 = alarm_event_us[i];
+    alarm_event_us[i] = 0;
+    portEXIT_CRITICAL(&alarm_mux);
+    if (t0 == 0) {
+      continue;
+    }
+    if (deviceConnected) {
+      ble_transmit_alarm(i, sm->alarm_mask[i]);
+    }
+    uint32_t latency_us = (uint32_t)(esp_timer_get_time() - t0);
+    alarm_latency.events++;
+    alarm_latency.last_us = latency_us;
+    alarm_latency.max_us = latency_us > alarm_latency.max_us ? latency_us : alarm_latency.max_us;
+    alarm_latency.sum_us += latency_us;
+    telemetry_emit(TLM_TIMING, TLM_STAGE_ALARM_NOTIFY, latency_us);
+    LOG_I(LOG_FMT_ALARM_EVENT, i, sm->alarm_mask[i], latency_us);
+  }
+}
+
+void smartplant_alarm_print() {
+  if (alarm_latency.events > 0) {
+    DEBUG_PRINT("Alarm events %u: last %u us, avg %u us, max %u us\n", alarm_latency.events, alarm_latency.last_us,
+                (uint32_t)(alarm_latency.sum_us / alarm_latency.events), alarm_latency.max_us);
+  }
+}
+
+uint32_t smartplant_next_interval(SmartPlant_t* sm, uint8_t size) {
+#if ADAPTIVE_SAMPLING
+  static float value[ALARM_NUM_FIELDS * NUM_PLANTS]; // Task1 only
+  if (size > NUM_PLANTS) {
+    return ADAPT_MIN_MS;
+  }
+  for (uint8_t i = 0; i < size; i++) {
+    value[ALARM_FIELD_TEMPERATURE * size + i] = sm->temperature[i];
+    value[ALARM_FIELD_HUMIDITY * size + i] = sm->sand_humidity[i];
+    value[ALARM_FIELD_SOLAR * size + i] = (float)sm->solar_intensity[i];
+  }
+  return adapt_update(&SM_adapt, value, size, millis());
+#else
+  return SM_adapt.min_ms; // fixed period, set by the configuration
+#endif
+}
+
+void smartplant_display_data(SmartPlant_t* sm, uint8_t channel, uint8_t size) {
+  if(channel < size && boot_ready(BOOT_DEV_OLED)){
     display.clearDisplay();
     display.setCursor(0,0);
     display.println("Smart Plant Monitor");
     display.setCursor(0,10);
     display.print("Temp: ");
-    display.print(sm[channel].temperature);
-    display.println(" C");
+    if (isnan(sm->temperature[channel])) {
+      display.println("--"); // no sensor
+    } else {
+      display.print(sm->temperature[channel]);
+      display.println(" C");
+    }
     display.setCursor(0,20);
     display.print("Solar intensity ");
-    if (sm[channel].solar_intensity == 1) {
+    if (sm->solar_intensity[channel] == 1) {
         display.println("Low");
     } else {
         display.println("High");
     }
     display.setCursor(0,31);
     display.print("Sand Humidity: ");
-    display.print(sm[channel].sand_humidity);
+    display.print(sm->sand_humidity[channel]);
+    display.println("%");
+    if (size > 1) {
+      display.setCursor(0,42);
+      display.print("Plant ");
+      display.print(channel + 1);
+      display.print("/");
+      display.println(size);
+    }
+    RollStatValue_t temp, hum;
+    smartplant_get_stats(channel, ALARM_FIELD_TEMPERATURE, size, &temp);
+    smartplant_get_stats(channel, ALARM_FIELD_HUMIDITY, size, &hum);
+    display.setCursor(0,53);
+    display.print("T ");
+    display.print(temp.min, 1);
+    display.print("/");
+    display.print(temp.max, 1);
+    display.print(" H ");
+    display.print(hum.mean, 1);
     display.println("%");
     
     display.display();
   }
-}
\ No newline at end of file
+}
+
+bool smartplant_history_init() {
+  history_ready = flash_init(&history_flash, TSDB_PARTITION_LABEL) && tsdb_mount(&SM_history, &history_flash);
+  if (history_ready) {
+    history_offset_us = (int64_t)(tsdb_last_ts(&SM_history) + 1) * 1000000;
+    DEBUG_PRINT("History: %u sectors, last ts %u, %u torn blocks\n",
+                SM_history.count, tsdb_last_ts(&SM_history), SM_history.stats.torn_blocks);
+  } else {
+    Serial.println("History partition not found");
+  }
+  return history_ready;
+}
+
+void smartplant_history_append(SmartPlant_t* sm, uint8_t channel, uint8_t size) {
+  if(channel < size && history_ready && !isnan(sm->temperature[channel])){ // no missing field in a record
+    PlantRecord_t r;
+    smartplant_get_record(sm, channel, size, &r);
+#if ULP_HUMIDITY
+    if (sm->humidity_ch[channel] == HUMIDITY_1_ch) { // ULP samples first, with the other fields of this run
+      TsdbSample_t u = r.s;
+      uint16_t ms;
+      for (uint8_t k = 0; k < ulp_sample_n; k++) {
+        history_time(ulp_sample_us[k], &u.ts, &ms);
+        u.humidity = (uint16_t)lroundf(ulp_sample[k] * 10.0f);
+        tsdb_append(&SM_history, &u);
+      }
+    }
+#endif
+    tsdb_append(&SM_history, &r.s); // same second twice is rejected
+  } else if (history_ready) {
+    tsdb_flush_aged(&SM_history, smartplant_history_ts()); // no sample: keep the power loss bound
+  }
+}
+
+uint32_t smartplant_history_ts() {
+  uint32_t ts;
+  uint16_t ms;
+  history_time(esp_timer_get_time(), &ts, &ms);
+  return ts;
+}
+
+bool smartplant_get_aligned(const SmartPlant_t* sm, uint8_t channel, uint8_t size, int64_t at_us,
+                            float value[ALARM_NUM_FIELDS]) {
+  if (channel >= size) {
+    return false;
+  }
+  value[ALARM_FIELD_TEMPERATURE] = sm->temperature[channel];
+  value[ALARM_FIELD_HUMIDITY] = sm->sand_humidity[channel];
+  value[ALARM_FIELD_SOLAR] = (float)sm->solar_intensity[channel];
+  for (uint8_t f = 0; f < ALARM_NUM_FIELDS; f++) {
+    int64_t t1 = sample_mid_us(&sm->sample_time[f]);
+    int64_t t0 = sm->prev_us[f];
+    float v0 = sm->prev_value[f][channel];
+    if (t0 == 0 || at_us >= t1 || isnan(v0) || isnan(value[f])) {
+      continue; // newest reading
+    }
+    if (at_us <= t0 || f == ALARM_FIELD_SOLAR) {
+      value[f] = v0; // status held until the next reading
+    } else {
+      value[f] = v0 + (value[f] - v0) * (float)(at_us - t0) / (float)(t1 - t0);
+    }
+  }
+  return true;
+}
+
+bool smartplant_get_record(const SmartPlant_t* sm, uint8_t channel, uint8_t size, PlantRecord_t* out) {
+  float value[ALARM_NUM_FIELDS];
+  int64_t at_us = INT64_MAX;
+  for (uint8_t f = 0; channel < size && f < ALARM_NUM_FIELDS; f++) {
+    const SampleTime_t* t = &sm->sample_time[f];
+    if (t->at_us >= sm->cycle_us && sample_mid_us(t) < at_us) {
+      at_us = sample_mid_us(t); // first reading of the last run
+    }
+  }
+  if (!smartplant_get_aligned(sm, channel, size, at_us != INT64_MAX ? at_us : sm->cycle_us, value)) {
+    return false;
+  }
+  out->plant = channel;
+  history_time(at_us != INT64_MAX ? at_us : sm->cycle_us, &out->s.ts, &out->ms);
+  out->s.temperature = isnan(value[ALARM_FIELD_TEMPERATURE]) ? RECORD_TEMP_NONE :
+                       (int16_t)lroundf(value[ALARM_FIELD_TEMPERATURE] * 10.0f);
+  out->s.humidity = (uint16_t)lroundf(value[ALARM_FIELD_HUMIDITY] * 10.0f);
+  out->s.solar = (uint8_t)value[ALARM_FIELD_SOLAR];
+  out->s.alarm = sm->alarm[channel] ? 1 : 0;
+  return true;
+}
+
+bool smartplant_history_request(const uint8_t* data, size_t len) {
+  HistoryQuery_t q;
+  if (len != sizeof(HistoryQuery_t)) {
+    return false;
+  }
+  memcpy(&q, data, sizeof(q));
+  if (q.field >= ALARM_NUM_FIELDS || q.mode >= DOWNSAMPLE_NUM_MODES ||
+      q.points < 3 || q.points > HISTORY_MAX_POINTS || (q.to != 0 && q.to < q.from)) {
+    return false;
+  }
+  portENTER_CRITICAL(&history_mux);
+  history_query = q;
+  history_query_set = true;
+  portEXIT_CRITICAL(&history_mux);
+  if (history_notify_task != NULL) {
+    xTaskNotifyGive(history_notify_task); // run the query now, not at the next sample
+  }
+  return true;
+}
+
+void smartplant_history_set_notify(TaskHandle_t task) {
+  history_notify_task = task;
+}
+
+void smartplant_history_run() {
+  if (!history_query_set || history_out_ready || !history_ready) {
+    return;
+  }
+  HistoryPass_t pass = {};
+  HistoryQuery_t q;
+  portENTER_CRITICAL(&history_mux);
+  q = history_query;
+  history_query_set = false;
+  portEXIT_CRITICAL(&history_mux);
+  int64_t start_us = esp_timer_get_time();
+  history_out_last = tsdb_last_ts(&SM_history);
+  uint32_t to = q.to != 0 ? q.to : history_out_last;
+  history_out_count = 0;
+  pass.field = q.field;
+  if (q.from <= to && downsample_init(&pass.ds, q.mode, q.from, to, q.points, history_collect, NULL)) {
+    tsdb_query(&SM_history, q.from, to, history_push, &pass); // one pass, RAM block included
+    downsample_finish(&pass.ds);
+  }
+  LOG_I(LOG_FMT_HISTORY_QUERY, pass.ds.in, history_out_count, (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+  history_out_ready = true;
+}
+
+void smartplant_history_send() {
+  if (history_out_ready) {
+    ble_transmit_history(history_out, history_out_count, history_out_last);
+    history_out_ready = false;
+  }
+}
@@ -0,0 +1,217 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file stress.c
+ * @brief Load stress harness: synthetic sensors, Task1 period sweep and saturation point
+ *
+ * This implementation file provides the synthetic temperature sensors, the stage hooks
+ * counting the CPU time of the tasks and the sweep task.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "stress.h"
+
+#if STRESS_MODE
+#include "config.h"
+#include "HAL/ble_hal.h"
+#include "esp_timer.h"
+#include <math.h>
+
+extern SmartPlant_t SM_list;
+
+static portMUX_TYPE stress_mux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t stage_start_us[STRESS_NUM_CORES][STRESS_MAX_DEPTH];
+static int64_t stage_child_us[STRESS_NUM_CORES][STRESS_MAX_DEPTH]; // nested stages of higher priority tasks
+static uint8_t stage_depth[STRESS_NUM_CORES];
+static uint64_t busy_us[STRESS_NUM_CORES];
+static uint32_t task1_max_us = 0;
+
+static_assert(STRESS_TASK_CORE == 0, "the idle time read by the stress task is the one of core 0");
+
+// idle time of the core of the caller: run time stats of ESP-IDF, esp_timer clock (us)
+static uint32_t idle_us() {
+#if configGENERATE_RUN_TIME_STATS
+  return ulTaskGetIdleRunTimeCounter();
+#else
+  return 0;
+#endif
+}
+
+static bool task_stage(uint8_t stage) {
+  return stage == TLM_STAGE_TASK1 || stage == TLM_STAGE_TASK2 || stage == TLM_STAGE_TASK3;
+}
+
+static void snapshot(uint64_t* busy, uint32_t* task1_max, bool reset_max) {
+  portENTER_CRITICAL(&stress_mux);
+  for (uint8_t c = 0; c < STRESS_NUM_CORES; c++) {
+    busy[c] = busy_us[c];
+  }
+  *task1_max = task1_max_us;
+  if (reset_max) {
+    task1_max_us = 0;
+  }
+  portEXIT_CRITICAL(&stress_mux);
+}
+
+// run a window at the given period, false if the configuration is refused
+static bool stress_step(const Config_t* base, uint16_t task1_ms, StressStep_t* r) {
+  Config_t c = *base;
+  c.task1_ms = task1_ms;
+  c.sample_max_ms = c.sample_max_ms < task1_ms ? task1_ms : c.sample_max_ms;
+  if (!config_store(&c)) {
+    return false;
+  }
+  vTaskDelay(pdMS_TO_TICKS(STRESS_SETTLE_MS + task1_ms)); // applied by the next Task1 cycle
+
+  uint64_t busy0[STRESS_NUM_CORES], busy1[STRESS_NUM_CORES];
+  uint32_t sent0, dropped0, sent1, dropped1, max_us;
+  snapshot(busy0, &max_us, true);
+  ble_get_notify_stats(&sent0, &dropped0);
+  uint32_t samples0 = SM_list.cycles;
+  uint32_t idle0 = idle_us();
+  int64_t start_us = esp_timer_get_time();
+  vTaskDelay(pdMS_TO_TICKS(STRESS_STEP_MS));
+  int64_t elapsed_us = esp_timer_get_time() - start_us;
+  uint32_t idle = idle_us() - idle0;
+  uint32_t samples = SM_list.cycles - samples0;
+  ble_get_notify_stats(&sent1, &dropped1);
+  snapshot(busy1, &max_us, false);
+
+  uint32_t expected = (uint32_t)(elapsed_us / 1000 / task1_ms);
+  r->plants = NUM_PLANTS;
+  r->centrals = ble_get_centrals();
+  r->task1_ms = task1_ms;
+  r->elapsed_ms = (uint32_t)(elapsed_us / 1000);
+  r->samples = samples;
+  r->dropped_samples = expected > samples + 1 ? expected - samples : 0; // one period of window edge
+  r->task1_max_us = max_us;
+  r->cpu0_pct = configGENERATE_RUN_TIME_STATS && elapsed_us > 0 ? 100.0f - (float)idle * 100.0f / (float)elapsed_us : NAN;
+  r->cpu0_pct = r->cpu0_pct < 0.0f ? 0.0f : r->cpu0_pct;
+  uint64_t busy = busy1[STRESS_FW_CORE] - busy0[STRESS_FW_CORE];
+  r->cpu1_pct = elapsed_us > 0 ? (float)busy * 100.0f / (float)elapsed_us : 0.0f;
+  r->cpu1_pct = r->cpu1_pct > 100.0f ? 100.0f : r->cpu1_pct; // stage open across the window edge
+  r->notify_sent = sent1 - sent0;
+  r->notify_dropped = dropped1 - dropped0;
+  return true;
+}
+
+static bool stress_failed(const StressStep_t* r) {
+  return r->dropped_samples > 0 || r->notify_dropped > 0;
+}
+
+static void StressTask(void* pvParameters) {
+  static const uint16_t rates_ms[] = { STRESS_RATES_MS };
+  static const uint8_t num_rates = sizeof(rates_ms) / sizeof(rates_ms[0]);
+  static StressStep_t r[num_rates];
+  bool done[num_rates];
+  Config_t saved = *config_get();
+
+  vTaskDelay(pdMS_TO_TICKS(STRESS_WARMUP_MS));
+  Serial.printf("%s,plants,centrals,task1_ms,elapsed_ms,samples,dropped_samples,task1_max_us,"
+                "cpu0_pct,cpu1_pct,notify_sent,notify_dropped\n", STRESS_PREFIX);
+  for (uint8_t i = 0; i < num_rates; i++) {
+    done[i] = stress_step(&saved, rates_ms[i], &r[i]);
+    if (!done[i]) {
+      Serial.printf("Stress: Task1 period %u ms refused by the configuration bounds\n", rates_ms[i]);
+      continue;
+    }
+    stress_print(&r[i]);
+  }
+  // slowest period from which every faster one fails
+  int sat = -1;
+  for (int i = num_rates - 1; i >= 0; i--) {
+    if (!done[i]) {
+      continue;
+    }
+    if (!stress_failed(&r[i])) {
+      break;
+    }
+    sat = i;
+  }
+  // failing windows at slower periods, between passing ones: reported, not hidden
+  uint8_t failed = 0;
+  uint16_t failed_ms = 0;
+  for (int i = 0; i < (sat >= 0 ? sat : num_rates); i++) {
+    if (done[i] && stress_failed(&r[i])) {
+      failed_ms = failed == 0 ? r[i].task1_ms : failed_ms; // fastest last: the first is the slowest
+      failed++;
+    }
+  }
+  if (sat >= 0) {
+    Serial.printf("%s,%u,%u,%u,%s,%u,%u\n", STRESS_SAT_PREFIX, r[sat].plants, r[sat].centrals, r[sat].task1_ms,
+                  r[sat].dropped_samples > 0 ? (r[sat].notify_dropped > 0 ? "samples+notify" : "samples") : "notify",
+                  failed, failed_ms);
+  } else {
+    Serial.printf("%s,%u,%u,0,none,%u,%u\n", STRESS_SAT_PREFIX, NUM_PLANTS, ble_get_centrals(), failed, failed_ms);
+  }
+  config_store(&saved); // configuration in use before the sweep
+  vTaskDelete(NULL);
+}
+#endif
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+#if STRESS_MODE
+void telemetry_stage_begin(uint8_t stage) {
+  if (!task_stage(stage)) {
+    return;
+  }
+  int64_t now_us = esp_timer_get_time();
+  uint8_t core = (uint8_t)xPortGetCoreID() % STRESS_NUM_CORES;
+  portENTER_CRITICAL(&stress_mux);
+  uint8_t d = stage_depth[core]++;
+  if (d < STRESS_MAX_DEPTH) {
+    stage_start_us[core][d] = now_us;
+    stage_child_us[core][d] = 0;
+  }
+  portEXIT_CRITICAL(&stress_mux);
+}
+
+void telemetry_stage_end(uint8_t stage) {
+  if (!task_stage(stage)) {
+    return;
+  }
+  int64_t now_us = esp_timer_get_time();
+  uint8_t core = (uint8_t)xPortGetCoreID() % STRESS_NUM_CORES;
+  portENTER_CRITICAL(&stress_mux);
+  if (stage_depth[core] > 0) {
+    uint8_t d = --stage_depth[core];
+    if (d < STRESS_MAX_DEPTH) {
+      int64_t span_us = now_us - stage_start_us[core][d];
+      busy_us[core] += span_us - stage_child_us[core][d]; // preempting stages counted by their own end
+      if (d > 0 && d - 1 < STRESS_MAX_DEPTH) {
+        stage_child_us[core][d - 1] += span_us;
+      }
+      if (stage == TLM_STAGE_TASK1 && span_us > task1_max_us) {
+        task1_max_us = (uint32_t)span_us;
+      }
+    }
+  }
+  portEXIT_CRITICAL(&stress_mux);
+}
+
+void stress_init() {
+  xTaskCreatePinnedToCore(StressTask, "Stress", 3072, NULL, STRESS_TASK_PRIO, NULL, STRESS_TASK_CORE);
+}
+
+float stress_temperature(uint8_t sensor) {
+  delayMicroseconds(STRESS_SENSOR_US); // bus time of the real read
+  return 22.0f + 10.5f * sinf(2.0f * (float)M_PI * (float)(esp_timer_get_time() / 1000) / (STRESS_TEMP_PERIOD_S * 1000.0f));
+}
+
+void stress_print(const StressStep_t* r) {
+  Serial.printf("%s,%u,%u,%u,%u,%u,%u,%u,%.1f,%.1f,%u,%u\n", STRESS_PREFIX, r->plants, r->centrals, r->task1_ms,
+                r->elapsed_ms, r->samples, r->dropped_samples, r->task1_max_us, r->cpu0_pct, r->cpu1_pct,
+                r->notify_sent, r->notify_dropped);
+}
+#endif
@@ -0,0 +1,140 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file telemetry.c
+ * @brief Binary telemetry stream over UART
+ *
+ * This implementation file queues telemetry records from any task and sends them in
+ * batches of COBS + CRC16 frames from a dedicated task.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "telemetry.h"
+
+#if TELEMETRY_MODE
+#include "HAL/power_hal.h"
+#include "HAL/ulp_hal.h"
+
+extern Power_t power_a[NUM_PM_LOCKS]; // array of PM locks
+
+static QueueHandle_t tlm_queue = NULL;
+static TaskHandle_t tlm_capture_task = NULL;
+static uint8_t tlm_capture_pin = 0;
+static uint16_t tlm_seq = 0;
+
+static void tlm_write_frame(const uint8_t* payload, size_t len) {
+  uint8_t frame[1 + FRAME_MAX_ENCODED(TLM_HEADER_SIZE + TELEMETRY_BATCH * sizeof(TlmRecord_t))];
+  frame[0] = FRAME_DELIMITER; // leading delimiter: boot text before a frame never corrupts it
+  size_t n = frame_encode(payload, len, &frame[1], sizeof(frame) - 1);
+  if (n > 0) {
+    Serial.write(frame, n + 1); // one call per frame, frames from different tasks never interleave
+  }
+}
+
+static void tlm_tx_task(void *pvParameters) {
+  uint8_t payload[TLM_HEADER_SIZE + TELEMETRY_BATCH * sizeof(TlmRecord_t)];
+  payload[0] = TLM_FRAME_RECORDS;
+  payload[1] = TLM_VERSION;
+  while (true) {
+    uint8_t count = 0;
+    TlmRecord_t* rec = (TlmRecord_t*)&payload[TLM_HEADER_SIZE];
+    // wait for the first record, then take what is already queued
+    if (xQueueReceive(tlm_queue, &rec[count], pdMS_TO_TICKS(10)) == pdTRUE) {
+      count++;
+      while (count < TELEMETRY_BATCH && xQueueReceive(tlm_queue, &rec[count], 0) == pdTRUE) {
+        count++;
+      }
+      payload[2] = count;
+      tlm_write_frame(payload, TLM_HEADER_SIZE + count * sizeof(TlmRecord_t));
+    }
+  }
+}
+
+static void tlm_capture_timer(void* arg) {
+  xTaskNotifyGive(tlm_capture_task);
+}
+
+static void tlm_capture(void *pvParameters) {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    power_lock_acquire(power_a, PM_LOCK_ADC_ch, NUM_PM_LOCKS);
+    uint16_t raw = analogRead(tlm_capture_pin);
+    power_lock_release(power_a, PM_LOCK_ADC_ch, NUM_PM_LOCKS);
+    telemetry_emit(TLM_RAW_CAPTURE, tlm_capture_pin, raw);
+  }
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void telemetry_init(uint8_t capture_pin){
+  tlm_queue = xQueueCreate(TELEMETRY_QUEUE_SIZE, sizeof(TlmRecord_t));
+  xTaskCreatePinnedToCore(tlm_tx_task, "tlm tx", 3072, NULL, TELEMETRY_TASK_PRIO, NULL, TELEMETRY_TASK_CORE);
+#if TELEMETRY_RAW_RATE_HZ > 0 && !ULP_HUMIDITY
+  tlm_capture_pin = capture_pin;
+  xTaskCreatePinnedToCore(tlm_capture, "tlm capture", 2048, NULL, TELEMETRY_TASK_PRIO + 1, &tlm_capture_task, TELEMETRY_TASK_CORE);
+  const esp_timer_create_args_t args = {
+    .callback = tlm_capture_timer,
+    .arg = NULL,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "tlm capture"
+  };
+  esp_timer_handle_t timer;
+  if (esp_timer_create(&args, &timer) == ESP_OK) {
+    esp_timer_start_periodic(timer, 1000000 / TELEMETRY_RAW_RATE_HZ);
+  }
+#endif
+}
+
+void telemetry_emit(uint8_t type, uint8_t channel, uint32_t value){
+  if (tlm_queue == NULL) {
+    return;
+  }
+  TlmRecord_t rec;
+  rec.type = type;
+  rec.channel = channel;
+  rec.seq = __atomic_fetch_add(&tlm_seq, 1, __ATOMIC_RELAXED);
+  rec.ts_us = micros();
+  rec.value = value;
+  xQueueSend(tlm_queue, &rec, 0);
+}
+
+void telemetry_emit_float(uint8_t field, float value){
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  telemetry_emit(TLM_FILTERED, field, bits);
+}
+
+void telemetry_send_log(const LogRecord_t* rec){
+  uint8_t payload[TLM_HEADER_SIZE + sizeof(LogRecord_t)];
+  payload[0] = TLM_FRAME_LOG;
+  payload[1] = TLM_VERSION;
+  payload[2] = 1;
+  memcpy(&payload[TLM_HEADER_SIZE], rec, sizeof(LogRecord_t));
+  tlm_write_frame(payload, sizeof(payload));
+}
+
+void telemetry_send_records(const PlantRecord_t* r, uint8_t count){
+  uint8_t payload[TLM_HEADER_SIZE + RECORD_BATCH_SIZE(TELEMETRY_PLANT_RECORDS)];
+  payload[0] = TLM_FRAME_PLANT;
+  payload[1] = TLM_VERSION;
+  for (uint8_t i = 0; i < count; i += TELEMETRY_PLANT_RECORDS){
+    uint8_t n = count - i < TELEMETRY_PLANT_RECORDS ? count - i : TELEMETRY_PLANT_RECORDS;
+    payload[2] = n;
+    size_t len = record_encode(&r[i], n, &payload[TLM_HEADER_SIZE], sizeof(payload) - TLM_HEADER_SIZE);
+    if (len > 0){
+      tlm_write_frame(payload, TLM_HEADER_SIZE + len);
+    }
+  }
+}
+
+#endif /* TELEMETRY_MODE */
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file timesync.c
+ * @brief Wall clock sync
+ *
+ * This implementation file provides the offset between the esp_timer clock and the wall
+ * clock written by a BLE client.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "timesync.h"
+#include "esp_timer.h"
+
+static int64_t offset_us = 0; // Unix time minus esp_timer time
+static bool synced = false;
+static uint32_t syncs = 0;
+static int32_t last_correction_ms = 0;
+static int64_t synced_at_us = 0;
+static portMUX_TYPE timesync_mux = portMUX_INITIALIZER_UNLOCKED; // 64-bit offset read by Task1 and Task2
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool timesync_request(const uint8_t* data, size_t len) {
+  if (len != sizeof(uint64_t)) {
+    return false;
+  }
+  uint64_t unix_ms = 0;
+  for (uint8_t i = 0; i < sizeof(uint64_t); i++) {
+    unix_ms |= (uint64_t)data[i] << (8 * i);
+  }
+  return timesync_set(unix_ms, esp_timer_get_time());
+}
+
+bool timesync_set(uint64_t unix_ms, int64_t now_us) {
+  if (unix_ms < TIMESYNC_MIN_UNIX_MS) {
+    return false;
+  }
+  int64_t offset = (int64_t)unix_ms * 1000 - now_us;
+  portENTER_CRITICAL(&timesync_mux);
+  int64_t correction_ms = synced ? (offset - offset_us) / 1000 : 0;
+  uint32_t after_s = synced ? (uint32_t)((now_us - synced_at_us) / 1000000) : 0;
+  last_correction_ms = (int32_t)(correction_ms > INT32_MAX ? INT32_MAX : (correction_ms < INT32_MIN ? INT32_MIN : correction_ms));
+  offset_us = offset;
+  synced = true;
+  synced_at_us = now_us;
+  syncs++;
+  portEXIT_CRITICAL(&timesync_mux);
+  LOG_I(LOG_FMT_TIME_SYNC, syncs, last_correction_ms, after_s);
+  return true;
+}
+
+bool timesync_to_unix_us(int64_t at_us, int64_t* unix_us) {
+  portENTER_CRITICAL(&timesync_mux);
+  bool ok = synced;
+  *unix_us = at_us + offset_us;
+  portEXIT_CRITICAL(&timesync_mux);
+  return ok;
+}
+
+void timesync_print() {
+  portENTER_CRITICAL(&timesync_mux);
+  bool ok = synced;
+  uint32_t n = syncs;
+  int32_t correction_ms = last_correction_ms;
+  int64_t at_us = synced_at_us;
+  portEXIT_CRITICAL(&timesync_mux);
+  if (ok) {
+    DEBUG_PRINT("Wall clock: %u syncs, last %u s ago, correction %d ms\n", n,
+                (uint32_t)((esp_timer_get_time() - at_us) / 1000000), correction_ms);
+  } else {
+    DEBUG_PRINT("Wall clock: not synced\n");
+  }
+}
@@ -0,0 +1,450 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file tsdb.c
+ * @brief Append-only time-series store on a flash partition
+ *
+ * This implementation file provides the delta/bit-packed encoding of samples, the
+ * circular sector management and the power-loss tolerant mount.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <string.h>
+#include "tsdb.h"
+#include "frame.h"
+
+typedef struct
+{
+  uint32_t  from;
+  uint32_t  to;
+  bool      (*cb)(const TsdbSample_t* s, void* arg);
+  void*     arg;
+  uint32_t  found;
+  bool      stop;
+}TsdbQuery_t;
+
+/***********************************************************
+ Bitstream helpers
+***********************************************************/
+static void bits_put(uint8_t* buf, uint16_t* pos, uint32_t value, uint8_t nbits){
+  for (int8_t i = nbits - 1; i >= 0; i--){
+    if ((value >> i) & 1) {
+      buf[*pos >> 3] |= (uint8_t)(0x80 >> (*pos & 7));
+    }
+    (*pos)++;
+  }
+}
+
+static bool bits_get(const uint8_t* buf, uint16_t len, uint16_t* pos, uint8_t nbits, uint32_t* value){
+  if (*pos + nbits > len * 8) {
+    return false;
+  }
+  uint32_t v = 0;
+  for (uint8_t i = 0; i < nbits; i++){
+    v = (v << 1) | ((buf[*pos >> 3] >> (7 - (*pos & 7))) & 1);
+    (*pos)++;
+  }
+  *value = v;
+  return true;
+}
+
+static int32_t sign_extend(uint32_t v, uint8_t nbits){
+  uint32_t m = 1u << (nbits - 1);
+  return (int32_t)((v ^ m) - m);
+}
+
+static void put_value(uint8_t* buf, uint16_t* pos, int32_t prev, int32_t value){
+  int32_t d = value - prev;
+  if (d == 0) {
+    bits_put(buf, pos, 0x0, 1);
+  } else if (d >= -8 && d <= 7) {
+    bits_put(buf, pos, 0x2, 2);
+    bits_put(buf, pos, (uint32_t)d & 0xF, 4);
+  } else if (d >= -128 && d <= 127) {
+    bits_put(buf, pos, 0x6, 3);
+    bits_put(buf, pos, (uint32_t)d & 0xFF, 8);
+  } else {
+    bits_put(buf, pos, 0x7, 3);
+    bits_put(buf, pos, (uint32_t)value & 0xFFFF, 16);
+  }
+}
+
+static bool get_value(const uint8_t* buf, uint16_t len, uint16_t* pos, int32_t prev, bool is_signed, int32_t* value){
+  uint32_t b;
+  if (!bits_get(buf, len, pos, 1, &b)) return false;
+  if (b == 0) {
+    *value = prev;
+    return true;
+  }
+  if (!bits_get(buf, len, pos, 1, &b)) return false;
+  if (b == 0) {
+    if (!bits_get(buf, len, pos, 4, &b)) return false;
+    *value = prev + sign_extend(b, 4);
+    return true;
+  }
+  if (!bits_get(buf, len, pos, 1, &b)) return false;
+  if (b == 0) {
+    if (!bits_get(buf, len, pos, 8, &b)) return false;
+    *value = prev + sign_extend(b, 8);
+    return true;
+  }
+  if (!bits_get(buf, len, pos, 16, &b)) return false;
+  *value = is_signed ? sign_extend(b, 16) : (int32_t)b;
+  return true;
+}
+
+/***********************************************************
+ Block helpers
+***********************************************************/
+static void key_write(uint8_t* buf, const TsdbSample_t* s){
+  buf[0] = (uint8_t)s->ts;
+  buf[1] = (uint8_t)(s->ts >> 8);
+  buf[2] = (uint8_t)(s->ts >> 16);
+  buf[3] = (uint8_t)(s->ts >> 24);
+  buf[4] = (uint8_t)s->temperature;
+  buf[5] = (uint8_t)((uint16_t)s->temperature >> 8);
+  buf[6] = (uint8_t)s->humidity;
+  buf[7] = (uint8_t)(s->humidity >> 8);
+  buf[8] = s->solar;
+  buf[9] = s->alarm;
+}
+
+static void key_read(const uint8_t* buf, TsdbSample_t* s){
+  s->ts = (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+  s->temperature = (int16_t)(buf[4] | (buf[5] << 8));
+  s->humidity = (uint16_t)(buf[6] | (buf[7] << 8));
+  s->solar = buf[8];
+  s->alarm = buf[9];
+}
+
+// decode a block payload and call visit for each record, false if visit asked to stop
+static bool block_decode(const uint8_t* buf, uint16_t len, uint8_t count,
+                         bool (*visit)(const TsdbSample_t* s, void* arg), void* arg){
+  if (count == 0 || len < TSDB_KEY_BYTES) {
+    return true;
+  }
+  TsdbSample_t s;
+  key_read(buf, &s);
+  if (!visit(&s, arg)) {
+    return false;
+  }
+  uint16_t pos = TSDB_KEY_BYTES * 8;
+  uint32_t dt = 0;
+  for (uint8_t i = 1; i < count; i++){
+    uint32_t b;
+    int32_t v;
+    if (!bits_get(buf, len, &pos, 1, &b)) return true;
+    if (b == 1) {
+      if (!bits_get(buf, len, &pos, 1, &b)) return true;
+      if (b == 0) {
+        if (!bits_get(buf, len, &pos, 7, &b)) return true;
+        dt += sign_extend(b, 7);
+      } else {
+        if (!bits_get(buf, len, &pos, 32, &dt)) return true;
+      }
+    }
+    s.ts += dt;
+    if (!get_value(buf, len, &pos, s.temperature, true, &v)) return true;
+    s.temperature = (int16_t)v;
+    if (!get_value(buf, len, &pos, s.humidity, false, &v)) return true;
+    s.humidity = (uint16_t)v;
+    if (!bits_get(buf, len, &pos, 1, &b)) return true;
+    if (b == 1) {
+      if (!bits_get(buf, len, &pos, 8, &b)) return true;
+      s.solar = (uint8_t)b;
+      if (!bits_get(buf, len, &pos, 1, &b)) return true;
+      s.alarm = (uint8_t)b;
+    }
+    if (!visit(&s, arg)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool visit_last(const TsdbSample_t* s, void* arg){
+  *(TsdbSample_t*)arg = *s;
+  return true;
+}
+
+static bool visit_query(const TsdbSample_t* s, void* arg){
+  TsdbQuery_t* q = (TsdbQuery_t*)arg;
+  if (s->ts > q->to) {
+    q->stop = true;
+    return false;
+  }
+  if (s->ts >= q->from) {
+    q->found++;
+    if (!q->cb(s, q->arg)) {
+      q->stop = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+// scan the blocks of a sector, returns the offset after the last block
+static uint32_t sector_scan(Tsdb_t* db, uint16_t sector,
+                            bool (*visit)(const TsdbSample_t* s, void* arg), void* arg, bool* stopped){
+  Flash_t* f = db->flash;
+  uint32_t base = (uint32_t)sector * f->sector_size;
+  uint32_t off = TSDB_SECTOR_HEADER;
+  uint8_t buf[TSDB_BLOCK_HEADER + TSDB_BLOCK_BYTES];
+  while (off + TSDB_BLOCK_HEADER <= f->sector_size) {
+    if (!f->read(f, base + off, buf, TSDB_BLOCK_HEADER)) {
+      return f->sector_size;
+    }
+    uint16_t len = (uint16_t)(buf[0] | (buf[1] << 8));
+    uint8_t count = buf[2];
+    uint16_t crc = (uint16_t)(buf[3] | (buf[4] << 8));
+    if (len == 0xFFFF && count == 0xFF && crc == 0xFFFF) {
+      return off; // erased: end of data
+    }
+    if (len == 0 || len > TSDB_BLOCK_BYTES || off + TSDB_BLOCK_HEADER + len > f->sector_size) {
+      return f->sector_size; // torn header: seal the sector
+    }
+    if (!f->read(f, base + off + TSDB_BLOCK_HEADER, &buf[TSDB_BLOCK_HEADER], len)) {
+      return f->sector_size;
+    }
+    if (frame_crc16(&buf[TSDB_BLOCK_HEADER], len) != crc) {
+      db->stats.torn_blocks++;
+    } else if (visit != NULL && !block_decode(&buf[TSDB_BLOCK_HEADER], len, count, visit, arg)) {
+      if (stopped != NULL) {
+        *stopped = true;
+      }
+      return off;
+    }
+    off += TSDB_BLOCK_HEADER + len;
+  }
+  return off;
+}
+
+static bool sector_open(Tsdb_t* db, uint32_t first_ts){
+  Flash_t* f = db->flash;
+  uint16_t sector = 0;
+  if (db->count > 0) {
+    sector = (uint16_t)((db->order[db->count - 1] + 1) % f->sector_count);
+  }
+  // the sector to reuse holds the oldest data (round robin): drop it from the index
+  for (uint16_t i = 0; i < db->count; i++){
+    if (db->order[i] == sector) {
+      memmove(&db->order[i], &db->order[i + 1], (db->count - i - 1) * sizeof(db->order[0]));
+      memmove(&db->first_ts[i], &db->first_ts[i + 1], (db->count - i - 1) * sizeof(db->first_ts[0]));
+      db->count--;
+      break;
+    }
+  }
+  if (!f->erase(f, sector)) {
+    return false;
+  }
+  db->stats.erases++;
+
+  uint8_t hdr[TSDB_SECTOR_HEADER];
+  uint32_t seq = db->seq + 1;
+  uint32_t magic = TSDB_MAGIC;
+  memcpy(&hdr[0], &magic, 4);
+  memcpy(&hdr[4], &seq, 4);
+  memcpy(&hdr[8], &first_ts, 4);
+  hdr[12] = TSDB_VERSION;
+  hdr[13] = 0xFF;
+  uint16_t crc = frame_crc16(hdr, 14);
+  memcpy(&hdr[14], &crc, 2);
+  if (!f->write(f, (uint32_t)sector * f->sector_size, hdr, sizeof(hdr))) {
+    return false;
+  }
+  db->stats.bytes_written += sizeof(hdr);
+  db->order[db->count] = sector;
+  db->first_ts[db->count] = first_ts;
+  db->count++;
+  db->seq = seq;
+  db->write_off = TSDB_SECTOR_HEADER;
+  return true;
+}
+
+static void block_reset(Tsdb_t* db){
+  memset(db->block, 0, sizeof(db->block));
+  db->bit_pos = 0;
+  db->block_count = 0;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool tsdb_mount(Tsdb_t* db, Flash_t* flash){
+  memset(db, 0, sizeof(Tsdb_t));
+  db->flash = flash;
+  if (flash->sector_count > TSDB_MAX_SECTORS ||
+      flash->sector_size < TSDB_SECTOR_HEADER + TSDB_BLOCK_HEADER + TSDB_BLOCK_BYTES) {
+    return false;
+  }
+  block_reset(db);
+
+  uint32_t seqs[TSDB_MAX_SECTORS];
+  for (uint16_t s = 0; s < flash->sector_count; s++){
+    uint8_t hdr[TSDB_SECTOR_HEADER];
+    uint32_t magic, seq, first_ts;
+    uint16_t crc;
+    if (!flash->read(flash, (uint32_t)s * flash->sector_size, hdr, sizeof(hdr))) {
+      continue;
+    }
+    memcpy(&magic, &hdr[0], 4);
+    memcpy(&seq, &hdr[4], 4);
+    memcpy(&first_ts, &hdr[8], 4);
+    memcpy(&crc, &hdr[14], 2);
+    if (magic != TSDB_MAGIC || hdr[12] != TSDB_VERSION || crc != frame_crc16(hdr, 14)) {
+      continue;
+    }
+    // insertion sort by sequence number, oldest first
+    uint16_t i = db->count;
+    while (i > 0 && seqs[i - 1] > seq) {
+      seqs[i] = seqs[i - 1];
+      db->order[i] = db->order[i - 1];
+      db->first_ts[i] = db->first_ts[i - 1];
+      i--;
+    }
+    seqs[i] = seq;
+    db->order[i] = s;
+    db->first_ts[i] = first_ts;
+    db->count++;
+  }
+  if (db->count == 0) {
+    return true;
+  }
+  db->seq = seqs[db->count - 1];
+  // newest sample: newest sector, or an older one if its blocks are all torn
+  for (int16_t i = (int16_t)db->count - 1; i >= 0 && !db->has_last; i--){
+    TsdbSample_t last = {};
+    uint32_t off = sector_scan(db, db->order[i], visit_last, &last, NULL);
+    if (i == db->count - 1) {
+      db->write_off = off;
+    }
+    if (last.ts != 0) {
+      db->last = last;
+      db->has_last = true;
+    }
+  }
+  return true;
+}
+
+bool tsdb_append(Tsdb_t* db, const TsdbSample_t* s){
+  if (db->has_last && s->ts <= db->last.ts) {
+    return false;
+  }
+  if (db->block_count == 0) {
+    key_write(db->block, s);
+    db->block_ts = s->ts;
+    db->bit_pos = TSDB_KEY_BYTES * 8;
+    db->last_dt = 0;
+  } else {
+    uint32_t dt = s->ts - db->last.ts;
+    int32_t dod = (int32_t)(dt - db->last_dt);
+    if (dod == 0) {
+      bits_put(db->block, &db->bit_pos, 0x0, 1);
+    } else if (dod >= -64 && dod <= 63) {
+      bits_put(db->block, &db->bit_pos, 0x2, 2);
+      bits_put(db->block, &db->bit_pos, (uint32_t)dod & 0x7F, 7);
+    } else {
+      bits_put(db->block, &db->bit_pos, 0x3, 2);
+      bits_put(db->block, &db->bit_pos, dt, 32);
+    }
+    db->last_dt = dt;
+    put_value(db->block, &db->bit_pos, db->last.temperature, s->temperature);
+    put_value(db->block, &db->bit_pos, db->last.humidity, s->humidity);
+    if (s->solar == db->last.solar && s->alarm == db->last.alarm) {
+      bits_put(db->block, &db->bit_pos, 0x0, 1);
+    } else {
+      bits_put(db->block, &db->bit_pos, 0x1, 1);
+      bits_put(db->block, &db->bit_pos, s->solar, 8);
+      bits_put(db->block, &db->bit_pos, s->alarm ? 1 : 0, 1);
+    }
+  }
+  db->block_count++;
+  db->last = *s;
+  db->last.alarm = s->alarm ? 1 : 0;
+  db->has_last = true;
+  db->stats.samples++;
+  if (db->block_count >= TSDB_BLOCK_RECORDS || db->bit_pos + TSDB_MAX_RECORD_BITS > TSDB_BLOCK_BYTES * 8 ||
+      s->ts - db->block_ts >= TSDB_FLUSH_S) {
+    return tsdb_flush(db);
+  }
+  return true;
+}
+
+bool tsdb_flush_aged(Tsdb_t* db, uint32_t now){
+  if (db->block_count == 0 || now - db->block_ts < TSDB_FLUSH_S) {
+    return true;
+  }
+  return tsdb_flush(db);
+}
+
+bool tsdb_flush(Tsdb_t* db){
+  if (db->block_count == 0) {
+    return true;
+  }
+  Flash_t* f = db->flash;
+  uint16_t len = (uint16_t)((db->bit_pos + 7) / 8);
+  uint32_t need = TSDB_BLOCK_HEADER + len;
+  if (db->count == 0 || db->write_off + need > f->sector_size) {
+    TsdbSample_t key;
+    key_read(db->block, &key);
+    if (!sector_open(db, key.ts)) {
+      return false;
+    }
+  }
+  uint8_t buf[TSDB_BLOCK_HEADER + TSDB_BLOCK_BYTES];
+  buf[0] = (uint8_t)len;
+  buf[1] = (uint8_t)(len >> 8);
+  buf[2] = db->block_count;
+  uint16_t crc = frame_crc16(db->block, len);
+  buf[3] = (uint8_t)crc;
+  buf[4] = (uint8_t)(crc >> 8);
+  memcpy(&buf[TSDB_BLOCK_HEADER], db->block, len);
+  uint32_t addr = (uint32_t)db->order[db->count - 1] * f->sector_size + db->write_off;
+  bool ok = f->write(f, addr, buf, need);
+  // on error the region is skipped at next mount (CRC), keep going after it
+  db->write_off += need;
+  db->stats.blocks++;
+  db->stats.bytes_written += need;
+  block_reset(db);
+  return ok;
+}
+
+uint32_t tsdb_query(Tsdb_t* db, uint32_t from, uint32_t to,
+                    bool (*cb)(const TsdbSample_t* s, void* arg), void* arg){
+  TsdbQuery_t q = { from, to, cb, arg, 0, false };
+  if (db->count > 0) {
+    // binary search: last sector starting at or before 'from'
+    uint16_t lo = 0, hi = db->count;
+    while (hi - lo > 1) {
+      uint16_t mid = (uint16_t)((lo + hi) / 2);
+      if (db->first_ts[mid] <= from) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    for (uint16_t i = lo; i < db->count && !q.stop; i++){
+      if (db->first_ts[i] > to) {
+        return q.found;
+      }
+      sector_scan(db, db->order[i], visit_query, &q, &q.stop);
+    }
+  }
+  if (!q.stop) {
+    block_decode(db->block, (uint16_t)((db->bit_pos + 7) / 8), db->block_count, visit_query, &q);
+  }
+  return q.found;
+}
+
+uint32_t tsdb_last_ts(Tsdb_t* db){
+  return db->has_last ? db->last.ts : 0;
+}
@@ -0,0 +1,337 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file uplink.c
+ * @brief Wi-Fi MQTT uplink
+ *
+ * This implementation file provides the batched publisher of the samples, its RAM and
+ * flash backlog.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "uplink.h"
+
+#if WIFI_UPLINK
+#include "mqtt.h"
+#include "config.h"
+#include <WiFi.h>
+#include <Preferences.h>
+
+extern Tsdb_t SM_history;
+
+static_assert(UPLINK_PAYLOAD_MAX + sizeof(UPLINK_TOPIC) + 8 <= MQTT_MAX_PACKET, "a batch fits one PUBLISH");
+
+static PlantRecord_t ring_a[UPLINK_RAM_RECORDS]; // RAM backlog, indexed by sequence
+static uint32_t ring_head = 0; // sequence of the next record
+static uint32_t ring_tail = 0; // sequence of the oldest record
+static uint32_t push_ts = 0; // timestamp of the newest record
+static bool flash_pending = false; // plant 1 records to read back from the flash history
+static uint32_t flash_from = 0; // first timestamp to read back
+static uint32_t flash_to = 0; // last timestamp to read back
+static PlantRecord_t flash_batch[UPLINK_BATCH_RECORDS]; // read by Task1, sent by the Uplink task
+static uint8_t flash_count = 0;
+static volatile bool flash_request = false;
+static volatile bool flash_ready = false;
+static UplinkStats_t uplink_stats = {};
+static portMUX_TYPE uplink_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static WiFiClient uplink_tcp;
+static MqttLink_t uplink_link = {};
+static MqttClient_t uplink_mqtt;
+
+// batch in flight, owned by the Uplink task
+typedef struct
+{
+  bool      active;
+  bool      flash; // from the flash history, else from the ring
+  uint32_t  seq; // first ring sequence
+  uint8_t   count;
+  uint16_t  len; // payload bytes
+}UplinkBatch_t;
+
+static bool link_open(MqttLink_t* l) {
+  return uplink_tcp.connect(UPLINK_MQTT_HOST, UPLINK_MQTT_PORT);
+}
+
+static int link_write(MqttLink_t* l, const uint8_t* data, size_t len) {
+  return uplink_tcp.connected() ? (int)uplink_tcp.write(data, len) : -1;
+}
+
+static int link_read(MqttLink_t* l, uint8_t* data, size_t max) {
+  int n = uplink_tcp.available();
+  if (n <= 0) {
+    return uplink_tcp.connected() ? 0 : -1;
+  }
+  return uplink_tcp.read(data, (size_t)n < max ? (size_t)n : max);
+}
+
+static void link_close(MqttLink_t* l) {
+  uplink_tcp.stop();
+}
+
+// oldest record overwritten, uplink_mux held
+static void ring_drop(uint32_t flash_last) {
+  const PlantRecord_t* r = &ring_a[ring_tail++ % UPLINK_RAM_RECORDS];
+  if (r->plant == PLANT_1 && r->s.temperature != RECORD_TEMP_NONE && r->s.ts <= flash_last) {
+    if (!flash_pending) {
+      flash_from = r->s.ts;
+      flash_pending = true;
+    }
+    flash_to = r->s.ts; // records leave the ring in time order: the range stays contiguous
+  } else {
+    uplink_stats.lost++;
+  }
+}
+
+static bool flash_collect(const TsdbSample_t* s, void* arg) {
+  if (flash_count > 0 && s->ts - flash_batch[0].s.ts > UINT16_MAX) {
+    return false; // next batch
+  }
+  flash_batch[flash_count].s = *s;
+  flash_batch[flash_count].plant = PLANT_1;
+  flash_batch[flash_count].ms = 0; // the history keeps seconds
+  return ++flash_count < UPLINK_BATCH_RECORDS;
+}
+
+// next records of the ring, time span of a payload at most
+static uint8_t ring_batch(PlantRecord_t* out, uint32_t* seq) {
+  uint8_t n = 0;
+  portENTER_CRITICAL(&uplink_mux);
+  *seq = ring_tail;
+  while (n < UPLINK_BATCH_RECORDS && ring_tail + n != ring_head) {
+    const PlantRecord_t* r = &ring_a[(ring_tail + n) % UPLINK_RAM_RECORDS];
+    if (n > 0 && (r->s.ts < out[0].s.ts || r->s.ts - out[0].s.ts > UINT16_MAX)) {
+      break;
+    }
+    out[n++] = *r;
+  }
+  portEXIT_CRITICAL(&uplink_mux);
+  return n;
+}
+
+// publish the flash batch read by Task1 first, then the ring
+static bool batch_send(UplinkBatch_t* b, uint32_t now_ms) {
+  PlantRecord_t records[UPLINK_BATCH_RECORDS];
+  uint8_t payload[UPLINK_PAYLOAD_MAX];
+  b->flash = flash_ready && flash_count > 0;
+  if (b->flash) {
+    b->count = flash_count;
+    memcpy(records, flash_batch, flash_count * sizeof(PlantRecord_t));
+  } else {
+    b->count = ring_batch(records, &b->seq);
+  }
+  size_t len = b->count > 0 ? record_encode(records, b->count, payload, sizeof(payload)) : 0;
+  if (len == 0 || !mqtt_publish(&uplink_mqtt, UPLINK_TOPIC, payload, len, now_ms)) {
+    return false;
+  }
+  b->len = (uint16_t)len;
+  b->active = true;
+  return true;
+}
+
+static void batch_acked(UplinkBatch_t* b) {
+  portENTER_CRITICAL(&uplink_mux);
+  if (b->flash) {
+    uint32_t next = flash_batch[b->count - 1].s.ts + 1;
+    flash_from = next > flash_from ? next : flash_from;
+    flash_pending = flash_pending && flash_from <= flash_to;
+    flash_ready = false; // Task1 reads the next one
+  } else if ((int32_t)(b->seq + b->count - ring_tail) > 0) {
+    ring_tail = b->seq + b->count; // records dropped meanwhile are sent again from flash
+  }
+  uplink_stats.acked += b->count;
+  uplink_stats.batches++;
+  uplink_stats.payload_bytes += b->len;
+  uplink_stats.payload_max = b->len > uplink_stats.payload_max ? b->len : uplink_stats.payload_max;
+  uplink_stats.flash_records += b->flash ? b->count : 0;
+  portEXIT_CRITICAL(&uplink_mux);
+  b->active = false;
+}
+
+// every plant 1 record up to this timestamp has been acknowledged
+static uint32_t acked_ts() {
+  uint32_t ts = push_ts;
+  portENTER_CRITICAL(&uplink_mux);
+  for (uint32_t seq = ring_tail; seq != ring_head; seq++) {
+    const PlantRecord_t* r = &ring_a[seq % UPLINK_RAM_RECORDS];
+    if (r->plant == PLANT_1) {
+      ts = r->s.ts - 1; // oldest one waiting
+      break;
+    }
+  }
+  if (flash_pending && flash_from - 1 < ts) {
+    ts = flash_from - 1;
+  }
+  portEXIT_CRITICAL(&uplink_mux);
+  return ts;
+}
+
+static void UplinkTask(void* pvParameters) {
+  UplinkBatch_t batch = {};
+  MqttState_t state = MQTT_STATE_DOWN;
+  uint32_t retry_ms = UPLINK_RETRY_MIN_MS;
+  uint32_t retry_at_ms = 0;
+  uint32_t publish_ms = 0; // last publish
+  uint32_t checkpoint_ms = 0;
+  uint32_t saved_ts = 0;
+  uint32_t sessions = 0;
+  bool wifi = false;
+  while (true) {
+    uint32_t now_ms = millis();
+    bool was_wifi = wifi;
+    wifi = WiFi.status() == WL_CONNECTED;
+    if (!wifi && state != MQTT_STATE_DOWN) {
+      mqtt_disconnect(&uplink_mqtt); // the batch in flight is sent again by the next session
+    } else if (wifi && !was_wifi) {
+      retry_at_ms = now_ms; // associated: broker at once
+    }
+    if ((int32_t)(now_ms - retry_at_ms) >= 0 && uplink_mqtt.state == MQTT_STATE_DOWN) {
+      if (!wifi) {
+        WiFi.reconnect();
+      } else {
+        mqtt_connect(&uplink_mqtt, now_ms);
+      }
+      retry_at_ms = now_ms + retry_ms;
+      retry_ms = retry_ms * 2 < UPLINK_RETRY_MAX_MS ? retry_ms * 2 : UPLINK_RETRY_MAX_MS;
+    }
+    MqttState_t prev = state;
+    state = mqtt_poll(&uplink_mqtt, now_ms);
+    if (state == MQTT_STATE_UP && prev != MQTT_STATE_UP) {
+      uplink_stats.reconnects += sessions++ > 0 ? 1 : 0;
+      uplink_stats.up = true;
+      retry_ms = UPLINK_RETRY_MIN_MS;
+      LOG_I(LOG_FMT_UPLINK_UP, uplink_stats.reconnects, ring_head - ring_tail, flash_pending ? flash_to - flash_from + 1 : 0);
+    } else if (state == MQTT_STATE_DOWN && prev == MQTT_STATE_UP) {
+      uplink_stats.up = false;
+      retry_at_ms = now_ms + retry_ms;
+      LOG_W(LOG_FMT_UPLINK_DOWN, wifi ? 1 : 0, retry_ms);
+    }
+
+    if (batch.active && uplink_mqtt.inflight_id == 0) {
+      batch_acked(&batch);
+    }
+    if (flash_ready && flash_count == 0) {
+      flash_ready = false; // nothing left in the range
+    }
+    if (flash_pending && !flash_request && !flash_ready) {
+      flash_request = true; // read by the next Task1 cycle
+    }
+    uint32_t backlog = ring_head - ring_tail;
+    uint32_t interval_ms = (config_get()->uplink_s != 0 ? config_get()->uplink_s : UPLINK_PUBLISH_S) * 1000u;
+    bool due = (flash_ready && flash_count > 0) || backlog >= UPLINK_BATCH_RECORDS ||
+               (backlog > 0 && now_ms - publish_ms >= interval_ms);
+    if (state == MQTT_STATE_UP && !batch.active && due && now_ms - publish_ms >= UPLINK_DRAIN_MS &&
+        batch_send(&batch, now_ms)) {
+      publish_ms = now_ms;
+    }
+
+    uint32_t ts = acked_ts();
+    if (ts != saved_ts && now_ms - checkpoint_ms >= UPLINK_CHECKPOINT_MS) {
+      Preferences prefs;
+      if (prefs.begin(UPLINK_NVS_NAMESPACE, false)) {
+        prefs.putUInt("acked", ts);
+        prefs.end();
+      }
+      saved_ts = ts;
+      checkpoint_ms = now_ms;
+    }
+    vTaskDelay(pdMS_TO_TICKS(UPLINK_POLL_MS));
+  }
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void uplink_init() {
+  Preferences prefs;
+  uint32_t acked = 0;
+  if (prefs.begin(UPLINK_NVS_NAMESPACE, true)) {
+    acked = prefs.getUInt("acked", 0);
+    prefs.end();
+  }
+  uint32_t last = tsdb_last_ts(&SM_history);
+  if (last > acked) { // stored while offline before the reset, or before the uplink existed
+    flash_pending = true;
+    flash_from = acked + 1;
+    flash_to = last;
+  }
+  push_ts = last;
+  uplink_link.open = link_open;
+  uplink_link.write = link_write;
+  uplink_link.read = link_read;
+  uplink_link.close = link_close;
+  mqtt_init(&uplink_mqtt, &uplink_link, UPLINK_CLIENT_ID, UPLINK_KEEPALIVE_S);
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(UPLINK_WIFI_SSID, UPLINK_WIFI_PASS);
+  Serial.printf("Uplink %s to %s:%u, flash backlog %u s\n", UPLINK_CLIENT_ID, UPLINK_MQTT_HOST, UPLINK_MQTT_PORT,
+                flash_pending ? flash_to - flash_from + 1 : 0);
+  xTaskCreatePinnedToCore(UplinkTask, "Uplink", UPLINK_TASK_STACK, NULL, UPLINK_TASK_PRIO, NULL, UPLINK_TASK_CORE);
+}
+
+void uplink_push(const PlantRecord_t* r, uint8_t count) {
+  uint32_t flash_last = tsdb_last_ts(&SM_history); // Task1 appended this cycle already
+  portENTER_CRITICAL(&uplink_mux);
+  for (uint8_t i = 0; i < count; i++) {
+    if (ring_head - ring_tail == UPLINK_RAM_RECORDS) {
+      ring_drop(flash_last);
+    }
+    ring_a[ring_head++ % UPLINK_RAM_RECORDS] = r[i];
+    push_ts = r[i].s.ts;
+  }
+  uplink_stats.pushed += count;
+  uint32_t backlog = ring_head - ring_tail;
+  uplink_stats.backlog_max = backlog > uplink_stats.backlog_max ? backlog : uplink_stats.backlog_max;
+  portEXIT_CRITICAL(&uplink_mux);
+}
+
+void uplink_run() {
+  if (!flash_request) {
+    return;
+  }
+  portENTER_CRITICAL(&uplink_mux);
+  bool pending = flash_pending;
+  uint32_t from = flash_from, to = flash_to;
+  portEXIT_CRITICAL(&uplink_mux);
+  flash_count = 0;
+  if (pending) {
+    tsdb_query(&SM_history, from, to, flash_collect, NULL);
+  }
+  if (flash_count == 0) { // range no longer in the history (oldest sectors erased)
+    portENTER_CRITICAL(&uplink_mux);
+    flash_from = to + 1;
+    flash_pending = flash_pending && flash_from <= flash_to;
+    portEXIT_CRITICAL(&uplink_mux);
+  }
+  flash_ready = true;
+  flash_request = false;
+}
+
+void uplink_get_stats(UplinkStats_t* out) {
+  portENTER_CRITICAL(&uplink_mux);
+  *out = uplink_stats;
+  out->backlog = ring_head - ring_tail;
+  out->flash_s = flash_pending ? flash_to - flash_from + 1 : 0;
+  portEXIT_CRITICAL(&uplink_mux);
+  out->retransmits = uplink_mqtt.stats.retransmits;
+}
+
+void uplink_print() {
+  UplinkStats_t s;
+  uplink_get_stats(&s);
+  DEBUG_PRINT("Uplink %s: %u batches, %u records (%.1f per batch), payload avg %u max %u bytes (%.1f per record)\n",
+              s.up ? "up" : "down", s.batches, s.acked, s.batches ? (float)s.acked / s.batches : 0.0f,
+              s.batches ? s.payload_bytes / s.batches : 0, s.payload_max,
+              s.acked ? (float)s.payload_bytes / s.acked : 0.0f);
+  DEBUG_PRINT("Uplink backlog %u (max %u) + flash %u s, %u from flash, %u lost, %u reconnects, %u retransmits\n",
+              s.backlog, s.backlog_max, s.flash_s, s.flash_records, s.lost, s.reconnects, s.retransmits);
+}
+#endif
@@ -0,0 +1,206 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file adapt_replay.cpp
+ * @brief Replay of recorded traces through the adaptive sampling controller
+ *
+ * The trace is read from the CSV written by telemetry_decode (rows of the "filtered"
+ * stream, channel = field, one Task1 cycle every TASK1_TIME starting at each temperature
+ * row) or, without argument, generated: 48 h of daily temperature swing crossing the hot
+ * threshold, sand drying with waterings, day/night light.
+ * The controller picks the samples it would have taken and the alarm engine runs on both
+ * the full trace and the adaptive samples (sample and hold). Report for several maximum
+ * intervals:
+ * - samples taken and effective rate against the fixed 1 s rate
+ * - worst and mean error of the held value against the trace, per field
+ * - alarm transitions missed and worst detection delay
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Iinclude tools/adapt_replay/adapt_replay.cpp src/adapt.cpp src/alarm.cpp -o adapt_replay
+ *   ./adapt_replay [samples.csv]
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "adapt.h"
+#include "alarm_rules.h"
+
+// same as smartplant.h
+#define REPLAY_MIN_MS 1000
+#define REPLAY_GROWTH 1.5f
+#define REPLAY_TEMP_RESOLUTION 0.2f
+#define REPLAY_TEMP_GUARD 1.0f
+#define REPLAY_HUMIDITY_RESOLUTION 1.0f
+#define REPLAY_HUMIDITY_GUARD 3.0f
+#define REPLAY_SOLAR_RESOLUTION 0.5f
+#define REPLAY_SOLAR_GUARD 0.0f
+#define REPLAY_MAX_DELAY_MS 10000 // accepted alarm detection delay
+#define REPLAY_MIN_REDUCTION 3.0 // generated trace: fewer samples than the fixed rate
+
+typedef struct
+{
+  float     v[ALARM_NUM_FIELDS]; // indexed by AlarmField_t
+}Row_t;
+
+typedef struct
+{
+  uint32_t  t_ms;
+  uint8_t   mask;
+}Transition_t;
+
+static std::vector<Row_t> load_csv(const char* path){
+  std::vector<Row_t> trace;
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    exit(2);
+  }
+  char line[256];
+  Row_t row = {};
+  bool started = false;
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long ts, channel, seq;
+    char stream[32];
+    float value;
+    if (sscanf(line, "%lu,%31[^,],%lu,%lu,%f", &ts, stream, &channel, &seq, &value) != 5 ||
+        strcmp(stream, "filtered") != 0 || channel >= ALARM_NUM_FIELDS) {
+      continue;
+    }
+    if (channel == ALARM_FIELD_TEMPERATURE) { // first record of a Task1 cycle
+      if (started) trace.push_back(row);
+      started = true;
+    }
+    row.v[channel] = value;
+  }
+  if (started) trace.push_back(row);
+  fclose(f);
+  return trace;
+}
+
+static std::vector<Row_t> generate(uint32_t seconds){
+  std::vector<Row_t> trace(seconds);
+  float humidity = 45.0f;
+  srand(1);
+  for (uint32_t s = 0; s < seconds; s++){
+    double day = fmod(s / 86400.0, 1.0);
+    float temp = 22.0f + 9.0f * (float)sin(2 * M_PI * (day - 0.35)); // 13..31 C, peak mid afternoon
+    temp += ((rand() % 201) - 100) / 2000.0f; // +-0.05 C noise
+    bool light = day > 0.25 && day < 0.8;
+    humidity -= light ? 0.0012f : 0.0003f; // dries faster in the sun
+    if (s % 72000 == 60000) humidity = 65.0f; // watering
+    if (humidity < 12.0f) humidity = 12.0f;
+    trace[s].v[ALARM_FIELD_TEMPERATURE] = temp;
+    trace[s].v[ALARM_FIELD_HUMIDITY] = humidity + ((rand() % 61) - 30) / 100.0f; // +-0.3 % noise
+    trace[s].v[ALARM_FIELD_SOLAR] = light ? 0.0f : 1.0f;
+  }
+  return trace;
+}
+
+static void adapt_config(Adapt_t* a, const AlarmTable_t* t, uint32_t max_ms){
+  adapt_init(a, ALARM_NUM_FIELDS, REPLAY_MIN_MS, max_ms, REPLAY_GROWTH);
+  adapt_set_field(a, ALARM_FIELD_TEMPERATURE, REPLAY_TEMP_RESOLUTION, REPLAY_TEMP_GUARD);
+  adapt_set_field(a, ALARM_FIELD_HUMIDITY, REPLAY_HUMIDITY_RESOLUTION, REPLAY_HUMIDITY_GUARD);
+  adapt_set_field(a, ALARM_FIELD_SOLAR, REPLAY_SOLAR_RESOLUTION, REPLAY_SOLAR_GUARD);
+  for (uint8_t i = 0; i < t->count; i++){
+    if (t->rule[i].op == ALARM_OP_COND) {
+      adapt_add_threshold(a, t->rule[i].field, t->rule[i].threshold);
+    }
+  }
+}
+
+int main(int argc, char** argv){
+  int failures = 0;
+  bool generated = argc < 2;
+  std::vector<Row_t> trace = generated ? generate(2 * 86400) : load_csv(argv[1]);
+  if (trace.size() < 2) {
+    fprintf(stderr, "trace too short\n");
+    return 2;
+  }
+  static const AlarmRule_t rules[] = ALARM_RULES;
+  AlarmTable_t table;
+  alarm_compile(&table, rules, sizeof(rules) / sizeof(rules[0]));
+
+  // reference: alarm engine on every sample
+  std::vector<Transition_t> ref;
+  AlarmPlant_t plant;
+  alarm_reset(&plant, 1);
+  uint8_t mask = 0;
+  for (size_t i = 0; i < trace.size(); i++){
+    uint8_t m = alarm_eval(&table, &plant, 0, 1, trace[i].v, (uint32_t)(i * REPLAY_MIN_MS));
+    if (m != mask) ref.push_back({(uint32_t)(i * REPLAY_MIN_MS), m});
+    mask = m;
+  }
+
+  printf("trace: %s, %zu s, %zu alarm transitions at full rate\n", generated ? "generated" : argv[1],
+         trace.size(), ref.size());
+  printf("max_ms,samples,reduction,eff_mhz,temp_err_max,temp_err_mean,hum_err_max,hum_err_mean,"
+         "solar_err_s,missed,delay_max_ms\n");
+  const uint32_t max_list[] = {1000, 10000, 30000, 60000, 120000};
+  for (uint32_t max_ms : max_list){
+    Adapt_t a;
+    adapt_config(&a, &table, max_ms);
+    alarm_reset(&plant, 1);
+    std::vector<Transition_t> got;
+    mask = 0;
+    double err_max[ALARM_NUM_FIELDS] = {}, err_sum[ALARM_NUM_FIELDS] = {};
+    size_t i = 0;
+    while (i < trace.size()) {
+      uint32_t now = (uint32_t)(i * REPLAY_MIN_MS);
+      uint8_t m = alarm_eval(&table, &plant, 0, 1, trace[i].v, now);
+      if (m != mask) got.push_back({now, m});
+      mask = m;
+      uint32_t interval = adapt_update(&a, trace[i].v, 1, now);
+      size_t next = i + interval / REPLAY_MIN_MS;
+      for (size_t k = i; k < next && k < trace.size(); k++){ // value held until the next sample
+        for (uint8_t f = 0; f < ALARM_NUM_FIELDS; f++){
+          double e = fabs(trace[k].v[f] - trace[i].v[f]);
+          err_max[f] = e > err_max[f] ? e : err_max[f];
+          err_sum[f] += e;
+        }
+      }
+      i = next;
+    }
+    // every reference transition must be seen later with the same bits
+    uint32_t missed = 0, delay_max = 0;
+    size_t g = 0;
+    for (const Transition_t& r : ref){
+      while (g < got.size() && (got[g].t_ms < r.t_ms || got[g].mask != r.mask)) g++;
+      if (g == got.size()) {
+        missed++;
+        g = 0;
+        continue;
+      }
+      uint32_t d = got[g].t_ms - r.t_ms;
+      delay_max = d > delay_max ? d : delay_max;
+    }
+    double reduction = (double)trace.size() / a.stats.cycles;
+    printf("%u,%u,%.1f,%u,%.2f,%.3f,%.2f,%.3f,%.0f,%u,%u\n", max_ms, a.stats.cycles, reduction,
+           (uint32_t)((uint64_t)a.stats.cycles * 1000000 / a.stats.elapsed_ms),
+           err_max[ALARM_FIELD_TEMPERATURE], err_sum[ALARM_FIELD_TEMPERATURE] / trace.size(),
+           err_max[ALARM_FIELD_HUMIDITY], err_sum[ALARM_FIELD_HUMIDITY] / trace.size(),
+           err_sum[ALARM_FIELD_SOLAR], missed, delay_max);
+    if (missed > 0 || delay_max > REPLAY_MAX_DELAY_MS) {
+      fprintf(stderr, "FAIL: max %u ms: %u transitions missed, delay %u ms\n", max_ms, missed, delay_max);
+      failures++;
+    }
+    if (generated && max_ms >= 30000 && reduction < REPLAY_MIN_REDUCTION) {
+      fprintf(stderr, "FAIL: max %u ms: only %.1fx fewer samples\n", max_ms, reduction);
+      failures++;
+    }
+  }
+  fprintf(stderr, "%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file amux_mock.cpp
+ * @brief Host mock of CD74HC4067 muxes in front of the ESP32 ADC
+ *
+ * Run the scanning engine on a virtual clock against an RC model of the analog path:
+ * - mux output node settles towards the selected probe with tau = Rsrc * Cout
+ * - every toggled select line injects charge on the mux output
+ * - a conversion shares charge with the ADC sampling capacitor, still holding the
+ *   previous channel, then acquires for a fixed time
+ * Report throughput (channels/s) of the pipelined sweep against a sequential reference
+ * and the worst crosstalk error for settling time, dummy conversions and scan order.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Iinclude tools/amux_mock/amux_mock.cpp src/HAL/amux_scan.cpp -o amux_mock
+ *   ./amux_mock
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "HAL/amux_scan.h"
+
+#define MOCK_SETTLE_US 10 // same as AMUX_SETTLE_US in amux_hal.h
+#define MOCK_DISCARD 1 // same as AMUX_DISCARD in amux_hal.h
+#define MOCK_TAU_OUT_US 1.0 // 10 kOhm probe x 100 pF mux output
+#define MOCK_C_RATIO 0.2 // ADC sampling capacitor / mux output capacitance
+#define MOCK_ACQ_US 1.5 // ADC acquisition time
+#define MOCK_TAU_ACQ_US 1.2 // 10 kOhm probe x (mux output + sampling capacitor)
+#define MOCK_INJECT 40.0 // charge injection per toggled select line (ADC bits)
+#define MOCK_CONV_US 10.0 // analogRead() duration
+#define MOCK_SELECT_US 0.2 // GPIO register writes
+#define MOCK_SINK_US 6.0 // analog_add_sample() duration
+#define MOCK_MAX_ERROR 20 // accepted crosstalk error with default settings (0.5% full scale)
+
+typedef struct
+{
+  double    t; // virtual time in us
+  double    v_out[AMUX_MAX_BANKS]; // mux output node
+  double    v_cap[AMUX_MAX_BANKS]; // ADC sampling capacitor
+  uint8_t   lines; // select lines
+  double    probe[AMUX_MAX_BANKS * AMUX_MAX_CHANNELS]; // probe values in ADC bits
+  uint8_t   channels;
+  uint16_t  raw[AMUX_MAX_BANKS * AMUX_MAX_CHANNELS]; // last sink per virtual channel
+  uint8_t   sinks[AMUX_MAX_BANKS * AMUX_MAX_CHANNELS]; // sinks per virtual channel
+}Mock_t;
+
+static void mock_advance(Mock_t* m, double dt){
+  for (uint8_t b = 0; b < AMUX_MAX_BANKS; b++){
+    double v = m->probe[b * m->channels + m->lines];
+    m->v_out[b] = v + (m->v_out[b] - v) * exp(-dt / MOCK_TAU_OUT_US);
+  }
+  m->t += dt;
+}
+
+static void mock_select(AmuxIo_t* io, uint8_t lines){
+  Mock_t* m = (Mock_t*)io->ctx;
+  int toggles = __builtin_popcount((m->lines ^ lines) & 0xF);
+  for (uint8_t b = 0; b < AMUX_MAX_BANKS; b++){
+    m->v_out[b] += MOCK_INJECT * toggles;
+  }
+  m->lines = lines;
+  mock_advance(m, MOCK_SELECT_US);
+}
+
+static uint16_t mock_convert(AmuxIo_t* io, uint8_t bank){
+  Mock_t* m = (Mock_t*)io->ctx;
+  double v = (m->v_out[bank] + MOCK_C_RATIO * m->v_cap[bank]) / (1.0 + MOCK_C_RATIO);
+  double target = m->probe[bank * m->channels + m->lines];
+  v = target + (v - target) * exp(-MOCK_ACQ_US / MOCK_TAU_ACQ_US);
+  m->v_out[bank] = v;
+  m->v_cap[bank] = v;
+  m->t += MOCK_ACQ_US;
+  mock_advance(m, MOCK_CONV_US - MOCK_ACQ_US);
+  long code = lround(v);
+  return (uint16_t)(code < 0 ? 0 : (code > 4095 ? 4095 : code));
+}
+
+static uint32_t mock_now_us(AmuxIo_t* io){
+  return (uint32_t)((Mock_t*)io->ctx)->t;
+}
+
+static void mock_delay_us(AmuxIo_t* io, uint32_t us){
+  mock_advance((Mock_t*)io->ctx, us);
+}
+
+static void mock_sink(AmuxIo_t* io, uint8_t channel, uint16_t raw){
+  Mock_t* m = (Mock_t*)io->ctx;
+  m->raw[channel] = raw;
+  m->sinks[channel]++;
+  mock_advance(m, MOCK_SINK_US);
+}
+
+static void mock_init(Mock_t* m, AmuxIo_t* io, uint8_t channels, unsigned seed){
+  *m = Mock_t();
+  m->channels = channels;
+  srand(seed);
+  for (int i = 0; i < AMUX_MAX_BANKS * AMUX_MAX_CHANNELS; i++){
+    m->probe[i] = (rand() & 1) ? 4000.0 : 100.0; // worst case: neighbours far apart
+  }
+  io->select = mock_select;
+  io->convert = mock_convert;
+  io->now_us = mock_now_us;
+  io->delay_us = mock_delay_us;
+  io->sink = mock_sink;
+  io->ctx = m;
+}
+
+// reference without pipelining: select, wait, convert, filter
+static void sequential_sweep(Amux_t* a, AmuxIo_t* io){
+  for (uint8_t step = 0; step < a->channels; step++){
+    uint8_t k = a->order[step];
+    io->select(io, k);
+    io->delay_us(io, a->settle_us);
+    for (uint8_t b = 0; b < a->banks; b++){
+      for (uint8_t d = 0; d < a->discard; d++){
+        io->convert(io, b);
+      }
+      io->sink(io, b * a->channels + k, io->convert(io, b));
+    }
+  }
+}
+
+static double max_error(Mock_t* m, uint8_t banks){
+  double err = 0;
+  for (int i = 0; i < banks * m->channels; i++){
+    double e = fabs(m->raw[i] - m->probe[i]);
+    err = e > err ? e : err;
+  }
+  return err;
+}
+
+static double sweep_error(uint8_t settle_us, uint8_t discard, bool gray){
+  Mock_t m;
+  AmuxIo_t io;
+  Amux_t a;
+  double worst = 0;
+  for (unsigned seed = 1; seed <= 50; seed++){
+    mock_init(&m, &io, AMUX_MAX_CHANNELS, seed);
+    amux_init(&a, 1, AMUX_MAX_CHANNELS, settle_us, discard);
+    if (!gray) {
+      for (uint8_t k = 0; k < AMUX_MAX_CHANNELS; k++) a.order[k] = k;
+    }
+    amux_sweep(&a, &io); // first sweep starts from an unknown state
+    amux_sweep(&a, &io);
+    double e = max_error(&m, 1);
+    worst = e > worst ? e : worst;
+  }
+  return worst;
+}
+
+int main(){
+  int failures = 0;
+
+  printf("throughput (virtual time, %.0f us/conversion, %.0f us filter):\n", MOCK_CONV_US, MOCK_SINK_US);
+  printf("banks,settle_us,discard,pipelined_ch_s,sequential_ch_s,wait_us,overlap_us\n");
+  for (uint8_t banks = 1; banks <= AMUX_MAX_BANKS; banks++){
+    for (uint8_t settle = 5; settle <= 20; settle += 5){
+      Mock_t m;
+      AmuxIo_t io;
+      Amux_t a;
+      mock_init(&m, &io, AMUX_MAX_CHANNELS, 1);
+      amux_init(&a, banks, AMUX_MAX_CHANNELS, settle, MOCK_DISCARD);
+      amux_sweep(&a, &io);
+      double pipelined = banks * AMUX_MAX_CHANNELS * 1e6 / a.stats.sweep_us;
+      for (int i = 0; i < banks * AMUX_MAX_CHANNELS; i++){
+        if (m.sinks[i] != 1) {
+          fprintf(stderr, "FAIL: channel %d filtered %u times in one sweep\n", i, m.sinks[i]);
+          failures++;
+        }
+      }
+      double t0 = m.t;
+      sequential_sweep(&a, &io);
+      double sequential = banks * AMUX_MAX_CHANNELS * 1e6 / (m.t - t0);
+      printf("%u,%u,%u,%.0f,%.0f,%u,%u\n", banks, settle, MOCK_DISCARD, pipelined, sequential,
+             a.stats.wait_us, a.stats.overlap_us);
+      if (pipelined <= sequential) {
+        fprintf(stderr, "FAIL: pipelined sweep not faster than sequential\n");
+        failures++;
+      }
+    }
+  }
+
+  printf("\ncrosstalk (worst error in ADC bits, random 100/4000 probes):\n");
+  printf("settle_us,discard,gray_order,linear_order\n");
+  for (uint8_t discard = 0; discard <= 1; discard++){
+    for (uint8_t settle = 0; settle <= 10; settle += 2){
+      printf("%u,%u,%.0f,%.0f\n", settle, discard, sweep_error(settle, discard, true), sweep_error(settle, discard, false));
+    }
+  }
+  double err_default = sweep_error(MOCK_SETTLE_US, MOCK_DISCARD, true);
+  double err_none = sweep_error(0, 0, true);
+  if (err_default > MOCK_MAX_ERROR) {
+    fprintf(stderr, "FAIL: crosstalk %.0f bits with default settings\n", err_default);
+    failures++;
+  }
+  if (err_none <= MOCK_MAX_ERROR) {
+    fprintf(stderr, "FAIL: mock does not show crosstalk without settling\n");
+    failures++;
+  }
+  fprintf(stderr, "%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
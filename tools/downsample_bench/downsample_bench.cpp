@@ -0,0 +1,299 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file downsample_bench.cpp
+ * @brief Host tests and benchmarks of the streaming downsampler
+ *
+ * One day of 1 Hz synthetic temperature (daily swing, noise, short sun peaks) is reduced
+ * to N points by each mode and rebuilt by linear interpolation between the points.
+ * - quality, for the streaming LTTB, a reference LTTB choosing among all the samples of a
+ *   bucket (same buckets), min/max buckets and plain decimation: RMS error of the rebuilt
+ *   series against the samples and mean error on the height of the sun peaks (what a
+ *   chart must not lose)
+ * - checks: point count, time order, first and last sample kept
+ * - speed: samples/s of downsample_push() alone and of the whole history query
+ *   (tsdb_query() on a RAM flash + downsampling), as run on the device
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Iinclude tools/downsample_bench/downsample_bench.cpp src/downsample.cpp src/tsdb.cpp src/frame.cpp -o downsample_bench
+ *   ./downsample_bench
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "downsample.h"
+#include "tsdb.h"
+
+#define BENCH_SAMPLES 86400 // one day at 1 Hz
+#define BENCH_T0 1000 // first timestamp
+#define BENCH_SECTOR_SIZE 4096
+#define BENCH_SECTORS 128
+#define BENCH_ROUNDS 20
+
+typedef std::vector<DsPoint_t> Series_t;
+
+static std::vector<uint32_t> peak_from, peak_to; // sun peaks of the generated day
+
+static void collect(const DsPoint_t* p, void* arg){
+  ((Series_t*)arg)->push_back(*p);
+}
+
+static Series_t generate(){
+  Series_t s;
+  std::mt19937 rng(7);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::uniform_int_distribution<int> start(0, BENCH_SAMPLES - 600);
+  std::vector<double> sun(BENCH_SAMPLES, 0.0);
+  for (int k = 0; k < 12; k++){ // sun on the sensor: 0.1 C units, a few minutes each
+    int t0 = start(rng), len = 30 + t0 % 120;
+    peak_from.push_back(BENCH_T0 + t0);
+    peak_to.push_back(BENCH_T0 + t0 + len - 1);
+    for (int i = 0; i < len; i++) sun[t0 + i] = 50.0 * sin(M_PI * i / len);
+  }
+  for (int i = 0; i < BENCH_SAMPLES; i++){
+    double v = 200.0 + 60.0 * sin(2 * M_PI * (i - 21600) / 86400.0) + sun[i] + noise(rng);
+    DsPoint_t p = {(uint32_t)(BENCH_T0 + i), (int32_t)lround(v)};
+    s.push_back(p);
+  }
+  return s;
+}
+
+static Series_t run(const Series_t& in, uint8_t mode, uint16_t points){
+  Series_t out;
+  Downsample_t d;
+  downsample_init(&d, mode, in.front().ts, in.back().ts, points, collect, &out);
+  for (const DsPoint_t& p : in) downsample_push(&d, p.ts, p.value);
+  downsample_finish(&d);
+  return out;
+}
+
+// LTTB on the same buckets, every sample of a bucket is a candidate
+static Series_t reference_lttb(const Series_t& in, uint16_t points){
+  Series_t out;
+  uint32_t from = in.front().ts, to = in.back().ts;
+  uint16_t buckets = points - 2;
+  std::vector<Series_t> b(buckets);
+  for (size_t i = 1; i < in.size(); i++){
+    b[(uint64_t)(in[i].ts - from) * buckets / ((uint64_t)to - from + 1)].push_back(in[i]);
+  }
+  std::vector<Series_t> full;
+  for (auto& x : b) if (!x.empty()) full.push_back(x);
+  DsPoint_t a = in.front(), last = in.back();
+  out.push_back(a);
+  for (size_t k = 0; k < full.size(); k++){
+    double cx, cy;
+    bool last_bucket = k + 1 == full.size();
+    if (last_bucket) {
+      cx = last.ts - from;
+      cy = last.value;
+    } else {
+      double sx = 0, sy = 0;
+      for (auto& p : full[k + 1]) { sx += p.ts - from; sy += p.value; }
+      cx = sx / full[k + 1].size();
+      cy = sy / full[k + 1].size();
+    }
+    double best = -1;
+    DsPoint_t sel = full[k].front();
+    for (auto& p : full[k]){
+      if (last_bucket && p.ts == last.ts) continue;
+      double ax = a.ts - from, bx = p.ts - from;
+      double area = fabs((ax - cx) * (p.value - a.value) - (ax - bx) * (cy - a.value));
+      if (area > best) { best = area; sel = p; }
+    }
+    if (!(last_bucket && full[k].size() == 1)) {
+      out.push_back(sel);
+      a = sel;
+    }
+  }
+  out.push_back(last);
+  return out;
+}
+
+static Series_t decimate(const Series_t& in, uint16_t points){
+  Series_t out;
+  size_t step = (in.size() + points - 1) / points;
+  for (size_t i = 0; i < in.size(); i += step) out.push_back(in[i]);
+  return out;
+}
+
+static double rebuild_rms(const Series_t& in, const Series_t& out){
+  double e2 = 0;
+  size_t k = 0;
+  for (const DsPoint_t& p : in){
+    while (k + 1 < out.size() && out[k + 1].ts <= p.ts) k++;
+    double v;
+    if (p.ts <= out[k].ts || k + 1 == out.size()) {
+      v = out[k].value;
+    } else {
+      double f = (double)(p.ts - out[k].ts) / (out[k + 1].ts - out[k].ts);
+      v = out[k].value + f * (out[k + 1].value - out[k].value);
+    }
+    e2 += (v - p.value) * (v - p.value);
+  }
+  return sqrt(e2 / in.size());
+}
+
+// mean difference between the highest sample of each peak and the highest point kept
+static double peak_error(const Series_t& in, const Series_t& out){
+  double sum = 0;
+  for (size_t k = 0; k < peak_from.size(); k++){
+    int32_t hi_in = INT32_MIN, hi_out = INT32_MIN;
+    for (const DsPoint_t& p : in){
+      if (p.ts >= peak_from[k] && p.ts <= peak_to[k] && p.value > hi_in) hi_in = p.value;
+    }
+    for (const DsPoint_t& p : out){
+      if (p.ts >= peak_from[k] && p.ts <= peak_to[k] && p.value > hi_out) hi_out = p.value;
+    }
+    if (hi_out == INT32_MIN) { // no point in the peak: height of the interpolated line
+      for (size_t i = 0; i + 1 < out.size(); i++){
+        if (out[i].ts < peak_from[k] && out[i + 1].ts > peak_to[k]) {
+          hi_out = out[i].value > out[i + 1].value ? out[i].value : out[i + 1].value;
+        }
+      }
+    }
+    sum += hi_in - hi_out;
+  }
+  return sum / peak_from.size();
+}
+
+static int check(const char* name, const Series_t& in, const Series_t& out, uint16_t points, bool ends){
+  int failures = 0;
+  if (out.size() > points || out.empty()) {
+    fprintf(stderr, "FAIL: %s %zu points for %u\n", name, out.size(), points);
+    failures++;
+  }
+  for (size_t i = 1; i < out.size(); i++){
+    if (out[i].ts <= out[i - 1].ts) {
+      fprintf(stderr, "FAIL: %s not in time order at %zu\n", name, i);
+      failures++;
+      break;
+    }
+  }
+  if (ends && (out.front().ts != in.front().ts || out.back().ts != in.back().ts)) {
+    fprintf(stderr, "FAIL: %s first or last sample dropped\n", name);
+    failures++;
+  }
+  return failures;
+}
+
+// RAM flash for the query benchmark
+static uint8_t* ram;
+static bool ram_read(Flash_t* f, uint32_t addr, void* dst, size_t len){
+  memcpy(dst, ram + addr, len);
+  return true;
+}
+static bool ram_write(Flash_t* f, uint32_t addr, const void* src, size_t len){
+  for (size_t i = 0; i < len; i++) ram[addr + i] &= ((const uint8_t*)src)[i];
+  return true;
+}
+static bool ram_erase(Flash_t* f, uint16_t sector){
+  memset(ram + (uint32_t)sector * BENCH_SECTOR_SIZE, 0xFF, BENCH_SECTOR_SIZE);
+  return true;
+}
+
+static bool query_cb(const TsdbSample_t* s, void* arg){
+  downsample_push((Downsample_t*)arg, s->ts, s->temperature);
+  return true;
+}
+
+static void discard(const DsPoint_t* p, void* arg){
+  (*(uint32_t*)arg)++;
+}
+
+int main(){
+  int failures = 0;
+  Series_t in = generate();
+  const uint16_t sizes[] = {100, 300, 1000};
+  printf("mode,points,out,rms_err,peak_err\n");
+  for (uint16_t n : sizes){
+    Series_t lttb = run(in, DOWNSAMPLE_LTTB, n);
+    Series_t ref = reference_lttb(in, n);
+    Series_t mm = run(in, DOWNSAMPLE_MINMAX, n);
+    Series_t dec = decimate(in, n);
+    failures += check("lttb", in, lttb, n, true);
+    failures += check("minmax", in, mm, n, false);
+    const Series_t* all[4] = {&lttb, &ref, &mm, &dec};
+    const char* names[4] = {"lttb", "lttb_full", "minmax", "decimate"};
+    double rms[4], peak[4];
+    for (int m = 0; m < 4; m++){
+      rms[m] = rebuild_rms(in, *all[m]);
+      peak[m] = peak_error(in, *all[m]);
+      printf("%s,%u,%zu,%.2f,%.1f\n", names[m], n, all[m]->size(), rms[m], peak[m]);
+    }
+    if (rms[0] > 1.2 * rms[1] || peak[0] > peak[1] + 2.0) {
+      fprintf(stderr, "FAIL: streaming LTTB error %.2f/%.1f against %.2f/%.1f of the full LTTB\n",
+              rms[0], peak[0], rms[1], peak[1]);
+      failures++;
+    }
+    if (peak[0] >= peak[3] || peak[2] >= peak[3]) {
+      fprintf(stderr, "FAIL: peaks lost, lttb %.1f minmax %.1f decimation %.1f\n", peak[0], peak[2], peak[3]);
+      failures++;
+    }
+  }
+
+  // a range with fewer samples than points is sent unchanged
+  Series_t few(in.begin(), in.begin() + 50);
+  if (run(few, DOWNSAMPLE_LTTB, 100).size() != few.size()) {
+    fprintf(stderr, "FAIL: short range not kept\n");
+    failures++;
+  }
+
+  // speed of the downsampler alone
+  printf("\nmode,samples_per_s\n");
+  for (uint8_t mode = 0; mode < DOWNSAMPLE_NUM_MODES; mode++){
+    uint32_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_ROUNDS; r++){
+      Downsample_t d;
+      downsample_init(&d, mode, in.front().ts, in.back().ts, 300, discard, &sink);
+      for (const DsPoint_t& p : in) downsample_push(&d, p.ts, p.value);
+      downsample_finish(&d);
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("%s,%.0f\n", mode == DOWNSAMPLE_LTTB ? "lttb" : "minmax", (double)BENCH_ROUNDS * in.size() / s);
+  }
+
+  // whole history query: flash decode + downsampling
+  ram = (uint8_t*)malloc(BENCH_SECTORS * BENCH_SECTOR_SIZE);
+  memset(ram, 0xFF, BENCH_SECTORS * BENCH_SECTOR_SIZE);
+  Flash_t f = {BENCH_SECTOR_SIZE, BENCH_SECTORS, ram_read, ram_write, ram_erase, nullptr};
+  static Tsdb_t db;
+  tsdb_mount(&db, &f);
+  for (const DsPoint_t& p : in){
+    TsdbSample_t s = {p.ts, (int16_t)p.value, 500, 1, 0};
+    tsdb_append(&db, &s);
+  }
+  tsdb_flush(&db);
+  uint32_t sink = 0, n = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < BENCH_ROUNDS; r++){
+    Downsample_t d;
+    downsample_init(&d, DOWNSAMPLE_LTTB, in.front().ts, in.back().ts, 300, discard, &sink);
+    n += tsdb_query(&db, in.front().ts, in.back().ts, query_cb, &d);
+    downsample_finish(&d);
+  }
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  printf("query+lttb,%.0f\n", n / s);
+  if (n != BENCH_ROUNDS * in.size()) {
+    fprintf(stderr, "FAIL: query returned %u samples\n", n);
+    failures++;
+  }
+  free(ram);
+  fprintf(stderr, "%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file i2cmux_fake.cpp
+ * @brief Host fake I2C bus with a TCA9548A and BMP280 sensors
+ *
+ * Run the grouped read plan of i2c_mux on a fake bus with a virtual clock (100 kHz,
+ * Wire default). A sensor answers only when its channel is selected, a read on the wrong
+ * channel is a NACK. Checks:
+ * - every sensor is read with one channel switch per used channel at most
+ * - grouped reads against reads in plant order (one switch per change of channel)
+ * - per-sensor latency reported by the plan matches the bus timing
+ * - a missing sensor or a mux that does not answer only affects its own sensors
+ * - a sensor lost at run time has no value after I2CMUX_MAX_ERRORS failed reads in a row
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Iinclude tools/i2cmux_fake/i2cmux_fake.cpp src/HAL/i2c_mux.cpp -o i2cmux_fake
+ *   ./i2cmux_fake
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "HAL/i2c_mux.h"
+
+#define FAKE_BIT_US 10 // 100 kHz
+#define FAKE_SELECT_US (20 * FAKE_BIT_US) // start, address, control byte, stop
+#define FAKE_READ_US (57 * FAKE_BIT_US) // register write, repeated start, 3 data bytes
+#define FAKE_NACK_US (11 * FAKE_BIT_US) // start, address, stop
+#define FAKE_PLANTS 32
+
+typedef struct
+{
+  uint32_t  t; // virtual time in us
+  uint8_t   selected; // mux channel, I2CMUX_NONE after reset
+  bool      mux_ok; // false: mux does not acknowledge
+  uint8_t   dead_ch; // channel whose select fails, I2CMUX_NONE if none
+  I2cMux_t* m;
+  bool      present[I2CMUX_MAX_SENSORS];
+  uint32_t  nacks; // reads of a sensor on a channel not selected
+}Fake_t;
+
+static bool fake_select(I2cBus_t* bus, uint8_t mux_ch){
+  Fake_t* f = (Fake_t*)bus->ctx;
+  f->t += FAKE_SELECT_US;
+  if (!f->mux_ok || mux_ch == f->dead_ch) {
+    f->selected = I2CMUX_NONE;
+    return false;
+  }
+  f->selected = mux_ch;
+  return true;
+}
+
+static bool fake_read(I2cBus_t* bus, uint8_t sensor, float* value){
+  Fake_t* f = (Fake_t*)bus->ctx;
+  I2cSensor_t* s = &f->m->sensor[sensor];
+  if (!f->present[sensor] || (s->mux_ch != I2CMUX_NONE && s->mux_ch != f->selected)) {
+    f->t += FAKE_NACK_US;
+    f->nacks += f->present[sensor] ? 1 : 0;
+    return false;
+  }
+  f->t += FAKE_READ_US + (s->mux_ch % 3) * FAKE_BIT_US; // clock stretching differs per channel
+  *value = 20.0f + sensor * 0.5f;
+  return true;
+}
+
+static uint32_t fake_now_us(I2cBus_t* bus){
+  return ((Fake_t*)bus->ctx)->t;
+}
+
+static void fake_init(Fake_t* f, I2cBus_t* bus, I2cMux_t* m, uint8_t sensors){
+  memset(f, 0, sizeof(Fake_t));
+  f->selected = I2CMUX_NONE;
+  f->mux_ok = true;
+  f->dead_ch = I2CMUX_NONE;
+  f->m = m;
+  i2cmux_init(m);
+  // discovery order of peripheral_init(): channel by channel, 0x76 then 0x77
+  for (uint8_t i = 0; i < sensors; i++){
+    i2cmux_add(m, i / 2, (i % 2) ? 0x77 : 0x76);
+    f->present[i] = true;
+  }
+  bus->select = fake_select;
+  bus->read = fake_read;
+  bus->now_us = fake_now_us;
+  bus->ctx = f;
+}
+
+// reference: one read per plant in plant order, switch when the channel changes
+static uint32_t plant_order_read(Fake_t* f, I2cBus_t* bus, const uint8_t* map, uint8_t plants, uint32_t* switches){
+  uint32_t t0 = f->t;
+  uint8_t current = f->selected;
+  for (uint8_t p = 0; p < plants; p++){
+    I2cSensor_t* s = &f->m->sensor[map[p]];
+    if (s->mux_ch != current) {
+      bus->select(bus, s->mux_ch);
+      current = s->mux_ch;
+      (*switches)++;
+    }
+    float v;
+    bus->read(bus, map[p], &v);
+  }
+  return f->t - t0;
+}
+
+int main(){
+  int failures = 0;
+  Fake_t f;
+  I2cBus_t bus;
+  I2cMux_t m;
+
+  printf("sensors,plants,grouped_switches,grouped_us,plant_order_switches,plant_order_us\n");
+  for (uint8_t sensors = 1; sensors <= I2CMUX_MAX_SENSORS; sensors *= 2){
+    fake_init(&f, &bus, &m, sensors);
+    uint8_t map[FAKE_PLANTS];
+    srand(sensors);
+    for (uint8_t p = 0; p < FAKE_PLANTS; p++){
+      map[p] = (uint8_t)(rand() % sensors); // pots wired to the nearest sensor
+    }
+    i2cmux_read_all(&m, &bus); // first cycle selects from reset
+    uint32_t sw0 = m.switches, t0 = f.t;
+    uint8_t ok = i2cmux_read_all(&m, &bus);
+    uint32_t grouped_sw = m.switches - sw0, grouped_us = f.t - t0;
+    uint8_t channels = (uint8_t)((sensors + 1) / 2);
+    if (ok != sensors || f.nacks > 0 || grouped_sw > (uint32_t)(channels - 1)) {
+      fprintf(stderr, "FAIL: %u sensors: %u read, %u nacks, %u switches\n", sensors, ok, f.nacks, grouped_sw);
+      failures++;
+    }
+    uint32_t plant_sw = 0;
+    uint32_t plant_us = plant_order_read(&f, &bus, map, FAKE_PLANTS, &plant_sw);
+    printf("%u,%u,%u,%u,%u,%u\n", sensors, FAKE_PLANTS, grouped_sw, grouped_us, plant_sw, plant_us);
+  }
+
+  // per-sensor latency reported by the plan
+  fake_init(&f, &bus, &m, I2CMUX_MAX_SENSORS);
+  for (int i = 0; i < 10; i++){
+    i2cmux_read_all(&m, &bus);
+  }
+  printf("\nsensor,mux_ch,addr,reads,errors,last_us,avg_us,max_us\n");
+  for (uint8_t i = 0; i < m.count; i++){
+    I2cSensor_t* s = &m.sensor[i];
+    printf("%u,%u,0x%02x,%u,%u,%u,%u,%u\n", i, s->mux_ch, s->addr, s->reads, s->errors,
+           s->last_us, (uint32_t)(s->sum_us / s->reads), s->max_us);
+    if (s->last_us != (uint32_t)(FAKE_READ_US + (s->mux_ch % 3) * FAKE_BIT_US)) {
+      fprintf(stderr, "FAIL: sensor %u latency %u us includes the channel switch\n", i, s->last_us);
+      failures++;
+    }
+  }
+
+  // faults: a missing sensor, then a channel whose switch fails
+  fake_init(&f, &bus, &m, 8);
+  f.present[3] = false;
+  f.dead_ch = 2;
+  uint8_t ok = i2cmux_read_all(&m, &bus);
+  printf("\nfaults: sensor 3 missing, channel 2 dead: %u/8 read, errors", ok);
+  for (uint8_t i = 0; i < m.count; i++){
+    printf(" %u", m.sensor[i].errors);
+  }
+  printf(", %u switches\n", m.switches);
+  if (ok != 5 || m.sensor[3].errors != 1 || m.sensor[4].errors != 1 || m.sensor[5].errors != 1 || f.nacks > 0) {
+    fprintf(stderr, "FAIL: faults spread to other sensors\n");
+    failures++;
+  }
+  f.mux_ok = false; // mux lost: every sensor behind it fails, no retry storm
+  uint32_t sw0 = m.switches;
+  i2cmux_read_all(&m, &bus);
+  if (m.switches - sw0 > 4) {
+    fprintf(stderr, "FAIL: %u switches with the mux lost\n", m.switches - sw0);
+    failures++;
+  }
+
+  // a sensor lost at run time: value kept for a few reads, then missing until it answers
+  fake_init(&f, &bus, &m, 2);
+  i2cmux_read_all(&m, &bus);
+  f.present[1] = false;
+  bool kept = true;
+  for (int i = 0; i < I2CMUX_MAX_ERRORS; i++) {
+    kept = kept && !isnan(m.sensor[1].value);
+    i2cmux_read_all(&m, &bus);
+  }
+  bool dropped = isnan(m.sensor[1].value) && !isnan(m.sensor[0].value);
+  printf("sensor 1 lost: value %.1f after %u failed reads", m.sensor[1].value, m.sensor[1].errors);
+  f.present[1] = true;
+  i2cmux_read_all(&m, &bus);
+  printf(", %.1f when it answers again\n", m.sensor[1].value);
+  if (!kept || !dropped || isnan(m.sensor[1].value)) {
+    fprintf(stderr, "FAIL: value of a lost sensor not dropped after %u errors\n", I2CMUX_MAX_ERRORS);
+    failures++;
+  }
+
+  fprintf(stderr, "%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file kalman_bench.cpp
+ * @brief Host comparison of the Kalman filter against the box average
+ *
+ * The trace is read from the CSV written by telemetry_decode (rows of the "raw_adc"
+ * stream of one analog channel) or, without argument, generated: humidity ADC readings
+ * with flat periods, drying ramps and watering steps plus gaussian noise. Both filters
+ * see the same accepted samples (the spike stage is upstream and not modelled).
+ * Reported for the box average of BUFFER_SIZE samples and for the Kalman filter:
+ * - noise: RMS distance from a centered moving average (zero-phase reference)
+ * - lag: shift of the reference that fits the output best, in samples
+ * - generated trace only: RMS error against the truth on flat and ramp segments, ramp
+ *   lag, samples to 90% after a step, and the filter variance against the measured
+ *   error variance
+ * - time per update
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Iinclude tools/kalman_bench/kalman_bench.cpp src/kalman.cpp -o kalman_bench
+ *   ./kalman_bench [samples.csv [channel]]
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "kalman.h"
+
+// same as analog_hal.h
+#define BENCH_BUFFER_SIZE 4
+#define BENCH_KALMAN_R 225.0 // KALMAN_ADC_R
+#define BENCH_KALMAN_QX 0.05 // KALMAN_ADC_QX
+#define BENCH_KALMAN_QV 0.05 // KALMAN_ADC_QV
+#define BENCH_NOISE 15.0 // ADC bits, generated trace
+#define BENCH_REF_HALF 15 // half window of the zero-phase reference
+#define BENCH_MAX_SHIFT 20
+
+typedef struct
+{
+  std::vector<double> z; // measurements
+  std::vector<double> truth; // generated trace only
+  std::vector<char>   kind; // 'f' flat, 'r' ramp, 's' first sample after a step
+}Trace_t;
+
+static Trace_t generate(){
+  Trace_t t;
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise(0.0, BENCH_NOISE);
+  double level = 2500.0;
+  for (int cycle = 0; cycle < 6; cycle++){
+    for (int i = 0; i < 300; i++){ // flat
+      t.truth.push_back(level);
+      t.kind.push_back('f');
+    }
+    for (int i = 0; i < 600; i++){ // drying
+      level -= 0.8;
+      t.truth.push_back(level);
+      t.kind.push_back('r');
+    }
+    level += 700.0; // watering
+    t.truth.push_back(level);
+    t.kind.push_back('s');
+  }
+  for (double v : t.truth){
+    t.z.push_back(floor(v + noise(rng) + 0.5));
+  }
+  return t;
+}
+
+static Trace_t load_csv(const char* path, unsigned channel){
+  Trace_t t;
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    exit(2);
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long ts, ch, seq, value;
+    char stream[32];
+    if (sscanf(line, "%lu,%31[^,],%lu,%lu,%lu", &ts, stream, &ch, &seq, &value) == 5 &&
+        strcmp(stream, "raw_adc") == 0 && ch == channel) {
+      t.z.push_back((double)value);
+    }
+  }
+  fclose(f);
+  return t;
+}
+
+static std::vector<double> run_box(const std::vector<double>& z){
+  std::vector<double> out;
+  uint16_t buf[BENCH_BUFFER_SIZE];
+  uint8_t count = 0;
+  for (double v : z){
+    if (count < BENCH_BUFFER_SIZE) {
+      buf[count++] = (uint16_t)v;
+    } else {
+      memmove(buf, buf + 1, (BENCH_BUFFER_SIZE - 1) * sizeof(uint16_t));
+      buf[BENCH_BUFFER_SIZE - 1] = (uint16_t)v;
+    }
+    uint16_t sum = 0;
+    for (uint8_t i = 0; i < count; i++) sum += buf[i];
+    out.push_back(sum / count); // integer media, as analog_get_media()
+  }
+  return out;
+}
+
+static std::vector<double> run_kalman(const std::vector<double>& z, double qv, std::vector<double>* var){
+  std::vector<double> out;
+  Kalman_t k;
+  kalman_init(&k, KALMAN_Q(BENCH_KALMAN_R), KALMAN_Q(BENCH_KALMAN_QX), KALMAN_Q(qv));
+  for (double v : z){
+    kalman_update(&k, (int32_t)v);
+    out.push_back(kalman_value(&k));
+    if (var) var->push_back((double)kalman_variance(&k) / (1 << KALMAN_FRAC));
+  }
+  return out;
+}
+
+// noise and lag against a centered moving average
+static void against_reference(const std::vector<double>& z, const std::vector<double>& y, double* noise, int* lag){
+  size_t n = z.size();
+  std::vector<double> ref(n, 0.0);
+  for (size_t i = BENCH_REF_HALF; i + BENCH_REF_HALF < n; i++){
+    double s = 0;
+    for (int k = -BENCH_REF_HALF; k <= BENCH_REF_HALF; k++) s += z[i + k];
+    ref[i] = s / (2 * BENCH_REF_HALF + 1);
+  }
+  double best = 1e30;
+  *lag = 0;
+  for (int d = 0; d <= BENCH_MAX_SHIFT; d++){
+    double e = 0;
+    size_t m = 0;
+    for (size_t i = BENCH_REF_HALF + BENCH_MAX_SHIFT; i + BENCH_REF_HALF < n; i++){
+      e += (y[i] - ref[i - d]) * (y[i] - ref[i - d]);
+      m++;
+    }
+    e = sqrt(e / m);
+    if (e < best) {
+      best = e;
+      *lag = d;
+    }
+  }
+  *noise = best;
+}
+
+typedef struct
+{
+  double  flat_rms;
+  double  ramp_rms;
+  double  ramp_lag; // samples
+  double  step_90; // samples, mean over steps
+  double  err_var; // flat segments
+}Truth_t;
+
+static Truth_t against_truth(const Trace_t& t, const std::vector<double>& y){
+  Truth_t r = {};
+  double fe = 0, re = 0, rb = 0, steps = 0;
+  size_t fn = 0, rn = 0;
+  for (size_t i = 0; i < y.size(); i++){
+    double e = y[i] - t.truth[i];
+    bool settled = i >= 50 && t.kind[i - 50] == t.kind[i] && t.kind[i] != 's';
+    if (t.kind[i] == 'f' && settled) {
+      fe += e * e;
+      fn++;
+    } else if (t.kind[i] == 'r' && settled) {
+      re += e * e;
+      rb += e;
+      rn++;
+    } else if (t.kind[i] == 's') {
+      double jump = t.truth[i] - t.truth[i - 1];
+      size_t k = i;
+      while (k < y.size() && y[k] - t.truth[i - 1] < 0.9 * jump) k++;
+      r.step_90 += (double)(k - i);
+      steps++;
+    }
+  }
+  r.flat_rms = sqrt(fe / fn);
+  r.ramp_rms = sqrt(re / rn);
+  r.ramp_lag = (rb / rn) / -0.8; // estimate above a falling ramp: lag = bias / |slope|
+  r.step_90 /= steps;
+  r.err_var = fe / fn;
+  return r;
+}
+
+static double bench_ns(const std::vector<double>& z){
+  std::vector<int32_t> zi(z.begin(), z.end());
+  Kalman_t k;
+  kalman_init(&k, KALMAN_Q(BENCH_KALMAN_R), KALMAN_Q(BENCH_KALMAN_QX), KALMAN_Q(BENCH_KALMAN_QV));
+  const int rounds = 200;
+  int32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++){
+    for (int32_t v : zi){
+      kalman_update(&k, v);
+      sink += kalman_value(&k);
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  if (sink == 42) printf(" ");
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / (rounds * zi.size());
+}
+
+int main(int argc, char** argv){
+  int failures = 0;
+  bool generated = argc < 2;
+  Trace_t t = generated ? generate() : load_csv(argv[1], argc > 2 ? (unsigned)atoi(argv[2]) : 0);
+  if (t.z.size() < 4 * (BENCH_REF_HALF + BENCH_MAX_SHIFT)) {
+    fprintf(stderr, "trace too short\n");
+    return 2;
+  }
+  printf("trace: %s, %zu samples\n", generated ? "generated" : argv[1], t.z.size());
+  printf("filter,q_v,noise_rms,lag,flat_rms,ramp_rms,ramp_lag,step_90,var_est,var_meas\n");
+
+  std::vector<double> box = run_box(t.z);
+  double box_noise;
+  int box_lag;
+  against_reference(t.z, box, &box_noise, &box_lag);
+  Truth_t bt = {};
+  if (generated) bt = against_truth(t, box);
+  printf("box%u,-,%.2f,%d,%.2f,%.2f,%.2f,%.1f,-,%.1f\n", BENCH_BUFFER_SIZE, box_noise, box_lag,
+         bt.flat_rms, bt.ramp_rms, bt.ramp_lag, bt.step_90, bt.err_var);
+
+  const double qv_list[] = {0.01, BENCH_KALMAN_QV, 0.2}; // below 1/256 q_v rounds to 0 in Q8
+  for (double qv : qv_list){
+    std::vector<double> var;
+    std::vector<double> y = run_kalman(t.z, qv, &var);
+    double noise;
+    int lag;
+    against_reference(t.z, y, &noise, &lag);
+    Truth_t kt = {};
+    double var_est = 0;
+    if (generated) {
+      kt = against_truth(t, y);
+      size_t n = 0;
+      for (size_t i = 0; i < var.size(); i++){
+        if (t.kind[i] == 'f' && i >= 50 && t.kind[i - 50] == 'f') {
+          var_est += var[i];
+          n++;
+        }
+      }
+      var_est /= n;
+    }
+    printf("kalman,%g,%.2f,%d,%.2f,%.2f,%.2f,%.1f,%.1f,%.1f\n", qv, noise, lag, kt.flat_rms, kt.ramp_rms,
+           kt.ramp_lag, kt.step_90, var_est, kt.err_var);
+    if (generated && qv == BENCH_KALMAN_QV) {
+      if (kt.flat_rms >= bt.flat_rms || fabs(kt.ramp_lag) >= fabs(bt.ramp_lag)) {
+        fprintf(stderr, "FAIL: Kalman not better than the box average (noise %.2f/%.2f, ramp lag %.2f/%.2f)\n",
+                kt.flat_rms, bt.flat_rms, kt.ramp_lag, bt.ramp_lag);
+        failures++;
+      }
+      if (var_est > 3 * kt.err_var || var_est < kt.err_var / 3) {
+        fprintf(stderr, "FAIL: variance estimate %.1f against measured %.1f\n", var_est, kt.err_var);
+        failures++;
+      }
+    }
+  }
+  printf("\nkalman update: %.1f ns\n", bench_ns(t.z));
+  fprintf(stderr, "%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file log_decode.cpp
+ * @brief Host decoder of the binary deferred log
+ *
+ * Read the serial stream of a firmware built with DLOG_BINARY=1 (file or stdin), find the
+ * records after the DLOG_SYNC_0/DLOG_SYNC_1 bytes and print them formatted as on device.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -Iinclude tools/log_decode/log_decode.cpp src/dlog_fmt.cpp -o log_decode
+ *   ./log_decode capture.bin        or        cat /dev/ttyUSB0 | ./log_decode
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "dlog_fmt.h"
+
+int main(int argc, char** argv){
+  FILE* in = stdin;
+  if (argc > 1) {
+    in = fopen(argv[1], "rb");
+    if (in == NULL) {
+      fprintf(stderr, "cannot open %s\n", argv[1]);
+      return 1;
+    }
+  }
+
+  unsigned long records = 0, skipped = 0;
+  int prev = -1;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (prev != DLOG_SYNC_0 || c != DLOG_SYNC_1) {
+      if (prev != -1) {
+        skipped++; // text or noise between records
+      }
+      prev = c;
+      continue;
+    }
+    LogRecord_t rec;
+    if (fread(&rec, sizeof(rec), 1, in) != 1) {
+      break;
+    }
+    char line[256];
+    dlog_format(line, sizeof(line), &rec);
+    fputs(line, stdout);
+    records++;
+    prev = -1;
+  }
+  if (in != stdin) {
+    fclose(in);
+  }
+  fprintf(stderr, "%lu records, %lu bytes skipped\n", records, skipped);
+  return 0;
+}
@@ -0,0 +1,264 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file pipeline_bench.cpp
+ * @brief Host runner of the microbenchmark suite and baseline comparison
+ *
+ * Boot the firmware on the fakes of the native build, run the suite of src/bench.cpp
+ * (same cases as the on-target runner, [env:bench]) and print the results as CSV.
+ * Cycles are host time scaled to 240 MHz: compare host runs with host runs and board
+ * runs with board runs.
+ * - with --baseline, the run is compared with a stored result file
+ * - with --compare, two result files are compared without running the suite, e.g. the
+ *   Serial log of the board (non "bench," lines are ignored) against its baseline
+ * The suite is run several times (--runs, default 5) and each case keeps its best result:
+ * a single run of the host is disturbed by the other processes of the machine. The runner
+ * starts again with address space randomization off: the cheap cases change by up to 2x
+ * with the memory layout of the process, and a fixed layout makes runs repeatable. The
+ * stack is padded to the same offset in a page, whatever the size of argv and environment.
+ * Cases are compared after dividing by the speed factor of the machine, the ratio of the
+ * reference case (a fixed busy loop, no firmware code) to its baseline: a host that is
+ * slower as a whole does not fail the gate, firmware that is slower does, even when all
+ * of its cases slow down together. A failed comparison runs the suite again in a new
+ * process after a pause (BENCH_RETRIES times at most) before it is reported: a load of
+ * the host passes, and so does a process whose memory landed badly (a case can stay
+ * 30 % slower for the whole life of one process), a regression does not.
+ * A case regresses when its best cycles per result grow more than the tolerance (default
+ * 25 %) and more than 10 cycles (rounding). Rows are matched by case, parameters and
+ * calls per result: a baseline of other batch sizes is not compared.
+ *
+ * Build and run from the repository root, BUFFER_SIZE and NUM_PLANTS as build flags. Functions
+ * and loops are aligned: without it an unrelated change moves the cheap cases by up to 40 %.
+ *   g++ -std=gnu++17 -O2 -falign-functions=64 -falign-loops=64 -pthread -Inative/include -Iinclude \
+ *       -DNUM_PLANTS=1 -DBUFFER_SIZE=4 \
+ *       $(find src native/src -name '*.cpp' ! -name native_main.cpp) tools/pipeline_bench/pipeline_bench.cpp -o pipeline_bench
+ *   ./pipeline_bench [--baseline tools/pipeline_bench/baseline.csv] [--tolerance PCT] [--runs N]
+ *   ./pipeline_bench --compare new.csv base.csv [--tolerance PCT]
+ * Cycle time vs plant count (smartplant_update rows) and buffer size:
+ *   for p in 1 4 8 16; do for b in 4 16; do g++ ... -DNUM_PLANTS=$p -DBUFFER_SIZE=$b ... && ./pipeline_bench; done; done
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "bench.h"
+#include "peripheral.h"
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <alloca.h>
+#include <sys/personality.h>
+
+#define BENCH_TOLERANCE_PCT 25.0
+#define BENCH_NOISE_CYCLES 10
+#define BENCH_RUNS 5 // runs of the suite, best result of each case
+#define BENCH_RETRIES 3 // more processes before a regression is reported
+#define BENCH_RETRY_PAUSE_MS 5000 // wait for the load of the host to pass, it lasts seconds
+#define BENCH_RETRY_ENV "PIPELINE_BENCH_RETRY" // processes already run
+#define BENCH_LINE_MAX 256
+#define BENCH_STACK_PAGE 4096 // the suite runs at the same offset in a page of the stack
+
+typedef struct
+{
+  std::string name;
+  uint32_t    plants;
+  uint32_t    buffer;
+  uint32_t    calls;
+  uint32_t    cycles_min;
+}Row_t;
+
+extern SmartPlant_t SM_list;
+
+void setup();
+
+static uint16_t humidity_adc(uint8_t pin, int64_t now_us) {
+  return 2000 + rand() % 16;
+}
+
+static float temperature_c(uint8_t sensor, int64_t now_us) {
+  return 22.0f + (rand() % 10) * 0.01f;
+}
+
+// result lines of a file, false if it cannot be read
+static bool load(const char* path, std::vector<Row_t>* rows) {
+  FILE* f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+  char line[BENCH_LINE_MAX], name[64];
+  Row_t r;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    char* p = strstr(line, BENCH_PREFIX ",");
+    unsigned iterations, avg, ns;
+    if (p != NULL && sscanf(p, BENCH_PREFIX ",%63[^,],%u,%u,%u,%u,%u,%u,%u", name, &r.plants, &r.buffer,
+                            &r.calls, &iterations, &r.cycles_min, &avg, &ns) == 8) { // lines without calls skipped
+      r.name = name;
+      rows->push_back(r);
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+// row of the same case and parameters, NULL if none
+static const Row_t* find(const std::vector<Row_t>& rows, const Row_t& b) {
+  const Row_t* n = NULL;
+  for (const Row_t& r : rows) {
+    if (r.name == b.name && r.plants == b.plants && r.buffer == b.buffer && r.calls == b.calls) {
+      n = &r;
+    }
+  }
+  return n;
+}
+
+// ratio of the reference case to its baseline, 1 if there is none
+static double speed_factor(const std::vector<Row_t>& now, const std::vector<Row_t>& base) {
+  for (const Row_t& b : base) {
+    const Row_t* n = find(now, b);
+    if (n != NULL && b.name == BENCH_REFERENCE && b.cycles_min > 0) {
+      return (double)n->cycles_min / b.cycles_min;
+    }
+  }
+  return 1.0;
+}
+
+// compare every baseline row with the same case and parameters, true if no regression
+static bool compare(const std::vector<Row_t>& now, const std::vector<Row_t>& base, double tolerance, bool report) {
+  uint32_t regressions = 0, missing = 0;
+  double speed = speed_factor(now, base);
+  if (report) {
+    printf("compare,name,plants,buffer,base_cycles,cycles,change_pct,status\n");
+  }
+  for (const Row_t& b : base) {
+    const Row_t* n = find(now, b);
+    if (n == NULL) {
+      continue; // other build parameters
+    }
+    double expected = b.cycles_min * speed; // baseline on this machine
+    double change = b.cycles_min > 0 ? 100.0 * (n->cycles_min - expected) / expected : 0.0;
+    bool reference = b.name == BENCH_REFERENCE;
+    bool slower = !reference && change > tolerance && n->cycles_min > expected + BENCH_NOISE_CYCLES;
+    regressions += slower ? 1 : 0;
+    if (report) {
+      printf("compare,%s,%u,%u,%u,%u,%.1f,%s\n", b.name.c_str(), b.plants, b.buffer, b.cycles_min, n->cycles_min,
+             change, reference ? "reference" : slower ? "REGRESSION" : "ok");
+    }
+  }
+  for (const Row_t& r : now) {
+    bool found = false;
+    for (const Row_t& b : base) {
+      found = found || (r.name == b.name && r.plants == b.plants && r.buffer == b.buffer && r.calls == b.calls);
+    }
+    if (!found && report) {
+      printf("compare,%s,%u,%u,,%u,,NO_BASELINE\n", r.name.c_str(), r.plants, r.buffer, r.cycles_min);
+    }
+    missing += found ? 0 : 1;
+  }
+  if (!report) {
+    return regressions == 0;
+  }
+  fprintf(stderr, "%u regressions, %u cases without baseline (tolerance %.0f %%, machine speed factor %.2f)\n",
+          regressions, missing, tolerance, speed);
+  return regressions == 0;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int main(int argc, char** argv) {
+  int persona = personality(0xffffffff);
+  if (persona != -1 && (persona & ADDR_NO_RANDOMIZE) == 0 && personality(persona | ADDR_NO_RANDOMIZE) != -1) {
+    execv("/proc/self/exe", argv); // same memory layout every run, returns only on failure
+  }
+  const char* baseline = NULL;
+  const char* compare_new = NULL;
+  double tolerance = BENCH_TOLERANCE_PCT;
+  int runs = BENCH_RUNS;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baseline = argv[++i];
+    } else if (strcmp(argv[i], "--compare") == 0 && i + 2 < argc) {
+      compare_new = argv[++i];
+      baseline = argv[++i];
+    } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+      runs = atoi(argv[++i]) > 0 ? atoi(argv[i]) : 1;
+    } else {
+      fprintf(stderr, "usage: %s [--baseline FILE] [--compare NEW BASE] [--tolerance PCT] [--runs N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<Row_t> now, base;
+  if (baseline != NULL && !load(baseline, &base)) {
+    return 2;
+  }
+  if (compare_new != NULL) {
+    if (!load(compare_new, &now)) {
+      return 2;
+    }
+    bool ok = compare(now, base, tolerance, true);
+    fflush(stdout);
+    fprintf(stderr, "%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+  }
+
+  // argv and environment move the stack, a case changes by 30 % with its offset in a page
+  volatile uint8_t* pad = (uint8_t*)alloca(((uintptr_t)__builtin_frame_address(0) & (BENCH_STACK_PAGE - 1)) + 1);
+  pad[0] = 0;
+  srand(1);
+  native_serial_mute(true); // boot messages
+  native_set_analog_source(humidity_adc);
+  native_set_temperature_source(temperature_c);
+  native_bmp280_add(TEMP_I2CMUX ? 0 : NATIVE_I2CMUX_NONE, BMP280_ADDR_1);
+  native_clock_init(1.0);
+  native_attach("bench", configMAX_PRIORITIES - 1); // the firmware tasks never take the CPU
+  setup();
+
+  static BenchResult_t results[BENCH_MAX_RESULTS], run[BENCH_MAX_RESULTS];
+  uint8_t count = bench_run(&SM_list, NUM_PLANTS, results, BENCH_MAX_RESULTS);
+  for (int r = 1; r < runs; r++) {
+    uint8_t n = bench_run(&SM_list, NUM_PLANTS, run, BENCH_MAX_RESULTS);
+    for (uint8_t i = 0; i < n && i < count; i++) {
+      if (run[i].cycles_min < results[i].cycles_min) {
+        results[i] = run[i]; // same case order every run
+      }
+    }
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    now.push_back({results[i].name, results[i].plants, results[i].buffer, results[i].calls, results[i].cycles_min});
+  }
+  const char* retry = getenv(BENCH_RETRY_ENV);
+  int retries = retry != NULL ? atoi(retry) : 0;
+  if (baseline != NULL && retries < BENCH_RETRIES && !compare(now, base, tolerance, false)) {
+    char next[8];
+    snprintf(next, sizeof(next), "%d", retries + 1);
+    setenv(BENCH_RETRY_ENV, next, 1);
+    fprintf(stderr, "regression, run again in a new process (%d of %d)\n", retries + 1, BENCH_RETRIES);
+    usleep(BENCH_RETRY_PAUSE_MS * 1000);
+    execv("/proc/self/exe", argv); // new process: other memory, same layout, returns only on failure
+  }
+  native_serial_mute(false);
+  bench_print(results, count);
+  fflush(stdout);
+  native_serial_mute(true);
+
+  bool ok = count > 0;
+  if (baseline != NULL) {
+    ok = compare(now, base, tolerance, true) && ok;
+  }
+  fflush(stdout);
+  fprintf(stderr, "%s\n", ok ? "PASSED" : "FAILED");
+  fflush(stderr);
+  _exit(ok ? 0 : 1); // tasks never return
+}
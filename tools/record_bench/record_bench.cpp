@@ -0,0 +1,208 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file record_bench.cpp
+ * @brief Host tests and benchmarks of the plant record codec
+ *
+ * Encode and decode synthetic plant records (4 plants, one record per plant and second,
+ * missing temperatures included) in batches of the size used by each output.
+ * - round trip: every decoded record equals the encoded one
+ * - schema: batches with a shorter record size (no milliseconds) and a longer one (fields
+ *   of a newer version) are read, a wrong version, a truncated batch and a span over
+ *   RECORD_MAX_SPAN_S are rejected
+ * - throughput: records per second and MB/s of the encoder and the decoder, bytes per
+ *   record against a text line (snprintf/sscanf, as on Serial) and the raw struct
+ * Report on stdout, one CSV line per codec and batch size.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Iinclude tools/record_bench/record_bench.cpp src/record.cpp -o record_bench
+ *   ./record_bench
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "record.h"
+
+#define BENCH_PLANTS 4
+#define BENCH_RECORDS 400000
+#define BENCH_TEXT_RECORDS 100000 // text codec is slower
+#define BENCH_TEXT_LINE 64
+#define BENCH_EXTRA_BYTES 2 // fields appended by a newer version in the schema test
+
+static double now_s(){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static std::vector<PlantRecord_t> make_records(uint32_t n){
+  std::vector<PlantRecord_t> r(n);
+  srand(1);
+  for (uint32_t i = 0; i < n; i++) {
+    r[i].plant = (uint8_t)(i % BENCH_PLANTS);
+    r[i].s.ts = 1000 + i / BENCH_PLANTS;
+    r[i].s.temperature = rand() % 50 == 0 ? RECORD_TEMP_NONE : (int16_t)(rand() % 800 - 200);
+    r[i].s.humidity = (uint16_t)(rand() % 1001);
+    r[i].s.solar = (uint8_t)(rand() % 2);
+    r[i].s.alarm = (uint8_t)(rand() % 2);
+    r[i].ms = (uint16_t)(rand() % 1000);
+  }
+  return r;
+}
+
+static bool same(const PlantRecord_t* a, const PlantRecord_t* b){
+  return a->plant == b->plant && a->s.ts == b->s.ts && a->s.temperature == b->s.temperature &&
+         a->s.humidity == b->s.humidity && a->s.solar == b->s.solar && a->s.alarm == b->s.alarm && a->ms == b->ms;
+}
+
+static int test_schema(const std::vector<PlantRecord_t>& r){
+  int failures = 0;
+  uint8_t buf[RECORD_BATCH_SIZE(BENCH_PLANTS)];
+  size_t len = record_encode(r.data(), BENCH_PLANTS, buf, sizeof(buf));
+  PlantRecord_t out[BENCH_PLANTS];
+  if (len != sizeof(buf) || record_decode(buf, len, out, BENCH_PLANTS) != BENCH_PLANTS) {
+    fprintf(stderr, "FAIL: batch of %u records not read back\n", BENCH_PLANTS);
+    failures++;
+  }
+  // newer version: each record has BENCH_EXTRA_BYTES more, in the same version
+  uint8_t wide[RECORD_HEADER_SIZE + BENCH_PLANTS * (RECORD_BYTES + BENCH_EXTRA_BYTES)];
+  memcpy(wide, buf, RECORD_HEADER_SIZE);
+  wide[1] = RECORD_BYTES + BENCH_EXTRA_BYTES;
+  for (uint8_t i = 0; i < BENCH_PLANTS; i++) {
+    uint8_t* p = &wide[RECORD_HEADER_SIZE + i * (RECORD_BYTES + BENCH_EXTRA_BYTES)];
+    memcpy(p, &buf[RECORD_HEADER_SIZE + i * RECORD_BYTES], RECORD_BYTES);
+    memset(p + RECORD_BYTES, 0xA5, BENCH_EXTRA_BYTES);
+  }
+  bool ok = record_decode(wide, sizeof(wide), out, BENCH_PLANTS) == BENCH_PLANTS;
+  for (uint8_t i = 0; ok && i < BENCH_PLANTS; i++) {
+    ok = same(&out[i], &r[i]);
+  }
+  if (!ok) {
+    fprintf(stderr, "FAIL: records with appended fields not read\n");
+    failures++;
+  }
+  // first records of this version: no milliseconds
+  uint8_t narrow[RECORD_HEADER_SIZE + BENCH_PLANTS * RECORD_MIN_BYTES];
+  memcpy(narrow, buf, RECORD_HEADER_SIZE);
+  narrow[1] = RECORD_MIN_BYTES;
+  for (uint8_t i = 0; i < BENCH_PLANTS; i++) {
+    memcpy(&narrow[RECORD_HEADER_SIZE + i * RECORD_MIN_BYTES], &buf[RECORD_HEADER_SIZE + i * RECORD_BYTES], RECORD_MIN_BYTES);
+  }
+  ok = record_decode(narrow, sizeof(narrow), out, BENCH_PLANTS) == BENCH_PLANTS;
+  for (uint8_t i = 0; ok && i < BENCH_PLANTS; i++) {
+    PlantRecord_t e = r[i];
+    e.ms = 0;
+    ok = same(&out[i], &e);
+  }
+  if (!ok) {
+    fprintf(stderr, "FAIL: records of size %u not read\n", RECORD_MIN_BYTES);
+    failures++;
+  }
+  uint8_t bad[sizeof(buf)];
+  memcpy(bad, buf, sizeof(buf));
+  bad[0] = RECORD_VERSION + 1;
+  if (record_decode(bad, sizeof(bad), out, BENCH_PLANTS) >= 0 || record_decode(buf, len - 1, out, BENCH_PLANTS) >= 0 ||
+      record_decode(buf, len, out, BENCH_PLANTS - 1) >= 0) {
+    fprintf(stderr, "FAIL: wrong version, truncated batch or too many records accepted\n");
+    failures++;
+  }
+  PlantRecord_t span[2] = {r[0], r[0]};
+  span[1].s.ts += RECORD_MAX_SPAN_S + 1;
+  if (record_encode(span, 2, buf, sizeof(buf)) != 0 || record_encode(r.data(), BENCH_PLANTS, buf, sizeof(buf) - 1) != 0) {
+    fprintf(stderr, "FAIL: span over %u s or short buffer accepted\n", RECORD_MAX_SPAN_S);
+    failures++;
+  }
+  printf("schema: version %u, header %u bytes, record %u bytes, appended fields skipped, %s\n",
+         RECORD_VERSION, RECORD_HEADER_SIZE, RECORD_BYTES, failures ? "FAILED" : "ok");
+  return failures;
+}
+
+// encode then decode all records in batches of batch records
+static int bench_binary(const std::vector<PlantRecord_t>& r, uint8_t batch){
+  uint32_t n = (uint32_t)r.size() / batch * batch;
+  std::vector<uint8_t> buf((size_t)(n / batch) * RECORD_BATCH_SIZE(batch));
+  std::vector<PlantRecord_t> out(n);
+  double t0 = now_s();
+  size_t bytes = 0;
+  for (uint32_t i = 0; i < n; i += batch) {
+    bytes += record_encode(&r[i], batch, &buf[bytes], buf.size() - bytes);
+  }
+  double enc_s = now_s() - t0;
+  t0 = now_s();
+  size_t pos = 0;
+  uint32_t decoded = 0;
+  for (uint32_t i = 0; i < n; i += batch) {
+    int k = record_decode(&buf[pos], RECORD_BATCH_SIZE(batch), &out[i], batch);
+    decoded += k > 0 ? (uint32_t)k : 0;
+    pos += RECORD_BATCH_SIZE(batch);
+  }
+  double dec_s = now_s() - t0;
+  uint32_t errors = bytes == buf.size() && decoded == n ? 0 : 1;
+  for (uint32_t i = 0; i < n && errors == 0; i++) {
+    errors += same(&out[i], &r[i]) ? 0 : 1;
+  }
+  printf("binary,%u,%.2f,%.0f,%.0f,%.1f,%.1f\n", batch, (double)bytes / n, n / enc_s, n / dec_s,
+         bytes / enc_s / 1e6, bytes / dec_s / 1e6);
+  if (errors) {
+    fprintf(stderr, "FAIL: batches of %u records not read back (%u bytes, %u records)\n", batch, (unsigned)bytes, decoded);
+  }
+  return errors ? 1 : 0;
+}
+
+// one text line per record, as printed on Serial
+static int bench_text(const std::vector<PlantRecord_t>& r){
+  uint32_t n = BENCH_TEXT_RECORDS < r.size() ? BENCH_TEXT_RECORDS : (uint32_t)r.size();
+  std::vector<char> buf((size_t)n * BENCH_TEXT_LINE); // one line per slot: sscanf() never scans the whole buffer
+  double t0 = now_s();
+  size_t bytes = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    bytes += (size_t)snprintf(&buf[(size_t)i * BENCH_TEXT_LINE], BENCH_TEXT_LINE, "%u,%u,%.1f,%.1f,%u,%u\n",
+                              r[i].plant, r[i].s.ts, r[i].s.temperature / 10.0, r[i].s.humidity / 10.0,
+                              r[i].s.solar, r[i].s.alarm);
+  }
+  double enc_s = now_s() - t0;
+  t0 = now_s();
+  uint32_t errors = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    unsigned plant, ts, solar, alarm;
+    float temperature, humidity;
+    if (sscanf(&buf[(size_t)i * BENCH_TEXT_LINE], "%u,%u,%f,%f,%u,%u", &plant, &ts, &temperature, &humidity,
+               &solar, &alarm) != 6) {
+      errors++;
+      break;
+    }
+    errors += plant == r[i].plant && ts == r[i].s.ts ? 0 : 1;
+  }
+  double dec_s = now_s() - t0;
+  printf("text,1,%.2f,%.0f,%.0f,%.1f,%.1f\n", (double)bytes / n, n / enc_s, n / dec_s,
+         bytes / enc_s / 1e6, bytes / dec_s / 1e6);
+  return errors ? 1 : 0;
+}
+
+int main(){
+  std::vector<PlantRecord_t> r = make_records(BENCH_RECORDS);
+  int failures = test_schema(r);
+  printf("codec,batch,bytes_per_record,encode_records_per_s,decode_records_per_s,encode_mb_s,decode_mb_s\n");
+  const uint8_t batches[] = {1, BENCH_PLANTS, 25, 32, 255}; // BLE, one cycle, UART frame, uplink, largest
+  for (uint8_t b : batches) {
+    failures += bench_binary(r, b);
+  }
+  failures += bench_text(r);
+  printf("raw,1,%u,,,,\n", (unsigned)sizeof(PlantRecord_t));
+  fflush(stdout);
+  fprintf(stderr, "%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file record_decode.cpp
+ * @brief Host decoder of the plant record batches
+ *
+ * Read plant record batches (see record.h) written in hex, one batch per line, from a
+ * file or stdin: the uplink payloads printed by mosquitto_sub -F '%x', or the values of
+ * the BLE record characteristic copied from a BLE client. Every record becomes one CSV
+ * line (plant,ts,temperature,humidity,solar,alarm; ts in seconds with milliseconds),
+ * statistics at the end on stderr.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Iinclude tools/record_decode/record_decode.cpp src/record.cpp -o record_decode
+ *   mosquitto_sub -t 'smartplant/#' -F '%x' | ./record_decode > records.csv
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "record.h"
+
+#define MAX_LINE 4096
+
+static int hex_value(char c){
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = (char)tolower(c);
+  return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+// hex digits of a line, spaces ignored; -1 if not hex
+static int parse_hex(const char* line, uint8_t* out, size_t max){
+  size_t n = 0;
+  int high = -1;
+  for (const char* p = line; *p != '\0'; p++) {
+    if (isspace((unsigned char)*p)) {
+      continue;
+    }
+    int v = hex_value(*p);
+    if (v < 0) {
+      return -1;
+    }
+    if (high < 0) {
+      high = v;
+    } else if (n < max) {
+      out[n++] = (uint8_t)(high << 4 | v);
+      high = -1;
+    } else {
+      return -1;
+    }
+  }
+  return high < 0 ? (int)n : -1;
+}
+
+int main(int argc, char** argv){
+  FILE* in = stdin;
+  if (argc > 1) {
+    in = fopen(argv[1], "r");
+    if (in == NULL) {
+      fprintf(stderr, "cannot open %s\n", argv[1]);
+      return 1;
+    }
+  }
+
+  unsigned long batches = 0, bad = 0, records = 0;
+  char line[2 * MAX_LINE + 2];
+  uint8_t data[MAX_LINE];
+  printf("plant,ts,temperature,humidity,solar,alarm\n");
+  while (fgets(line, sizeof(line), in) != NULL) {
+    int len = parse_hex(line, data, sizeof(data));
+    RecordReader_t rd;
+    if (len == 0) {
+      continue; // empty line
+    }
+    if (len < 0 || !record_reader_init(&rd, data, (size_t)len)) {
+      bad++; // not hex, unknown version or truncated
+      continue;
+    }
+    PlantRecord_t r;
+    while (record_read(&rd, &r)) {
+      if (r.s.temperature == RECORD_TEMP_NONE) {
+        printf("%u,%u.%03u,,%.1f,%u,%u\n", r.plant, r.s.ts, r.ms, r.s.humidity / 10.0, r.s.solar, r.s.alarm);
+      } else {
+        printf("%u,%u.%03u,%.1f,%.1f,%u,%u\n", r.plant, r.s.ts, r.ms, r.s.temperature / 10.0, r.s.humidity / 10.0,
+               r.s.solar, r.s.alarm);
+      }
+      records++;
+    }
+    batches++;
+  }
+  if (in != stdin) {
+    fclose(in);
+  }
+  fprintf(stderr, "%lu batches (%lu bad), %lu records\n", batches, bad, records);
+  return 0;
+}
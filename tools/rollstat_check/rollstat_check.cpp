@@ -0,0 +1,167 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file rollstat_check.cpp
+ * @brief Host check of the rolling statistics against a brute force reference
+ *
+ * Feed a random walk (temperature-like, with spikes) to rollstat and, after every sample,
+ * compare mean, standard deviation, min and max with a brute force pass in double over
+ * the same samples (closed buckets of the window plus the open bucket). Report the worst
+ * error and the time per push for growing windows: it must not grow with the window.
+ * A sample held for k periods (rollstat_push_n) must match k single pushes.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Iinclude tools/rollstat_check/rollstat_check.cpp src/rollstat.cpp -o rollstat_check
+ *   ./rollstat_check
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "rollstat.h"
+
+#define CHECK_SAMPLES 20000
+#define CHECK_MAX_ERROR 0.01 // accepted error on mean and stddev (Celsius)
+#define BENCH_SAMPLES 2000000
+
+static float trace_next(float v){
+  v += ((rand() % 2001) - 1000) / 5000.0f; // +-0.2 per sample
+  if (rand() % 500 == 0) {
+    v += (rand() % 2) ? 8.0f : -8.0f; // spike
+  }
+  return v;
+}
+
+static double check(uint16_t window, uint16_t bucket_samples){
+  RollStat_t r;
+  rollstat_init(&r, window, bucket_samples, 0.1f);
+  std::vector<float> all;
+  double worst = 0;
+  float v = 20.0f;
+  srand(window * 1000 + bucket_samples);
+  for (int i = 0; i < CHECK_SAMPLES; i++){
+    v = trace_next(v);
+    rollstat_push(&r, v);
+    all.push_back(v);
+    // reference: samples of the closed buckets in the window and of the open bucket
+    size_t open = all.size() % bucket_samples;
+    size_t closed = (all.size() / bucket_samples) < window ? all.size() / bucket_samples : window;
+    size_t first = all.size() - open - closed * bucket_samples;
+    double sum = 0, sq = 0, mn = all[first], mx = all[first];
+    for (size_t k = first; k < all.size(); k++){
+      sum += all[k];
+      mn = all[k] < mn ? all[k] : mn;
+      mx = all[k] > mx ? all[k] : mx;
+    }
+    size_t n = all.size() - first;
+    double mean = sum / n;
+    for (size_t k = first; k < all.size(); k++){
+      sq += (all[k] - mean) * (all[k] - mean);
+    }
+    RollStatValue_t s;
+    rollstat_get(&r, &s);
+    if (s.n != n || s.min != (float)mn || s.max != (float)mx) {
+      fprintf(stderr, "FAIL: window %u x %u sample %d: n %u/%zu min %f/%f max %f/%f\n", window, bucket_samples,
+              i, s.n, n, s.min, mn, s.max, mx);
+      return 1e9;
+    }
+    double e = fabs(s.mean - mean);
+    double es = fabs(s.stddev - sqrt(sq / n));
+    e = es > e ? es : e;
+    worst = e > worst ? e : worst;
+  }
+  return worst;
+}
+
+static double bench_ns(uint16_t window, uint16_t bucket_samples){
+  RollStat_t r;
+  rollstat_init(&r, window, bucket_samples, 0.1f);
+  std::vector<float> trace(4096);
+  float v = 20.0f;
+  for (size_t k = 0; k < trace.size(); k++){
+    v = trace_next(v);
+    trace[k] = v;
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_SAMPLES; i++){
+    rollstat_push(&r, trace[i & 4095]);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  RollStatValue_t s;
+  rollstat_get(&r, &s);
+  if (s.n == 0) {
+    return 0; // keep the loop
+  }
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_SAMPLES;
+}
+
+int main(){
+  int failures = 0;
+  const uint16_t windows[] = {1, 4, 12, ROLLSTAT_MAX_BUCKETS};
+  const uint16_t buckets[] = {1, 7, 60};
+
+  printf("window,bucket_samples,worst_error,ns_per_push\n");
+  double ns_min = 1e9, ns_max = 0;
+  for (uint16_t w : windows){
+    for (uint16_t b : buckets){
+      double e = check(w, b);
+      double ns = bench_ns(w, b);
+      printf("%u,%u,%.6f,%.1f\n", w, b, e, ns);
+      if (e > CHECK_MAX_ERROR) {
+        fprintf(stderr, "FAIL: window %u x %u error %f\n", w, b, e);
+        failures++;
+      }
+      ns_min = ns < ns_min ? ns : ns_min;
+      ns_max = ns > ns_max ? ns : ns_max;
+    }
+  }
+  if (ns_max > 4 * ns_min) { // O(1): cost must not follow the window size
+    fprintf(stderr, "FAIL: push cost %.1f..%.1f ns depends on the window\n", ns_min, ns_max);
+    failures++;
+  }
+
+  // sample and hold: one rollstat_push_n() against k rollstat_push()
+  RollStat_t held, single;
+  rollstat_init(&held, 12, 60, 0.1f);
+  rollstat_init(&single, 12, 60, 0.1f);
+  float v = 20.0f;
+  srand(7);
+  for (int i = 0; i < 2000; i++){
+    v = trace_next(v);
+    uint32_t k = 1 + rand() % 150; // crosses bucket boundaries
+    rollstat_push_n(&held, v, k);
+    for (uint32_t j = 0; j < k; j++) rollstat_push(&single, v);
+  }
+  RollStatValue_t sh, ss;
+  rollstat_get(&held, &sh);
+  rollstat_get(&single, &ss);
+  printf("\nheld,n,mean,stddev,min,max,ewma\n");
+  printf("push_n,%u,%.4f,%.4f,%.4f,%.4f,%.4f\n", sh.n, sh.mean, sh.stddev, sh.min, sh.max, sh.ewma);
+  printf("push,%u,%.4f,%.4f,%.4f,%.4f,%.4f\n", ss.n, ss.mean, ss.stddev, ss.min, ss.max, ss.ewma);
+  if (sh.n != ss.n || sh.min != ss.min || sh.max != ss.max || fabs(sh.mean - ss.mean) > CHECK_MAX_ERROR ||
+      fabs(sh.stddev - ss.stddev) > CHECK_MAX_ERROR || fabs(sh.ewma - ss.ewma) > CHECK_MAX_ERROR) {
+    fprintf(stderr, "FAIL: held sample differs from single pushes\n");
+    failures++;
+  }
+
+  RollStat_t r;
+  if (rollstat_init(&r, 0, 1, 0.1f) || rollstat_init(&r, ROLLSTAT_MAX_BUCKETS + 1, 1, 0.1f) ||
+      rollstat_init(&r, 1, 0, 0.1f) || rollstat_init(&r, 1, 1, 0.0f)) {
+    fprintf(stderr, "FAIL: invalid parameters accepted\n");
+    failures++;
+  }
+  fprintf(stderr, "%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
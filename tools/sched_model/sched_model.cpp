@@ -0,0 +1,375 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file sched_model.cpp
+ * @brief Deterministic scheduler model of the firmware tasks with simulated stage costs
+ *
+ * Boot the firmware on the fakes of the native build with the virtual clock, so Task1,
+ * Task2 and Task3 run with the priorities, periods and blocking calls of task_a and
+ * scheduler.cpp. The code itself takes no device time: every stage timed by
+ * TELEMETRY_TIME() (built with TELEMETRY_STAGE_HOOK=1) is charged a cost, preemptible by
+ * the tick like on the board. Costs are exclusive (nested stages not included), board
+ * estimates by default, or the mean of the timing_us rows of a telemetry_decode CSV
+ * (nested stages subtracted from the task stages). A run is repeatable: change priorities,
+ * periods or costs and compare.
+ * Report on stdout (CSV sections):
+ * - cost: stage costs used
+ * - task: jobs, response time from release to end of the task stage, worst start delay,
+ *   deadline (Task1 and Task2 period, --alarm-deadline-ms for Task3) and misses
+ * - preemption: where a task lost the CPU (innermost stage) and to which task
+ * - race: a task reading SM_list (Task2, Task3) started while Task1 was preempted inside
+ *   smartplant_update(), i.e. read a half updated SM_list; writer stage and first time
+ * With --events FILE every scheduling and stage event is written (t_us,event,task,stage).
+ * PASSED when Task1 ran and no deadline was missed.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=gnu++17 -O2 -pthread -Inative/include -Iinclude -DTELEMETRY_STAGE_HOOK=1 \
+ *       $(find src native/src -name '*.cpp' ! -name native_main.cpp) tools/sched_model/sched_model.cpp -o sched_model
+ *   ./sched_model [--seconds N] [--timing samples.csv] [--cost STAGE=US ...] [--scale K]
+ *                 [--alarm-deadline-ms N] [--events events.csv]
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "smartplant.h"
+#include "peripheral.h"
+#include "scheduler.h"
+#include "config.h"
+#include "telemetry.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#define SCHED_SECONDS 600 // default run length, device time
+#define SCHED_ALARM_DEADLINE_MS 100 // alarm notification after the alarm stage
+#define SCHED_TEMP_PERIOD_S 120.0 // temperature swing crossing the hot threshold
+#define SCHED_SOLAR_PERIOD_S 30
+#define SCHED_NUM_STAGES (TLM_STAGE_STATS + 1)
+#define SCHED_MAX_DEPTH 8
+#define SCHED_LINE_MAX 256
+
+#if !TELEMETRY_STAGE_HOOK || TELEMETRY_MODE
+#error "build with -DTELEMETRY_STAGE_HOOK=1 and without TELEMETRY_MODE"
+#endif
+
+typedef struct
+{
+  std::string name;
+  int64_t   release_us; // last release, start of the response time
+  bool      released; // released since the end of the last job
+  uint8_t   stage[SCHED_MAX_DEPTH]; // open stages, innermost last
+  uint8_t   depth;
+  int8_t    update_stage; // last stage entered inside smartplant_update(), -1 outside
+  int64_t   deadline_us; // 0 for tasks outside the model
+  uint32_t  jobs;
+  uint32_t  misses;
+  int64_t   resp_min_us;
+  int64_t   resp_max_us;
+  int64_t   resp_sum_us;
+  int64_t   start_max_us; // worst delay from release to start of the task stage
+}TaskStat_t;
+
+typedef struct
+{
+  uint32_t  count;
+  int64_t   first_us;
+}Count_t;
+
+extern SmartPlant_t SM_list;
+
+void setup();
+
+static const char* stage_name[SCHED_NUM_STAGES] = {
+  "temperature", "solar", "humidity", "alarm", "display", "task1", "task2", "task3", "alarm_notify", "stats"
+};
+
+// board estimates in microseconds, NUM_PLANTS 1, CPU at 240 MHz
+static double stage_cost_us[SCHED_NUM_STAGES] = {
+  1100, // temperature: BMP280 read at 100 kHz
+  10, // solar
+  350, // humidity: ADC reads and filter
+  25, // alarm
+  23000, // display: SSD1306 frame at 400 kHz
+  400, // task1: configuration, history append, log
+  3000, // task2: six BLE notifications
+  300, // task3: alarm notification
+  0, // alarm_notify: not a timed stage
+  40 // stats
+};
+
+static std::map<TaskHandle_t, TaskStat_t> task_stat;
+static std::map<std::string, Count_t> preemptions; // "task,stage,by"
+static std::map<std::string, Count_t> races; // "reader,writer,writer_stage"
+static TaskHandle_t preempted = NULL;
+static FILE* events_out = NULL;
+static double cost_scale = 1.0;
+static int64_t alarm_deadline_us = SCHED_ALARM_DEADLINE_MS * 1000;
+
+static uint16_t humidity_adc(uint8_t pin, int64_t now_us) {
+  return 2000 + rand() % 16;
+}
+
+static float temperature_c(uint8_t sensor, int64_t now_us) {
+  return 22.0f + 10.5f * (float)sin(2.0 * M_PI * (now_us / 1e6) / SCHED_TEMP_PERIOD_S);
+}
+
+static uint8_t solar_level(uint8_t pin, int64_t now_us) {
+  return pin == SOLAR_SNS_1_pin ? (now_us / 1000000 / SCHED_SOLAR_PERIOD_S) % 2 : NATIVE_PIN_UNDRIVEN;
+}
+
+static void count(std::map<std::string, Count_t>& m, const std::string& key) {
+  Count_t& c = m[key];
+  c.first_us = c.count == 0 ? native_now_us() : c.first_us;
+  c.count++;
+}
+
+static TaskStat_t& stat_of(TaskHandle_t t) {
+  auto it = task_stat.find(t);
+  if (it == task_stat.end()) {
+    TaskStat_t s = {};
+    s.name = pcTaskGetName(t);
+    s.update_stage = -1;
+    s.resp_min_us = INT64_MAX;
+    it = task_stat.emplace(t, s).first;
+  }
+  return it->second;
+}
+
+static const char* open_stage(const TaskStat_t& s) {
+  return s.depth > 0 ? stage_name[s.stage[s.depth - 1]] : "-";
+}
+
+static void event(const char* ev, TaskHandle_t t, const char* stage) {
+  if (events_out != NULL) {
+    fprintf(events_out, "%lld,%s,%s,%s\n", (long long)native_now_us(), ev, pcTaskGetName(t), stage);
+  }
+}
+
+static void on_sched(NativeSched_t ev, TaskHandle_t t) {
+  TaskStat_t& s = stat_of(t);
+  switch (ev) {
+    case NATIVE_SCHED_READY:
+      s.release_us = native_now_us();
+      s.released = true;
+      event("ready", t, open_stage(s));
+      break;
+    case NATIVE_SCHED_RUN:
+      if (preempted != NULL) {
+        TaskStat_t& p = stat_of(preempted);
+        count(preemptions, p.name + "," + open_stage(p) + "," + s.name);
+        preempted = NULL;
+      }
+      event("run", t, open_stage(s));
+      break;
+    case NATIVE_SCHED_PREEMPT:
+      preempted = t;
+      event("preempt", t, open_stage(s));
+      break;
+    case NATIVE_SCHED_BLOCK:
+      event("block", t, open_stage(s));
+      break;
+  }
+}
+
+static bool is_task_stage(uint8_t stage) {
+  return stage == TLM_STAGE_TASK1 || stage == TLM_STAGE_TASK2 || stage == TLM_STAGE_TASK3;
+}
+
+// mean duration of each stage in the timing_us rows, nested stages subtracted
+static bool load_timing(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+  double sum[SCHED_NUM_STAGES] = {};
+  uint32_t n[SCHED_NUM_STAGES] = {};
+  char line[SCHED_LINE_MAX], stream[32];
+  unsigned long long ts;
+  unsigned channel, seq;
+  double value;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    if (sscanf(line, "%llu,%31[^,],%u,%u,%lf", &ts, stream, &channel, &seq, &value) == 5 &&
+        strcmp(stream, "timing_us") == 0 && channel < SCHED_NUM_STAGES) {
+      sum[channel] += value;
+      n[channel]++;
+    }
+  }
+  fclose(f);
+  double mean[SCHED_NUM_STAGES];
+  for (uint8_t i = 0; i < SCHED_NUM_STAGES; i++) {
+    mean[i] = n[i] > 0 ? sum[i] / n[i] : -1;
+  }
+  double update = 0, task1 = mean[TLM_STAGE_TASK1];
+  for (uint8_t i : { TLM_STAGE_TEMPERATURE, TLM_STAGE_SOLAR, TLM_STAGE_HUMIDITY, TLM_STAGE_ALARM, TLM_STAGE_STATS, TLM_STAGE_DISPLAY }) {
+    update += mean[i] > 0 ? mean[i] : 0;
+  }
+  mean[TLM_STAGE_TASK1] = task1 >= 0 ? (task1 > update ? task1 - update : 0) : -1;
+  for (uint8_t i = 0; i < SCHED_NUM_STAGES; i++) {
+    stage_cost_us[i] = mean[i] >= 0 ? mean[i] : stage_cost_us[i]; // estimate kept for the stages not in the file
+  }
+  return true;
+}
+
+static bool set_cost(const char* arg) {
+  for (uint8_t i = 0; i < SCHED_NUM_STAGES; i++) {
+    size_t len = strlen(stage_name[i]);
+    if (strncmp(arg, stage_name[i], len) == 0 && arg[len] == '=') {
+      stage_cost_us[i] = atof(arg + len + 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void telemetry_stage_begin(uint8_t stage) {
+  TaskHandle_t t = xTaskGetCurrentTaskHandle();
+  TaskStat_t& s = stat_of(t);
+  int64_t now = native_now_us();
+  if (is_task_stage(stage) && !s.released && s.deadline_us > 0) {
+    s.release_us += s.deadline_us; // period elapsed before the end of the last job: no block, nominal release
+  }
+  if (is_task_stage(stage) && now - s.release_us > s.start_max_us) {
+    s.start_max_us = now - s.release_us;
+  }
+  if (stage == TLM_STAGE_TASK2 || stage == TLM_STAGE_TASK3) { // readers of SM_list
+    for (auto& w : task_stat) {
+      if (w.first != t && w.second.update_stage >= 0) {
+        count(races, s.name + "," + w.second.name + "," + stage_name[w.second.update_stage]);
+      }
+    }
+  }
+  if (stage == TLM_STAGE_TEMPERATURE || stage == TLM_STAGE_SOLAR || stage == TLM_STAGE_HUMIDITY ||
+      stage == TLM_STAGE_ALARM || stage == TLM_STAGE_STATS) {
+    s.update_stage = stage; // smartplant_update() writes SM_list stage after stage
+  }
+  if (s.depth < SCHED_MAX_DEPTH) {
+    s.stage[s.depth++] = stage;
+  }
+  event("begin", t, stage_name[stage]);
+  native_spend_us((uint32_t)(stage_cost_us[stage] * cost_scale)); // the stage effects land at its end
+}
+
+void telemetry_stage_end(uint8_t stage) {
+  TaskHandle_t t = xTaskGetCurrentTaskHandle();
+  TaskStat_t& s = stat_of(t);
+  event("end", t, stage_name[stage]);
+  s.depth -= s.depth > 0 ? 1 : 0;
+  if (stage == TLM_STAGE_STATS) {
+    s.update_stage = -1; // last stage of smartplant_update()
+  }
+  if (is_task_stage(stage)) {
+    int64_t resp = native_now_us() - s.release_us;
+    s.jobs++;
+    s.resp_sum_us += resp;
+    s.resp_min_us = resp < s.resp_min_us ? resp : s.resp_min_us;
+    s.resp_max_us = resp > s.resp_max_us ? resp : s.resp_max_us;
+    s.deadline_us = stage == TLM_STAGE_TASK1 ? config_get()->task1_ms * 1000LL :
+                    stage == TLM_STAGE_TASK2 ? config_get()->task2_ms * 1000LL : alarm_deadline_us;
+    s.misses += resp > s.deadline_us ? 1 : 0;
+    s.released = false;
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t seconds = SCHED_SECONDS;
+  const char* timing = NULL;
+  std::vector<const char*> costs;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--timing") == 0 && i + 1 < argc) {
+      timing = argv[++i];
+    } else if (strcmp(argv[i], "--cost") == 0 && i + 1 < argc) {
+      costs.push_back(argv[++i]);
+    } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+      cost_scale = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--alarm-deadline-ms") == 0 && i + 1 < argc) {
+      alarm_deadline_us = atoll(argv[++i]) * 1000;
+    } else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+      events_out = fopen(argv[++i], "w");
+    } else {
+      fprintf(stderr, "usage: %s [--seconds N] [--timing FILE] [--cost STAGE=US] [--scale K] "
+              "[--alarm-deadline-ms N] [--events FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (timing != NULL && !load_timing(timing)) {
+    return 2;
+  }
+  for (const char* c : costs) { // after --timing: explicit costs win
+    if (!set_cost(c)) {
+      fprintf(stderr, "unknown stage in %s\n", c);
+      return 2;
+    }
+  }
+  if (events_out != NULL) {
+    fprintf(events_out, "t_us,event,task,stage\n");
+  }
+
+  srand(1);
+  native_serial_mute(true);
+  native_set_analog_source(humidity_adc);
+  native_set_temperature_source(temperature_c);
+  native_set_digital_source(solar_level);
+  native_bmp280_add(TEMP_I2CMUX ? 0 : NATIVE_I2CMUX_NONE, BMP280_ADDR_1);
+  native_set_sched_hook(on_sched);
+  native_clock_init(0);
+  native_attach("loopTask", 1);
+  setup();
+  native_ble_connect(true); // Task2 sends every period
+  vTaskDelay(pdMS_TO_TICKS(seconds * 1000));
+
+  printf("cost,stage,us\n");
+  for (uint8_t i = 0; i < SCHED_NUM_STAGES; i++) {
+    if (i != TLM_STAGE_ALARM_NOTIFY) {
+      printf("cost,%s,%.0f\n", stage_name[i], stage_cost_us[i] * cost_scale);
+    }
+  }
+  printf("task,name,jobs,resp_min_us,resp_avg_us,resp_max_us,start_max_us,deadline_us,misses\n");
+  bool ok = false;
+  uint32_t misses = 0;
+  for (auto& t : task_stat) {
+    const TaskStat_t& s = t.second;
+    if (s.jobs > 0) {
+      printf("task,%s,%u,%lld,%lld,%lld,%lld,%lld,%u\n", s.name.c_str(), s.jobs, (long long)s.resp_min_us,
+             (long long)(s.resp_sum_us / s.jobs), (long long)s.resp_max_us, (long long)s.start_max_us,
+             (long long)s.deadline_us, s.misses);
+      ok = ok || s.name == "Task 1";
+      misses += s.misses;
+    }
+  }
+  printf("preemption,task,stage,by,count,first_us\n");
+  for (auto& p : preemptions) {
+    printf("preemption,%s,%u,%lld\n", p.first.c_str(), p.second.count, (long long)p.second.first_us);
+  }
+  printf("race,reader,writer,writer_stage,count,first_us\n");
+  uint32_t race_count = 0;
+  for (auto& r : races) {
+    printf("race,%s,%u,%lld\n", r.first.c_str(), r.second.count, (long long)r.second.first_us);
+    race_count += r.second.count;
+  }
+  if (events_out != NULL) {
+    fclose(events_out);
+  }
+
+  ok = ok && misses == 0;
+  fflush(stdout);
+  fprintf(stderr, "%u s device time, %u deadline misses, %u SM_list races\n", seconds, misses, race_count);
+  fprintf(stderr, "%s\n", ok ? "PASSED" : "FAILED");
+  fflush(stderr);
+  _exit(ok ? 0 : 1); // tasks never return
+}
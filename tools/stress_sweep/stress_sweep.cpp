@@ -0,0 +1,179 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file stress_sweep.cpp
+ * @brief Host runner of the load stress harness: Task1 period x BLE centrals x plants
+ *
+ * Boot the firmware built with STRESS_MODE=1 (see include/stress.h) on the fakes of the
+ * native build, with the virtual clock and the device costs of the fakes on (ADC, OLED
+ * frame, BLE notify per central, TX buffers drained per connection interval, see
+ * native_set_device_costs()). The synthetic temperature sensors spend STRESS_SENSOR_US
+ * per read like on the board. One run per number of centrals (0 to --centrals, each in
+ * its own process since the firmware cannot be booted twice): the firmware sweeps the
+ * Task1 period and reports each window.
+ * Report on stdout: the "stress," lines of every run, then the "stress_sat," line of each
+ * run (slowest period from which every faster one drops samples or notifications, then the
+ * failing windows at slower periods).
+ * With --min-ms N the run FAILS if a configuration saturates or has a failing window at a
+ * period of N ms or more, i.e. the firmware must sustain N ms with NUM_PLANTS plants and up
+ * to --centrals centrals.
+ *
+ * Build and run from the repository root, NUM_PLANTS as build flag:
+ *   g++ -std=gnu++17 -O2 -pthread -Inative/include -Iinclude -DSTRESS_MODE=1 -DTELEMETRY_STAGE_HOOK=1 \
+ *       -DADAPTIVE_SAMPLING=0 -DCONFIG_TASK1_MIN_MS=10 -DNUM_PLANTS=4 \
+ *       $(find src native/src -name '*.cpp' ! -name native_main.cpp) tools/stress_sweep/stress_sweep.cpp -o stress_sweep
+ *   ./stress_sweep [--centrals N] [--min-ms N]
+ * Saturation vs plant count:
+ *   for p in 1 4 8 16; do g++ ... -DNUM_PLANTS=$p ... && ./stress_sweep; done
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "stress.h"
+#include "peripheral.h"
+#include "HAL/ble_hal.h"
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SWEEP_LINE_MAX 256
+#define SWEEP_SOLAR_PERIOD_S 30
+
+#if !STRESS_MODE
+#error "build with -DSTRESS_MODE=1 (see the build line above)"
+#endif
+
+void setup();
+
+static uint16_t humidity_adc(uint8_t pin, int64_t now_us) {
+  return 2000 + rand() % 16;
+}
+
+static uint8_t solar_level(uint8_t pin, int64_t now_us) {
+  return pin == SOLAR_SNS_1_pin ? (now_us / 1000000 / SWEEP_SOLAR_PERIOD_S) % 2 : NATIVE_PIN_UNDRIVEN;
+}
+
+// firmware with the given number of centrals, Serial on fd; never returns
+static void run_firmware(uint8_t centrals, int fd) {
+  dup2(fd, STDOUT_FILENO);
+  setvbuf(stdout, NULL, _IOLBF, 0); // the process is killed, not flushed at exit
+  srand(1);
+  native_set_analog_source(humidity_adc);
+  native_set_digital_source(solar_level);
+  native_set_device_costs(true);
+  native_clock_init(0);
+  native_attach("loopTask", 1);
+  setup();
+  native_ble_set_centrals(centrals);
+  while (true) {
+    vTaskDelay(pdMS_TO_TICKS(1000)); // the stress task reports, the parent stops the run
+  }
+}
+
+// run one configuration, keep its stress lines; false if the sweep did not complete
+static bool run(uint8_t centrals, std::vector<std::string>* steps, std::string* sat) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return false;
+  }
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    run_firmware(centrals, fds[1]);
+  }
+  close(fds[1]);
+  FILE* f = fdopen(fds[0], "r");
+  char line[SWEEP_LINE_MAX];
+  bool done = false;
+  while (!done && f != NULL && fgets(line, sizeof(line), f) != NULL) {
+    if (strncmp(line, STRESS_SAT_PREFIX ",", strlen(STRESS_SAT_PREFIX ",")) == 0) {
+      *sat = line;
+      done = true;
+    } else if (strncmp(line, STRESS_PREFIX ",", strlen(STRESS_PREFIX ",")) == 0 &&
+               strncmp(line, STRESS_PREFIX ",plants", strlen(STRESS_PREFIX ",plants")) != 0) {
+      steps->push_back(line);
+    }
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+  if (f != NULL) {
+    fclose(f);
+  }
+  return done;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int main(int argc, char** argv) {
+  int max_centrals = BLE_MAX_CENTRALS;
+  int min_ms = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--centrals") == 0 && i + 1 < argc) {
+      max_centrals = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc) {
+      min_ms = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--centrals N] [--min-ms N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (max_centrals < 0 || max_centrals > NATIVE_BLE_MAX_CENTRALS) {
+    fprintf(stderr, "--centrals must be 0..%u\n", NATIVE_BLE_MAX_CENTRALS);
+    return 2;
+  }
+
+  std::vector<std::string> steps, sats;
+  bool ok = true;
+  for (int c = 0; c <= max_centrals; c++) {
+    std::string sat;
+    if (!run((uint8_t)c, &steps, &sat)) {
+      fprintf(stderr, "%u plants, %d centrals: sweep did not complete\n", NUM_PLANTS, c);
+      ok = false;
+      continue;
+    }
+    sats.push_back(sat);
+    unsigned plants, centrals, task1_ms, failed, failed_ms;
+    char reason[32];
+    if (sscanf(sat.c_str(), STRESS_SAT_PREFIX ",%u,%u,%u,%31[^,],%u,%u", &plants, &centrals, &task1_ms, reason,
+               &failed, &failed_ms) == 6) {
+      if (task1_ms == 0) {
+        fprintf(stderr, "%u plants, %u centrals: no saturation down to the fastest period", plants, centrals);
+      } else {
+        fprintf(stderr, "%u plants, %u centrals: saturated at Task1 %u ms (%s)", plants, centrals, task1_ms, reason);
+        ok = ok && (min_ms == 0 || (int)task1_ms < min_ms);
+      }
+      if (failed > 0) {
+        fprintf(stderr, ", %u failing window(s) at slower periods, the slowest at %u ms", failed, failed_ms);
+        ok = ok && (min_ms == 0 || (int)failed_ms < min_ms);
+      }
+      fprintf(stderr, "\n");
+    }
+  }
+
+  printf("%s,plants,centrals,task1_ms,elapsed_ms,samples,dropped_samples,task1_max_us,"
+         "cpu0_pct,cpu1_pct,notify_sent,notify_dropped\n", STRESS_PREFIX);
+  for (const std::string& s : steps) {
+    fputs(s.c_str(), stdout);
+  }
+  printf("%s,plants,centrals,task1_ms,reason,failed_windows,failed_ms\n", STRESS_SAT_PREFIX);
+  for (const std::string& s : sats) {
+    fputs(s.c_str(), stdout);
+  }
+  fflush(stdout);
+  fprintf(stderr, "%s\n", ok ? "PASSED" : "FAILED");
+  fflush(stderr);
+  _exit(ok ? 0 : 1); // tasks never return
+}
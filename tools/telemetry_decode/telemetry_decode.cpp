@@ -0,0 +1,197 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file telemetry_decode.cpp
+ * @brief Linux decoder of the binary telemetry stream
+ *
+ * Read the stream of a firmware built with TELEMETRY_MODE=1 from a serial device, a
+ * capture file or stdin. Every record becomes one CSV line with typed columns
+ * (ts_us,stream,channel,seq,value), ready for pandas/pyarrow to convert to Parquet.
+ * Deferred log records and plant records (one per plant and cycle, see record.h) are
+ * printed on stderr, statistics at the end.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -Iinclude tools/telemetry_decode/telemetry_decode.cpp src/frame.cpp src/dlog_fmt.cpp src/record.cpp -o telemetry_decode
+ *   ./telemetry_decode -b 921600 /dev/ttyUSB0 > samples.csv
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "frame.h"
+#include "dlog_fmt.h"
+#include "telemetry_fmt.h"
+#include "record.h"
+
+#define MAX_FRAME 1024
+
+static volatile sig_atomic_t stop = 0;
+
+static const char* stream_name(uint8_t type){
+  switch (type) {
+    case TLM_RAW_ADC: return "raw_adc";
+    case TLM_FILTERED: return "filtered";
+    case TLM_TIMING: return "timing_us";
+    case TLM_RAW_CAPTURE: return "raw_capture";
+    case TLM_RAW_TEMPERATURE: return "raw_temperature";
+    case TLM_RAW_DIGITAL: return "raw_digital";
+    default: return "unknown";
+  }
+}
+
+static speed_t baud_constant(long baud){
+  switch (baud) {
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    default: return 0;
+  }
+}
+
+static int open_input(const char* path, long baud){
+  if (path == NULL) {
+    return STDIN_FILENO;
+  }
+  int fd = open(path, O_RDONLY | O_NOCTTY);
+  if (fd < 0 || !isatty(fd)) {
+    return fd;
+  }
+  struct termios tio;
+  tcgetattr(fd, &tio);
+  cfmakeraw(&tio);
+  speed_t speed = baud_constant(baud);
+  if (speed == 0) {
+    fprintf(stderr, "unsupported baud %ld\n", baud);
+    close(fd);
+    return -1;
+  }
+  cfsetispeed(&tio, speed);
+  cfsetospeed(&tio, speed);
+  tio.c_cc[VMIN] = 1;
+  tio.c_cc[VTIME] = 0;
+  tcsetattr(fd, TCSANOW, &tio);
+  return fd;
+}
+
+static void on_signal(int sig){
+  stop = 1;
+}
+
+int main(int argc, char** argv){
+  long baud = 921600;
+  const char* path = NULL;
+  for (int i = 1; i < argc; i++){
+    if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      baud = atol(argv[++i]);
+    } else {
+      path = argv[i];
+    }
+  }
+  int fd = open_input(path, baud);
+  if (fd < 0) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return 1;
+  }
+  signal(SIGINT, on_signal);
+
+  uint8_t encoded[MAX_FRAME];
+  uint8_t payload[MAX_FRAME];
+  size_t n = 0;
+  unsigned long frames = 0, bad_frames = 0, records = 0, lost = 0, logs = 0, plants = 0;
+  bool have_seq = false;
+  uint16_t next_seq = 0;
+
+  printf("ts_us,stream,channel,seq,value\n");
+  uint8_t buf[4096];
+  while (!stop) {
+    ssize_t got = read(fd, buf, sizeof(buf));
+    if (got <= 0) {
+      break;
+    }
+    for (ssize_t k = 0; k < got; k++){
+      if (buf[k] != FRAME_DELIMITER) {
+        if (n < sizeof(encoded)) {
+          encoded[n] = buf[k];
+        }
+        n++;
+        continue;
+      }
+      if (n == 0) {
+        continue;
+      }
+      int len = (n <= sizeof(encoded)) ? frame_decode(encoded, n, payload, sizeof(payload)) : -1;
+      n = 0;
+      if (len < TLM_HEADER_SIZE || payload[1] != TLM_VERSION) {
+        bad_frames++; // text before the first frame, corruption or unknown version
+        continue;
+      }
+      frames++;
+      RecordReader_t rd;
+      if (payload[0] == TLM_FRAME_LOG && len == TLM_HEADER_SIZE + (int)sizeof(LogRecord_t)) {
+        LogRecord_t rec;
+        char line[256];
+        memcpy(&rec, &payload[TLM_HEADER_SIZE], sizeof(rec));
+        dlog_format(line, sizeof(line), &rec);
+        fputs(line, stderr);
+        logs++;
+      } else if (payload[0] == TLM_FRAME_RECORDS &&
+                 len == TLM_HEADER_SIZE + payload[2] * (int)sizeof(TlmRecord_t)) {
+        for (uint8_t i = 0; i < payload[2]; i++){
+          TlmRecord_t rec;
+          memcpy(&rec, &payload[TLM_HEADER_SIZE + i * sizeof(TlmRecord_t)], sizeof(rec));
+          if (have_seq && rec.seq != next_seq) {
+            lost += (uint16_t)(rec.seq - next_seq);
+          }
+          have_seq = true;
+          next_seq = (uint16_t)(rec.seq + 1);
+          if (rec.type == TLM_FILTERED || rec.type == TLM_RAW_TEMPERATURE) {
+            float v;
+            memcpy(&v, &rec.value, sizeof(v));
+            printf("%u,%s,%u,%u,%.4f\n", rec.ts_us, stream_name(rec.type), rec.channel, rec.seq, v);
+          } else {
+            printf("%u,%s,%u,%u,%u\n", rec.ts_us, stream_name(rec.type), rec.channel, rec.seq, rec.value);
+          }
+          records++;
+        }
+      } else if (payload[0] == TLM_FRAME_PLANT &&
+                 record_reader_init(&rd, &payload[TLM_HEADER_SIZE], len - TLM_HEADER_SIZE)) {
+        PlantRecord_t r;
+        while (record_read(&rd, &r)) {
+          if (r.s.temperature == RECORD_TEMP_NONE) {
+            fprintf(stderr, "plant %u at %u.%03u s: temperature -, humidity %.1f %%, solar %u, alarm %u\n",
+                    r.plant, r.s.ts, r.ms, r.s.humidity / 10.0, r.s.solar, r.s.alarm);
+          } else {
+            fprintf(stderr, "plant %u at %u.%03u s: temperature %.1f C, humidity %.1f %%, solar %u, alarm %u\n",
+                    r.plant, r.s.ts, r.ms, r.s.temperature / 10.0, r.s.humidity / 10.0, r.s.solar, r.s.alarm);
+          }
+          plants++;
+        }
+      } else {
+        bad_frames++;
+      }
+    }
+  }
+  if (fd != STDIN_FILENO) {
+    close(fd);
+  }
+  fprintf(stderr, "%lu frames (%lu bad), %lu records, %lu lost, %lu log records, %lu plant records\n",
+          frames, bad_frames, records, lost, logs, plants);
+  return 0;
+}
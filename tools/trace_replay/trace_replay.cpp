@@ -0,0 +1,312 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file trace_replay.cpp
+ * @brief Replay of recorded sensor traces through the whole firmware
+ *
+ * Boot the firmware on the fakes of the native build with the virtual clock and feed its
+ * sensors from a trace: every analogRead(), BMP280 read and digitalRead() returns the last
+ * trace value of its source at the current device time (sample and hold). Tasks, alarm
+ * engine, BLE and display run unchanged, so weeks of data replay in seconds with the
+ * same outputs as the device, and two runs on the same trace give the same outputs.
+ *
+ * The trace is read from the CSV written by telemetry_decode from a board built with
+ * [env:trace] (raw streams: "raw_adc" by analog channel, "raw_temperature" by sensor index,
+ * "raw_digital" by digital channel, other rows ignored) or, without argument, generated:
+ * 14 days of daily temperature swing crossing the hot threshold, sand drying with a
+ * watering every 3 days, day/night light. Trace time 0 is the first record.
+ * Outputs:
+ * - stdout: every alarm notification as CSV (t_ms,plant,mask)
+ * - --ble FILE: every BLE notification as CSV (t_ms,uuid,hex value)
+ * - --frames FILE: every OLED frame that differs from the previous one, after a
+ *   "# t_ms=" line
+ * - stderr: summary and speed-up over real time
+ *
+ * Record on the board and replay from the repository root:
+ *   pio run -e trace -t upload && ./telemetry_decode -b 921600 /dev/ttyUSB0 > trace.csv
+ *   g++ -std=gnu++17 -O2 -pthread -Inative/include -Iinclude \
+ *       $(find src native/src -name '*.cpp' ! -name native_main.cpp) tools/trace_replay/trace_replay.cpp -o trace_replay
+ *   ./trace_replay [trace.csv] [--days N] [--ble ble.csv] [--frames frames.txt] > alarms.csv
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "smartplant.h"
+#include "peripheral.h"
+#include "HAL/ble_hal.h"
+#include "HAL/digital_hal.h"
+#include "HAL/amux_hal.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+
+#define REPLAY_DAYS 14 // generated trace length
+#define REPLAY_STEP_S 10 // generated trace, seconds between records
+#define REPLAY_WATER_DAYS 3 // generated trace, days between waterings
+#define REPLAY_POLL_MS 100 // main loop period, device time
+#define REPLAY_LINE_MAX 256
+
+typedef struct
+{
+  int64_t   t_us;
+  uint32_t  value; // ADC count, float bits or pin level
+}Sample_t;
+
+typedef std::vector<Sample_t> Source_t;
+
+extern SmartPlant_t SM_list;
+extern Analog_t analog_a[NUM_ANALOG_PERIP];
+extern Dig_t digital_a[NUM_DIG_PERIP];
+
+void setup();
+
+static Source_t analog_src[NUM_ANALOG_PERIP];
+static Source_t temperature_src[NATIVE_MAX_BMP280];
+static Source_t digital_src[NUM_DIG_PERIP];
+static FILE* ble_out = NULL;
+static FILE* frames_out = NULL;
+static std::string last_frame;
+static uint32_t alarm_notifications = 0, ble_notifications = 0, frames = 0, frames_written = 0;
+
+static bool sample_less(const Sample_t& a, const Sample_t& b) {
+  return a.t_us < b.t_us;
+}
+
+// last value of a source at the given time, the first one before it starts
+static bool sample_at(const Source_t& s, int64_t now_us, uint32_t* value) {
+  if (s.empty()) {
+    return false;
+  }
+  Sample_t key = { now_us, 0 };
+  auto it = std::upper_bound(s.begin(), s.end(), key, sample_less);
+  *value = it == s.begin() ? it->value : (it - 1)->value;
+  return true;
+}
+
+// analog channel read by analogRead() on a pin: direct channel or selected mux channel
+static int analog_channel(uint8_t pin) {
+#if AMUX_HUMIDITY
+  const uint8_t sig[AMUX_MAX_BANKS] = { AMUX_SIG_0_pin, AMUX_SIG_1_pin };
+  for (uint8_t b = 0; b < AMUX_NUM_BANKS; b++) {
+    if (pin == sig[b]) {
+      uint8_t k = native_get_digital(AMUX_S0_pin) | native_get_digital(AMUX_S1_pin) << 1 |
+                  native_get_digital(AMUX_S2_pin) << 2 | native_get_digital(AMUX_S3_pin) << 3;
+      return AMUX_FIRST_ch + b * AMUX_BANK_CHANNELS + k;
+    }
+  }
+#endif
+  for (uint8_t ch = 0; ch < NUM_ANALOG_PERIP; ch++) {
+    if (analog_a[ch].pin == pin) {
+      return ch;
+    }
+  }
+  return -1;
+}
+
+static uint16_t trace_adc(uint8_t pin, int64_t now_us) {
+  int ch = analog_channel(pin);
+  uint32_t v = 0;
+  return ch >= 0 && sample_at(analog_src[ch], now_us, &v) ? (uint16_t)v : 0;
+}
+
+static float trace_temperature(uint8_t sensor, int64_t now_us) {
+  uint32_t bits;
+  float v = 25.0f;
+  if (sample_at(temperature_src[sensor], now_us, &bits)) {
+    memcpy(&v, &bits, sizeof(v));
+  }
+  return v;
+}
+
+static uint8_t trace_digital(uint8_t pin, int64_t now_us) {
+  for (uint8_t ch = 0; ch < NUM_DIG_PERIP; ch++) {
+    uint32_t v;
+    if (digital_a[ch].pin == pin && sample_at(digital_src[ch], now_us, &v)) {
+      return v ? HIGH : LOW;
+    }
+  }
+  return NATIVE_PIN_UNDRIVEN; // outputs and pins without trace
+}
+
+static void on_notify(const BLECharacteristic* c) {
+  uint32_t t_ms = millis();
+  ble_notifications++;
+  if (c == characteristic_alarm && c->value.size() >= 2) { // [plant, mask]
+    printf("%u,%u,%u\n", t_ms, c->value[0], c->value[1]);
+    alarm_notifications++;
+  }
+  if (ble_out != NULL) {
+    fprintf(ble_out, "%u,%s,", t_ms, c->uuid.c_str());
+    for (uint8_t b : c->value) {
+      fprintf(ble_out, "%02x", b);
+    }
+    fputc('\n', ble_out);
+  }
+}
+
+static void on_frame(const char* frame) {
+  frames++;
+  if (frames_out != NULL && last_frame != frame) {
+    fprintf(frames_out, "# t_ms=%lu\n%s", millis(), frame);
+    frames_written++;
+  }
+  last_frame = frame;
+}
+
+// raw rows of the telemetry_decode CSV, micros() wrap undone; false if it cannot be read
+static bool load(const char* path, uint32_t* records) {
+  FILE* f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+  char line[REPLAY_LINE_MAX], stream[32];
+  unsigned long long ts;
+  unsigned channel, seq;
+  double value;
+  int64_t t0 = -1, wrap = 0, last = 0;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    if (sscanf(line, "%llu,%31[^,],%u,%u,%lf", &ts, stream, &channel, &seq, &value) != 5) {
+      continue; // header
+    }
+    int64_t t = (int64_t)ts + wrap;
+    if (t < last - 0x80000000LL) {
+      wrap += 0x100000000LL; // 32-bit micros() of the board wrapped
+      t += 0x100000000LL;
+    } else if (t > last + 0x80000000LL && wrap > 0) {
+      t -= 0x100000000LL; // record queued just before the wrap
+    }
+    last = std::max(last, t);
+    t0 = t0 < 0 ? t : t0;
+    Sample_t s = { t - t0, 0 };
+    if (strcmp(stream, "raw_adc") == 0 && channel < NUM_ANALOG_PERIP) {
+      s.value = (uint32_t)value;
+      analog_src[channel].push_back(s);
+    } else if (strcmp(stream, "raw_temperature") == 0 && channel < NATIVE_MAX_BMP280) {
+      float v = (float)value;
+      memcpy(&s.value, &v, sizeof(v));
+      temperature_src[channel].push_back(s);
+    } else if (strcmp(stream, "raw_digital") == 0 && channel < NUM_DIG_PERIP) {
+      s.value = (uint32_t)value;
+      digital_src[channel].push_back(s);
+    } else {
+      continue;
+    }
+    (*records)++;
+  }
+  fclose(f);
+  return true;
+}
+
+static void generate(uint32_t days, uint32_t* records) {
+  for (int64_t t = 0; t <= (int64_t)days * 86400; t += REPLAY_STEP_S) {
+    double day = fmod(t / 86400.0, 1.0);
+    float temp = (float)(22.0 - 10.0 * cos(2.0 * M_PI * (day - 0.125))); // 12 C at 3:00, 32 C at 15:00
+    double since_water = fmod(t / 86400.0, REPLAY_WATER_DAYS);
+    double pct = 70.0 - 20.0 * since_water; // 10 % before watering
+    uint8_t dark = day < 0.25 || day >= 0.75;
+    Sample_t s = { t * 1000000, 0 };
+    memcpy(&s.value, &temp, sizeof(temp));
+    temperature_src[0].push_back(s);
+    s.value = (uint32_t)lround(pct * 4095.0 / 100.0);
+    analog_src[HUMIDITY_1_ch].push_back(s);
+    s.value = dark;
+    digital_src[SOLAR_SNS_1_ch].push_back(s);
+    *records += 3;
+  }
+}
+
+// sort every source by time, return the time of the last record
+static int64_t sort_sources(Source_t* set, uint8_t count) {
+  int64_t end = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    std::stable_sort(set[i].begin(), set[i].end(), sample_less);
+    end = set[i].empty() ? end : std::max(end, set[i].back().t_us);
+  }
+  return end;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int main(int argc, char** argv) {
+  const char* path = NULL;
+  uint32_t days = REPLAY_DAYS;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+      days = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--ble") == 0 && i + 1 < argc) {
+      ble_out = fopen(argv[++i], "w");
+    } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames_out = fopen(argv[++i], "w");
+    } else if (argv[i][0] != '-' && path == NULL) {
+      path = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [trace.csv] [--days N] [--ble FILE] [--frames FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  uint32_t records = 0;
+  if (path != NULL) {
+    if (!load(path, &records)) {
+      return 2;
+    }
+  } else {
+    generate(days, &records);
+  }
+  int64_t end_us = std::max(sort_sources(analog_src, NUM_ANALOG_PERIP), sort_sources(digital_src, NUM_DIG_PERIP));
+  end_us = std::max(end_us, sort_sources(temperature_src, NATIVE_MAX_BMP280));
+  uint8_t sensors = 1;
+  for (uint8_t i = 0; i < NATIVE_MAX_BMP280; i++) {
+    sensors = temperature_src[i].empty() ? sensors : i + 1;
+  }
+
+  native_serial_mute(true);
+  native_set_analog_source(trace_adc);
+  native_set_temperature_source(trace_temperature);
+  native_set_digital_source(trace_digital);
+  for (uint8_t i = 0; i < (TEMP_I2CMUX ? sensors : 1); i++) {
+    native_bmp280_add(TEMP_I2CMUX ? i : NATIVE_I2CMUX_NONE, BMP280_ADDR_1); // index = sensor index of the board
+  }
+  native_ble_set_notify_hook(on_notify);
+  native_oled_set_frame_hook(on_frame);
+  printf("t_ms,plant,mask\n");
+
+  auto host_t0 = std::chrono::steady_clock::now();
+  native_clock_init(0);
+  native_attach("loopTask", 1);
+  setup();
+  native_ble_connect(true); // the central stays connected for the whole trace
+  while (native_now_us() < end_us) {
+    vTaskDelay(pdMS_TO_TICKS(REPLAY_POLL_MS));
+  }
+  double host_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - host_t0).count();
+
+  bool ok = records > 0 && SM_list.cycles > 0 && frames > 0;
+  fflush(stdout);
+  fprintf(stderr, "%u records, %.0f s of device time in %.2f s (x%.0f)\n", records, end_us / 1e6, host_s,
+          host_s > 0 ? end_us / 1e6 / host_s : 0.0);
+  fprintf(stderr, "%u Task1 cycles, %u alarm notifications, %u BLE notifications, %u OLED frames (%u written)\n",
+          SM_list.cycles, alarm_notifications, ble_notifications, frames, frames_written);
+  if (ble_out != NULL) {
+    fclose(ble_out);
+  }
+  if (frames_out != NULL) {
+    fclose(frames_out);
+  }
+  fprintf(stderr, "%s\n", ok ? "PASSED" : "FAILED");
+  fflush(stderr);
+  _exit(ok ? 0 : 1); // tasks never return
+}
@@ -0,0 +1,360 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file tsdb_bench.cpp
+ * @brief Host tests and benchmarks of the time-series store
+ *
+ * Run the store on a file-backed NOR flash emulator (writes can only clear bits, erase
+ * sets a sector to 0xFF, writes can be cut at any byte to emulate a power loss) with the
+ * geometry of the tsdb partition in partitions.csv.
+ * - capacity: 14 days of 1 Hz synthetic samples, compression ratio and write amplification
+ * - query: random time ranges checked against the generated samples, query time
+ * - wrap: small partition written several times, wear spread and oldest data dropped
+ * - power loss: writes cut at random bytes, remount and check no stored sample is lost
+ *   and at most TSDB_FLUSH_S + 1 samples of 1 Hz are lost per cut
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Iinclude tools/tsdb_bench/tsdb_bench.cpp src/tsdb.cpp src/frame.cpp -o tsdb_bench
+ *   ./tsdb_bench [flash.bin]
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "tsdb.h"
+
+#define BENCH_SECTOR_SIZE 4096
+#define BENCH_SECTORS (0x1F0000 / BENCH_SECTOR_SIZE) // tsdb partition in partitions.csv
+#define BENCH_DAYS 14
+#define BENCH_RAW_BYTES 16 // SmartPlant_t (12 bytes) + 32-bit timestamp
+
+typedef struct
+{
+  FILE*     file;
+  uint32_t  size;
+  uint32_t  erases[TSDB_MAX_SECTORS];
+  uint64_t  bytes_programmed;
+  int32_t   fail_after; // bytes before the power loss, -1 disabled
+  bool      dead; // power lost, every access fails until remount
+}Emu_t;
+
+static bool emu_read(Flash_t* f, uint32_t addr, void* dst, size_t len){
+  Emu_t* e = (Emu_t*)f->ctx;
+  if (e->dead || addr + len > e->size) {
+    return false;
+  }
+  fseek(e->file, addr, SEEK_SET);
+  return fread(dst, 1, len, e->file) == len;
+}
+
+static bool emu_write(Flash_t* f, uint32_t addr, const void* src, size_t len){
+  Emu_t* e = (Emu_t*)f->ctx;
+  if (e->dead || addr + len > e->size) {
+    return false;
+  }
+  uint8_t buf[TSDB_BLOCK_HEADER + TSDB_BLOCK_BYTES];
+  if (len > sizeof(buf)) {
+    return false;
+  }
+  size_t n = len;
+  if (e->fail_after >= 0 && (size_t)e->fail_after < len) {
+    n = (size_t)e->fail_after; // power loss in the middle of the write
+    e->dead = true;
+  }
+  if (e->fail_after >= 0) {
+    e->fail_after -= (int32_t)n;
+  }
+  fseek(e->file, addr, SEEK_SET);
+  if (fread(buf, 1, n, e->file) != n) {
+    return false;
+  }
+  for (size_t i = 0; i < n; i++){
+    buf[i] &= ((const uint8_t*)src)[i]; // NOR: program clears bits only
+  }
+  fseek(e->file, addr, SEEK_SET);
+  fwrite(buf, 1, n, e->file);
+  e->bytes_programmed += n;
+  return !e->dead;
+}
+
+static bool emu_erase(Flash_t* f, uint16_t sector){
+  Emu_t* e = (Emu_t*)f->ctx;
+  if (e->dead) {
+    return false;
+  }
+  uint8_t ff[BENCH_SECTOR_SIZE];
+  memset(ff, 0xFF, sizeof(ff));
+  fseek(e->file, (long)sector * BENCH_SECTOR_SIZE, SEEK_SET);
+  fwrite(ff, 1, sizeof(ff), e->file);
+  e->erases[sector]++;
+  return true;
+}
+
+static void emu_open(Emu_t* e, Flash_t* f, const char* path, uint16_t sectors){
+  memset(e, 0, sizeof(Emu_t));
+  e->file = fopen(path, "w+b");
+  if (e->file == NULL) {
+    fprintf(stderr, "cannot open %s\n", path);
+    exit(1);
+  }
+  e->size = (uint32_t)sectors * BENCH_SECTOR_SIZE;
+  e->fail_after = -1;
+  uint8_t ff[BENCH_SECTOR_SIZE];
+  memset(ff, 0xFF, sizeof(ff));
+  for (uint16_t i = 0; i < sectors; i++){
+    fwrite(ff, 1, sizeof(ff), e->file); // new chip: erased
+  }
+  f->sector_size = BENCH_SECTOR_SIZE;
+  f->sector_count = sectors;
+  f->read = emu_read;
+  f->write = emu_write;
+  f->erase = emu_erase;
+  f->ctx = e;
+}
+
+// synthetic plant: daily temperature cycle, slow drying with daily watering, day/night solar
+static TsdbSample_t synthetic_sample(uint32_t i){
+  TsdbSample_t s;
+  double day = (i % 86400) / 86400.0;
+  double temperature = 23.0 + 5.0 * sin(2.0 * M_PI * (day - 0.25)) + 0.04 * sin(i * 0.7);
+  double humidity = 70.0 - 30.0 * day + 0.03 * sin(i * 1.3);
+  s.ts = 1000 + i + i / 3600; // 1 Hz with one skipped second per hour
+  s.temperature = (int16_t)lround(temperature * 10.0);
+  s.humidity = (uint16_t)lround(humidity * 10.0);
+  s.solar = (day > 0.25 && day < 0.75) ? 0 : 1;
+  s.alarm = temperature > 30.0 ? 1 : 0;
+  return s;
+}
+
+static uint32_t index_of_ts(uint32_t ts){
+  // inverse of the synthetic timestamp: ts - 1000 = i + i / 3600
+  uint32_t t = ts - 1000;
+  uint32_t i = t - t / 3601;
+  while (1000 + i + i / 3600 < ts) i++;
+  while (i > 0 && 1000 + i + i / 3600 > ts) i--;
+  return i;
+}
+
+typedef struct
+{
+  uint32_t  next; // index of the expected sample
+  uint32_t  errors;
+  uint32_t  last_ts;
+}Check_t;
+
+static bool check_cb(const TsdbSample_t* s, void* arg){
+  Check_t* c = (Check_t*)arg;
+  TsdbSample_t e = synthetic_sample(c->next);
+  if (memcmp(s, &e, sizeof(TsdbSample_t)) != 0 && c->errors++ < 5) {
+    fprintf(stderr, "  mismatch at ts %u (expected %u)\n", s->ts, e.ts);
+  }
+  c->next++;
+  c->last_ts = s->ts;
+  return true;
+}
+
+static bool count_cb(const TsdbSample_t* s, void* arg){
+  Check_t* c = (Check_t*)arg;
+  if (s->ts <= c->last_ts && c->next > 0) {
+    c->errors++;
+  }
+  c->last_ts = s->ts;
+  c->next++;
+  return true;
+}
+
+static double now_s(){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static int bench_capacity(const char* path, Tsdb_t* db){
+  Emu_t emu;
+  Flash_t f;
+  emu_open(&emu, &f, path, BENCH_SECTORS);
+  tsdb_mount(db, &f);
+
+  const uint32_t n = BENCH_DAYS * 86400;
+  double t0 = now_s();
+  for (uint32_t i = 0; i < n; i++){
+    TsdbSample_t s = synthetic_sample(i);
+    tsdb_append(db, &s);
+  }
+  tsdb_flush(db);
+  double append_s = now_s() - t0;
+
+  uint64_t raw = (uint64_t)n * BENCH_RAW_BYTES;
+  uint32_t used = db->count * BENCH_SECTOR_SIZE;
+  printf("capacity: %u samples (%u days at 1 Hz) in %u/%u sectors\n", n, BENCH_DAYS, db->count, BENCH_SECTORS);
+  printf("  raw %llu bytes, programmed %llu bytes, %.2f bytes/sample, compression ratio %.1fx\n",
+         (unsigned long long)raw, (unsigned long long)emu.bytes_programmed,
+         (double)emu.bytes_programmed / n, (double)raw / emu.bytes_programmed);
+  printf("  write amplification %.3f (erased bytes / programmed bytes), %u blocks, %.1f samples/block\n",
+         (double)db->stats.erases * BENCH_SECTOR_SIZE / emu.bytes_programmed,
+         db->stats.blocks, (double)n / db->stats.blocks);
+  printf("  days that fit the partition: %.1f\n", (double)BENCH_DAYS * BENCH_SECTORS * BENCH_SECTOR_SIZE / used);
+  printf("  append %.0f ns/sample\n", append_s * 1e9 / n);
+
+  int failures = 0;
+  if (db->count == BENCH_SECTORS) {
+    fprintf(stderr, "FAIL: %u days do not fit the partition\n", BENCH_DAYS);
+    failures++;
+  }
+
+  // remount and check every sample
+  tsdb_mount(db, &f);
+  Check_t c = {};
+  t0 = now_s();
+  uint32_t found = tsdb_query(db, 0, 0xFFFFFFFF, check_cb, &c);
+  printf("  full scan after remount %.3f s (%u samples)\n", now_s() - t0, found);
+  if (found != n || c.errors > 0 || tsdb_last_ts(db) != synthetic_sample(n - 1).ts) {
+    fprintf(stderr, "FAIL: full scan %u/%u samples, %u mismatches\n", found, n, c.errors);
+    failures++;
+  }
+
+  // random one hour ranges
+  const int queries = 2000;
+  uint32_t bad = 0;
+  t0 = now_s();
+  for (int q = 0; q < queries; q++){
+    uint32_t from = synthetic_sample(rand() % n).ts;
+    uint32_t to = from + 3600;
+    Check_t cq = {};
+    cq.next = index_of_ts(from);
+    uint32_t got = tsdb_query(db, from, to, check_cb, &cq);
+    uint32_t last = index_of_ts(to < tsdb_last_ts(db) ? to : tsdb_last_ts(db));
+    if (got != last - index_of_ts(from) + 1 || cq.errors > 0) {
+      bad++;
+    }
+  }
+  printf("  1 hour range query %.1f us\n", (now_s() - t0) * 1e6 / queries);
+  if (bad > 0) {
+    fprintf(stderr, "FAIL: %u range queries returned wrong samples\n", bad);
+    failures++;
+  }
+  fclose(emu.file);
+  return failures;
+}
+
+static int bench_wrap(const char* path, Tsdb_t* db){
+  Emu_t emu;
+  Flash_t f;
+  const uint16_t sectors = 16;
+  emu_open(&emu, &f, path, sectors);
+  tsdb_mount(db, &f);
+
+  int failures = 0;
+  const uint32_t n = 2000000; // several times the capacity of 16 sectors
+  for (uint32_t i = 0; i < n; i++){
+    TsdbSample_t s = synthetic_sample(i);
+    tsdb_append(db, &s);
+    if (i % 250000 == 0) {
+      tsdb_flush(db);
+      tsdb_mount(db, &f); // reboot
+    }
+  }
+  tsdb_flush(db);
+  tsdb_mount(db, &f);
+
+  uint32_t min = 0xFFFFFFFF, max = 0;
+  for (uint16_t i = 0; i < sectors; i++){
+    min = emu.erases[i] < min ? emu.erases[i] : min;
+    max = emu.erases[i] > max ? emu.erases[i] : max;
+  }
+  Check_t c = {};
+  uint32_t first_ts = db->first_ts[0];
+  c.next = index_of_ts(first_ts);
+  uint32_t found = tsdb_query(db, 0, 0xFFFFFFFF, check_cb, &c);
+  printf("wrap: %u samples on %u sectors, erases per sector min %u max %u, %u samples retained\n",
+         n, sectors, min, max, found);
+  if (max - min > 1 || c.errors > 0 || c.last_ts != synthetic_sample(n - 1).ts || db->count != sectors) {
+    fprintf(stderr, "FAIL: wear spread %u, %u mismatches\n", max - min, c.errors);
+    failures++;
+  }
+  fclose(emu.file);
+  return failures;
+}
+
+static int bench_power_loss(const char* path, Tsdb_t* db){
+  Emu_t emu;
+  Flash_t f;
+  const uint16_t sectors = 8;
+  const int rounds = 500;
+  emu_open(&emu, &f, path, sectors);
+  tsdb_mount(db, &f);
+
+  int failures = 0;
+  uint32_t i = 0, torn = 0, lost = 0, lost_max = 0;
+  for (int r = 0; r < rounds; r++){
+    emu.fail_after = rand() % 20000; // power lost somewhere in the next writes
+    while (!emu.dead) {
+      TsdbSample_t s = synthetic_sample(i);
+      tsdb_append(db, &s);
+      i++;
+    }
+    // reboot: samples of the torn block and of the RAM block are lost, no other
+    uint32_t durable = tsdb_last_ts(db);
+    emu.dead = false;
+    emu.fail_after = -1;
+    tsdb_mount(db, &f);
+    torn += db->stats.torn_blocks;
+
+    Check_t c = {};
+    tsdb_query(db, 0, 0xFFFFFFFF, count_cb, &c);
+    uint32_t last = tsdb_last_ts(db);
+    if (c.errors > 0 || last > durable || (db->count > 0 && c.last_ts != last)) {
+      failures++;
+    }
+    if (last > 0) {
+      i = index_of_ts(last) + 1; // continue after the newest stored sample
+    }
+    uint32_t n = index_of_ts(durable) - (last > 0 ? index_of_ts(last) : 0);
+    lost += n;
+    lost_max = n > lost_max ? n : lost_max;
+
+    // appending after the recovery must work
+    TsdbSample_t s = synthetic_sample(i);
+    if (!tsdb_append(db, &s) || !tsdb_flush(db)) {
+      failures++;
+    }
+    i++;
+  }
+  printf("power loss: %d cuts, %u torn blocks skipped at mount, %.1f samples lost per cut, max %u (bound %u)\n",
+         rounds, torn, (double)lost / rounds, lost_max, TSDB_FLUSH_S + 1);
+  if (lost_max > TSDB_FLUSH_S + 1) {
+    fprintf(stderr, "FAIL: %u samples lost by a cut, flush bound %u s\n", lost_max, TSDB_FLUSH_S);
+    failures++;
+  }
+  if (failures > 0) {
+    fprintf(stderr, "FAIL: %d recoveries lost or reordered samples\n", failures);
+  }
+  fclose(emu.file);
+  return failures;
+}
+
+int main(int argc, char** argv){
+  const char* path = argc > 1 ? argv[1] : "tsdb_flash.bin";
+  static Tsdb_t db;
+  srand(1);
+
+  int failures = 0;
+  failures += bench_capacity(path, &db);
+  failures += bench_wrap(path, &db);
+  failures += bench_power_loss(path, &db);
+  remove(path);
+  fprintf(stderr, "%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
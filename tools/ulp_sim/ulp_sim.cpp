@@ -0,0 +1,126 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file ulp_sim.cpp
+ * @brief Host simulator of the ULP humidity program
+ *
+ * Feed a trace of raw ADC samples (one value per line, first CSV column) to the ULP
+ * reference model and print one CSV line for every wake-up of the main cores.
+ * Without a trace file a synthetic trace (slow drift, noise, single spikes and a step)
+ * is generated and the spike/batch/threshold rules are checked.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -Iinclude tools/ulp_sim/ulp_sim.cpp src/HAL/ulp_model.cpp -o ulp_sim
+ *   ./ulp_sim [trace.csv]
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "HAL/ulp_model.h"
+
+#define SIM_RANGE ((4095 * 300) / 3320) // same as RANGE in analog_hal.h
+#define SIM_LIMIT 3 // same as LIMIT_ADC_SPIKE in analog_hal.h
+#define SIM_TH_HIGH ((4095 * 80) / 100)
+#define SIM_TH_LOW ((4095 * 20) / 100)
+#define SIM_SAMPLES 20000
+
+static uint16_t synthetic_sample(uint32_t i){
+  int value = 1500 + (int)(i / 40) % 200 + (rand() % 21) - 10; // drift + noise
+  if (i % 997 == 500) {
+    value += 2000; // single spike, must be rejected
+  }
+  if (i >= 15000) {
+    value += 2000; // persistent step, must be accepted and cross ULP_TH_HIGH
+  }
+  return (uint16_t)(value < 0 ? 0 : (value > 4095 ? 4095 : value));
+}
+
+int main(int argc, char** argv){
+  uint16_t mem[ULP_VAR_WORDS];
+  uint16_t batch[ULP_BATCH_SIZE];
+  ulp_model_init(mem, SIM_RANGE, SIM_LIMIT, SIM_TH_HIGH, SIM_TH_LOW);
+
+  FILE* trace = NULL;
+  if (argc > 1) {
+    trace = fopen(argv[1], "r");
+    if (trace == NULL) {
+      fprintf(stderr, "cannot open %s\n", argv[1]);
+      return 1;
+    }
+  }
+
+  uint32_t samples = 0, wakes = 0, batch_wakes = 0, threshold_wakes = 0, batch_samples = 0;
+  uint16_t max_media = 0;
+  printf("sample,raw,media,reason,batch_n\n");
+  while (true) {
+    uint16_t raw;
+    if (trace) {
+      char line[64];
+      if (fgets(line, sizeof(line), trace) == NULL) {
+        break;
+      }
+      raw = (uint16_t)atoi(line);
+    } else {
+      if (samples >= SIM_SAMPLES) {
+        break;
+      }
+      raw = synthetic_sample(samples);
+    }
+    samples++;
+
+    uint16_t reason = ulp_model_step(mem, raw);
+    if (mem[ULP_VAR_MEDIA] > max_media && samples < 15000) {
+      max_media = mem[ULP_VAR_MEDIA];
+    }
+    if (reason != ULP_WAKE_NONE) {
+      // main cores: drain the batch and clear the reason, as ulp_hal.cpp does
+      wakes++;
+      batch_wakes += (reason & ULP_WAKE_BATCH) ? 1 : 0;
+      threshold_wakes += (reason & ULP_WAKE_THRESHOLD) ? 1 : 0;
+      printf("%u,%u,%u,%u,%u\n", samples, raw, mem[ULP_VAR_MEDIA], reason, mem[ULP_VAR_BATCH_N]);
+      for (uint16_t i = 0; i < mem[ULP_VAR_BATCH_N]; i++){
+        batch[i] = mem[ULP_VAR_BATCH + i];
+      }
+      batch_samples += mem[ULP_VAR_BATCH_N];
+      mem[ULP_VAR_BATCH_N] = 0;
+      mem[ULP_VAR_WAKE] = 0;
+    }
+  }
+  (void)batch;
+  if (trace) {
+    fclose(trace);
+  }
+
+  fprintf(stderr, "%u samples, %u wake-ups (%u batch, %u threshold), %.1f samples/wake-up\n",
+          samples, wakes, batch_wakes, threshold_wakes, wakes ? (float)samples / wakes : 0.0f);
+  if (trace) {
+    return 0;
+  }
+
+  // synthetic trace checks
+  int failures = 0;
+  if (max_media > 1500 + 200 + 10 + SIM_RANGE) {
+    fprintf(stderr, "FAIL: spike reached the average (%u)\n", max_media);
+    failures++;
+  }
+  if (threshold_wakes == 0 || mem[ULP_VAR_ZONE] != ULP_ZONE_HIGH) {
+    fprintf(stderr, "FAIL: step above threshold did not wake main cores\n");
+    failures++;
+  }
+  if (batch_wakes < batch_samples / ULP_BATCH_SIZE) {
+    fprintf(stderr, "FAIL: missing batch wake-ups\n");
+    failures++;
+  }
+  fprintf(stderr, "%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2025 Marconatale Parise. All rights reserved.
+ *
+ * This file is part of proprietary software. Unauthorized copying, distribution,
+ * or modification of this file, via any medium, is strictly prohibited without
+ * prior written permission from the copyright holder.
+ *
+ *****************************************************************************/
+/**
+ * @file uplink_sim.cpp
+ * @brief Host runner of the Wi-Fi MQTT uplink: outages, store and forward, drain rate
+ *
+ * Boot the firmware built with WIFI_UPLINK=1 on the fakes of the native build, with the
+ * virtual clock, and publish to the in-process broker of the Wi-Fi fake. The access point
+ * and the broker go down for the given outages (minutes), and the first PUBACKs are lost
+ * so the firmware sends them again with DUP. Every payload received by the broker is
+ * decoded. After each outage the backlog (RAM ring + flash history) is measured until it
+ * is drained.
+ * Report on stdout:
+ * - "drain," one line per outage: backlog at the end of the outage, drain time and rate
+ * - "uplink," one summary line: records, batches, payload size, duplicates, reconnects
+ * The run FAILS if a plant 1 record of the flash history older than the newest one
+ * received never reached the broker, if records were lost, or if a backlog was not
+ * drained before the end.
+ *
+ * With --broker HOST:PORT the firmware publishes to a real broker instead, e.g. a local
+ * Mosquitto (mosquitto -p 1883; mosquitto_sub -t 'smartplant/#' -F '%x' | ./record_decode to
+ * watch the records), on the real time clock times --speed: the broker is not observed, the run
+ * checks the records acknowledged by its PUBACKs.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=gnu++17 -O2 -pthread -Inative/include -Iinclude -DWIFI_UPLINK=1 \
+ *       $(find src native/src -name '*.cpp' ! -name native_main.cpp) tools/uplink_sim/uplink_sim.cpp -o uplink_sim
+ *   ./uplink_sim [--minutes N] [--ap-outage START:LEN]... [--broker-outage START:LEN]... [--lost-pubacks N]
+ *   ./uplink_sim --broker localhost:1883 --minutes 10 --ap-outage 2:5 [--speed K]
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "native.h"
+#include "uplink.h"
+#include "peripheral.h"
+#include <set>
+#include <string>
+#include <vector>
+#include <utility>
+#include <unistd.h>
+
+#define SIM_MINUTES 360
+#define SIM_POLL_MS 1000 // main loop period, device time
+#define SIM_TEMP_PERIOD_S 3600.0
+#define SIM_LOST_PUBACKS 2
+#define SIM_BROKER_SPEED 1.0
+
+#if !WIFI_UPLINK
+#error "build with -DWIFI_UPLINK=1 (see the build line above)"
+#endif
+
+typedef struct
+{
+  bool      broker; // broker down, else access point down
+  uint32_t  start_min;
+  uint32_t  len_min;
+  // measured
+  bool      ended;
+  uint32_t  backlog; // RAM records at the end of the outage
+  uint32_t  flash_s; // flash backlog at the end of the outage
+  uint32_t  acked; // acknowledged records at the end of the outage
+  uint32_t  drain_ms; // end of the outage to empty backlog, 0 if not drained
+  uint32_t  drained; // records acknowledged meanwhile
+}SimOutage_t;
+
+extern Tsdb_t SM_history;
+
+void setup();
+
+static std::set<std::pair<uint8_t, uint32_t>> received; // (plant, ts)
+static uint32_t received_records = 0; // duplicates included
+static uint32_t dup_packets = 0;
+static uint32_t bad_payloads = 0;
+
+static uint16_t humidity_adc(uint8_t pin, int64_t now_us) {
+  return 2000 + rand() % 41; // +/- 0.5 %
+}
+
+static float temperature_c(uint8_t sensor, int64_t now_us) {
+  return 22.0f + 6.0f * (float)sin(2.0 * M_PI * (now_us / 1e6) / SIM_TEMP_PERIOD_S);
+}
+
+static void on_publish(const char* topic, const uint8_t* payload, size_t len, bool dup) {
+  PlantRecord_t r[UPLINK_BATCH_RECORDS];
+  int n = strcmp(topic, UPLINK_TOPIC) == 0 ? record_decode(payload, len, r, UPLINK_BATCH_RECORDS) : -1;
+  if (n < 0) {
+    bad_payloads++;
+    return;
+  }
+  for (int i = 0; i < n; i++) {
+    received.insert(std::make_pair(r[i].plant, r[i].s.ts));
+  }
+  received_records += n;
+  dup_packets += dup ? 1 : 0;
+}
+
+static bool history_cb(const TsdbSample_t* s, void* arg) {
+  ((std::vector<uint32_t>*)arg)->push_back(s->ts);
+  return true;
+}
+
+static bool parse_outage(const char* arg, bool broker, std::vector<SimOutage_t>* out) {
+  SimOutage_t o = {};
+  o.broker = broker;
+  if (sscanf(arg, "%u:%u", &o.start_min, &o.len_min) != 2 || o.len_min == 0) {
+    return false;
+  }
+  out->push_back(o);
+  return true;
+}
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int main(int argc, char** argv) {
+  uint32_t minutes = SIM_MINUTES;
+  uint32_t lost_pubacks = SIM_LOST_PUBACKS;
+  std::vector<SimOutage_t> outages;
+  std::string broker_host;
+  uint16_t broker_port = 0;
+  double speed = SIM_BROKER_SPEED;
+  bool args_ok = true, defaults = true;
+  for (int i = 1; i < argc && args_ok; i++) {
+    if (strcmp(argv[i], "--minutes") == 0 && i + 1 < argc) {
+      minutes = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--ap-outage") == 0 && i + 1 < argc) {
+      args_ok = parse_outage(argv[++i], false, &outages);
+      defaults = false;
+    } else if (strcmp(argv[i], "--broker-outage") == 0 && i + 1 < argc) {
+      args_ok = parse_outage(argv[++i], true, &outages);
+      defaults = false;
+    } else if (strcmp(argv[i], "--lost-pubacks") == 0 && i + 1 < argc) {
+      lost_pubacks = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--broker") == 0 && i + 1 < argc) {
+      std::string b = argv[++i];
+      size_t colon = b.rfind(':');
+      broker_host = b.substr(0, colon);
+      broker_port = colon != std::string::npos ? (uint16_t)atoi(b.c_str() + colon + 1) : 1883;
+    } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+      speed = atof(argv[++i]);
+    } else {
+      args_ok = false;
+    }
+  }
+  if (!args_ok || speed <= 0) {
+    fprintf(stderr, "usage: %s [--minutes N] [--ap-outage START:LEN]... [--broker-outage START:LEN]... "
+                    "[--lost-pubacks N] [--broker HOST:PORT [--speed K]]\n", argv[0]);
+    return 2;
+  }
+  if (defaults) { // 2 h without Wi-Fi (beyond the RAM ring), then a broker restart
+    parse_outage("60:120", false, &outages);
+    parse_outage("240:20", true, &outages);
+  }
+
+  srand(1);
+  native_serial_mute(true);
+  native_set_analog_source(humidity_adc);
+  native_set_temperature_source(temperature_c);
+  native_bmp280_add(TEMP_I2CMUX ? 0 : NATIVE_I2CMUX_NONE, BMP280_ADDR_1);
+  native_broker_drop_pubacks(lost_pubacks);
+  if (broker_host.empty()) {
+    native_broker_set_publish_hook(on_publish);
+    native_clock_init(0);
+  } else {
+    native_broker_use_socket(broker_host.c_str(), broker_port);
+    native_clock_init(speed);
+  }
+  native_attach("loopTask", 1);
+  setup();
+
+  uint32_t end_ms = minutes * 60000;
+  for (uint32_t now = millis(); now < end_ms; now = millis()) {
+    uint32_t min = now / 60000;
+    bool ap_down = false, broker_down = false;
+    for (const SimOutage_t& o : outages) {
+      bool down = min >= o.start_min && min < o.start_min + o.len_min;
+      ap_down = ap_down || (down && !o.broker);
+      broker_down = broker_down || (down && o.broker);
+    }
+    native_wifi_set_ap(!ap_down);
+    native_broker_set_up(!broker_down);
+    UplinkStats_t s;
+    uplink_get_stats(&s);
+    for (SimOutage_t& o : outages) {
+      if (!o.ended && min >= o.start_min + o.len_min) {
+        o.ended = true;
+        o.backlog = s.backlog;
+        o.flash_s = s.flash_s;
+        o.acked = s.acked;
+      } else if (o.ended && o.drain_ms == 0 && s.up && s.flash_s == 0 && s.backlog < UPLINK_BATCH_RECORDS) {
+        o.drain_ms = now - (o.start_min + o.len_min) * 60000;
+        o.drained = s.acked - o.acked;
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(SIM_POLL_MS));
+  }
+
+  UplinkStats_t s;
+  uplink_get_stats(&s);
+  std::vector<uint32_t> stored;
+  tsdb_query(&SM_history, 0, 0xFFFFFFFF, history_cb, &stored);
+  uint32_t newest = 0, missing = 0;
+  for (const std::pair<uint8_t, uint32_t>& r : received) {
+    newest = r.first == PLANT_1 && r.second > newest ? r.second : newest;
+  }
+  for (uint32_t ts : stored) {
+    missing += ts <= newest && received.count(std::make_pair((uint8_t)PLANT_1, ts)) == 0 ? 1 : 0;
+  }
+
+  bool observed = broker_host.empty();
+  bool ok = s.batches > 0 && s.lost == 0 && bad_payloads == 0 && (!observed || (missing == 0 && !received.empty()));
+  printf("drain,kind,start_min,len_min,backlog_records,flash_s,drain_s,records_per_s\n");
+  for (const SimOutage_t& o : outages) {
+    printf("drain,%s,%u,%u,%u,%u,%.1f,%.1f\n", o.broker ? "broker" : "wifi", o.start_min, o.len_min, o.backlog,
+           o.flash_s, o.drain_ms / 1000.0, o.drain_ms ? o.drained * 1000.0 / o.drain_ms : 0.0);
+    ok = ok && o.drain_ms != 0;
+  }
+  printf("uplink,minutes,pushed,acked,unique,batches,payload_avg,payload_max,bytes_per_record,"
+         "dup_packets,backlog_max,flash_records,lost,reconnects,retransmits\n");
+  printf("uplink,%u,%u,%u,%zu,%u,%u,%u,%.2f,%u,%u,%u,%u,%u,%u\n", minutes, s.pushed, s.acked, received.size(),
+         s.batches, s.batches ? s.payload_bytes / s.batches : 0, s.payload_max,
+         s.acked ? (double)s.payload_bytes / s.acked : 0.0, dup_packets, s.backlog_max, s.flash_records, s.lost,
+         s.reconnects, s.retransmits);
+  fflush(stdout);
+  if (observed) {
+    fprintf(stderr, "%zu records stored in flash, %u of them missing at the broker, %u received (%zu unique)\n",
+            stored.size(), missing, received_records, received.size());
+  } else {
+    fprintf(stderr, "broker %s:%u not observed: %u records acknowledged\n", broker_host.c_str(), broker_port, s.acked);
+  }
+  fprintf(stderr, "%s\n", ok ? "PASSED" : "FAILED");
+  fflush(stderr);
+  _exit(ok ? 0 : 1); // tasks never return
+}